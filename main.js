@@ -160,6 +160,9 @@ const UpdateManager = require("./src/updater");
 const GlobeKeyManager = require("./src/helpers/globeKeyManager");
 const DevServerManager = require("./src/helpers/devServerManager");
 const WindowsKeyManager = require("./src/helpers/windowsKeyManager");
+const LinuxKeyManager = require("./src/helpers/linuxKeyManager");
+const AudioCaptureManager = require("./src/helpers/audioCapture");
+const startupManifest = require("./src/helpers/startupManifest");
 const { i18nMain, changeLanguage } = require("./src/helpers/i18nMain");
 
 // Manager instances - initialized after app.whenReady()
@@ -175,6 +178,8 @@ let trayManager = null;
 let updateManager = null;
 let globeKeyManager = null;
 let windowsKeyManager = null;
+let linuxKeyManager = null;
+let audioCaptureManager = null;
 let globeKeyAlertShown = false;
 let authBridgeServer = null;
 
@@ -236,6 +241,14 @@ function initializeCoreManagers() {
   parakeetManager = new ParakeetManager();
   updateManager = new UpdateManager();
   windowsKeyManager = new WindowsKeyManager();
+  clipboardManager.setPasteAgent(windowsKeyManager);
+  linuxKeyManager = new LinuxKeyManager();
+  audioCaptureManager = new AudioCaptureManager();
+  if (process.platform === "linux") {
+    windowManager.setNativePushListener(linuxKeyManager);
+  }
+
+  windowManager.setPasteTargetDetector(() => clipboardManager.preDetectPasteTarget());
 
   // IPC handlers must be registered before window content loads
   new IPCHandlers({
@@ -247,17 +260,20 @@ function initializeCoreManagers() {
     windowManager,
     updateManager,
     windowsKeyManager,
+    linuxKeyManager,
+    audioCaptureManager,
     getTrayManager: () => trayManager,
   });
 }
 
 // Phase 2: Non-critical setup after windows are visible
 function initializeDeferredManagers() {
-  clipboardManager.preWarmAccessibility();
+  startupManifest.background("paste-daemon", () => clipboardManager.preWarmAccessibility());
   trayManager = new TrayManager();
   globeKeyManager = new GlobeKeyManager();
 
   if (process.platform === "darwin") {
+    windowManager.setNativePushListener(globeKeyManager);
     globeKeyManager.on("error", (error) => {
       if (globeKeyAlertShown) {
         return;
@@ -429,9 +445,12 @@ function startAuthBridgeServer() {
 
 // Main application startup
 async function startApp() {
+  startupManifest.mark("app-ready");
+
   // Phase 1: Core managers + IPC handlers before windows
   initializeCoreManagers();
   startAuthBridgeServer();
+  startupManifest.mark("core-managers");
 
   // Electron's file:// sends no Origin header, which Neon Auth rejects.
   session.defaultSession.webRequest.onBeforeSendHeaders(
@@ -474,33 +493,35 @@ async function startApp() {
 
   // Create windows FIRST so the user sees UI as soon as possible
   await windowManager.createMainWindow();
+  startupManifest.mark("main-window");
   await windowManager.createControlPanelWindow();
+  startupManifest.mark("control-panel");
 
   // Phase 2: Initialize remaining managers after windows are visible
   initializeDeferredManagers();
 
-  // Non-blocking server pre-warming
+  // Server pre-warming, started with the other resident helpers below
   const whisperSettings = {
     localTranscriptionProvider: process.env.LOCAL_TRANSCRIPTION_PROVIDER || "",
     whisperModel: process.env.LOCAL_WHISPER_MODEL,
   };
-  whisperManager.initializeAtStartup(whisperSettings).catch((err) => {
-    debugLogger.debug("Whisper startup init error (non-fatal)", { error: err.message });
-  });
+  startupManifest.background("whisper-server", () =>
+    whisperManager.initializeAtStartup(whisperSettings)
+  );
 
   const parakeetSettings = {
     localTranscriptionProvider: process.env.LOCAL_TRANSCRIPTION_PROVIDER || "",
     parakeetModel: process.env.PARAKEET_MODEL,
   };
-  parakeetManager.initializeAtStartup(parakeetSettings).catch((err) => {
-    debugLogger.debug("Parakeet startup init error (non-fatal)", { error: err.message });
-  });
+  startupManifest.background("parakeet-server", () =>
+    parakeetManager.initializeAtStartup(parakeetSettings)
+  );
 
   if (process.env.REASONING_PROVIDER === "local" && process.env.LOCAL_REASONING_MODEL) {
     const modelManager = require("./src/helpers/modelManagerBridge").default;
-    modelManager.prewarmServer(process.env.LOCAL_REASONING_MODEL).catch((err) => {
-      debugLogger.debug("llama-server pre-warm error (non-fatal)", { error: err.message });
-    });
+    startupManifest.background("llama-server", () =>
+      modelManager.prewarmServer(process.env.LOCAL_REASONING_MODEL)
+    );
   }
 
   if (process.platform === "win32") {
@@ -512,6 +533,7 @@ async function startApp() {
   trayManager.setWindowManager(windowManager);
   trayManager.setCreateControlPanelCallback(() => windowManager.createControlPanelWindow());
   await trayManager.createTray();
+  startupManifest.mark("tray");
 
   updateManager.setWindows(windowManager.mainWindow, windowManager.controlPanelWindow);
   updateManager.checkForUpdatesOnStartup();
@@ -631,16 +653,67 @@ async function startApp() {
       }
     });
 
-    globeKeyManager.start();
+    // Push mode for other hotkeys: bind them in the listener's event tap so
+    // key-up is reported directly instead of inferred from modifier releases.
+    // Until BIND_OK (or without Input Monitoring) globalShortcut stays in charge.
+    const HOTKEY_BINDING_ID = "hotkey";
+    const { isRightSideModifier } = require("./src/helpers/hotkeyManager");
+
+    const syncHotkeyBinding = (
+      hotkey = hotkeyManager.getCurrentHotkey(),
+      mode = windowManager.getActivationMode()
+    ) => {
+      if (!globeKeyManager.hasFeature("bind")) return;
+      windowManager.resetWindowsPushState();
+      const needsBinding =
+        mode === "push" && hotkey && hotkey !== "GLOBE" && !isRightSideModifier(hotkey);
+      const request = needsBinding
+        ? globeKeyManager.bind(HOTKEY_BINDING_ID, hotkey)
+        : globeKeyManager.unbind(HOTKEY_BINDING_ID);
+      request.catch((error) => {
+        debugLogger.debug("[Push-to-Talk] macOS hotkey binding unavailable", {
+          hotkey,
+          error: error.message,
+        });
+      });
+    };
+
+    globeKeyManager.on("features", () => syncHotkeyBinding());
+
+    globeKeyManager.on("binding-down", (bindingId) => {
+      if (bindingId !== HOTKEY_BINDING_ID || hotkeyManager.isInListeningMode()) return;
+      if (!isLiveWindow(windowManager.mainWindow)) return;
+      if (windowManager.getActivationMode() === "push") {
+        windowManager.startWindowsPushToTalk();
+      }
+    });
+
+    globeKeyManager.on("binding-up", (bindingId) => {
+      if (bindingId !== HOTKEY_BINDING_ID) return;
+      if (!isLiveWindow(windowManager.mainWindow)) return;
+      windowManager.handleWindowsPushKeyUp();
+    });
+
+    startupManifest.background("key-listener", () => {
+      // The listener announces FEATURES once its event tap is installed
+      const ready = startupManifest.whenEmitted(globeKeyManager, "features", ["error"]);
+      globeKeyManager.start();
+      return ready;
+    });
+
+    ipcMain.on("activation-mode-changed", (_event, mode) => {
+      syncHotkeyBinding(undefined, mode);
+    });
 
     // Reset native key state when hotkey changes
-    ipcMain.on("hotkey-changed", (_event, _newHotkey) => {
+    ipcMain.on("hotkey-changed", (_event, newHotkey) => {
       globeKeyDownTime = 0;
       globeKeyIsRecording = false;
       globeLastStopTime = 0;
       rightModDownTime = 0;
       rightModIsRecording = false;
       rightModLastStopTime = 0;
+      syncHotkeyBinding(newHotkey);
     });
   }
 
@@ -708,18 +781,19 @@ async function startApp() {
       debugLogger.debug("[Push-to-Talk] WindowsKeyManager is ready and listening");
     });
 
-    const startWindowsKeyListener = () => {
-      if (!isLiveWindow(windowManager.mainWindow)) return;
+    startupManifest.background("key-listener", () => {
+      if (!isLiveWindow(windowManager.mainWindow)) return null;
       const activationMode = windowManager.getActivationMode();
       const currentHotkey = hotkeyManager.getCurrentHotkey();
-
-      if (needsNativeListener(currentHotkey, activationMode)) {
-        windowsKeyManager.start(currentHotkey);
-      }
-    };
-
-    const STARTUP_DELAY_MS = 3000;
-    setTimeout(startWindowsKeyListener, STARTUP_DELAY_MS);
+      if (!needsNativeListener(currentHotkey, activationMode)) return null;
+
+      const ready = startupManifest.whenEmitted(windowsKeyManager, "ready", [
+        "unavailable",
+        "error",
+      ]);
+      windowsKeyManager.start(currentHotkey);
+      return ready;
+    });
 
     ipcMain.on("activation-mode-changed", (_event, mode) => {
       windowManager.resetWindowsPushState();
@@ -741,6 +815,88 @@ async function startApp() {
       }
     });
   }
+
+  // Set up Linux Push-to-Talk handling. The evdev listener needs the "input"
+  // group; until it reports READY the global shortcut keeps toggling.
+  if (process.platform === "linux") {
+    const { isRightSideModifier } = require("./src/helpers/hotkeyManager");
+
+    // Modifier-only combos stay on globalShortcut in tap mode, so only push mode
+    // and right-side modifiers (which have no globalShortcut) need the listener
+    const needsNativeListener = (hotkey, mode) =>
+      !!hotkey && hotkey !== "GLOBE" && (mode === "push" || isRightSideModifier(hotkey));
+
+    linuxKeyManager.on("key-down", () => {
+      if (!isLiveWindow(windowManager.mainWindow)) return;
+
+      const activationMode = windowManager.getActivationMode();
+      if (activationMode === "push") {
+        windowManager.startWindowsPushToTalk();
+      } else if (activationMode === "tap") {
+        windowManager.showDictationPanel();
+        windowManager.mainWindow.webContents.send("toggle-dictation");
+      }
+    });
+
+    linuxKeyManager.on("key-up", () => {
+      if (!isLiveWindow(windowManager.mainWindow)) return;
+
+      if (windowManager.getActivationMode() === "push") {
+        windowManager.handleWindowsPushKeyUp();
+      }
+    });
+
+    linuxKeyManager.on("error", (error) => {
+      debugLogger.warn("[Push-to-Talk] Linux key listener error", { error: error.message });
+    });
+
+    linuxKeyManager.on("unavailable", (_error, { reason } = {}) => {
+      debugLogger.debug(
+        "[Push-to-Talk] Linux key listener not available - using global shortcut",
+        { reason }
+      );
+    });
+
+    linuxKeyManager.on("ready", () => {
+      debugLogger.debug("[Push-to-Talk] LinuxKeyManager is ready and listening");
+    });
+
+    const restartLinuxKeyListener = (hotkey, mode) => {
+      windowManager.resetWindowsPushState();
+      if (needsNativeListener(hotkey, mode)) {
+        linuxKeyManager.start(hotkey);
+      } else {
+        linuxKeyManager.stop();
+      }
+    };
+
+    startupManifest.background("key-listener", () => {
+      if (!isLiveWindow(windowManager.mainWindow)) return null;
+      const hotkey = hotkeyManager.getCurrentHotkey();
+      const mode = windowManager.getActivationMode();
+      if (!needsNativeListener(hotkey, mode)) return null;
+
+      const ready = startupManifest.whenEmitted(linuxKeyManager, "ready", [
+        "unavailable",
+        "error",
+      ]);
+      restartLinuxKeyListener(hotkey, mode);
+      return ready;
+    });
+
+    ipcMain.on("activation-mode-changed", (_event, mode) => {
+      restartLinuxKeyListener(hotkeyManager.getCurrentHotkey(), mode);
+    });
+
+    ipcMain.on("hotkey-changed", (_event, hotkey) => {
+      if (!isLiveWindow(windowManager.mainWindow)) return;
+      restartLinuxKeyListener(hotkey, windowManager.getActivationMode());
+    });
+  }
+
+  // Resident helpers and model servers start together, off the path to the
+  // first window; the startup timing report is logged once they settled
+  startupManifest.startBackground();
 }
 
 // Listen for usage limit reached from dictation overlay, forward to control panel
@@ -870,6 +1026,16 @@ if (gotSingleInstanceLock) {
     if (windowsKeyManager) {
       windowsKeyManager.stop();
     }
+    if (linuxKeyManager) {
+      linuxKeyManager.stop();
+    }
+    if (clipboardManager) {
+      clipboardManager.stopNativeHelpers();
+    }
+    startupManifest.flush();
+    if (audioCaptureManager) {
+      audioCaptureManager.shutdown();
+    }
     if (updateManager) {
       updateManager.cleanup();
     }
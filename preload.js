@@ -65,6 +65,11 @@ contextBridge.exposeInMainWorld("electronAPI", {
   writeClipboard: (text) => ipcRenderer.invoke("write-clipboard", text),
   checkPasteTools: () => ipcRenderer.invoke("check-paste-tools"),
 
+  // Native microphone capture
+  nativeAudioAvailable: () => ipcRenderer.invoke("native-audio-available"),
+  nativeAudioStart: (options) => ipcRenderer.invoke("native-audio-start", options),
+  nativeAudioStop: () => ipcRenderer.invoke("native-audio-stop"),
+
   // Local Whisper functions (whisper.cpp)
   transcribeLocalWhisper: (audioBlob, options) =>
     ipcRenderer.invoke("transcribe-local-whisper", audioBlob, options),
@@ -212,6 +217,8 @@ contextBridge.exposeInMainWorld("electronAPI", {
 
   getLogLevel: () => ipcRenderer.invoke("get-log-level"),
   log: (entry) => ipcRenderer.invoke("app-log", entry),
+  traceDictation: (entry) => ipcRenderer.send("trace-dictation", entry),
+  exportLatencyTrace: () => ipcRenderer.invoke("export-latency-trace"),
 
   // Debug logging management
   getDebugState: () => ipcRenderer.invoke("get-debug-state"),
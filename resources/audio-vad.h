@@ -0,0 +1,201 @@
+/*
+ * audio-vad.h - voice activity detection for the native audio capture helpers
+ *
+ * Push-to-talk recordings usually open and close with silence, and long
+ * dictations carry pauses; whisper.cpp inference time grows with all of it.
+ * vad_segments() finds the stretches that contain speech so the caller can
+ * drop the rest before transcription.
+ *
+ * Works on 16 kHz mono float32 in 20 ms frames. Each frame gets its energy
+ * (mean square) and zero-crossing rate, vectorised with SSE2 or NEON where
+ * available. A frame is speech when its energy clears a threshold derived
+ * from the recording's own noise floor, or when it is moderately loud and
+ * crosses zero often (unvoiced consonants such as "s" and "f" are quiet but
+ * noisy). Speech closer together than VAD_MIN_PAUSE_FRAMES joins into one
+ * segment, and every segment keeps some padding so word onsets and tails
+ * survive.
+ *
+ * Header-only and dependency-free: included by linux-audio-capture.c and
+ * windows-audio-capture.c, and by macos-audio-capture.swift as its bridging
+ * header.
+ */
+#ifndef OPENWHISPR_AUDIO_VAD_H
+#define OPENWHISPR_AUDIO_VAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VAD_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define VAD_NEON 1
+#endif
+
+#define VAD_FRAME 320             /* 20 ms at 16 kHz */
+#define VAD_LEAD_PAD_FRAMES 10    /* 200 ms kept before speech */
+#define VAD_TRAIL_PAD_FRAMES 15   /* 300 ms kept after speech */
+#define VAD_MIN_PAUSE_FRAMES 35   /* 700 ms of silence ends a segment */
+#define VAD_MIN_SPEECH_FRAMES 3   /* shorter bursts are clicks, not speech */
+#define VAD_NOISE_FACTOR 6.0f     /* ~8 dB above the noise floor */
+#define VAD_FRICATIVE_FACTOR 2.0f /* ~3 dB above the floor, with a high ZCR */
+#define VAD_FRICATIVE_ZCR 0.25f   /* zero crossings per sample */
+#define VAD_MIN_ENERGY 1e-5f      /* -50 dBFS: quieter is never speech */
+#define VAD_LOUD_RATIO 0.1f       /* within 10 dB of loud speech is always speech */
+
+typedef struct {
+    size_t start; /* first sample */
+    size_t end;   /* one past the last sample */
+} VadSegment;
+
+/* Energy and zero-crossing rate of one VAD_FRAME. x must have VAD_FRAME + 1
+ * readable samples except for the final frame, where the last crossing is
+ * simply not counted. */
+static void vad_frame_stats(const float *x, size_t available, float *energy, float *zcr) {
+    size_t n = VAD_FRAME;
+    size_t pairs = available > n ? n : n - 1;
+    float sum = 0.0f;
+    unsigned crossings = 0;
+    size_t i = 0;
+
+#if defined(VAD_SSE2)
+    static const unsigned char popcount4[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+    __m128 acc = _mm_setzero_ps();
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        __m128 a = _mm_loadu_ps(x + i);
+        acc = _mm_add_ps(acc, _mm_mul_ps(a, a));
+        if (i + 4 <= pairs) {
+            __m128 b = _mm_loadu_ps(x + i + 1);
+            crossings += popcount4[_mm_movemask_ps(_mm_cmplt_ps(_mm_mul_ps(a, b), zero))];
+        } else {
+            for (size_t j = i; j < pairs; j++) crossings += (x[j] * x[j + 1]) < 0.0f;
+        }
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(VAD_NEON)
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    uint32x4_t count = vdupq_n_u32(0);
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t a = vld1q_f32(x + i);
+        acc = vmlaq_f32(acc, a, a);
+        if (i + 4 <= pairs) {
+            float32x4_t b = vld1q_f32(x + i + 1);
+            uint32x4_t negative = vcltq_f32(vmulq_f32(a, b), vdupq_n_f32(0.0f));
+            count = vaddq_u32(count, vshrq_n_u32(negative, 31));
+        } else {
+            for (size_t j = i; j < pairs; j++) crossings += (x[j] * x[j + 1]) < 0.0f;
+        }
+    }
+    sum = vaddvq_f32(acc);
+    crossings += vaddvq_u32(count);
+#endif
+
+    for (; i < n; i++) {
+        sum += x[i] * x[i];
+        if (i < pairs) crossings += (x[i] * x[i + 1]) < 0.0f;
+    }
+
+    *energy = sum / (float)n;
+    *zcr = (float)crossings / (float)n;
+}
+
+static int vad_compare_float(const void *a, const void *b) {
+    float fa = *(const float *)a, fb = *(const float *)b;
+    return (fa > fb) - (fa < fb);
+}
+
+/*
+ * Find the speech segments in samples[0, count). Writes at most max_segments
+ * entries (sample offsets, padded and in order) and returns how many were
+ * found, 0 when nothing sounds like speech, or -1 if memory ran out. Pauses
+ * beyond max_segments are kept inside the last segment rather than dropped.
+ */
+static int vad_segments(const float *samples, size_t count, VadSegment *out, int max_segments) {
+    size_t frames = count / VAD_FRAME;
+    if (frames == 0 || max_segments <= 0) return 0;
+
+    float *energy = (float *)malloc(frames * sizeof(float));
+    float *zcr = (float *)malloc(frames * sizeof(float));
+    float *sorted = (float *)malloc(frames * sizeof(float));
+    unsigned char *speech = (unsigned char *)malloc(frames);
+    if (!energy || !zcr || !sorted || !speech) {
+        free(energy);
+        free(zcr);
+        free(sorted);
+        free(speech);
+        return -1;
+    }
+
+    for (size_t f = 0; f < frames; f++) {
+        size_t offset = f * VAD_FRAME;
+        vad_frame_stats(samples + offset, count - offset, &energy[f], &zcr[f]);
+    }
+
+    /* The quietest tenth of the recording is taken as its noise floor. In a
+     * recording that is speech throughout that is the gaps between words, so
+     * the threshold is also capped relative to the loud frames. */
+    memcpy(sorted, energy, frames * sizeof(float));
+    qsort(sorted, frames, sizeof(float), vad_compare_float);
+    float floor_energy = sorted[frames / 10];
+    float loud_energy = sorted[frames - 1 - frames / 10];
+    float threshold = floor_energy * VAD_NOISE_FACTOR;
+    if (threshold > loud_energy * VAD_LOUD_RATIO) threshold = loud_energy * VAD_LOUD_RATIO;
+    if (threshold < VAD_MIN_ENERGY) threshold = VAD_MIN_ENERGY;
+    float fricative = floor_energy * VAD_FRICATIVE_FACTOR;
+    if (fricative < VAD_MIN_ENERGY) fricative = VAD_MIN_ENERGY;
+
+    for (size_t f = 0; f < frames; f++) {
+        speech[f] = energy[f] >= threshold ||
+                    (energy[f] >= fricative && zcr[f] >= VAD_FRICATIVE_ZCR);
+    }
+
+    /* Drop isolated bursts (key clicks, mouse) */
+    for (size_t f = 0; f < frames;) {
+        if (!speech[f]) {
+            f++;
+            continue;
+        }
+        size_t run = f;
+        while (run < frames && speech[run]) run++;
+        if (run - f < VAD_MIN_SPEECH_FRAMES) memset(speech + f, 0, run - f);
+        f = run;
+    }
+
+    int found = 0;
+    size_t f = 0;
+    while (f < frames) {
+        while (f < frames && !speech[f]) f++;
+        if (f == frames) break;
+
+        size_t first = f, last = f, gap = 0;
+        for (; f < frames; f++) {
+            if (speech[f]) {
+                last = f;
+                gap = 0;
+            } else if (++gap >= VAD_MIN_PAUSE_FRAMES && found < max_segments - 1) {
+                break;
+            }
+        }
+
+        size_t start = first > VAD_LEAD_PAD_FRAMES ? (first - VAD_LEAD_PAD_FRAMES) * VAD_FRAME : 0;
+        size_t end = (last + 1 + VAD_TRAIL_PAD_FRAMES) * VAD_FRAME;
+        if (end > count || last + 1 + VAD_TRAIL_PAD_FRAMES >= frames) end = count;
+        out[found].start = start;
+        out[found].end = end;
+        found++;
+    }
+
+    free(energy);
+    free(zcr);
+    free(sorted);
+    free(speech);
+    return found;
+}
+
+#endif /* OPENWHISPR_AUDIO_VAD_H */
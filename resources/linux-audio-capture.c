@@ -0,0 +1,361 @@
+/*
+ * linux-audio-capture - records the microphone as 16 kHz mono float32 PCM
+ * into a file-backed shared-memory ring, so local transcription can skip the
+ * MediaRecorder webm -> ffmpeg -> WAV round trip.
+ *
+ * Capture goes through the PulseAudio protocol, which PipeWire serves via
+ * pipewire-pulse, and the server resamples to 16 kHz mono for us.
+ *
+ * Usage: linux-audio-capture --ring PATH [--capacity SAMPLES]
+ *
+ * Prints READY once the ring is mapped, then answers one line per command:
+ *   START [--device NAME]  -> START_OK <session> <start_us>
+ *   STOP                   -> STOP_OK <session> <samples> <first_sample_us>
+ *   STATUS                 -> STATUS_OK <capturing> <session> <samples>
+ *   VAD                    -> VAD_OK <samples> <count> <start>:<end> ...
+ *   QUIT
+ * NAME is matched against PulseAudio source descriptions, which are the
+ * labels Chromium shows for the same devices. Errors are reported as
+ * START_ERROR / STOP_ERROR <code> <message>. VAD lists the speech segments
+ * (sample offsets) of the session so far, see audio-vad.h.
+ *
+ * Ring layout (little endian, shared with the Windows and macOS helpers):
+ *   0  char[4] "OWRB"        4  u32 version (1)
+ *   8  u32 sample_rate      12  u32 channels (1)
+ *  16  u32 capacity (samples, power of two)
+ *  20  u32 session (incremented by every START)
+ *  24  u64 write_index (samples written this session, stored with release)
+ *  32  u64 first_sample_us (CLOCK_MONOTONIC, same clock as process.hrtime)
+ *  40  u32 capturing
+ *  64  float32 samples[capacity], sample i lives at i & (capacity - 1)
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <pulse/error.h>
+#include <pulse/pulseaudio.h>
+#include <pulse/simple.h>
+
+#include "audio-vad.h"
+
+#define RING_MAGIC "OWRB"
+#define RING_VERSION 1
+#define SAMPLE_RATE 16000
+#define DEFAULT_CAPACITY (1u << 23) /* ~8.7 minutes at 16 kHz */
+#define CHUNK_FRAMES 320            /* 20 ms per read */
+#define MAX_VAD_SEGMENTS 128
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t sample_rate;
+    uint32_t channels;
+    uint32_t capacity;
+    uint32_t session;
+    uint64_t write_index;
+    uint64_t first_sample_us;
+    uint32_t capturing;
+    uint8_t reserved[20];
+} RingHeader;
+
+_Static_assert(sizeof(RingHeader) == 64, "ring header must stay 64 bytes");
+
+typedef struct {
+    RingHeader *header;
+    float *samples;
+    size_t map_size;
+
+    pa_simple *stream;
+    pthread_t thread;
+    int thread_running;
+    volatile int stop_requested;
+    int read_error;
+} Capture;
+
+static long long monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static int ring_open(Capture *cap, const char *path, uint32_t capacity) {
+    size_t size = sizeof(RingHeader) + (size_t)capacity * sizeof(float);
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) return 0;
+    /* Sparse: pages are only allocated as the ring fills */
+    if (ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        return 0;
+    }
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return 0;
+
+    cap->header = (RingHeader *)map;
+    cap->samples = (float *)((char *)map + sizeof(RingHeader));
+    cap->map_size = size;
+
+    memcpy(cap->header->magic, RING_MAGIC, 4);
+    cap->header->version = RING_VERSION;
+    cap->header->sample_rate = SAMPLE_RATE;
+    cap->header->channels = 1;
+    cap->header->capacity = capacity;
+    return 1;
+}
+
+static void ring_write(Capture *cap, const float *data, size_t count) {
+    RingHeader *h = cap->header;
+    uint64_t index = h->write_index;
+    uint32_t mask = h->capacity - 1;
+    for (size_t i = 0; i < count; i++) {
+        cap->samples[(index + i) & mask] = data[i];
+    }
+    __atomic_store_n(&h->write_index, index + count, __ATOMIC_RELEASE);
+}
+
+/* ---- device lookup ---------------------------------------------------- */
+
+typedef struct {
+    const char *wanted;
+    char exact[256];
+    char partial[256];
+    int done;
+} SourceLookup;
+
+static void on_source_info(pa_context *ctx, const pa_source_info *info, int eol, void *userdata) {
+    (void)ctx;
+    SourceLookup *lookup = userdata;
+    if (eol) {
+        lookup->done = 1;
+        return;
+    }
+    /* Monitors of output sinks are not microphones */
+    if (!info || info->monitor_of_sink != PA_INVALID_INDEX || !info->description) return;
+    if (!lookup->exact[0] && strcasecmp(info->description, lookup->wanted) == 0) {
+        snprintf(lookup->exact, sizeof(lookup->exact), "%s", info->name);
+    } else if (!lookup->partial[0] && strcasestr(info->description, lookup->wanted)) {
+        snprintf(lookup->partial, sizeof(lookup->partial), "%s", info->name);
+    }
+}
+
+/* Map a device label to a PulseAudio source name. Returns 0 if the server
+ * can't be reached or nothing matches. */
+static int resolve_source(const char *wanted, char *out, size_t out_len) {
+    pa_mainloop *loop = pa_mainloop_new();
+    if (!loop) return 0;
+    pa_context *ctx = pa_context_new(pa_mainloop_get_api(loop), "OpenWhispr device lookup");
+    SourceLookup lookup = {.wanted = wanted};
+    int found = 0;
+
+    if (ctx && pa_context_connect(ctx, NULL, PA_CONTEXT_NOFLAGS, NULL) >= 0) {
+        pa_operation *op = NULL;
+        long long deadline = monotonic_us() + 2000000;
+        while (!lookup.done && monotonic_us() < deadline) {
+            if (pa_mainloop_iterate(loop, 1, NULL) < 0) break;
+            pa_context_state_t state = pa_context_get_state(ctx);
+            if (state == PA_CONTEXT_FAILED || state == PA_CONTEXT_TERMINATED) break;
+            if (state == PA_CONTEXT_READY && !op) {
+                op = pa_context_get_source_info_list(ctx, on_source_info, &lookup);
+                if (!op) break;
+            }
+        }
+        if (op) pa_operation_unref(op);
+        pa_context_disconnect(ctx);
+    }
+    if (ctx) pa_context_unref(ctx);
+    pa_mainloop_free(loop);
+
+    const char *match = lookup.exact[0] ? lookup.exact : lookup.partial;
+    if (match[0]) {
+        snprintf(out, out_len, "%s", match);
+        found = 1;
+    }
+    return found;
+}
+
+/* ---- capture ---------------------------------------------------------- */
+
+static void *capture_thread(void *arg) {
+    Capture *cap = arg;
+    float chunk[CHUNK_FRAMES];
+    int first = 1;
+
+    while (!cap->stop_requested) {
+        int err = 0;
+        if (pa_simple_read(cap->stream, chunk, sizeof(chunk), &err) < 0) {
+            fprintf(stderr, "pa_simple_read failed: %s\n", pa_strerror(err));
+            cap->read_error = err;
+            break;
+        }
+        if (first) {
+            /* The read returns once the chunk is complete */
+            cap->header->first_sample_us =
+                (uint64_t)(monotonic_us() - (long long)CHUNK_FRAMES * 1000000 / SAMPLE_RATE);
+            first = 0;
+        }
+        ring_write(cap, chunk, CHUNK_FRAMES);
+    }
+    return NULL;
+}
+
+static void capture_stop(Capture *cap) {
+    if (!cap->thread_running) return;
+    cap->stop_requested = 1;
+    pthread_join(cap->thread, NULL);
+    cap->thread_running = 0;
+    pa_simple_free(cap->stream);
+    cap->stream = NULL;
+    __atomic_store_n(&cap->header->capturing, 0, __ATOMIC_RELEASE);
+}
+
+static void handle_start(Capture *cap, char *device) {
+    if (cap->thread_running) {
+        printf("START_ERROR 1 already capturing\n");
+        return;
+    }
+
+    char source[256];
+    const char *source_name = NULL;
+    if (device && *device && strcasecmp(device, "default") != 0) {
+        if (!resolve_source(device, source, sizeof(source))) {
+            printf("START_ERROR 3 device not found\n");
+            return;
+        }
+        source_name = source;
+    }
+
+    pa_sample_spec spec = {.format = PA_SAMPLE_FLOAT32LE, .rate = SAMPLE_RATE, .channels = 1};
+    /* Small fragments so STOP doesn't have to wait long for the last read */
+    pa_buffer_attr attr = {
+        .maxlength = (uint32_t)-1,
+        .tlength = (uint32_t)-1,
+        .prebuf = (uint32_t)-1,
+        .minreq = (uint32_t)-1,
+        .fragsize = CHUNK_FRAMES * sizeof(float),
+    };
+    int err = 0;
+    pa_simple *stream = pa_simple_new(NULL, "OpenWhispr", PA_STREAM_RECORD, source_name,
+                                      "Dictation", &spec, NULL, &attr, &err);
+    if (!stream) {
+        printf("START_ERROR 2 %s\n", pa_strerror(err));
+        return;
+    }
+
+    RingHeader *h = cap->header;
+    h->session++;
+    h->first_sample_us = 0;
+    __atomic_store_n(&h->write_index, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&h->capturing, 1, __ATOMIC_RELEASE);
+
+    cap->stream = stream;
+    cap->stop_requested = 0;
+    cap->read_error = 0;
+    if (pthread_create(&cap->thread, NULL, capture_thread, cap) != 0) {
+        pa_simple_free(stream);
+        cap->stream = NULL;
+        h->capturing = 0;
+        printf("START_ERROR 2 failed to start capture thread\n");
+        return;
+    }
+    cap->thread_running = 1;
+    printf("START_OK %u %lld\n", h->session, monotonic_us());
+}
+
+static void handle_vad(Capture *cap) {
+    RingHeader *h = cap->header;
+    uint64_t count = __atomic_load_n(&h->write_index, __ATOMIC_ACQUIRE);
+    if (count > h->capacity) {
+        printf("VAD_ERROR 2 session is longer than the ring\n");
+        return;
+    }
+
+    /* Sessions start at slot 0, so while they fit the ring they are contiguous */
+    VadSegment segments[MAX_VAD_SEGMENTS];
+    int found = vad_segments(cap->samples, (size_t)count, segments, MAX_VAD_SEGMENTS);
+    if (found < 0) {
+        printf("VAD_ERROR 1 out of memory\n");
+        return;
+    }
+    printf("VAD_OK %llu %d", (unsigned long long)count, found);
+    for (int i = 0; i < found; i++) {
+        printf(" %zu:%zu", segments[i].start, segments[i].end);
+    }
+    printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *ring_path = NULL;
+    uint32_t capacity = DEFAULT_CAPACITY;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--ring") == 0 && i + 1 < argc) {
+            ring_path = argv[++i];
+        } else if (strcmp(argv[i], "--capacity") == 0 && i + 1 < argc) {
+            capacity = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+    }
+
+    if (!ring_path || capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        fprintf(stderr, "Usage: linux-audio-capture --ring PATH [--capacity POWER_OF_TWO]\n");
+        return 1;
+    }
+
+    Capture cap = {0};
+    if (!ring_open(&cap, ring_path, capacity)) {
+        fprintf(stderr, "Failed to map ring %s: %s\n", ring_path, strerror(errno));
+        return 2;
+    }
+
+    printf("READY\n");
+    fflush(stdout);
+
+    char line[1024];
+    while (fgets(line, sizeof(line), stdin)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        char *rest = line;
+        char *cmd = strsep(&rest, " ");
+        if (!cmd || !*cmd) continue;
+
+        if (strcmp(cmd, "QUIT") == 0) break;
+
+        if (strcmp(cmd, "START") == 0) {
+            char *device = NULL;
+            if (rest && strncmp(rest, "--device ", 9) == 0) device = rest + 9;
+            handle_start(&cap, device);
+        } else if (strcmp(cmd, "STOP") == 0) {
+            if (!cap.thread_running) {
+                printf("STOP_ERROR 1 not capturing\n");
+            } else {
+                capture_stop(&cap);
+                RingHeader *h = cap.header;
+                printf("STOP_OK %u %llu %llu\n", h->session,
+                       (unsigned long long)h->write_index,
+                       (unsigned long long)h->first_sample_us);
+            }
+        } else if (strcmp(cmd, "VAD") == 0) {
+            handle_vad(&cap);
+        } else if (strcmp(cmd, "STATUS") == 0) {
+            RingHeader *h = cap.header;
+            printf("STATUS_OK %d %u %llu\n", cap.thread_running, h->session,
+                   (unsigned long long)__atomic_load_n(&h->write_index, __ATOMIC_ACQUIRE));
+        } else {
+            printf("ERROR unknown command %s\n", cmd);
+        }
+        fflush(stdout);
+    }
+
+    capture_stop(&cap);
+    munmap(cap.header, cap.map_size);
+    unlink(ring_path);
+    return 0;
+}
@@ -8,40 +8,127 @@
 #include <X11/Xutil.h>
 #include <X11/extensions/XTest.h>
 #include <X11/keysym.h>
+#include <poll.h>
+#include <time.h>
 #include <unistd.h>
 
 #ifdef HAVE_UINPUT
 #include <linux/uinput.h>
 #include <linux/input.h>
+#include <sys/ioctl.h>
+#include <dirent.h>
 #include <fcntl.h>
 #include <errno.h>
 #endif
 
-static const char *terminal_classes[] = {
-    "konsole", "gnome-terminal", "terminal", "kitty", "alacritty",
-    "terminator", "xterm", "urxvt", "rxvt", "tilix", "terminology",
-    "wezterm", "foot", "st", "yakuake", "ghostty", "guake", "tilda",
-    "hyper", "tabby", "sakura", "warp", NULL
-};
+#ifdef HAVE_WAYLAND
+#include <stdint.h>
+#include <sys/mman.h>
+#include <wayland-client.h>
+#endif
 
+#include "terminal-classes.h"
+
+/* WM_CLASS fields are matched exactly against the generated table */
 static int is_terminal(const char *wm_class) {
-    if (!wm_class) return 0;
-    for (int i = 0; terminal_classes[i]; i++) {
-        if (strcasestr(wm_class, terminal_classes[i]))
-            return 1;
+    return terminal_class_match(wm_class);
+}
+
+/* Display connection plus everything derived from it that is safe to reuse
+ * between pastes. One-shot mode fills this once and exits; daemon mode keeps
+ * it alive for the lifetime of the process. */
+typedef struct {
+    Display *dpy;
+    Window root;
+    Atom net_active_window;
+    KeyCode ctrl;
+    KeyCode shift;
+    KeyCode v;
+
+    /* CLIPBOARD ownership, set up lazily by the daemon's PASTE_TEXT */
+    Window owner;
+    Atom clipboard, targets, utf8_string, text, text_plain_utf8, timestamp_prop;
+    char *sel_data;
+    size_t sel_len;
+    int sel_awaiting;         /* keystroke sent, waiting for the target to read */
+    long long sel_served_at;
+    Time sel_paste_time;      /* server time taken just before the keystroke */
+    Window sel_early[8];      /* requestors seen before the keystroke */
+    int sel_early_count;
+
+    /* Core keyboard mapping for direct typing, reloaded per TYPE_TEXT */
+    KeySym *keymap;
+    int min_keycode, max_keycode, keysyms_per_keycode;
+    KeyCode spare[8];         /* keycodes with no keysyms, borrowed for remapping */
+    int spare_count;
+    int spares_dirty;         /* spare keycodes still carry borrowed keysyms */
+} PasteContext;
+
+static int x_error_code = 0;
+
+/* Record X errors instead of letting Xlib's default handler exit the
+ * process; a stale --window ID must not kill a long-running daemon. */
+static int handle_x_error(Display *dpy, XErrorEvent *err) {
+    (void)dpy;
+    x_error_code = err->error_code;
+    return 0;
+}
+
+static long long monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+/* Returns 0 on success, or the process exit code to use on failure */
+static int context_open(PasteContext *ctx) {
+    memset(ctx, 0, sizeof(*ctx));
+
+    ctx->dpy = XOpenDisplay(NULL);
+    if (!ctx->dpy) return 1;
+
+    int event_base, error_base, major, minor;
+    if (!XTestQueryExtension(ctx->dpy, &event_base, &error_base, &major, &minor)) {
+        XCloseDisplay(ctx->dpy);
+        ctx->dpy = NULL;
+        return 2;
     }
+
+    XSetErrorHandler(handle_x_error);
+    ctx->root = DefaultRootWindow(ctx->dpy);
+    ctx->net_active_window = XInternAtom(ctx->dpy, "_NET_ACTIVE_WINDOW", False);
+    ctx->ctrl = XKeysymToKeycode(ctx->dpy, XK_Control_L);
+    ctx->shift = XKeysymToKeycode(ctx->dpy, XK_Shift_L);
+    ctx->v = XKeysymToKeycode(ctx->dpy, XK_v);
     return 0;
 }
 
-static Window get_active_window(Display *dpy) {
-    Atom prop = XInternAtom(dpy, "_NET_ACTIVE_WINDOW", True);
+static void keymap_restore_spares(PasteContext *ctx);
+
+static void context_close(PasteContext *ctx) {
+    free(ctx->sel_data);
+    ctx->sel_data = NULL;
+    if (ctx->dpy && ctx->spares_dirty) keymap_restore_spares(ctx);
+    if (ctx->keymap) {
+        XFree(ctx->keymap);
+        ctx->keymap = NULL;
+    }
+    if (ctx->dpy) {
+        XCloseDisplay(ctx->dpy);
+        ctx->dpy = NULL;
+    }
+}
+
+static Window get_active_window(PasteContext *ctx) {
+    Display *dpy = ctx->dpy;
+    Atom prop = ctx->net_active_window;
     if (prop != None) {
         Atom actual_type;
         int actual_format;
         unsigned long nitems, bytes_after;
         unsigned char *data = NULL;
 
-        if (XGetWindowProperty(dpy, DefaultRootWindow(dpy), prop, 0, 1, False,
+        if (XGetWindowProperty(dpy, ctx->root, prop, 0, 1, False,
                                XA_WINDOW, &actual_type, &actual_format,
                                &nitems, &bytes_after, &data) == Success && data) {
             Window win = nitems > 0 ? *(Window *)data : None;
@@ -56,30 +143,450 @@ static Window get_active_window(Display *dpy) {
     return focused;
 }
 
-/* Send _NET_ACTIVE_WINDOW client message then fall back to XSetInputFocus */
-static void activate_window(Display *dpy, Window win) {
-    Atom net_active = XInternAtom(dpy, "_NET_ACTIVE_WINDOW", False);
+/* Copy the window's WM_CLASS (res_class, else res_name) into wm_class and
+ * return whether it belongs to a terminal emulator */
+static int classify_window(PasteContext *ctx, Window win, char *wm_class, size_t size) {
+    int terminal = 0;
+    wm_class[0] = '\0';
+    if (win == None) return 0;
+
+    XClassHint hint;
+    if (XGetClassHint(ctx->dpy, win, &hint)) {
+        const char *name = hint.res_class ? hint.res_class : hint.res_name;
+        if (name) snprintf(wm_class, size, "%s", name);
+        terminal = is_terminal(hint.res_class) || is_terminal(hint.res_name);
+        if (hint.res_name) XFree(hint.res_name);
+        if (hint.res_class) XFree(hint.res_class);
+    }
+    return terminal;
+}
+
+/* ---- CLIPBOARD ownership ------------------------------------------------
+ *
+ * Instead of having the app write the clipboard and restore it after a fixed
+ * delay, the daemon owns CLIPBOARD itself and answers the target's
+ * SelectionRequest directly. The first data request after the keystroke
+ * tells the caller the paste has been consumed, so the previous clipboard
+ * can be put back immediately.
+ */
+
+static int selection_init(PasteContext *ctx) {
+    if (ctx->owner != None) return 0;
+
+    char *names[] = { "CLIPBOARD", "TARGETS", "UTF8_STRING", "TEXT",
+                      "text/plain;charset=utf-8", "OPENWHISPR_TIMESTAMP" };
+    Atom atoms[6];
+    if (!XInternAtoms(ctx->dpy, names, 6, False, atoms)) return -1;
+    ctx->clipboard       = atoms[0];
+    ctx->targets         = atoms[1];
+    ctx->utf8_string     = atoms[2];
+    ctx->text            = atoms[3];
+    ctx->text_plain_utf8 = atoms[4];
+    ctx->timestamp_prop  = atoms[5];
+
+    /* Never mapped; only exists to own the selection */
+    ctx->owner = XCreateSimpleWindow(ctx->dpy, ctx->root, -10, -10, 1, 1, 0, 0, 0);
+    XSelectInput(ctx->dpy, ctx->owner, PropertyChangeMask);
+    return 0;
+}
+
+/* Largest reply that fits in one ChangeProperty request; bigger texts would
+ * need the INCR protocol and are left to the regular clipboard path. */
+static size_t selection_max_bytes(PasteContext *ctx) {
+    long units = XExtendedMaxRequestSize(ctx->dpy);
+    if (units <= 0) units = XMaxRequestSize(ctx->dpy);
+    return (size_t)units * 4 - 256;
+}
+
+/* ICCCM forbids CurrentTime for XSetSelectionOwner; a zero-length append
+ * to our own window yields a PropertyNotify carrying a server timestamp. */
+static Time server_timestamp(PasteContext *ctx) {
     XEvent ev;
-    memset(&ev, 0, sizeof(ev));
-    ev.xclient.type         = ClientMessage;
-    ev.xclient.window       = win;
-    ev.xclient.message_type = net_active;
-    ev.xclient.format       = 32;
-    ev.xclient.data.l[0]    = 2; /* source: pager / direct call */
-    ev.xclient.data.l[1]    = CurrentTime;
-    ev.xclient.data.l[2]    = 0;
-
-    XSendEvent(dpy, DefaultRootWindow(dpy), False,
-               SubstructureNotifyMask | SubstructureRedirectMask, &ev);
-    XFlush(dpy);
+    XChangeProperty(ctx->dpy, ctx->owner, ctx->timestamp_prop, XA_STRING, 8,
+                    PropModeAppend, NULL, 0);
+    XWindowEvent(ctx->dpy, ctx->owner, PropertyChangeMask, &ev);
+    return ev.xproperty.time;
+}
+
+/* Take CLIPBOARD with a copy of text. Returns 0 on success. */
+static int selection_own(PasteContext *ctx, const char *text, size_t len) {
+    char *copy = malloc(len ? len : 1);
+    if (!copy) return -1;
+    memcpy(copy, text, len);
+
+    free(ctx->sel_data);
+    ctx->sel_data = copy;
+    ctx->sel_len = len;
+    ctx->sel_awaiting = 0;
+    ctx->sel_served_at = 0;
+    ctx->sel_paste_time = CurrentTime;
+    ctx->sel_early_count = 0;
+
+    XSetSelectionOwner(ctx->dpy, ctx->clipboard, ctx->owner, server_timestamp(ctx));
+    return XGetSelectionOwner(ctx->dpy, ctx->clipboard) == ctx->owner ? 0 : -1;
+}
+
+static int is_text_target(PasteContext *ctx, Atom target) {
+    return target == ctx->utf8_string || target == ctx->text_plain_utf8 ||
+           target == ctx->text || target == XA_STRING;
+}
+
+static void handle_selection_event(PasteContext *ctx, XEvent *ev) {
+    if (ev->type == SelectionClear && ev->xselectionclear.selection == ctx->clipboard) {
+        /* Someone else (normally the app restoring the old clipboard) took over */
+        free(ctx->sel_data);
+        ctx->sel_data = NULL;
+        ctx->sel_len = 0;
+        return;
+    }
+    if (ev->type != SelectionRequest) return;
+
+    XSelectionRequestEvent *req = &ev->xselectionrequest;
+    Atom property = req->property != None ? req->property : req->target;
+
+    XEvent reply;
+    memset(&reply, 0, sizeof(reply));
+    reply.xselection.type      = SelectionNotify;
+    reply.xselection.requestor = req->requestor;
+    reply.xselection.selection = req->selection;
+    reply.xselection.target    = req->target;
+    reply.xselection.time      = req->time;
+    reply.xselection.property  = None;
+
+    if (req->selection == ctx->clipboard && ctx->sel_data) {
+        if (req->target == ctx->targets) {
+            Atom supported[] = { ctx->targets, ctx->utf8_string, ctx->text_plain_utf8,
+                                 ctx->text, XA_STRING };
+            XChangeProperty(ctx->dpy, req->requestor, property, XA_ATOM, 32, PropModeReplace,
+                            (unsigned char *)supported, 5);
+            reply.xselection.property = property;
+        } else if (is_text_target(ctx, req->target)) {
+            Atom type = req->target == ctx->text ? ctx->utf8_string : req->target;
+            XChangeProperty(ctx->dpy, req->requestor, property, type, 8, PropModeReplace,
+                            (unsigned char *)ctx->sel_data, (int)ctx->sel_len);
+            reply.xselection.property = property;
+
+            /* Clipboard managers fetch new contents as soon as ownership
+             * changes; only a requestor new since then counts as the paste,
+             * and only with a request time no older than the keystroke
+             * (CurrentTime carries no time, so only the requestor decides). */
+            int early = 0;
+            for (int i = 0; i < ctx->sel_early_count; i++) {
+                if (ctx->sel_early[i] == req->requestor) early = 1;
+            }
+            if (req->time != CurrentTime && ctx->sel_paste_time != CurrentTime &&
+                (long)(req->time - ctx->sel_paste_time) < 0) {
+                early = 1;
+            }
+            if (ctx->sel_awaiting && !early) {
+                ctx->sel_awaiting = 0;
+                ctx->sel_served_at = monotonic_us();
+            } else if (!ctx->sel_awaiting && !early && ctx->sel_early_count < 8) {
+                ctx->sel_early[ctx->sel_early_count++] = req->requestor;
+            }
+        }
+    }
 
-    /* Give the WM time to process the activation request */
-    usleep(50000);
+    XSendEvent(ctx->dpy, req->requestor, False, NoEventMask, &reply);
+    XFlush(ctx->dpy);
+}
+
+static void dispatch_pending_events(PasteContext *ctx) {
+    while (XPending(ctx->dpy)) {
+        XEvent ev;
+        XNextEvent(ctx->dpy, &ev);
+        handle_selection_event(ctx, &ev);
+    }
+}
+
+/* Clipboard managers (klipper, CopyQ, GPaste) ask for new contents within a
+ * few ms of the XFixes ownership notification */
+#define SELECTION_SETTLE_US 15000
+
+/* Largest PASTE_TEXT / TYPE_TEXT payload the daemon accepts */
+#define TEXT_PAYLOAD_MAX (1024 * 1024)
+
+/* Serve the fetches that follow an ownership change (clipboard managers read
+ * new contents right away) before the keystroke goes out, so their
+ * requestors are known as early ones and can't pass for the paste */
+static void settle_selection(PasteContext *ctx) {
+    struct pollfd pfd = { ConnectionNumber(ctx->dpy), POLLIN, 0 };
+    long long deadline = monotonic_us() + SELECTION_SETTLE_US;
+    XSync(ctx->dpy, False);
+    for (;;) {
+        dispatch_pending_events(ctx);
+        long long remaining = deadline - monotonic_us();
+        if (remaining <= 0) return;
+        poll(&pfd, 1, (int)((remaining + 999) / 1000));
+    }
+}
+
+/* Serve selection requests until the target has read the text or the
+ * deadline passes */
+static void wait_for_selection_served(PasteContext *ctx, long long deadline) {
+    struct pollfd pfd = { ConnectionNumber(ctx->dpy), POLLIN, 0 };
+    for (;;) {
+        dispatch_pending_events(ctx);
+        if (!ctx->sel_awaiting) return;
+
+        long long remaining = deadline - monotonic_us();
+        if (remaining <= 0) return;
+        poll(&pfd, 1, (int)((remaining + 999) / 1000));
+    }
+}
+
+/* True if the X input focus is on win or one of its descendants */
+static int focus_is_within(PasteContext *ctx, Window win) {
+    Window focused;
+    int revert;
+    XGetInputFocus(ctx->dpy, &focused, &revert);
+
+    while (focused != None && focused != PointerRoot) {
+        if (focused == win) return 1;
+        if (focused == ctx->root) return 0;
+
+        Window root, parent, *children = NULL;
+        unsigned int count;
+        if (!XQueryTree(ctx->dpy, focused, &root, &parent, &children, &count)) return 0;
+        if (children) XFree(children);
+        focused = parent;
+    }
+    return 0;
+}
+
+/*
+ * Block until focus lands on win or the deadline passes. FocusIn on the
+ * target (any detail) means focus is on it or a descendant; a
+ * _NET_ACTIVE_WINDOW change on the root triggers an explicit check since
+ * some WMs update the property after moving focus.
+ */
+static int wait_for_focus(PasteContext *ctx, Window win, long long deadline) {
+    Display *dpy = ctx->dpy;
+    struct pollfd pfd = { ConnectionNumber(dpy), POLLIN, 0 };
+
+    for (;;) {
+        while (XPending(dpy)) {
+            XEvent ev;
+            XNextEvent(dpy, &ev);
+            if (ev.type == FocusIn && ev.xfocus.window == win) {
+                return 1;
+            }
+            if (ev.type == PropertyNotify && ev.xproperty.atom == ctx->net_active_window &&
+                focus_is_within(ctx, win)) {
+                return 1;
+            }
+            /* Keep answering the clipboard while waiting on the WM */
+            handle_selection_event(ctx, &ev);
+        }
+
+        long long remaining = deadline - monotonic_us();
+        if (remaining <= 0) return 0;
+        poll(&pfd, 1, (int)((remaining + 999) / 1000));
+    }
+}
 
-    /* Fallback: also set X input focus directly */
-    XSetInputFocus(dpy, win, RevertToParent, CurrentTime);
+/*
+ * Ask the WM to activate win via _NET_ACTIVE_WINDOW and wait for focus to
+ * arrive, falling back to XSetInputFocus. The old fixed 50 ms + 20 ms sleeps
+ * are kept only as upper bounds. Returns the microseconds spent waiting.
+ */
+static long long activate_window(PasteContext *ctx, Window win) {
+    Display *dpy = ctx->dpy;
+    long long start = monotonic_us();
+
+    XSelectInput(dpy, ctx->root, PropertyChangeMask);
+    XSelectInput(dpy, win, FocusChangeMask);
+
+    if (!focus_is_within(ctx, win)) {
+        XEvent ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.xclient.type         = ClientMessage;
+        ev.xclient.window       = win;
+        ev.xclient.message_type = ctx->net_active_window;
+        ev.xclient.format       = 32;
+        ev.xclient.data.l[0]    = 2; /* source: pager / direct call */
+        ev.xclient.data.l[1]    = CurrentTime;
+        ev.xclient.data.l[2]    = 0;
+
+        XSendEvent(dpy, ctx->root, False,
+                   SubstructureNotifyMask | SubstructureRedirectMask, &ev);
+        XFlush(dpy);
+
+        if (!wait_for_focus(ctx, win, start + 50000)) {
+            /* Fallback: WM ignored the request, set X input focus directly */
+            XSetInputFocus(dpy, win, RevertToParent, CurrentTime);
+            XFlush(dpy);
+            wait_for_focus(ctx, win, monotonic_us() + 20000);
+        }
+    }
+
+    XSelectInput(dpy, win, NoEventMask);
+    XSelectInput(dpy, ctx->root, NoEventMask);
     XFlush(dpy);
-    usleep(20000);
+    return monotonic_us() - start;
+}
+
+/* ---- Keystroke scripts --------------------------------------------------
+ *
+ * A script is a space-separated list of steps, sent as one batch:
+ *   enter, shift+enter, ctrl+a, tab, ...  a chord of modifiers and one key
+ *   paste                                  Ctrl+V, or Ctrl+Shift+V in terminals
+ *   wait:MS                                flush what is queued, sleep MS
+ * Modifiers are ctrl, shift, alt and super (win/meta); keys are a-z, 0-9,
+ * f1-f12 and the names in script_keys. Under X any other keysym name
+ * (XStringToKeysym, e.g. "KP_Enter") works too. "paste enter" pastes and
+ * submits in one helper call.
+ */
+#define KEY_SCRIPT_MAX_STEPS 32
+#define KEY_SCRIPT_MAX_MODIFIERS 4
+#define KEY_SCRIPT_MAX_WAIT_MS 1000
+
+/* evdev codes only matter to the uinput backend */
+#ifdef HAVE_UINPUT
+#define EVDEV(code) (code)
+#else
+#define EVDEV(code) 0
+#endif
+
+typedef struct {
+    const char *name;
+    KeySym sym;
+    int evcode;
+} ScriptKeyName;
+
+static const ScriptKeyName script_keys[] = {
+    { "enter", XK_Return, EVDEV(KEY_ENTER) },       { "return", XK_Return, EVDEV(KEY_ENTER) },
+    { "tab", XK_Tab, EVDEV(KEY_TAB) },              { "space", XK_space, EVDEV(KEY_SPACE) },
+    { "backspace", XK_BackSpace, EVDEV(KEY_BACKSPACE) },
+    { "escape", XK_Escape, EVDEV(KEY_ESC) },        { "esc", XK_Escape, EVDEV(KEY_ESC) },
+    { "delete", XK_Delete, EVDEV(KEY_DELETE) },     { "insert", XK_Insert, EVDEV(KEY_INSERT) },
+    { "home", XK_Home, EVDEV(KEY_HOME) },           { "end", XK_End, EVDEV(KEY_END) },
+    { "pageup", XK_Prior, EVDEV(KEY_PAGEUP) },      { "pagedown", XK_Next, EVDEV(KEY_PAGEDOWN) },
+    { "up", XK_Up, EVDEV(KEY_UP) },                 { "down", XK_Down, EVDEV(KEY_DOWN) },
+    { "left", XK_Left, EVDEV(KEY_LEFT) },           { "right", XK_Right, EVDEV(KEY_RIGHT) },
+    { NULL, NoSymbol, 0 }
+};
+
+static const ScriptKeyName script_modifiers[] = {
+    { "ctrl", XK_Control_L, EVDEV(KEY_LEFTCTRL) },  { "control", XK_Control_L, EVDEV(KEY_LEFTCTRL) },
+    { "shift", XK_Shift_L, EVDEV(KEY_LEFTSHIFT) },  { "alt", XK_Alt_L, EVDEV(KEY_LEFTALT) },
+    { "super", XK_Super_L, EVDEV(KEY_LEFTMETA) },   { "win", XK_Super_L, EVDEV(KEY_LEFTMETA) },
+    { "meta", XK_Super_L, EVDEV(KEY_LEFTMETA) },    { NULL, NoSymbol, 0 }
+};
+
+static const int script_letter_codes[26] = {
+    EVDEV(KEY_A), EVDEV(KEY_B), EVDEV(KEY_C), EVDEV(KEY_D), EVDEV(KEY_E), EVDEV(KEY_F),
+    EVDEV(KEY_G), EVDEV(KEY_H), EVDEV(KEY_I), EVDEV(KEY_J), EVDEV(KEY_K), EVDEV(KEY_L),
+    EVDEV(KEY_M), EVDEV(KEY_N), EVDEV(KEY_O), EVDEV(KEY_P), EVDEV(KEY_Q), EVDEV(KEY_R),
+    EVDEV(KEY_S), EVDEV(KEY_T), EVDEV(KEY_U), EVDEV(KEY_V), EVDEV(KEY_W), EVDEV(KEY_X),
+    EVDEV(KEY_Y), EVDEV(KEY_Z)
+};
+
+static const int script_digit_codes[10] = {
+    EVDEV(KEY_0), EVDEV(KEY_1), EVDEV(KEY_2), EVDEV(KEY_3), EVDEV(KEY_4),
+    EVDEV(KEY_5), EVDEV(KEY_6), EVDEV(KEY_7), EVDEV(KEY_8), EVDEV(KEY_9)
+};
+
+static const int script_function_codes[12] = {
+    EVDEV(KEY_F1), EVDEV(KEY_F2), EVDEV(KEY_F3), EVDEV(KEY_F4), EVDEV(KEY_F5), EVDEV(KEY_F6),
+    EVDEV(KEY_F7), EVDEV(KEY_F8), EVDEV(KEY_F9), EVDEV(KEY_F10), EVDEV(KEY_F11), EVDEV(KEY_F12)
+};
+
+typedef struct {
+    KeySym modifiers[KEY_SCRIPT_MAX_MODIFIERS];
+    int modifier_codes[KEY_SCRIPT_MAX_MODIFIERS];
+    int modifier_count;
+    KeySym sym;
+    int evcode;               /* 0: no evdev equivalent, X only */
+    int paste;
+    int wait_ms;              /* > 0: a wait step, nothing else is set */
+} ScriptStep;
+
+static int script_table_lookup(const ScriptKeyName *table, const char *name, KeySym *sym,
+                               int *evcode) {
+    for (int i = 0; table[i].name; i++) {
+        if (strcasecmp(name, table[i].name) == 0) {
+            *sym = table[i].sym;
+            *evcode = table[i].evcode;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int script_key_lookup(const char *name, KeySym *sym, int *evcode) {
+    size_t len = strlen(name);
+    int c = (unsigned char)name[0];
+    if (len == 1 && ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))) {
+        int index = (c | 0x20) - 'a';
+        *sym = XK_a + index;
+        *evcode = script_letter_codes[index];
+        return 1;
+    }
+    if (len == 1 && c >= '0' && c <= '9') {
+        *sym = XK_0 + (c - '0');
+        *evcode = script_digit_codes[c - '0'];
+        return 1;
+    }
+    if ((c == 'f' || c == 'F') && len >= 2 && len <= 3) {
+        int n = atoi(name + 1);
+        if (n >= 1 && n <= 12) {
+            *sym = XK_F1 + (n - 1);
+            *evcode = script_function_codes[n - 1];
+            return 1;
+        }
+    }
+    if (script_table_lookup(script_keys, name, sym, evcode)) return 1;
+
+    *evcode = 0;
+    *sym = XStringToKeysym(name);
+    return *sym != NoSymbol;
+}
+
+/* Parse one step such as "shift+enter" or "wait:50". Modifies token. */
+static int parse_script_step(char *token, ScriptStep *step) {
+    memset(step, 0, sizeof(*step));
+
+    if (strncasecmp(token, "wait:", 5) == 0) {
+        step->wait_ms = atoi(token + 5);
+        return step->wait_ms > 0 && step->wait_ms <= KEY_SCRIPT_MAX_WAIT_MS;
+    }
+
+    char *save = NULL;
+    char *part = strtok_r(token, "+", &save);
+    while (part) {
+        char *next = strtok_r(NULL, "+", &save);
+        if (!next) {
+            if (strcasecmp(part, "paste") == 0 && step->modifier_count == 0) {
+                step->paste = 1;
+                return 1;
+            }
+            return script_key_lookup(part, &step->sym, &step->evcode);
+        }
+        int n = step->modifier_count;
+        if (n == KEY_SCRIPT_MAX_MODIFIERS ||
+            !script_table_lookup(script_modifiers, part, &step->modifiers[n],
+                                 &step->modifier_codes[n])) {
+            return 0;
+        }
+        step->modifier_count++;
+        part = next;
+    }
+    return 0;
+}
+
+/* Parse a whole script up front, so a typo sends nothing. Returns the step
+ * count, or -1 if a step is invalid or there are too many. Modifies script. */
+static int parse_key_script(char *script, ScriptStep *steps) {
+    int count = 0;
+    char *save = NULL;
+    char *token = strtok_r(script, " \t\r\n", &save);
+    while (token) {
+        if (count == KEY_SCRIPT_MAX_STEPS || !parse_script_step(token, &steps[count])) return -1;
+        count++;
+        token = strtok_r(NULL, " \t\r\n", &save);
+    }
+    return count > 0 ? count : -1;
 }
 
 #ifdef HAVE_UINPUT
@@ -94,19 +601,29 @@ static void emit(int fd, int type, int code, int val) {
     }
 }
 
-static int paste_via_uinput(int use_shift) {
+/* Returns an fd for a freshly created virtual keyboard, or -(exit code) */
+static int uinput_create(void) {
     int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK);
     if (fd < 0) {
         fprintf(stderr, "Cannot open /dev/uinput: %s\n", strerror(errno));
-        return 3;
+        return -3;
     }
 
-    if (ioctl(fd, UI_SET_EVBIT, EV_KEY) < 0 ||
-        ioctl(fd, UI_SET_KEYBIT, KEY_LEFTCTRL) < 0 ||
-        ioctl(fd, UI_SET_KEYBIT, KEY_LEFTSHIFT) < 0 ||
-        ioctl(fd, UI_SET_KEYBIT, KEY_V) < 0) {
+    /* Every key a keystroke script can name, so KEYS works over uinput too */
+    int ok = ioctl(fd, UI_SET_EVBIT, EV_KEY) >= 0;
+    for (int i = 0; ok && script_keys[i].name; i++)
+        ok = ioctl(fd, UI_SET_KEYBIT, script_keys[i].evcode) >= 0;
+    for (int i = 0; ok && script_modifiers[i].name; i++)
+        ok = ioctl(fd, UI_SET_KEYBIT, script_modifiers[i].evcode) >= 0;
+    for (int i = 0; ok && i < 26; i++)
+        ok = ioctl(fd, UI_SET_KEYBIT, script_letter_codes[i]) >= 0;
+    for (int i = 0; ok && i < 10; i++)
+        ok = ioctl(fd, UI_SET_KEYBIT, script_digit_codes[i]) >= 0;
+    for (int i = 0; ok && i < 12; i++)
+        ok = ioctl(fd, UI_SET_KEYBIT, script_function_codes[i]) >= 0;
+    if (!ok) {
         close(fd);
-        return 4;
+        return -4;
     }
 
     struct uinput_setup usetup;
@@ -119,50 +636,1147 @@ static int paste_via_uinput(int use_shift) {
     if (ioctl(fd, UI_DEV_SETUP, &usetup) < 0 ||
         ioctl(fd, UI_DEV_CREATE) < 0) {
         close(fd);
-        return 4;
+        return -4;
     }
+    return fd;
+}
 
-    /* Let the kernel register the virtual device */
-    usleep(50000);
-
-    emit(fd, EV_KEY, KEY_LEFTCTRL, 1);
-    emit(fd, EV_SYN, SYN_REPORT, 0);
+/*
+ * Wait until the kernel has published the evdev node for the device, then
+ * give userspace (libinput/the compositor) the remainder of the settle time
+ * to open it. Bounded by the old fixed 50 ms sleep.
+ */
+static void uinput_wait_ready(int fd) {
+    long long deadline = monotonic_us() + 50000;
+    char sysname[64];
 
-    if (use_shift) {
-        emit(fd, EV_KEY, KEY_LEFTSHIFT, 1);
-        emit(fd, EV_SYN, SYN_REPORT, 0);
+    if (ioctl(fd, UI_GET_SYSNAME(sizeof(sysname)), sysname) >= 0) {
+        char path[128];
+        snprintf(path, sizeof(path), "/sys/devices/virtual/input/%s", sysname);
+        while (monotonic_us() < deadline) {
+            DIR *dir = opendir(path);
+            int found = 0;
+            if (dir) {
+                struct dirent *entry;
+                while ((entry = readdir(dir))) {
+                    if (strncmp(entry->d_name, "event", 5) == 0) {
+                        found = 1;
+                        break;
+                    }
+                }
+                closedir(dir);
+            }
+            if (found) break;
+            usleep(1000);
+        }
     }
 
-    usleep(8000);
+    long long remaining = deadline - monotonic_us();
+    if (remaining > 0) usleep((useconds_t)remaining);
+}
+
+static void uinput_destroy(int fd) {
+    ioctl(fd, UI_DEV_DESTROY);
+    close(fd);
+}
+
+/* One SYN_REPORT frame per state change (modifiers, V down, V up, modifiers
+ * up). Consumers apply a frame's key events in order, so no sleeps between. */
+static void uinput_send_paste(int fd, int use_shift) {
+    emit(fd, EV_KEY, KEY_LEFTCTRL, 1);
+    if (use_shift) emit(fd, EV_KEY, KEY_LEFTSHIFT, 1);
+    emit(fd, EV_SYN, SYN_REPORT, 0);
 
     emit(fd, EV_KEY, KEY_V, 1);
     emit(fd, EV_SYN, SYN_REPORT, 0);
-    usleep(8000);
 
     emit(fd, EV_KEY, KEY_V, 0);
     emit(fd, EV_SYN, SYN_REPORT, 0);
 
-    usleep(8000);
+    if (use_shift) emit(fd, EV_KEY, KEY_LEFTSHIFT, 0);
+    emit(fd, EV_KEY, KEY_LEFTCTRL, 0);
+    emit(fd, EV_SYN, SYN_REPORT, 0);
+}
+
+static void uinput_chord(int fd, const int *modifiers, int count, int code) {
+    for (int i = 0; i < count; i++) emit(fd, EV_KEY, modifiers[i], 1);
+    emit(fd, EV_KEY, code, 1);
+    emit(fd, EV_SYN, SYN_REPORT, 0);
+    emit(fd, EV_KEY, code, 0);
+    for (int i = count - 1; i >= 0; i--) emit(fd, EV_KEY, modifiers[i], 0);
+    emit(fd, EV_SYN, SYN_REPORT, 0);
+}
 
-    if (use_shift) {
-        emit(fd, EV_KEY, KEY_LEFTSHIFT, 0);
-        emit(fd, EV_SYN, SYN_REPORT, 0);
+/* Send parsed steps through the virtual keyboard. Returns 0, or 8 (before
+ * sending anything) if a step names a key with no evdev code. *events
+ * receives the number of key events written. */
+static int uinput_send_keys(int fd, const ScriptStep *steps, int count, int use_shift,
+                            int *events) {
+    static const int paste_modifiers[] = { KEY_LEFTCTRL, KEY_LEFTSHIFT };
+
+    *events = 0;
+    for (int i = 0; i < count; i++) {
+        if (!steps[i].wait_ms && !steps[i].paste && !steps[i].evcode) return 8;
     }
 
-    emit(fd, EV_KEY, KEY_LEFTCTRL, 0);
-    emit(fd, EV_SYN, SYN_REPORT, 0);
+    for (int i = 0; i < count; i++) {
+        const ScriptStep *step = &steps[i];
+        if (step->wait_ms) {
+            usleep((useconds_t)step->wait_ms * 1000);
+        } else if (step->paste) {
+            uinput_chord(fd, paste_modifiers, use_shift ? 2 : 1, KEY_V);
+            *events += use_shift ? 6 : 4;
+        } else {
+            uinput_chord(fd, step->modifier_codes, step->modifier_count, step->evcode);
+            *events += 2 * (step->modifier_count + 1);
+        }
+    }
+    return 0;
+}
+
+static int paste_via_uinput(int use_shift) {
+    int fd = uinput_create();
+    if (fd < 0) return -fd;
+
+    uinput_wait_ready(fd);
+    uinput_send_paste(fd, use_shift);
 
+    /* Let consumers read the events before the device disappears */
     usleep(20000);
 
-    ioctl(fd, UI_DEV_DESTROY);
+    uinput_destroy(fd);
+    return 0;
+}
+
+static int keys_via_uinput(const ScriptStep *steps, int count, int use_shift) {
+    int fd = uinput_create();
+    if (fd < 0) return -fd;
+
+    uinput_wait_ready(fd);
+    int events = 0;
+    int rc = uinput_send_keys(fd, steps, count, use_shift, &events);
+
+    /* Let consumers read the events before the device disappears */
+    usleep(20000);
+
+    uinput_destroy(fd);
+    return rc;
+}
+#endif
+
+/* ---- Wayland virtual keyboard -------------------------------------------
+ *
+ * zwp_virtual_keyboard_v1 (wlroots compositors: Sway, Hyprland, river, ...)
+ * lets a client inject keys without /dev/uinput access or XWayland. The
+ * protocol has two small interfaces, described here by hand rather than
+ * generated with wayland-scanner, so the build needs only libwayland-client.
+ *
+ * The keyboard carries its own keymap with one keycode per script key, so
+ * what a keycode means never depends on the user's layout. Modifiers are sent
+ * as a modifier state, not as key presses. Keys go out in one batch per wait
+ * step, and a roundtrip at the end confirms the compositor has taken them.
+ */
+#ifdef HAVE_WAYLAND
+#define VK_MAX_KEYS 80
+
+/* Request opcodes, in protocol order */
+enum { VK_MANAGER_CREATE_VIRTUAL_KEYBOARD = 0 };
+enum { VK_KEYMAP = 0, VK_KEY = 1, VK_MODIFIERS = 2, VK_DESTROY = 3 };
+
+/* Real modifier bits of an xkb keymap using the "complete" types/compat */
+#define VK_MOD_SHIFT (1u << 0)
+#define VK_MOD_CTRL (1u << 2)
+#define VK_MOD_ALT (1u << 3)
+#define VK_MOD_SUPER (1u << 6)
+
+static const struct wl_interface *vk_no_types[] = { NULL, NULL, NULL, NULL };
+
+static const struct wl_message vk_keyboard_requests[] = {
+    { "keymap", "uhu", vk_no_types },
+    { "key", "uuu", vk_no_types },
+    { "modifiers", "uuuu", vk_no_types },
+    { "destroy", "", vk_no_types },
+};
+
+static const struct wl_interface vk_keyboard_interface = {
+    "zwp_virtual_keyboard_v1", 1, 4, vk_keyboard_requests, 0, NULL,
+};
+
+static const struct wl_interface *vk_manager_types[] = {
+    &wl_seat_interface, &vk_keyboard_interface,
+};
+
+static const struct wl_message vk_manager_requests[] = {
+    { "create_virtual_keyboard", "on", vk_manager_types },
+};
+
+static const struct wl_interface vk_manager_interface = {
+    "zwp_virtual_keyboard_manager_v1", 1, 1, vk_manager_requests, 0, NULL,
+};
+
+typedef struct {
+    struct wl_display *display;
+    struct wl_registry *registry;
+    struct wl_seat *seat;
+    struct wl_proxy *manager;
+    struct wl_proxy *keyboard;
+    KeySym keys[VK_MAX_KEYS];   /* keys[i] is on evdev code i + 1 */
+    int key_count;
+} WaylandKeyboard;
+
+static void vk_registry_global(void *data, struct wl_registry *registry, uint32_t name,
+                               const char *interface, uint32_t version) {
+    WaylandKeyboard *wk = data;
+    (void)version;
+    if (!wk->seat && strcmp(interface, wl_seat_interface.name) == 0) {
+        wk->seat = wl_registry_bind(registry, name, &wl_seat_interface, 1);
+    } else if (!wk->manager && strcmp(interface, vk_manager_interface.name) == 0) {
+        wk->manager = wl_registry_bind(registry, name, &vk_manager_interface, 1);
+    }
+}
+
+static void vk_registry_global_remove(void *data, struct wl_registry *registry, uint32_t name) {
+    (void)data;
+    (void)registry;
+    (void)name;
+}
+
+static const struct wl_registry_listener vk_registry_listener = {
+    vk_registry_global,
+    vk_registry_global_remove,
+};
+
+static void vk_add_key(WaylandKeyboard *wk, KeySym sym) {
+    for (int i = 0; i < wk->key_count; i++) {
+        if (wk->keys[i] == sym) return;
+    }
+    if (wk->key_count < VK_MAX_KEYS) wk->keys[wk->key_count++] = sym;
+}
+
+/* Evdev code of sym on our keymap, or 0 if it has none */
+static unsigned int vk_keycode(const WaylandKeyboard *wk, KeySym sym) {
+    for (int i = 0; i < wk->key_count; i++) {
+        if (wk->keys[i] == sym) return (unsigned int)i + 1;
+    }
+    return 0;
+}
+
+static unsigned int vk_modifier_mask(KeySym sym) {
+    switch (sym) {
+    case XK_Shift_L: return VK_MOD_SHIFT;
+    case XK_Control_L: return VK_MOD_CTRL;
+    case XK_Alt_L: return VK_MOD_ALT;
+    case XK_Super_L: return VK_MOD_SUPER;
+    default: return 0;
+    }
+}
+
+/* Build the keymap (xkb keycode = evdev code + 8) and hand it over in a
+ * memfd. Returns 0 on success. */
+static int vk_upload_keymap(WaylandKeyboard *wk) {
+    wk->key_count = 0;
+    for (int i = 0; script_keys[i].name; i++) vk_add_key(wk, script_keys[i].sym);
+    for (int i = 0; i < 26; i++) vk_add_key(wk, XK_a + i);
+    for (int i = 0; i < 10; i++) vk_add_key(wk, XK_0 + i);
+    for (int i = 0; i < 12; i++) vk_add_key(wk, XK_F1 + i);
+
+    char keymap[8192];
+    size_t len = 0;
+#define KEYMAP_APPEND(...) \
+    len += (size_t)snprintf(keymap + len, len < sizeof(keymap) ? sizeof(keymap) - len : 0, \
+                            __VA_ARGS__)
+    KEYMAP_APPEND("xkb_keymap {\nxkb_keycodes \"openwhispr\" {\nminimum = 8;\nmaximum = %d;\n",
+                  wk->key_count + 8);
+    for (int i = 0; i < wk->key_count; i++) KEYMAP_APPEND("<K%d> = %d;\n", i + 1, i + 9);
+    KEYMAP_APPEND("};\nxkb_types \"openwhispr\" { include \"complete\" };\n"
+                  "xkb_compat \"openwhispr\" { include \"complete\" };\n"
+                  "xkb_symbols \"openwhispr\" {\n");
+    for (int i = 0; i < wk->key_count; i++) {
+        KEYMAP_APPEND("key <K%d> {[ %s ]};\n", i + 1, XKeysymToString(wk->keys[i]));
+    }
+    KEYMAP_APPEND("};\n};\n");
+#undef KEYMAP_APPEND
+    if (len >= sizeof(keymap)) return -1;
+
+    /* The compositor maps the keymap, NUL terminator included */
+    int fd = memfd_create("openwhispr-keymap", MFD_CLOEXEC);
+    if (fd < 0) return -1;
+    size_t size = len + 1;
+    size_t written = 0;
+    while (written < size) {
+        ssize_t n = write(fd, keymap + written, size - written);
+        if (n <= 0) {
+            close(fd);
+            return -1;
+        }
+        written += (size_t)n;
+    }
+
+    /* libwayland duplicates the fd while marshalling */
+    wl_proxy_marshal(wk->keyboard, VK_KEYMAP, WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1, fd,
+                     (uint32_t)size);
     close(fd);
     return 0;
 }
+
+static void wayland_keyboard_close(WaylandKeyboard *wk) {
+    if (wk->keyboard) {
+        wl_proxy_marshal(wk->keyboard, VK_DESTROY);
+        wl_proxy_destroy(wk->keyboard);
+    }
+    if (wk->manager) wl_proxy_destroy(wk->manager);
+    if (wk->seat) wl_seat_destroy(wk->seat);
+    if (wk->registry) wl_registry_destroy(wk->registry);
+    if (wk->display) {
+        wl_display_flush(wk->display);
+        wl_display_disconnect(wk->display);
+    }
+    memset(wk, 0, sizeof(*wk));
+}
+
+/* Connect, bind the seat and the manager, create the keyboard and upload its
+ * keymap. Returns 0, or 9 if there is no compositor or it lacks the protocol
+ * (or refuses it). */
+static int wayland_keyboard_open(WaylandKeyboard *wk) {
+    memset(wk, 0, sizeof(*wk));
+    wk->display = wl_display_connect(NULL);
+    if (!wk->display) return 9;
+
+    wk->registry = wl_display_get_registry(wk->display);
+    wl_registry_add_listener(wk->registry, &vk_registry_listener, wk);
+    if (wl_display_roundtrip(wk->display) < 0 || !wk->seat || !wk->manager) {
+        wayland_keyboard_close(wk);
+        return 9;
+    }
+
+    wk->keyboard = wl_proxy_marshal_constructor(wk->manager, VK_MANAGER_CREATE_VIRTUAL_KEYBOARD,
+                                                &vk_keyboard_interface, wk->seat, NULL);
+    if (!wk->keyboard || vk_upload_keymap(wk) != 0 || wl_display_roundtrip(wk->display) < 0) {
+        wayland_keyboard_close(wk);
+        return 9;
+    }
+    return 0;
+}
+
+static void vk_chord(WaylandKeyboard *wk, unsigned int mods, unsigned int key) {
+    uint32_t time = (uint32_t)(monotonic_us() / 1000);
+    if (mods) wl_proxy_marshal(wk->keyboard, VK_MODIFIERS, mods, 0, 0, 0);
+    wl_proxy_marshal(wk->keyboard, VK_KEY, time, key, WL_KEYBOARD_KEY_STATE_PRESSED);
+    wl_proxy_marshal(wk->keyboard, VK_KEY, time, key, WL_KEYBOARD_KEY_STATE_RELEASED);
+    if (mods) wl_proxy_marshal(wk->keyboard, VK_MODIFIERS, 0, 0, 0, 0);
+}
+
+/* Send parsed steps through the virtual keyboard. Returns 0, 6 (before
+ * sending anything) if a step names a key missing from our keymap, or 9 if
+ * the connection broke. *events receives the number of key and modifier
+ * events sent. */
+static int wayland_send_keys(WaylandKeyboard *wk, const ScriptStep *steps, int count,
+                             int use_shift, int *events) {
+    unsigned int codes[KEY_SCRIPT_MAX_STEPS];
+    unsigned int masks[KEY_SCRIPT_MAX_STEPS];
+
+    *events = 0;
+    for (int i = 0; i < count; i++) {
+        const ScriptStep *step = &steps[i];
+        if (step->wait_ms) continue;
+        if (step->paste) {
+            codes[i] = vk_keycode(wk, XK_v);
+            masks[i] = VK_MOD_CTRL | (use_shift ? VK_MOD_SHIFT : 0);
+        } else {
+            codes[i] = vk_keycode(wk, step->sym);
+            masks[i] = 0;
+            for (int m = 0; m < step->modifier_count; m++) {
+                masks[i] |= vk_modifier_mask(step->modifiers[m]);
+            }
+        }
+        if (!codes[i]) return 6;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (steps[i].wait_ms) {
+            if (wl_display_flush(wk->display) < 0) return 9;
+            usleep((useconds_t)steps[i].wait_ms * 1000);
+            continue;
+        }
+        vk_chord(wk, masks[i], codes[i]);
+        *events += masks[i] ? 4 : 2;
+    }
+    return wl_display_roundtrip(wk->display) < 0 ? 9 : 0;
+}
+
+static int wayland_send_paste(WaylandKeyboard *wk, int use_shift) {
+    ScriptStep step;
+    memset(&step, 0, sizeof(step));
+    step.paste = 1;
+    int events = 0;
+    return wayland_send_keys(wk, &step, 1, use_shift, &events);
+}
+
+/* Daemon side: make sure the persistent keyboard is usable before a command,
+ * reconnecting if the compositor dropped the connection since the last one.
+ * Returns 0 if it is. */
+static int wayland_keyboard_check(WaylandKeyboard *wk) {
+    if (wk->display && wl_display_get_error(wk->display) == 0) return 0;
+    wayland_keyboard_close(wk);
+    return wayland_keyboard_open(wk);
+}
 #endif
 
+/* ---- Direct typing ------------------------------------------------------
+ *
+ * Short texts can be typed instead of pasted, which leaves the clipboard
+ * untouched. Characters already on the keyboard are sent with their own
+ * keycode (plus Shift for the second level); anything else is mapped
+ * temporarily onto an unused keycode. All events of a batch are buffered by
+ * Xlib and flushed together.
+ */
+
+static int keymap_load(PasteContext *ctx) {
+    if (ctx->keymap) XFree(ctx->keymap);
+    XDisplayKeycodes(ctx->dpy, &ctx->min_keycode, &ctx->max_keycode);
+    int count = ctx->max_keycode - ctx->min_keycode + 1;
+    ctx->keymap = XGetKeyboardMapping(ctx->dpy, (KeyCode)ctx->min_keycode, count,
+                                      &ctx->keysyms_per_keycode);
+    if (!ctx->keymap) return -1;
+
+    ctx->spare_count = 0;
+    for (int i = count - 1; i >= 0 && ctx->spare_count < 8; i--) {
+        int used = 0;
+        for (int j = 0; j < ctx->keysyms_per_keycode; j++) {
+            if (ctx->keymap[i * ctx->keysyms_per_keycode + j] != NoSymbol) used = 1;
+        }
+        if (!used) ctx->spare[ctx->spare_count++] = (KeyCode)(ctx->min_keycode + i);
+    }
+    return 0;
+}
+
+static void keymap_restore_spares(PasteContext *ctx) {
+    KeySym none = NoSymbol;
+    for (int i = 0; i < ctx->spare_count; i++) {
+        XChangeKeyboardMapping(ctx->dpy, ctx->spare[i], 1, &none, 1);
+    }
+    XFlush(ctx->dpy);
+    ctx->spares_dirty = 0;
+}
+
+/* Find keysym on the first or shifted level of the current mapping */
+static int keymap_lookup(PasteContext *ctx, KeySym sym, KeyCode *code, int *shift) {
+    int count = ctx->max_keycode - ctx->min_keycode + 1;
+    int levels = ctx->keysyms_per_keycode < 2 ? ctx->keysyms_per_keycode : 2;
+    for (int level = 0; level < levels; level++) {
+        for (int i = 0; i < count; i++) {
+            if (ctx->keymap[i * ctx->keysyms_per_keycode + level] == sym) {
+                *code = (KeyCode)(ctx->min_keycode + i);
+                *shift = level;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/* Decode one UTF-8 sequence; invalid bytes become U+FFFD */
+static unsigned int utf8_next(const unsigned char **p, const unsigned char *end) {
+    const unsigned char *s = *p;
+    unsigned int cp = *s++;
+    int extra = cp >= 0xF0 ? 3 : cp >= 0xE0 ? 2 : cp >= 0xC0 ? 1 : 0;
+    if (extra) cp &= 0x3F >> extra;
+    else if (cp >= 0x80) cp = 0xFFFD;
+    while (extra-- > 0) {
+        if (s >= end || (*s & 0xC0) != 0x80) {
+            cp = 0xFFFD;
+            break;
+        }
+        cp = (cp << 6) | (*s++ & 0x3F);
+    }
+    *p = s;
+    return cp;
+}
+
+static KeySym codepoint_to_keysym(unsigned int cp) {
+    if (cp == '\n') return XK_Return;
+    if (cp == '\t') return XK_Tab;
+    if ((cp >= 0x20 && cp <= 0x7E) || (cp >= 0xA0 && cp <= 0xFF)) return cp;
+    return 0x01000000 | cp;
+}
+
+/* Activate the target (if any), press BackSpace backspaces times and type
+ * text. Returns 0 on success, or 6 (before sending anything) if BackSpace is
+ * needed but missing from the layout, or a character is missing and no
+ * keycode is free to remap. *chars receives the number typed. */
+static int type_via_xtest(PasteContext *ctx, const char *text, size_t len, int backspaces,
+                          Window target_window, long long *focus_us, int *chars) {
+    Display *dpy = ctx->dpy;
+
+    *focus_us = 0;
+    *chars = 0;
+    if (keymap_load(ctx) != 0) return 1;
+
+    const unsigned char *p = (const unsigned char *)text;
+    const unsigned char *end = p + len;
+
+    /* Fail before typing anything, so the caller can paste instead */
+    KeyCode backspace = 0;
+    int shift_level;
+    if (backspaces > 0 && !keymap_lookup(ctx, XK_BackSpace, &backspace, &shift_level)) return 6;
+    if (ctx->spare_count == 0) {
+        for (const unsigned char *q = p; q < end;) {
+            KeyCode code;
+            int shift;
+            unsigned int cp = utf8_next(&q, end);
+            if (cp != '\r' && !keymap_lookup(ctx, codepoint_to_keysym(cp), &code, &shift)) {
+                return 6;
+            }
+        }
+    }
+
+    if (target_window != None) {
+        *focus_us = activate_window(ctx, target_window);
+    }
+
+    if (backspaces > 0) {
+        for (int i = 0; i < backspaces; i++) {
+            XTestFakeKeyEvent(dpy, backspace, True, CurrentTime);
+            XTestFakeKeyEvent(dpy, backspace, False, CurrentTime);
+        }
+    }
+
+    KeySym borrowed[8];
+    int borrowed_count = 0;
+
+    while (p < end) {
+        unsigned int cp = utf8_next(&p, end);
+        if (cp == '\r') continue;
+        KeySym sym = codepoint_to_keysym(cp);
+
+        KeyCode code;
+        int shift = 0;
+        if (!keymap_lookup(ctx, sym, &code, &shift)) {
+            int slot = -1;
+            for (int i = 0; i < borrowed_count; i++) {
+                if (borrowed[i] == sym) slot = i;
+            }
+            if (slot < 0) {
+                if (borrowed_count == ctx->spare_count) {
+                    /* Clients re-read the mapping lazily after MappingNotify;
+                     * give them time before the spare keycodes change again */
+                    XSync(dpy, False);
+                    usleep(20000);
+                    borrowed_count = 0;
+                }
+                slot = borrowed_count++;
+                borrowed[slot] = sym;
+                XChangeKeyboardMapping(dpy, ctx->spare[slot], 1, &sym, 1);
+                ctx->spares_dirty = 1;
+            }
+            code = ctx->spare[slot];
+        }
+
+        if (shift) XTestFakeKeyEvent(dpy, ctx->shift, True, CurrentTime);
+        XTestFakeKeyEvent(dpy, code, True, CurrentTime);
+        XTestFakeKeyEvent(dpy, code, False, CurrentTime);
+        if (shift) XTestFakeKeyEvent(dpy, ctx->shift, False, CurrentTime);
+        (*chars)++;
+    }
+
+    XFlush(dpy);
+    return 0;
+}
+
+/* Activate the target (if any), pick the paste combo and send it via XTest.
+ * *focus_us receives the time spent waiting for the target to take focus. */
+static int paste_via_xtest(PasteContext *ctx, int force_terminal, Window target_window,
+                           long long *focus_us) {
+    Display *dpy = ctx->dpy;
+
+    *focus_us = 0;
+    if (target_window != None) {
+        *focus_us = activate_window(ctx, target_window);
+    }
+
+    Window win = (target_window != None) ? target_window : get_active_window(ctx);
+
+    int use_shift = force_terminal;
+    if (!use_shift) {
+        char wm_class[256];
+        use_shift = classify_window(ctx, win, wm_class, sizeof(wm_class));
+    }
+
+    /* While we own CLIPBOARD, requests older than this are not the paste */
+    if (ctx->sel_data) ctx->sel_paste_time = server_timestamp(ctx);
+
+    /* The chord sits in the Xlib queue until the XFlush below, so the server
+     * gets it in one go; sleeping between the events would only add latency */
+    XTestFakeKeyEvent(dpy, ctx->ctrl, True, CurrentTime);
+    if (use_shift)
+        XTestFakeKeyEvent(dpy, ctx->shift, True, CurrentTime);
+    XTestFakeKeyEvent(dpy, ctx->v, True, CurrentTime);
+    XTestFakeKeyEvent(dpy, ctx->v, False, CurrentTime);
+    if (use_shift)
+        XTestFakeKeyEvent(dpy, ctx->shift, False, CurrentTime);
+    XTestFakeKeyEvent(dpy, ctx->ctrl, False, CurrentTime);
+
+    XFlush(dpy);
+    return 0;
+}
+
+/* Activate the target (if any) and send parsed steps via XTest, queueing
+ * everything between waits and flushing it with a single XFlush. Returns 0,
+ * or 6 (before sending anything) if a key is not on the keyboard. "paste"
+ * steps follow the target's class unless force_terminal is set. */
+static int keys_via_xtest(PasteContext *ctx, const ScriptStep *steps, int count,
+                          int force_terminal, Window target_window, long long *focus_us,
+                          int *events) {
+    Display *dpy = ctx->dpy;
+    KeyCode codes[KEY_SCRIPT_MAX_STEPS][KEY_SCRIPT_MAX_MODIFIERS + 1];
+    int needs_paste = 0;
+
+    *focus_us = 0;
+    *events = 0;
+    for (int i = 0; i < count; i++) {
+        if (steps[i].paste) needs_paste = 1;
+        if (steps[i].wait_ms || steps[i].paste) continue;
+        for (int m = 0; m < steps[i].modifier_count; m++) {
+            codes[i][m] = XKeysymToKeycode(dpy, steps[i].modifiers[m]);
+            if (!codes[i][m]) return 6;
+        }
+        codes[i][steps[i].modifier_count] = XKeysymToKeycode(dpy, steps[i].sym);
+        if (!codes[i][steps[i].modifier_count]) return 6;
+    }
+
+    if (target_window != None) {
+        *focus_us = activate_window(ctx, target_window);
+    }
+
+    int use_shift = force_terminal;
+    if (needs_paste && !use_shift) {
+        Window win = (target_window != None) ? target_window : get_active_window(ctx);
+        char wm_class[256];
+        use_shift = classify_window(ctx, win, wm_class, sizeof(wm_class));
+    }
+
+    for (int i = 0; i < count; i++) {
+        const ScriptStep *step = &steps[i];
+        if (step->wait_ms) {
+            XFlush(dpy);
+            usleep((useconds_t)step->wait_ms * 1000);
+            continue;
+        }
+
+        KeyCode paste_codes[3] = { ctx->ctrl, ctx->shift, ctx->v };
+        const KeyCode *chord = codes[i];
+        int modifiers = step->modifier_count;
+        if (step->paste) {
+            if (!use_shift) paste_codes[1] = ctx->v;
+            chord = paste_codes;
+            modifiers = use_shift ? 2 : 1;
+        }
+
+        for (int m = 0; m < modifiers; m++) XTestFakeKeyEvent(dpy, chord[m], True, CurrentTime);
+        XTestFakeKeyEvent(dpy, chord[modifiers], True, CurrentTime);
+        XTestFakeKeyEvent(dpy, chord[modifiers], False, CurrentTime);
+        for (int m = modifiers - 1; m >= 0; m--)
+            XTestFakeKeyEvent(dpy, chord[m], False, CurrentTime);
+        *events += 2 * (modifiers + 1);
+    }
+
+    XFlush(dpy);
+    return 0;
+}
+
+/* Line-oriented stdin reader for daemon mode. PASTE_TEXT payloads follow
+ * their command line, so lines and raw bytes share one buffer. */
+typedef struct {
+    char buf[4096];
+    size_t len;
+    int overlong;   /* the start of the current line was dropped */
+} StdinReader;
+
+/* Returns 1 if data was read, 0 on EOF or error */
+static int reader_fill(StdinReader *r) {
+    if (r->len == sizeof(r->buf)) {
+        /* Over-long line: drop what we have, reader_next_line reports it */
+        r->len = 0;
+        r->overlong = 1;
+    }
+    ssize_t n = read(STDIN_FILENO, r->buf + r->len, sizeof(r->buf) - r->len);
+    if (n <= 0) return 0;
+    r->len += (size_t)n;
+    return 1;
+}
+
+/* Pop the next complete line into line (NUL-terminated). Returns 1 if found,
+ * 0 if no line is complete yet, or -1 if the line did not fit (it is dropped). */
+static int reader_next_line(StdinReader *r, char *line, size_t size) {
+    char *nl = memchr(r->buf, '\n', r->len);
+    if (!nl) return 0;
+    size_t n = (size_t)(nl - r->buf);
+    int fits = !r->overlong && n < size;
+    if (fits) {
+        memcpy(line, r->buf, n);
+        line[n] = '\0';
+    }
+    r->overlong = 0;
+    r->len -= n + 1;
+    memmove(r->buf, nl + 1, r->len);
+    return fits ? 1 : -1;
+}
+
+/* Read exactly size payload bytes, draining buffered input first */
+static int reader_read_exact(StdinReader *r, char *dst, size_t size) {
+    size_t got = r->len < size ? r->len : size;
+    memcpy(dst, r->buf, got);
+    r->len -= got;
+    memmove(r->buf, r->buf + got, r->len);
+
+    while (got < size) {
+        ssize_t n = read(STDIN_FILENO, dst + got, size - got);
+        if (n <= 0) return 0;
+        got += (size_t)n;
+    }
+    return 1;
+}
+
+/*
+ * Daemon mode: keep the display connection, keycodes and atoms alive and
+ * serve newline-delimited commands from stdin:
+ *
+ *   PASTE [--terminal] [--window ID]  ->  PASTE_OK <elapsed_us> <focus_us> <start_us>
+ *   PASTE --uinput [--terminal]       ->  PASTE_OK <elapsed_us> 0 <start_us>
+ *   PASTE --wayland [--uinput] [--terminal]
+ *                                     ->  PASTE_OK <elapsed_us> 0 <start_us>
+ *                                         PASTE_ERROR <code> <message>
+ *   PASTE_TEXT <nbytes> [--terminal] [--window ID] [--timeout MS]
+ *   <nbytes of UTF-8 text>            ->  PASTE_OK <elapsed_us> <focus_us> <start_us> <served_us>
+ *                                         PASTE_ERROR <code> <message>
+ *   TYPE_TEXT <nbytes> [--window ID] [--backspace N] [--require-window ID]
+ *   <nbytes of UTF-8 text>            ->  TYPE_OK <elapsed_us> <focus_us> <chars>
+ *                                         TYPE_ERROR <code> <message>
+ *   KEYS [--terminal] [--uinput] [--wayland] [--window ID] [--require-window ID] <script...>
+ *                                     ->  KEYS_OK <elapsed_us> <focus_us> <start_us> <events>
+ *                                         KEYS_ERROR <code> <message>
+ *   DETECT                            ->  DETECT_OK <window_id> <0|1> <wm_class>
+ *                                         DETECT_ERROR <code> <message>
+ *   QUIT                              ->  (exits)
+ *
+ * A command line longer than 511 bytes is dropped with "ERROR line too long".
+ *
+ * PASTE_TEXT takes CLIPBOARD ownership with the given text, sends the paste
+ * keystroke and waits (default 1000 ms) until the target has read the text.
+ * served_us is when that happened relative to the command, or -1 on timeout.
+ * start_us is CLOCK_MONOTONIC when the command arrived (the process.hrtime
+ * clock, for latency traces); focus_us ends as the paste keystroke is sent.
+ * The daemon keeps serving the text until another client takes CLIPBOARD.
+ *
+ * TYPE_TEXT types the text with XTest instead, leaving CLIPBOARD alone.
+ * Keycodes borrowed for characters missing from the layout are given back
+ * once the daemon has been idle for half a second. --backspace erases N
+ * characters first, so live transcripts can rewrite their unstable tail;
+ * --require-window refuses (error 7) if the user has switched windows.
+ *
+ * A PASTE_TEXT or TYPE_TEXT over TEXT_PAYLOAD_MAX bytes is refused with error
+ * 11 before anything is allocated, and the daemon then exits: the payload
+ * can't be skipped without trusting its byte count.
+ *
+ * KEYS takes the rest of the line as a keystroke script (see "Keystroke
+ * scripts" above), e.g. "KEYS paste enter" to paste and submit. Error 8 means
+ * the script did not parse, or over uinput named a key with no evdev code;
+ * over the Wayland keyboard such a key is error 6. Nothing is sent in either
+ * case.
+ *
+ * With --uinput the virtual keyboard is created and confirmed ready once at
+ * startup and reused for every paste. The X connection is then optional, so
+ * the daemon also runs on Wayland sessions without XWayland.
+ *
+ * With --wayland the daemon also connects to the compositor at startup and
+ * keeps the zwp_virtual_keyboard_v1 keyboard, its keymap and the seat for its
+ * lifetime, reconnecting if the compositor drops it. Commands flagged
+ * --wayland go through it; on compositors without the protocol they use
+ * uinput if also flagged --uinput, and fail with error 9 otherwise.
+ *
+ * "READY" is written once setup is complete. EOF on stdin (parent exited)
+ * ends the daemon.
+ */
+static int run_daemon(int with_uinput, int with_wayland) {
+    PasteContext ctx;
+    int x_rc = context_open(&ctx);
+    int uinput_fd = -1;
+    int uinput_rc = 3;
+    int wayland_ready = 0;
+
+    if (with_uinput) {
+#ifdef HAVE_UINPUT
+        uinput_fd = uinput_create();
+        if (uinput_fd >= 0) {
+            uinput_wait_ready(uinput_fd);
+        } else {
+            uinput_rc = -uinput_fd;
+        }
+#else
+        fprintf(stderr, "uinput support not compiled in\n");
+#endif
+    }
+
+#ifdef HAVE_WAYLAND
+    WaylandKeyboard wk;
+    memset(&wk, 0, sizeof(wk));
+    if (with_wayland) {
+        wayland_ready = wayland_keyboard_open(&wk) == 0;
+        if (!wayland_ready) fprintf(stderr, "Wayland virtual keyboard unavailable\n");
+    }
+#else
+    (void)with_wayland;
+#endif
+
+    if (x_rc != 0 && uinput_fd < 0 && !wayland_ready) {
+        if (with_uinput) return uinput_rc;
+        if (with_wayland) return 9;
+        fprintf(stderr, x_rc == 1 ? "Cannot open X display\n" : "XTest extension not available\n");
+        return x_rc;
+    }
+
+    printf("READY\n");
+    fflush(stdout);
+
+    StdinReader reader = { .len = 0 };
+    struct pollfd fds[3] = {
+        { STDIN_FILENO, POLLIN, 0 },
+        { ctx.dpy ? ConnectionNumber(ctx.dpy) : -1, POLLIN, 0 },
+        { -1, POLLIN, 0 },
+    };
+    char line[512];
+    int running = 1;
+
+    while (running) {
+        /* Selection requests can arrive at any time while we own CLIPBOARD */
+        if (ctx.dpy) dispatch_pending_events(&ctx);
+
+        int got = reader_next_line(&reader, line, sizeof(line));
+        if (got < 0) {
+            printf("ERROR line too long (max %zu bytes)\n", sizeof(line) - 1);
+            fflush(stdout);
+            continue;
+        }
+        if (!got) {
+#ifdef HAVE_WAYLAND
+            /* Drain compositor events (seat changes, a hangup) as they come */
+            fds[2].fd = wk.display && wl_display_get_error(wk.display) == 0
+                ? wl_display_get_fd(wk.display)
+                : -1;
+#endif
+            int ready = poll(fds, 3, ctx.spares_dirty ? 500 : -1);
+            if (ready == 0) keymap_restore_spares(&ctx);
+            if (ready <= 0) continue;
+#ifdef HAVE_WAYLAND
+            if (fds[2].revents) wl_display_dispatch(wk.display);
+#endif
+            if ((fds[0].revents & (POLLIN | POLLHUP)) && !reader_fill(&reader)) break;
+            continue;
+        }
+
+        char *save = NULL;
+        char *cmd = strtok_r(line, " \t\r\n", &save);
+        if (!cmd) continue;
+
+        if (strcmp(cmd, "QUIT") == 0) break;
+
+        if (strcmp(cmd, "DETECT") == 0) {
+            if (!ctx.dpy) {
+                printf("DETECT_ERROR %d X display unavailable\n", x_rc);
+            } else {
+                Window win = get_active_window(&ctx);
+                char wm_class[256];
+                int terminal = classify_window(&ctx, win, wm_class, sizeof(wm_class));
+                if (win == None) {
+                    printf("DETECT_ERROR 2 no active window\n");
+                } else {
+                    printf("DETECT_OK 0x%lx %d %s\n", (unsigned long)win, terminal, wm_class);
+                }
+            }
+            fflush(stdout);
+            continue;
+        }
+
+        if (strcmp(cmd, "KEYS") == 0) {
+            /* Options come first; every other token is a script step */
+            long long start = monotonic_us();
+            ScriptStep steps[KEY_SCRIPT_MAX_STEPS];
+            int step_count = 0;
+            int force_terminal = 0;
+            int use_uinput = 0;
+            int use_wayland = 0;
+            int valid = 1;
+            Window target_window = None;
+            Window require_window = None;
+            char *arg;
+            while (valid && (arg = strtok_r(NULL, " \t\r\n", &save))) {
+                char *id = NULL;
+                if (step_count == 0 && strcmp(arg, "--terminal") == 0) {
+                    force_terminal = 1;
+                } else if (step_count == 0 && strcmp(arg, "--uinput") == 0) {
+                    use_uinput = 1;
+                } else if (step_count == 0 && strcmp(arg, "--wayland") == 0) {
+                    use_wayland = 1;
+                } else if (step_count == 0 && strcmp(arg, "--window") == 0 &&
+                           (id = strtok_r(NULL, " \t\r\n", &save))) {
+                    target_window = (Window)strtoul(id, NULL, 0);
+                } else if (step_count == 0 && strcmp(arg, "--require-window") == 0 &&
+                           (id = strtok_r(NULL, " \t\r\n", &save))) {
+                    require_window = (Window)strtoul(id, NULL, 0);
+                } else if (step_count < KEY_SCRIPT_MAX_STEPS &&
+                           parse_script_step(arg, &steps[step_count])) {
+                    step_count++;
+                } else {
+                    valid = 0;
+                }
+            }
+
+            int rc = -1;
+            int events = 0;
+            long long focus_us = 0;
+            if (!valid || step_count == 0) rc = 8;
+#ifdef HAVE_WAYLAND
+            if (rc < 0 && use_wayland && wayland_ready && wayland_keyboard_check(&wk) == 0) {
+                rc = wayland_send_keys(&wk, steps, step_count, force_terminal, &events);
+            }
+#endif
+            if (rc >= 0) {
+                /* sent (or refused) above */
+            } else if (use_uinput) {
+#ifdef HAVE_UINPUT
+                rc = uinput_fd >= 0
+                    ? uinput_send_keys(uinput_fd, steps, step_count, force_terminal, &events)
+                    : 3;
+#else
+                rc = 3;
+#endif
+            } else if (use_wayland) {
+                rc = 9;
+            } else if (!ctx.dpy) {
+                rc = x_rc;
+            } else if (require_window != None && get_active_window(&ctx) != require_window) {
+                rc = 7;
+            } else {
+                x_error_code = 0;
+                rc = keys_via_xtest(&ctx, steps, step_count, force_terminal, target_window,
+                                    &focus_us, &events);
+                XSync(ctx.dpy, False);
+                if (x_error_code) {
+                    fprintf(stderr, "X error %d during keys\n", x_error_code);
+                }
+            }
+
+            if (rc == 0) {
+                printf("KEYS_OK %lld %lld %lld %d\n", monotonic_us() - start, focus_us, start,
+                       events);
+            } else {
+                printf("KEYS_ERROR %d %s\n", rc,
+                       rc == 9   ? "Wayland virtual keyboard unavailable"
+                       : rc == 8 ? "invalid key script"
+                       : rc == 7 ? "active window changed"
+                       : rc == 6 ? "key not on the keyboard"
+                       : rc == 3 ? "uinput device unavailable"
+                                 : "X display unavailable");
+            }
+            fflush(stdout);
+            continue;
+        }
+
+        int paste_text = strcmp(cmd, "PASTE_TEXT") == 0;
+        int type_text = strcmp(cmd, "TYPE_TEXT") == 0;
+        if (!paste_text && !type_text && strcmp(cmd, "PASTE") != 0) {
+            printf("ERROR unknown command %s\n", cmd);
+            fflush(stdout);
+            continue;
+        }
+
+        long long start = monotonic_us();
+        size_t text_len = 0;
+        if (paste_text || type_text) {
+            char *len_arg = strtok_r(NULL, " \t\r\n", &save);
+            text_len = len_arg ? strtoul(len_arg, NULL, 10) : 0;
+        }
+
+        int force_terminal = 0;
+        int use_uinput = 0;
+        int use_wayland = 0;
+        int timeout_ms = 1000;
+        int backspaces = 0;
+        Window target_window = None;
+        Window require_window = None;
+        char *arg;
+        while ((arg = strtok_r(NULL, " \t\r\n", &save))) {
+            if (strcmp(arg, "--terminal") == 0) {
+                force_terminal = 1;
+            } else if (strcmp(arg, "--uinput") == 0) {
+                use_uinput = 1;
+            } else if (strcmp(arg, "--wayland") == 0) {
+                use_wayland = 1;
+            } else if (strcmp(arg, "--window") == 0) {
+                char *id = strtok_r(NULL, " \t\r\n", &save);
+                if (id) target_window = (Window)strtoul(id, NULL, 0);
+            } else if (strcmp(arg, "--timeout") == 0) {
+                char *ms = strtok_r(NULL, " \t\r\n", &save);
+                if (ms) timeout_ms = atoi(ms);
+            } else if (strcmp(arg, "--backspace") == 0) {
+                char *n = strtok_r(NULL, " \t\r\n", &save);
+                if (n) backspaces = atoi(n);
+            } else if (strcmp(arg, "--require-window") == 0) {
+                char *id = strtok_r(NULL, " \t\r\n", &save);
+                if (id) require_window = (Window)strtoul(id, NULL, 0);
+            }
+        }
+
+        if ((paste_text || type_text) && text_len > TEXT_PAYLOAD_MAX) {
+            printf("%s 11 payload too large\n", paste_text ? "PASTE_ERROR" : "TYPE_ERROR");
+            fflush(stdout);
+            running = 0;
+            continue;
+        }
+
+        char *text = NULL;
+        if (paste_text || type_text) {
+            /* Always consume the payload so the stream stays in sync */
+            text = malloc(text_len ? text_len : 1);
+            if (!text || !reader_read_exact(&reader, text, text_len)) {
+                free(text);
+                running = 0;
+                continue;
+            }
+        }
+
+        if (type_text) {
+            if (!ctx.dpy) {
+                printf("TYPE_ERROR %d X display unavailable\n", x_rc);
+            } else if (require_window != None && get_active_window(&ctx) != require_window) {
+                printf("TYPE_ERROR 7 active window changed\n");
+            } else {
+                long long focus_us = 0;
+                int chars = 0;
+                x_error_code = 0;
+                int rc = type_via_xtest(&ctx, text, text_len, backspaces, target_window,
+                                        &focus_us, &chars);
+                XSync(ctx.dpy, False);
+                if (x_error_code) {
+                    fprintf(stderr, "X error %d during typing\n", x_error_code);
+                }
+                if (rc == 0) {
+                    printf("TYPE_OK %lld %lld %d\n", monotonic_us() - start, focus_us, chars);
+                } else {
+                    printf("TYPE_ERROR %d %s\n", rc,
+                           rc == 6 ? "key missing from the keyboard layout"
+                                   : "cannot read keyboard mapping");
+                }
+            }
+            free(text);
+            fflush(stdout);
+            continue;
+        }
+
+        if (paste_text) {
+            const char *error = NULL;
+            int rc = 0;
+            if (!ctx.dpy) {
+                rc = x_rc;
+                error = "X display unavailable";
+            } else if (selection_init(&ctx) != 0) {
+                rc = 4;
+                error = "cannot set up selection owner";
+            } else if (text_len > selection_max_bytes(&ctx)) {
+                rc = 5;
+                error = "text too large for a single selection reply";
+            } else if (selection_own(&ctx, text, text_len) != 0) {
+                rc = 4;
+                error = "cannot take CLIPBOARD ownership";
+            }
+            free(text);
+
+            if (error) {
+                printf("PASTE_ERROR %d %s\n", rc, error);
+                fflush(stdout);
+                continue;
+            }
+
+            long long focus_us = 0;
+            x_error_code = 0;
+            settle_selection(&ctx);
+            paste_via_xtest(&ctx, force_terminal, target_window, &focus_us);
+            ctx.sel_awaiting = 1;
+            wait_for_selection_served(&ctx, monotonic_us() + (long long)timeout_ms * 1000);
+            if (x_error_code) {
+                fprintf(stderr, "X error %d during paste\n", x_error_code);
+            }
+
+            long long served_us = ctx.sel_awaiting ? -1 : ctx.sel_served_at - start;
+            ctx.sel_awaiting = 0;
+            printf("PASTE_OK %lld %lld %lld %lld\n", monotonic_us() - start, focus_us, start,
+                   served_us);
+            fflush(stdout);
+            continue;
+        }
+
+        int rc = -1;
+        long long focus_us = 0;
+#ifdef HAVE_WAYLAND
+        if (use_wayland && wayland_ready && wayland_keyboard_check(&wk) == 0) {
+            rc = wayland_send_paste(&wk, force_terminal);
+        }
+#endif
+        if (rc >= 0) {
+            /* sent above */
+        } else if (use_uinput) {
+#ifdef HAVE_UINPUT
+            if (uinput_fd >= 0) {
+                uinput_send_paste(uinput_fd, force_terminal);
+                rc = 0;
+            } else {
+                rc = 3;
+            }
+#else
+            rc = 3;
+#endif
+        } else if (use_wayland) {
+            rc = 9;
+        } else if (ctx.dpy) {
+            x_error_code = 0;
+            rc = paste_via_xtest(&ctx, force_terminal, target_window, &focus_us);
+            XSync(ctx.dpy, False);
+            if (x_error_code) {
+                fprintf(stderr, "X error %d during paste\n", x_error_code);
+            }
+        } else {
+            rc = x_rc;
+        }
+
+        if (rc == 0) {
+            printf("PASTE_OK %lld %lld %lld\n", monotonic_us() - start, focus_us, start);
+        } else {
+            printf("PASTE_ERROR %d %s\n", rc,
+                   rc == 9      ? "Wayland virtual keyboard unavailable"
+                   : use_uinput ? "uinput device unavailable"
+                                : "X display unavailable");
+        }
+        fflush(stdout);
+    }
+
+#ifdef HAVE_UINPUT
+    if (uinput_fd >= 0) uinput_destroy(uinput_fd);
+#endif
+#ifdef HAVE_WAYLAND
+    wayland_keyboard_close(&wk);
+#endif
+    context_close(&ctx);
+    return 0;
+}
+
 int main(int argc, char *argv[]) {
     int force_terminal = 0;
     int use_uinput = 0;
+    int use_wayland = 0;
+    int daemon_mode = 0;
+    int detect_only = 0;
+    int type_mode = 0;
+    char *key_script = NULL;
     Window target_window = None;
 
     for (int i = 1; i < argc; i++) {
@@ -170,13 +1784,56 @@ int main(int argc, char *argv[]) {
             force_terminal = 1;
         } else if (strcmp(argv[i], "--uinput") == 0) {
             use_uinput = 1;
+        } else if (strcmp(argv[i], "--wayland") == 0) {
+            use_wayland = 1;
+        } else if (strcmp(argv[i], "--daemon") == 0) {
+            daemon_mode = 1;
+        } else if (strcmp(argv[i], "--detect-only") == 0) {
+            detect_only = 1;
+        } else if (strcmp(argv[i], "--type") == 0) {
+            type_mode = 1;
+        } else if (strcmp(argv[i], "--keys") == 0 && i + 1 < argc) {
+            key_script = argv[++i];
         } else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc) {
             target_window = (Window)strtoul(argv[++i], NULL, 0);
         }
     }
 
+    ScriptStep steps[KEY_SCRIPT_MAX_STEPS];
+    int step_count = 0;
+    if (key_script) {
+        step_count = parse_key_script(key_script, steps);
+        if (step_count < 0) {
+            fprintf(stderr, "Invalid key script\n");
+            return 8;
+        }
+    }
+
+    if (daemon_mode) {
+        return run_daemon(use_uinput, use_wayland);
+    }
+
+    if (use_wayland) {
+#ifdef HAVE_WAYLAND
+        WaylandKeyboard wk;
+        if (wayland_keyboard_open(&wk) == 0) {
+            int events = 0;
+            int wayland_rc = key_script
+                ? wayland_send_keys(&wk, steps, step_count, force_terminal, &events)
+                : wayland_send_paste(&wk, force_terminal);
+            wayland_keyboard_close(&wk);
+            return wayland_rc;
+        }
+#endif
+        if (!use_uinput) {
+            fprintf(stderr, "Wayland virtual keyboard unavailable\n");
+            return 9;
+        }
+    }
+
     if (use_uinput) {
 #ifdef HAVE_UINPUT
+        if (key_script) return keys_via_uinput(steps, step_count, force_terminal);
         return paste_via_uinput(force_terminal);
 #else
         fprintf(stderr, "uinput support not compiled in\n");
@@ -184,51 +1841,82 @@ int main(int argc, char *argv[]) {
 #endif
     }
 
-    Display *dpy = XOpenDisplay(NULL);
-    if (!dpy) return 1;
+    long long start = monotonic_us();
+    PasteContext ctx;
+    int rc = context_open(&ctx);
+    if (rc != 0) return rc;
 
-    int event_base, error_base, major, minor;
-    if (!XTestQueryExtension(dpy, &event_base, &error_base, &major, &minor)) {
-        XCloseDisplay(dpy);
-        return 2;
+    if (detect_only) {
+        Window win = get_active_window(&ctx);
+        char wm_class[256];
+        int terminal = classify_window(&ctx, win, wm_class, sizeof(wm_class));
+        context_close(&ctx);
+        if (win == None) {
+            fprintf(stderr, "ERROR: No active window found\n");
+            return 2;
+        }
+        printf("WINDOW_ID 0x%lx\n", (unsigned long)win);
+        printf("WINDOW_CLASS %s\n", wm_class);
+        printf("IS_TERMINAL %s\n", terminal ? "true" : "false");
+        fflush(stdout);
+        return 0;
     }
 
-    if (target_window != None) {
-        activate_window(dpy, target_window);
-    }
+    if (type_mode) {
+        /* Text arrives on stdin until EOF */
+        StdinReader reader = { .len = 0 };
+        char *text = NULL;
+        size_t len = 0;
+        while (reader_fill(&reader)) {
+            char *grown = realloc(text, len + reader.len);
+            if (!grown) break;
+            text = grown;
+            memcpy(text + len, reader.buf, reader.len);
+            len += reader.len;
+            reader.len = 0;
+        }
 
-    Window win = (target_window != None) ? target_window : get_active_window(dpy);
+        long long focus_us = 0;
+        int chars = 0;
+        rc = type_via_xtest(&ctx, text, len, 0, target_window, &focus_us, &chars);
+        free(text);
+        if (ctx.spares_dirty) {
+            /* Let clients pick up the borrowed keysyms before removing them */
+            XSync(ctx.dpy, False);
+            usleep(50000);
+        }
+        context_close(&ctx);
 
-    int use_shift = force_terminal;
-    if (!use_shift && win != None) {
-        XClassHint hint;
-        if (XGetClassHint(dpy, win, &hint)) {
-            use_shift = is_terminal(hint.res_class) || is_terminal(hint.res_name);
-            XFree(hint.res_name);
-            XFree(hint.res_class);
+        if (rc == 0) {
+            printf("TYPE_OK %lld %lld %d\n", monotonic_us() - start, focus_us, chars);
+            fflush(stdout);
         }
+        return rc;
     }
 
-    KeyCode ctrl = XKeysymToKeycode(dpy, XK_Control_L);
-    KeyCode shift = XKeysymToKeycode(dpy, XK_Shift_L);
-    KeyCode v = XKeysymToKeycode(dpy, XK_v);
+    if (key_script) {
+        long long focus_us = 0;
+        int events = 0;
+        rc = keys_via_xtest(&ctx, steps, step_count, force_terminal, target_window, &focus_us,
+                            &events);
+        XSync(ctx.dpy, False);
+        context_close(&ctx);
 
-    XTestFakeKeyEvent(dpy, ctrl, True, CurrentTime);
-    if (use_shift)
-        XTestFakeKeyEvent(dpy, shift, True, CurrentTime);
-    usleep(8000);
-
-    XTestFakeKeyEvent(dpy, v, True, CurrentTime);
-    usleep(8000);
-    XTestFakeKeyEvent(dpy, v, False, CurrentTime);
-
-    usleep(8000);
-    if (use_shift)
-        XTestFakeKeyEvent(dpy, shift, False, CurrentTime);
-    XTestFakeKeyEvent(dpy, ctrl, False, CurrentTime);
+        if (rc == 0) {
+            printf("KEYS_OK %lld %lld %lld %d\n", monotonic_us() - start, focus_us, start, events);
+            fflush(stdout);
+        }
+        return rc;
+    }
 
-    XFlush(dpy);
+    long long focus_us = 0;
+    rc = paste_via_xtest(&ctx, force_terminal, target_window, &focus_us);
     usleep(20000);
-    XCloseDisplay(dpy);
-    return 0;
+    context_close(&ctx);
+
+    if (rc == 0) {
+        printf("PASTE_OK %lld %lld %lld\n", monotonic_us() - start, focus_us, start);
+        fflush(stdout);
+    }
+    return rc;
 }
@@ -0,0 +1,608 @@
+/*
+ * linux-key-listener - Push-to-Talk key up/down detection for Linux.
+ *
+ * Reads the kernel's evdev keyboards directly (/dev/input/event*), so key
+ * releases are seen on X11 and on every Wayland compositor alike, without a
+ * global shortcut. Needs read access to the event nodes, which desktop
+ * distributions grant to members of the "input" group.
+ *
+ * Usage: linux-key-listener <hotkey> [--binary-events]
+ *
+ * The hotkey uses the same names as the Windows listener ("F8", "`",
+ * "Control+Super", "RightControl", ...). Keys are matched by evdev code, i.e.
+ * by physical position on a US layout.
+ *
+ * Speaks the Windows listener's protocol on stdout: "READY" once the
+ * keyboards are open, then "KEY_DOWN <us>" / "KEY_UP <us>" with CLOCK_MONOTONIC
+ * microseconds (process.hrtime's clock). With --binary-events key events are
+ * the 16-byte records described in src/helpers/nativeEventStream.js instead.
+ *
+ * Every keyboard is one fd in a single epoll set. Where the kernel supports
+ * EVIOCSMASK (4.4+) each fd is masked down to the hotkey's keys and their
+ * modifiers, so ordinary typing never wakes the process. An inotify watch on
+ * /dev/input opens keyboards plugged in later; IN_ATTRIB matters because udev
+ * only grants the group permission after the node is created.
+ *
+ * Exit codes: 1 bad arguments or setup failure, 2 no keyboard could be opened
+ * for lack of permission, 3 no keyboard that can produce the hotkey. Either of
+ * the last two leaves the caller on its global-shortcut fallback.
+ */
+
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/input.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define INPUT_DIR "/dev/input"
+#define MAX_DEVICES 64
+#define EXIT_NO_PERMISSION 2
+#define EXIT_NO_KEYBOARD 3
+
+/* linux-fast-paste's uinput keyboard; its Ctrl+V must not touch the hotkey */
+#define PASTE_DEVICE_NAME "openwhispr-paste"
+
+#define MOD_BIT_CTRL 1
+#define MOD_BIT_ALT 2
+#define MOD_BIT_SHIFT 4
+#define MOD_BIT_SUPER 8
+
+#define EVENT_RECORD_MARKER 0xFE
+#define EVENT_RECORD_KEY_DOWN 1
+#define EVENT_RECORD_KEY_UP 2
+
+/* Pre-4.16 headers only have the struct timeval member */
+#ifndef input_event_sec
+#define input_event_sec time.tv_sec
+#define input_event_usec time.tv_usec
+#endif
+
+#define BITS_PER_LONG (sizeof(unsigned long) * 8)
+#define NLONGS(n) (((n) + BITS_PER_LONG - 1) / BITS_PER_LONG)
+#define TEST_BIT(bit, array) (((array)[(bit) / BITS_PER_LONG] >> ((bit) % BITS_PER_LONG)) & 1UL)
+
+typedef struct {
+    int fd;
+    char node[32];            /* "event3" */
+} Device;
+
+static Device devices[MAX_DEVICES];
+static int device_count = 0;
+
+static int epoll_fd = -1;
+static int inotify_fd = -1;
+static int binary_events = 0;
+
+/* The hotkey: a main key (0 for modifier-only combos) plus required modifiers */
+static unsigned short hotkey_code = 0;
+static unsigned char hotkey_modifiers = 0;
+static int hotkey_down = 0;
+static int hotkey_device = -1;  /* fd the main key went down on */
+
+/* Held modifiers, as MOD_BIT_* for the left keys and << 4 for the right ones */
+static unsigned char held_modifiers = 0;
+
+static long long monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+typedef struct {
+    const char *name;
+    unsigned short code;
+} KeyName;
+
+/* Named keys accepted in hotkeys (case-insensitive). F1-F24, single letters
+ * and digits, and raw 0x.. / decimal evdev codes are parsed without it. */
+static const KeyName key_names[] = {
+    {"Pause", KEY_PAUSE},
+    {"ScrollLock", KEY_SCROLLLOCK},
+    {"Insert", KEY_INSERT},
+    {"Delete", KEY_DELETE},
+    {"Home", KEY_HOME},
+    {"End", KEY_END},
+    {"PageUp", KEY_PAGEUP},
+    {"PageDown", KEY_PAGEDOWN},
+    {"Up", KEY_UP},
+    {"Down", KEY_DOWN},
+    {"Left", KEY_LEFT},
+    {"Right", KEY_RIGHT},
+    {"Space", KEY_SPACE},
+    {"Enter", KEY_ENTER},
+    {"Return", KEY_ENTER},
+    {"Backspace", KEY_BACKSPACE},
+    {"Escape", KEY_ESC},
+    {"Esc", KEY_ESC},
+    {"Tab", KEY_TAB},
+    {"CapsLock", KEY_CAPSLOCK},
+    {"NumLock", KEY_NUMLOCK},
+
+    /* Right-side modifier keys (used as single-key hotkeys) */
+    {"RightAlt", KEY_RIGHTALT},
+    {"RightOption", KEY_RIGHTALT},
+    {"RightControl", KEY_RIGHTCTRL},
+    {"RightCtrl", KEY_RIGHTCTRL},
+    {"RightShift", KEY_RIGHTSHIFT},
+    {"RightSuper", KEY_RIGHTMETA},
+    {"RightWin", KEY_RIGHTMETA},
+    {"RightMeta", KEY_RIGHTMETA},
+    {"RightCommand", KEY_RIGHTMETA},
+    {"RightCmd", KEY_RIGHTMETA},
+
+    /* Backtick/tilde - the default hotkey */
+    {"`", KEY_GRAVE},
+    {"Backquote", KEY_GRAVE},
+
+    {"-", KEY_MINUS},
+    {"Minus", KEY_MINUS},
+    {"=", KEY_EQUAL},
+    {"Equal", KEY_EQUAL},
+    {"Plus", KEY_EQUAL},
+    {"[", KEY_LEFTBRACE},
+    {"]", KEY_RIGHTBRACE},
+    {"\\", KEY_BACKSLASH},
+    {";", KEY_SEMICOLON},
+    {"'", KEY_APOSTROPHE},
+    {",", KEY_COMMA},
+    {".", KEY_DOT},
+    {"/", KEY_SLASH},
+    {NULL, 0}
+};
+
+typedef struct {
+    const char *name;
+    unsigned char bit;
+} ModifierName;
+
+static const ModifierName modifier_names[] = {
+    {"CommandOrControl", MOD_BIT_CTRL},
+    {"CmdOrCtrl", MOD_BIT_CTRL},
+    {"Control", MOD_BIT_CTRL},
+    {"Ctrl", MOD_BIT_CTRL},
+    {"Alt", MOD_BIT_ALT},
+    {"Option", MOD_BIT_ALT},
+    {"Shift", MOD_BIT_SHIFT},
+    {"Super", MOD_BIT_SUPER},
+    {"Meta", MOD_BIT_SUPER},
+    {"Win", MOD_BIT_SUPER},
+    {"Command", MOD_BIT_SUPER},
+    {"Cmd", MOD_BIT_SUPER},
+    {NULL, 0}
+};
+
+static const unsigned short letter_codes[26] = {
+    KEY_A, KEY_B, KEY_C, KEY_D, KEY_E, KEY_F, KEY_G, KEY_H, KEY_I,
+    KEY_J, KEY_K, KEY_L, KEY_M, KEY_N, KEY_O, KEY_P, KEY_Q, KEY_R,
+    KEY_S, KEY_T, KEY_U, KEY_V, KEY_W, KEY_X, KEY_Y, KEY_Z
+};
+
+static unsigned short parse_key_code(const char *name) {
+    /* Function keys: F1-F10, F11-F12 and F13-F24 are three separate runs */
+    if ((name[0] == 'F' || name[0] == 'f') && name[1] >= '1' && name[1] <= '9') {
+        char *end = NULL;
+        long n = strtol(name + 1, &end, 10);
+        if (*end == '\0' && n >= 1 && n <= 24) {
+            if (n <= 10) return (unsigned short)(KEY_F1 + n - 1);
+            if (n <= 12) return (unsigned short)(KEY_F11 + n - 11);
+            return (unsigned short)(KEY_F13 + n - 13);
+        }
+    }
+
+    for (int i = 0; key_names[i].name; i++) {
+        if (strcasecmp(name, key_names[i].name) == 0) return key_names[i].code;
+    }
+
+    if (strlen(name) == 1) {
+        char c = name[0];
+        if (c >= 'a' && c <= 'z') return letter_codes[c - 'a'];
+        if (c >= 'A' && c <= 'Z') return letter_codes[c - 'A'];
+        if (c == '0') return KEY_0;
+        if (c >= '1' && c <= '9') return (unsigned short)(KEY_1 + c - '1');
+    }
+
+    long code = strtol(name, NULL, 0);
+    return code > 0 && code < KEY_CNT ? (unsigned short)code : 0;
+}
+
+/* Parse "CommandOrControl+Shift+F11" style hotkeys. Returns 0 if it names
+ * neither a key nor a modifier. */
+static int parse_hotkey(const char *hotkey) {
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", hotkey);
+
+    char *context = NULL;
+    for (char *token = strtok_r(buffer, "+", &context); token;
+         token = strtok_r(NULL, "+", &context)) {
+        while (*token == ' ') token++;
+        char *end = token + strlen(token);
+        while (end > token && end[-1] == ' ') *--end = '\0';
+        if (!*token) continue;
+
+        unsigned char modifier = 0;
+        for (int i = 0; modifier_names[i].name; i++) {
+            if (strcasecmp(token, modifier_names[i].name) == 0) {
+                modifier = modifier_names[i].bit;
+                break;
+            }
+        }
+        if (modifier) {
+            hotkey_modifiers |= modifier;
+        } else {
+            hotkey_code = parse_key_code(token);
+            if (!hotkey_code) return 0;
+        }
+    }
+
+    return hotkey_code != 0 || hotkey_modifiers != 0;
+}
+
+/* Held-modifier bit for an evdev code, or 0 for ordinary keys */
+static unsigned char modifier_key_for_code(unsigned short code) {
+    switch (code) {
+        case KEY_LEFTCTRL: return MOD_BIT_CTRL;
+        case KEY_RIGHTCTRL: return MOD_BIT_CTRL << 4;
+        case KEY_LEFTALT: return MOD_BIT_ALT;
+        case KEY_RIGHTALT: return MOD_BIT_ALT << 4;
+        case KEY_LEFTSHIFT: return MOD_BIT_SHIFT;
+        case KEY_RIGHTSHIFT: return MOD_BIT_SHIFT << 4;
+        case KEY_LEFTMETA: return MOD_BIT_SUPER;
+        case KEY_RIGHTMETA: return MOD_BIT_SUPER << 4;
+        default: return 0;
+    }
+}
+
+static const unsigned short modifier_codes[] = {
+    KEY_LEFTCTRL, KEY_RIGHTCTRL, KEY_LEFTALT, KEY_RIGHTALT,
+    KEY_LEFTSHIFT, KEY_RIGHTSHIFT, KEY_LEFTMETA, KEY_RIGHTMETA
+};
+
+static int modifiers_pressed(void) {
+    unsigned char either = (unsigned char)((held_modifiers | (held_modifiers >> 4)) & 0x0F);
+    return (either & hotkey_modifiers) == hotkey_modifiers;
+}
+
+/* Whether an evdev code can change the hotkey's state */
+static int is_watched_code(unsigned short code) {
+    if (code == hotkey_code) return 1;
+    unsigned char bit = modifier_key_for_code(code);
+    return bit && ((bit | (bit >> 4)) & hotkey_modifiers);
+}
+
+static void emit_key(int is_down, const struct input_event *ev) {
+    long long now_us = monotonic_us();
+    if (binary_events) {
+        unsigned char record[16];
+        uint32_t event_ms = ev
+            ? (uint32_t)((long long)ev->input_event_sec * 1000LL + ev->input_event_usec / 1000)
+            : (uint32_t)(now_us / 1000);
+        uint64_t timestamp = (uint64_t)now_us;
+        record[0] = EVENT_RECORD_MARKER;
+        record[1] = is_down ? EVENT_RECORD_KEY_DOWN : EVENT_RECORD_KEY_UP;
+        record[2] = 0;
+        record[3] = 0;
+        for (int i = 0; i < 4; i++) record[4 + i] = (unsigned char)(event_ms >> (8 * i));
+        for (int i = 0; i < 8; i++) record[8 + i] = (unsigned char)(timestamp >> (8 * i));
+        fwrite(record, 1, sizeof(record), stdout);
+    } else {
+        printf("%s %lld\n", is_down ? "KEY_DOWN" : "KEY_UP", now_us);
+    }
+    fflush(stdout);
+}
+
+static void set_hotkey_state(int is_down, int fd, const struct input_event *ev) {
+    if (hotkey_down == is_down) return;
+    hotkey_down = is_down;
+    hotkey_device = is_down ? fd : -1;
+    emit_key(is_down, ev);
+}
+
+static void handle_key(int fd, const struct input_event *ev) {
+    /* value 2 is autorepeat; the press is already reported */
+    if (ev->value == 2 || !is_watched_code(ev->code)) return;
+    int is_down = ev->value == 1;
+
+    unsigned char bit = modifier_key_for_code(ev->code);
+    if (bit) {
+        if (is_down) held_modifiers |= bit;
+        else held_modifiers &= (unsigned char)~bit;
+    }
+
+    /* A required modifier released while the hotkey is held ends the press */
+    if (hotkey_down && !is_down && bit && ((bit | (bit >> 4)) & hotkey_modifiers) &&
+        ev->code != hotkey_code) {
+        if (!modifiers_pressed()) set_hotkey_state(0, fd, ev);
+        return;
+    }
+
+    if (hotkey_code == 0) {
+        /* Modifier-only hotkey */
+        set_hotkey_state(modifiers_pressed(), fd, ev);
+        return;
+    }
+
+    if (ev->code != hotkey_code) return;
+    if (is_down) {
+        if (modifiers_pressed()) set_hotkey_state(1, fd, ev);
+    } else {
+        set_hotkey_state(0, fd, ev);
+    }
+}
+
+/* Rebuild held_modifiers from the keyboards' current key state. Used at
+ * startup, after SYN_DROPPED and when a keyboard goes away, so a modifier
+ * whose release was never read cannot stay "held". */
+static void resync_key_state(void) {
+    unsigned long keys[NLONGS(KEY_CNT)];
+    int main_key_held = 0;
+
+    held_modifiers = 0;
+    for (int i = 0; i < device_count; i++) {
+        memset(keys, 0, sizeof(keys));
+        if (ioctl(devices[i].fd, EVIOCGKEY(sizeof(keys)), keys) < 0) continue;
+        for (size_t m = 0; m < sizeof(modifier_codes) / sizeof(modifier_codes[0]); m++) {
+            if (TEST_BIT(modifier_codes[m], keys)) {
+                held_modifiers |= modifier_key_for_code(modifier_codes[m]);
+            }
+        }
+        if (hotkey_code && TEST_BIT(hotkey_code, keys)) main_key_held = 1;
+    }
+
+    if (hotkey_down && (!modifiers_pressed() || (hotkey_code && !main_key_held))) {
+        set_hotkey_state(0, -1, NULL);
+    }
+}
+
+/* Restrict delivery to EV_KEY events for the watched codes. SYN_REPORT and
+ * SYN_DROPPED are never filtered, and empty reports are dropped by the kernel. */
+static void apply_event_mask(int fd) {
+#ifdef EVIOCSMASK
+    unsigned long types[NLONGS(EV_CNT)];
+    unsigned long codes[NLONGS(KEY_CNT)];
+    memset(types, 0, sizeof(types));
+    memset(codes, 0, sizeof(codes));
+
+    types[EV_KEY / BITS_PER_LONG] |= 1UL << (EV_KEY % BITS_PER_LONG);
+    for (unsigned short code = 1; code < KEY_CNT; code++) {
+        if (is_watched_code(code)) codes[code / BITS_PER_LONG] |= 1UL << (code % BITS_PER_LONG);
+    }
+
+    struct input_mask type_mask = {0, sizeof(types), (uint64_t)(uintptr_t)types};
+    struct input_mask key_mask = {EV_KEY, sizeof(codes), (uint64_t)(uintptr_t)codes};
+    /* Older kernels reject the ioctl; the same filter runs in handle_key */
+    if (ioctl(fd, EVIOCSMASK, &type_mask) == 0) ioctl(fd, EVIOCSMASK, &key_mask);
+#else
+    (void)fd;
+#endif
+}
+
+static int find_device(const char *node) {
+    for (int i = 0; i < device_count; i++) {
+        if (strcmp(devices[i].node, node) == 0) return i;
+    }
+    return -1;
+}
+
+/* Open an event node if it is a keyboard that can produce the hotkey.
+ * Returns 1 if opened (or already open), 0 if skipped, -1 on EACCES. */
+static int open_device(const char *node) {
+    if (strncmp(node, "event", 5) != 0) return 0;
+    if (find_device(node) != -1) return 1;
+    if (device_count >= MAX_DEVICES) return 0;
+
+    char path[64];
+    snprintf(path, sizeof(path), INPUT_DIR "/%s", node);
+    int fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) return errno == EACCES ? -1 : 0;
+
+    unsigned long types[NLONGS(EV_CNT)];
+    unsigned long keys[NLONGS(KEY_CNT)];
+    char name[256] = "";
+    memset(types, 0, sizeof(types));
+    memset(keys, 0, sizeof(keys));
+
+    int usable = ioctl(fd, EVIOCGBIT(0, sizeof(types)), types) >= 0 &&
+                 TEST_BIT(EV_KEY, types) &&
+                 ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keys)), keys) >= 0;
+    if (usable) {
+        ioctl(fd, EVIOCGNAME(sizeof(name)), name);
+        if (strcmp(name, PASTE_DEVICE_NAME) == 0) usable = 0;
+    }
+    if (usable) {
+        /* Mice and power buttons report EV_KEY too; require a watched key */
+        usable = 0;
+        for (unsigned short code = 1; code < KEY_CNT && !usable; code++) {
+            if (TEST_BIT(code, keys) && is_watched_code(code)) usable = 1;
+        }
+    }
+    if (!usable) {
+        close(fd);
+        return 0;
+    }
+
+    struct epoll_event event = {.events = EPOLLIN, .data.fd = fd};
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        close(fd);
+        return 0;
+    }
+
+    /* Event times on process.hrtime's clock rather than wall time */
+    int clock_id = CLOCK_MONOTONIC;
+    ioctl(fd, EVIOCSCLOCKID, &clock_id);
+    apply_event_mask(fd);
+    devices[device_count].fd = fd;
+    snprintf(devices[device_count].node, sizeof(devices[device_count].node), "%s", node);
+    device_count++;
+    fprintf(stderr, "Opened keyboard %s (%s)\n", node, name);
+    return 1;
+}
+
+static void close_device(int index) {
+    int fd = devices[index].fd;
+    fprintf(stderr, "Keyboard %s removed\n", devices[index].node);
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    close(fd);
+    devices[index] = devices[--device_count];
+
+    /* Its pending releases will never arrive */
+    if (hotkey_device == fd) set_hotkey_state(0, -1, NULL);
+    resync_key_state();
+}
+
+static void read_device(int index) {
+    struct input_event events[64];
+    int fd = devices[index].fd;
+
+    for (;;) {
+        ssize_t n = read(fd, events, sizeof(events));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN) close_device(index);
+            return;
+        }
+        if (n == 0) {
+            close_device(index);
+            return;
+        }
+
+        size_t count = (size_t)n / sizeof(events[0]);
+        for (size_t i = 0; i < count; i++) {
+            if (events[i].type == EV_KEY) {
+                handle_key(fd, &events[i]);
+            } else if (events[i].type == EV_SYN && events[i].code == SYN_DROPPED) {
+                /* The kernel buffer overflowed; the remaining events are stale */
+                resync_key_state();
+                break;
+            }
+        }
+    }
+}
+
+static void read_inotify(void) {
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    for (;;) {
+        ssize_t n = read(inotify_fd, buffer, sizeof(buffer));
+        if (n <= 0) return;
+
+        for (char *p = buffer; p < buffer + n;) {
+            const struct inotify_event *event = (const struct inotify_event *)p;
+            if (event->len > 0 && (event->mask & (IN_CREATE | IN_ATTRIB))) {
+                open_device(event->name);
+            }
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+}
+
+/* Open every keyboard present now. Returns the number of nodes that could not
+ * be opened for lack of permission. */
+static int scan_devices(void) {
+    DIR *dir = opendir(INPUT_DIR);
+    if (!dir) return 0;
+
+    int denied = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (open_device(entry->d_name) < 0) denied++;
+    }
+    closedir(dir);
+    return denied;
+}
+
+int main(int argc, char *argv[]) {
+    const char *hotkey = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--binary-events") == 0) {
+            binary_events = 1;
+        } else if (!hotkey) {
+            hotkey = argv[i];
+        }
+    }
+
+    if (!hotkey) {
+        fprintf(stderr, "Usage: linux-key-listener <hotkey> [--binary-events]\n");
+        return 1;
+    }
+    if (!parse_hotkey(hotkey)) {
+        fprintf(stderr, "Error: Invalid hotkey \"%s\"\n", hotkey);
+        return 1;
+    }
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        fprintf(stderr, "Error: epoll_create1 failed (%s)\n", strerror(errno));
+        return 1;
+    }
+
+    /* Watch before scanning so a keyboard plugged in between is not missed */
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd >= 0 && inotify_add_watch(inotify_fd, INPUT_DIR, IN_CREATE | IN_ATTRIB) >= 0) {
+        struct epoll_event event = {.events = EPOLLIN, .data.fd = inotify_fd};
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, inotify_fd, &event);
+    } else {
+        fprintf(stderr, "Warning: inotify unavailable, keyboards plugged in later are ignored\n");
+    }
+
+    int denied = scan_devices();
+    if (device_count == 0 && denied > 0) {
+        fprintf(stderr,
+                "Error: Permission denied reading " INPUT_DIR "/event* "
+                "(add the user to the \"input\" group)\n");
+        return EXIT_NO_PERMISSION;
+    }
+    if (device_count == 0) {
+        fprintf(stderr, "Error: No keyboard in " INPUT_DIR " can produce \"%s\"\n", hotkey);
+        return EXIT_NO_KEYBOARD;
+    }
+    resync_key_state();
+
+    /* The parent closing its end of a stdin pipe means it is gone */
+    struct stat st;
+    if (fstat(STDIN_FILENO, &st) == 0 && S_ISFIFO(st.st_mode)) {
+        struct epoll_event event = {.events = EPOLLIN, .data.fd = STDIN_FILENO};
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, STDIN_FILENO, &event);
+    }
+
+    printf("READY\n");
+    fflush(stdout);
+    fprintf(stderr, "Listening for %s on %d keyboard(s)\n", hotkey, device_count);
+
+    struct epoll_event ready[16];
+    for (;;) {
+        int n = epoll_wait(epoll_fd, ready, 16, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "Error: epoll_wait failed (%s)\n", strerror(errno));
+            return 1;
+        }
+
+        for (int i = 0; i < n; i++) {
+            int fd = ready[i].data.fd;
+            if (fd == inotify_fd) {
+                read_inotify();
+            } else if (fd == STDIN_FILENO) {
+                char discard[256];
+                if (read(STDIN_FILENO, discard, sizeof(discard)) <= 0) return 0;
+            } else {
+                for (int d = 0; d < device_count; d++) {
+                    if (devices[d].fd == fd) {
+                        read_device(d);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
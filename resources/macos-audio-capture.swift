@@ -0,0 +1,299 @@
+import AVFoundation
+import CoreAudio
+import Foundation
+
+// Records the microphone as 16 kHz mono float32 into a file-backed
+// shared-memory ring, so local transcription can skip the MediaRecorder
+// webm -> ffmpeg -> WAV round trip.
+//
+// Usage: macos-audio-capture --ring PATH [--capacity SAMPLES]
+//
+// Prints READY once the ring is mapped, then answers one line per command,
+// the same protocol as linux-audio-capture (which documents the ring layout):
+//   START [--device NAME]  -> START_OK <session> <start_us>
+//   STOP                   -> STOP_OK <session> <samples> <first_sample_us>
+//   STATUS                 -> STATUS_OK <capturing> <session> <samples>
+//   VAD                    -> VAD_OK <samples> <count> <start>:<end> ...
+//   QUIT
+// NAME is matched against Core Audio device names, which are the labels
+// Chromium shows. Times are CLOCK_UPTIME_RAW microseconds, like the other
+// macOS helpers. VAD runs the C detector in audio-vad.h, compiled in as the
+// bridging header.
+
+let sampleRate = 16000.0
+let defaultCapacity = 1 << 23  // ~8.7 minutes at 16 kHz
+let maxVadSegments = 128
+
+func monotonicMicros() -> UInt64 {
+    return clock_gettime_nsec_np(CLOCK_UPTIME_RAW) / 1000
+}
+
+var timebase = mach_timebase_info_data_t()
+mach_timebase_info(&timebase)
+
+func hostTimeMicros(_ hostTime: UInt64) -> UInt64 {
+    return hostTime * UInt64(timebase.numer) / UInt64(timebase.denom) / 1000
+}
+
+// Header field offsets, see linux-audio-capture.c
+let headerSize = 64
+let sessionOffset = 20
+let writeIndexOffset = 24
+let firstSampleOffset = 32
+let capturingOffset = 40
+
+final class Ring {
+    let base: UnsafeMutableRawPointer
+    let samples: UnsafeMutablePointer<Float>
+    let capacity: Int
+    let mapSize: Int
+
+    init?(path: String, capacity: Int) {
+        mapSize = headerSize + capacity * MemoryLayout<Float>.size
+        let fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0o600)
+        if fd < 0 { return nil }
+        defer { close(fd) }
+        // Sparse: pages are only allocated as the ring fills
+        guard ftruncate(fd, off_t(mapSize)) == 0,
+              let map = mmap(nil, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0),
+              map != UnsafeMutableRawPointer(bitPattern: -1)
+        else { return nil }
+
+        base = map
+        samples = (map + headerSize).bindMemory(to: Float.self, capacity: capacity)
+        self.capacity = capacity
+
+        let magic: [UInt8] = Array("OWRB".utf8)
+        for (i, byte) in magic.enumerated() { base.storeBytes(of: byte, toByteOffset: i, as: UInt8.self) }
+        base.storeBytes(of: UInt32(1), toByteOffset: 4, as: UInt32.self)
+        base.storeBytes(of: UInt32(sampleRate), toByteOffset: 8, as: UInt32.self)
+        base.storeBytes(of: UInt32(1), toByteOffset: 12, as: UInt32.self)
+        base.storeBytes(of: UInt32(capacity), toByteOffset: 16, as: UInt32.self)
+    }
+
+    var session: UInt32 {
+        get { base.load(fromByteOffset: sessionOffset, as: UInt32.self) }
+        set { base.storeBytes(of: newValue, toByteOffset: sessionOffset, as: UInt32.self) }
+    }
+
+    var writeIndex: UInt64 {
+        get { base.load(fromByteOffset: writeIndexOffset, as: UInt64.self) }
+        set {
+            // Samples must be visible before the index that covers them
+            OSMemoryBarrier()
+            base.storeBytes(of: newValue, toByteOffset: writeIndexOffset, as: UInt64.self)
+        }
+    }
+
+    var firstSampleUs: UInt64 {
+        get { base.load(fromByteOffset: firstSampleOffset, as: UInt64.self) }
+        set { base.storeBytes(of: newValue, toByteOffset: firstSampleOffset, as: UInt64.self) }
+    }
+
+    var capturing: Bool {
+        get { base.load(fromByteOffset: capturingOffset, as: UInt32.self) != 0 }
+        set { base.storeBytes(of: UInt32(newValue ? 1 : 0), toByteOffset: capturingOffset, as: UInt32.self) }
+    }
+
+    func write(_ data: UnsafePointer<Float>, count: Int) {
+        let index = writeIndex
+        let mask = UInt64(capacity - 1)
+        for i in 0..<count {
+            samples[Int((index + UInt64(i)) & mask)] = data[i]
+        }
+        writeIndex = index + UInt64(count)
+    }
+}
+
+func deviceName(_ id: AudioDeviceID) -> String? {
+    var address = AudioObjectPropertyAddress(
+        mSelector: kAudioObjectPropertyName,
+        mScope: kAudioObjectPropertyScopeGlobal,
+        mElement: kAudioObjectPropertyElementMain)
+    var name: Unmanaged<CFString>?
+    var size = UInt32(MemoryLayout<Unmanaged<CFString>?>.size)
+    guard AudioObjectGetPropertyData(id, &address, 0, nil, &size, &name) == noErr,
+          let value = name?.takeRetainedValue()
+    else { return nil }
+    return value as String
+}
+
+func hasInputStreams(_ id: AudioDeviceID) -> Bool {
+    var address = AudioObjectPropertyAddress(
+        mSelector: kAudioDevicePropertyStreams,
+        mScope: kAudioDevicePropertyScopeInput,
+        mElement: kAudioObjectPropertyElementMain)
+    var size: UInt32 = 0
+    return AudioObjectGetPropertyDataSize(id, &address, 0, nil, &size) == noErr && size > 0
+}
+
+// Exact (case-insensitive) name match first, then substring
+func findInputDevice(named wanted: String) -> AudioDeviceID? {
+    var address = AudioObjectPropertyAddress(
+        mSelector: kAudioHardwarePropertyDevices,
+        mScope: kAudioObjectPropertyScopeGlobal,
+        mElement: kAudioObjectPropertyElementMain)
+    let system = AudioObjectID(kAudioObjectSystemObject)
+    var size: UInt32 = 0
+    guard AudioObjectGetPropertyDataSize(system, &address, 0, nil, &size) == noErr else { return nil }
+    var ids = [AudioDeviceID](repeating: 0, count: Int(size) / MemoryLayout<AudioDeviceID>.size)
+    guard AudioObjectGetPropertyData(system, &address, 0, nil, &size, &ids) == noErr else { return nil }
+
+    var partial: AudioDeviceID?
+    for id in ids where hasInputStreams(id) {
+        guard let name = deviceName(id) else { continue }
+        if name.caseInsensitiveCompare(wanted) == .orderedSame { return id }
+        if partial == nil && name.range(of: wanted, options: .caseInsensitive) != nil {
+            partial = id
+        }
+    }
+    return partial
+}
+
+final class Capture {
+    let ring: Ring
+    let target = AVAudioFormat(
+        commonFormat: .pcmFormatFloat32, sampleRate: sampleRate, channels: 1, interleaved: false)!
+    var engine: AVAudioEngine?
+
+    init(ring: Ring) {
+        self.ring = ring
+    }
+
+    func start(device: String?) -> String {
+        if engine != nil { return "START_ERROR 1 already capturing" }
+
+        // A fresh engine per session, so a device chosen last time doesn't stick
+        let engine = AVAudioEngine()
+        let input = engine.inputNode
+
+        if let device = device, !device.isEmpty, device.lowercased() != "default" {
+            guard var id = findInputDevice(named: device), let unit = input.audioUnit else {
+                return "START_ERROR 3 device not found"
+            }
+            let status = AudioUnitSetProperty(
+                unit, kAudioOutputUnitProperty_CurrentDevice, kAudioUnitScope_Global, 0, &id,
+                UInt32(MemoryLayout<AudioDeviceID>.size))
+            if status != noErr { return "START_ERROR 3 device unavailable \(status)" }
+        }
+
+        let inputFormat = input.outputFormat(forBus: 0)
+        guard inputFormat.sampleRate > 0, inputFormat.channelCount > 0,
+              let converter = AVAudioConverter(from: inputFormat, to: target)
+        else { return "START_ERROR 2 no input format" }
+
+        ring.session += 1
+        ring.firstSampleUs = 0
+        ring.writeIndex = 0
+        ring.capturing = true
+
+        let ratio = sampleRate / inputFormat.sampleRate
+        var first = true
+        input.installTap(onBus: 0, bufferSize: 1024, format: inputFormat) { [ring, target] buffer, time in
+            if first {
+                if time.isHostTimeValid { ring.firstSampleUs = hostTimeMicros(time.hostTime) }
+                first = false
+            }
+            let frames = AVAudioFrameCount(Double(buffer.frameLength) * ratio) + 32
+            guard let out = AVAudioPCMBuffer(pcmFormat: target, frameCapacity: frames) else { return }
+            var consumed = false
+            var error: NSError?
+            converter.convert(to: out, error: &error) { _, status in
+                if consumed {
+                    status.pointee = .noDataNow
+                    return nil
+                }
+                consumed = true
+                status.pointee = .haveData
+                return buffer
+            }
+            if error == nil, let channel = out.floatChannelData, out.frameLength > 0 {
+                ring.write(channel[0], count: Int(out.frameLength))
+            }
+        }
+
+        do {
+            engine.prepare()
+            try engine.start()
+        } catch {
+            input.removeTap(onBus: 0)
+            ring.capturing = false
+            return "START_ERROR 2 \(error.localizedDescription)"
+        }
+        self.engine = engine
+        return "START_OK \(ring.session) \(monotonicMicros())"
+    }
+
+    func stop() -> String {
+        guard let engine = engine else { return "STOP_ERROR 1 not capturing" }
+        engine.inputNode.removeTap(onBus: 0)
+        engine.stop()
+        self.engine = nil
+        ring.capturing = false
+        return "STOP_OK \(ring.session) \(ring.writeIndex) \(ring.firstSampleUs)"
+    }
+
+    func vad() -> String {
+        let count = ring.writeIndex
+        if count > UInt64(ring.capacity) { return "VAD_ERROR 2 session is longer than the ring" }
+
+        // Sessions start at slot 0, so while they fit the ring they are contiguous
+        var segments = [VadSegment](repeating: VadSegment(), count: maxVadSegments)
+        let found = vad_segments(ring.samples, Int(count), &segments, Int32(maxVadSegments))
+        if found < 0 { return "VAD_ERROR 1 out of memory" }
+        let ranges = segments.prefix(Int(found)).map { " \($0.start):\($0.end)" }.joined()
+        return "VAD_OK \(count) \(found)\(ranges)"
+    }
+
+    func status() -> String {
+        return "STATUS_OK \(engine != nil ? 1 : 0) \(ring.session) \(ring.writeIndex)"
+    }
+}
+
+let arguments = CommandLine.arguments
+func argument(_ flag: String) -> String? {
+    guard let index = arguments.firstIndex(of: flag), index + 1 < arguments.count else { return nil }
+    return arguments[index + 1]
+}
+
+let capacity = argument("--capacity").flatMap { Int($0) } ?? defaultCapacity
+guard let ringPath = argument("--ring"), capacity > 0, capacity & (capacity - 1) == 0 else {
+    FileHandle.standardError.write("Usage: macos-audio-capture --ring PATH [--capacity POWER_OF_TWO]\n".data(using: .utf8)!)
+    exit(1)
+}
+guard let ring = Ring(path: ringPath, capacity: capacity) else {
+    FileHandle.standardError.write("Failed to map ring \(ringPath)\n".data(using: .utf8)!)
+    exit(2)
+}
+
+let capture = Capture(ring: ring)
+print("READY")
+fflush(stdout)
+
+while let line = readLine() {
+    let command = line.trimmingCharacters(in: .whitespaces)
+    if command.isEmpty { continue }
+    if command == "QUIT" { break }
+
+    let reply: String
+    if command == "START" || command.hasPrefix("START ") {
+        let prefix = "START --device "
+        let device = command.hasPrefix(prefix) ? String(command.dropFirst(prefix.count)) : nil
+        reply = capture.start(device: device)
+    } else if command == "STOP" {
+        reply = capture.stop()
+    } else if command == "VAD" {
+        reply = capture.vad()
+    } else if command == "STATUS" {
+        reply = capture.status()
+    } else {
+        reply = "ERROR unknown command \(command)"
+    }
+    print(reply)
+    fflush(stdout)
+}
+
+_ = capture.stop()
+munmap(ring.base, ring.mapSize)
+unlink(ringPath)
+exit(0)
@@ -1,17 +1,353 @@
 import Cocoa
 
+// Accessibility trust is checked once, also in --server mode: the resident
+// helper exits before READY when untrusted, and callers fall back.
 if !AXIsProcessTrusted() {
     exit(2)
 }
 
-guard let keyDown = CGEvent(keyboardEventSource: nil, virtualKey: 0x09, keyDown: true),
-      let keyUp = CGEvent(keyboardEventSource: nil, virtualKey: 0x09, keyDown: false) else {
+// A private event source keeps keys the user is still physically holding
+// (e.g. push-to-talk modifiers) out of the synthesized events
+let eventSource = CGEventSource(stateID: .privateState)
+
+func monotonicMicros() -> UInt64 {
+    return clock_gettime_nsec_np(CLOCK_UPTIME_RAW) / 1000
+}
+
+func post(_ keyDown: CGEvent?, _ keyUp: CGEvent?) -> Bool {
+    guard let keyDown = keyDown, let keyUp = keyUp else { return false }
+    keyDown.post(tap: .cgSessionEventTap)
+    keyUp.post(tap: .cgSessionEventTap)
+    return true
+}
+
+func pressKey(_ virtualKey: CGKeyCode) -> Bool {
+    return post(CGEvent(keyboardEventSource: eventSource, virtualKey: virtualKey, keyDown: true),
+                CGEvent(keyboardEventSource: eventSource, virtualKey: virtualKey, keyDown: false))
+}
+
+// Type text with Unicode keyboard events instead of pasting, leaving the
+// clipboard untouched. CGEventKeyboardSetUnicodeString only delivers the first
+// 20 UTF-16 units of an event reliably, so the text is sent in chunks of that
+// size; newlines go out as the Return key. backspace erases that many
+// characters first (live streaming transcripts). Returns the number of
+// characters typed, or nil if an event could not be created.
+func typeText(_ text: String, backspace: Int) -> Int? {
+    let maxChunk = 20
+    var typed = 0
+
+    func flush(_ units: [UniChar]) -> Bool {
+        if units.isEmpty { return true }
+        let keyDown = CGEvent(keyboardEventSource: eventSource, virtualKey: 0, keyDown: true)
+        let keyUp = CGEvent(keyboardEventSource: eventSource, virtualKey: 0, keyDown: false)
+        units.withUnsafeBufferPointer { buffer in
+            keyDown?.keyboardSetUnicodeString(stringLength: buffer.count, unicodeString: buffer.baseAddress)
+            keyUp?.keyboardSetUnicodeString(stringLength: buffer.count, unicodeString: buffer.baseAddress)
+        }
+        return post(keyDown, keyUp)
+    }
+
+    for _ in 0..<max(backspace, 0) {
+        if !pressKey(0x33) { return nil }
+    }
+
+    var chunk: [UniChar] = []
+    for character in text {
+        if character == "\r" { continue }
+        if character == "\n" || character == "\r\n" {
+            if !flush(chunk) { return nil }
+            chunk.removeAll()
+            if !pressKey(0x24) { return nil }
+            typed += 1
+            continue
+        }
+        // Keep grapheme clusters (emoji, combining marks) within one event
+        let units = Array(String(character).utf16)
+        if chunk.count + units.count > maxChunk {
+            if !flush(chunk) { return nil }
+            chunk.removeAll()
+        }
+        chunk.append(contentsOf: units)
+        typed += 1
+    }
+    if !flush(chunk) { return nil }
+    return typed
+}
+
+func optionValue(_ arguments: [String], _ name: String) -> Int? {
+    guard let index = arguments.firstIndex(of: name), index + 1 < arguments.count else { return nil }
+    return Int(arguments[index + 1])
+}
+
+// Cmd+V, built once and reposted for every paste
+guard let pasteDown = CGEvent(keyboardEventSource: eventSource, virtualKey: 0x09, keyDown: true),
+      let pasteUp = CGEvent(keyboardEventSource: eventSource, virtualKey: 0x09, keyDown: false) else {
     exit(1)
 }
+pasteDown.flags = .maskCommand
+pasteUp.flags = .maskCommand
+
+func postPaste() {
+    pasteDown.post(tap: .cgSessionEventTap)
+    usleep(8000)
+    pasteUp.post(tap: .cgSessionEventTap)
+}
+
+// --server: stay resident and answer one reply line per stdin command, after
+// a READY line (the NativeHelperDaemon protocol shared with the Windows and
+// Linux helpers):
+//
+//   DETECT                        -> DETECT_OK <pid> <bundle-id|->
+//   PASTE [--pid P] [--timeout MS] [--consume-timeout MS]
+//                                 -> PASTE_OK <elapsed_us> <focus_wait_us> <start_us>
+//                                    [<consumed_us|-1> <pasteboard_changed 0|1>]
+//   TYPE_TEXT <bytes> [--backspace N] + <bytes> of UTF-8 -> TYPE_OK <chars>
+//   QUIT
+//
+// A TYPE_TEXT of more than maxTypeTextBytes is TYPE_ERROR 11, refused before
+// anything is read or allocated; the server then exits, since the payload
+// can't be skipped without trusting its byte count.
+//
+// Instead of a fixed pre-paste delay, PASTE waits for an NSWorkspace
+// activation of app P (or, without --pid, of any app other than our parent)
+// and posts the moment it arrives. --timeout caps the wait; the paste is
+// posted anyway when it expires, as the old fixed delay did. Cmd+V goes out
+// right after the focus wait; start_us is the command's arrival on
+// CLOCK_UPTIME_RAW (process.hrtime's clock), so the caller can place these
+// on its latency trace.
+//
+// With --consume-timeout the reply is held until the paste has landed (see
+// ConsumeWatch), so the caller can restore the clipboard right away instead
+// of after a fixed delay.
+
+// Watches for a posted paste to be consumed: an accessibility value or
+// selection change on the target's focused element means the text went in.
+// Apps without accessibility support (many terminals, some Electron apps)
+// never send these, so the timeout is the fallback. A changeCount bump means
+// someone else wrote the pasteboard meanwhile, and restoring it would clobber
+// their content.
+final class ConsumeWatch {
+    private var observer: AXObserver?
+    private var poll: Timer?
+    private var done: ((_ consumedUs: Int64, _ pasteboardChanged: Bool) -> Void)?
+    private let changeCount = NSPasteboard.general.changeCount
+    private var commandStart: UInt64 = 0
+
+    // Subscribes before the paste is posted, so its notification can't be missed
+    init(pid: pid_t) {
+        guard pid > 0 else { return }
+        let app = AXUIElementCreateApplication(pid)
+        // A hung target must not stall the paste
+        AXUIElementSetMessagingTimeout(app, 0.05)
+        var focused: CFTypeRef?
+        guard AXUIElementCopyAttributeValue(app, kAXFocusedUIElementAttribute as CFString, &focused) == .success,
+              let focused = focused, CFGetTypeID(focused) == AXUIElementGetTypeID() else { return }
+        let element = focused as! AXUIElement
+
+        var created: AXObserver?
+        let callback: AXObserverCallback = { _, _, _, refcon in
+            guard let refcon = refcon else { return }
+            Unmanaged<ConsumeWatch>.fromOpaque(refcon).takeUnretainedValue().finish(consumed: true)
+        }
+        guard AXObserverCreate(pid, callback, &created) == .success, let observer = created else { return }
+
+        let refcon = Unmanaged.passUnretained(self).toOpaque()
+        var subscribed = false
+        for name in [kAXValueChangedNotification, kAXSelectedTextChangedNotification] {
+            if AXObserverAddNotification(observer, element, name as CFString, refcon) == .success {
+                subscribed = true
+            }
+        }
+        guard subscribed else { return }
+        CFRunLoopAddSource(CFRunLoopGetMain(), AXObserverGetRunLoopSource(observer), .defaultMode)
+        self.observer = observer
+    }
+
+    // consumedUs is reported relative to start, the PASTE command's arrival
+    func start(since start: UInt64, timeoutMs: Int, done: @escaping (Int64, Bool) -> Void) {
+        commandStart = start
+        self.done = done
+        // NSPasteboard has no change notification, so poll its counter
+        poll = Timer.scheduledTimer(withTimeInterval: 0.01, repeats: true) { [weak self] _ in
+            guard let self = self else { return }
+            if NSPasteboard.general.changeCount != self.changeCount {
+                self.finish(consumed: false, pasteboardChanged: true)
+            }
+        }
+        DispatchQueue.main.asyncAfter(deadline: .now() + .milliseconds(timeoutMs)) { [weak self] in
+            self?.finish(consumed: false)
+        }
+    }
+
+    func finish(consumed: Bool, pasteboardChanged: Bool = false) {
+        guard let done = done else { return }
+        self.done = nil
+        poll?.invalidate()
+        poll = nil
+        if let observer = observer {
+            CFRunLoopRemoveSource(CFRunLoopGetMain(), AXObserverGetRunLoopSource(observer), .defaultMode)
+        }
+        observer = nil
+        done(consumed ? Int64(monotonicMicros() - commandStart) : -1, pasteboardChanged)
+    }
+}
+
+final class PasteServer {
+    private var frontmostPid: pid_t
+    private let parentPid = getppid()
+    private var pending: (targetPid: pid_t?, start: UInt64, consumeTimeoutMs: Int?, reply: (String) -> Void)?
+    private var pendingGeneration = 0
+    private var watch: ConsumeWatch?
+
+    init() {
+        frontmostPid = NSWorkspace.shared.frontmostApplication?.processIdentifier ?? 0
+        NSWorkspace.shared.notificationCenter.addObserver(
+            forName: NSWorkspace.didActivateApplicationNotification,
+            object: nil,
+            queue: .main
+        ) { [weak self] notification in
+            let app = notification.userInfo?[NSWorkspace.applicationUserInfoKey] as? NSRunningApplication
+            self?.frontmostPid = app?.processIdentifier ?? 0
+            self?.completePendingPaste(timedOut: false)
+        }
+    }
+
+    private func isTargetFrontmost(_ targetPid: pid_t?) -> Bool {
+        if let targetPid = targetPid { return frontmostPid == targetPid }
+        return frontmostPid != 0 && frontmostPid != parentPid
+    }
+
+    private func completePendingPaste(timedOut: Bool) {
+        guard let request = pending else { return }
+        if !timedOut && !isTargetFrontmost(request.targetPid) { return }
+        pending = nil
+        paste(start: request.start, consumeTimeoutMs: request.consumeTimeoutMs, reply: request.reply)
+    }
+
+    private func paste(start: UInt64, consumeTimeoutMs: Int?, reply: @escaping (String) -> Void) {
+        let focusWaitUs = monotonicMicros() - start
+        guard let consumeTimeoutMs = consumeTimeoutMs else {
+            postPaste()
+            reply("PASTE_OK \(monotonicMicros() - start) \(focusWaitUs) \(start)")
+            return
+        }
+
+        let watch = ConsumeWatch(pid: frontmostPid)
+        self.watch = watch
+        postPaste()
+        let postedAt = monotonicMicros()
+        watch.start(since: start, timeoutMs: max(consumeTimeoutMs, 0)) { [weak self] consumedUs, changed in
+            self?.watch = nil
+            reply("PASTE_OK \(postedAt - start) \(focusWaitUs) \(start) \(consumedUs) \(changed ? 1 : 0)")
+        }
+    }
+
+    // Runs on the main queue; reply is called exactly once
+    func handle(_ line: String, payload: Data?, reply: @escaping (String) -> Void) {
+        let arguments = line.split(separator: " ").map(String.init)
+        switch arguments.first {
+        case "DETECT"?:
+            let app = NSWorkspace.shared.frontmostApplication
+            let pid = app?.processIdentifier ?? frontmostPid
+            reply("DETECT_OK \(pid) \(app?.bundleIdentifier ?? "-")")
+
+        case "PASTE"?:
+            let start = monotonicMicros()
+            let targetPid = optionValue(arguments, "--pid").map { pid_t($0) }
+            let consumeTimeoutMs = optionValue(arguments, "--consume-timeout")
+            if isTargetFrontmost(targetPid) {
+                paste(start: start, consumeTimeoutMs: consumeTimeoutMs, reply: reply)
+                return
+            }
+            pendingGeneration += 1
+            let generation = pendingGeneration
+            pending = (targetPid, start, consumeTimeoutMs, reply)
+            let timeoutMs = max(optionValue(arguments, "--timeout") ?? 120, 0)
+            DispatchQueue.main.asyncAfter(deadline: .now() + .milliseconds(timeoutMs)) {
+                if generation == self.pendingGeneration {
+                    self.completePendingPaste(timedOut: true)
+                }
+            }
+
+        case "TYPE_TEXT"?:
+            let text = String(decoding: payload ?? Data(), as: UTF8.self)
+            if let typed = typeText(text, backspace: optionValue(arguments, "--backspace") ?? 0) {
+                reply("TYPE_OK \(typed)")
+            } else {
+                reply("TYPE_ERROR 1")
+            }
+
+        case "QUIT"?:
+            exit(0)
+
+        default:
+            reply("ERROR unknown command")
+        }
+    }
+}
+
+let maxTypeTextBytes = 1024 * 1024
+let arguments = CommandLine.arguments
+
+if arguments.contains("--server") {
+    // Connects to the window server so NSWorkspace activation notifications
+    // arrive, without ever showing up as an app
+    NSApplication.shared.setActivationPolicy(.prohibited)
+    let server = PasteServer()
+
+    // stdin is read on its own thread; each command runs on the main queue
+    // (where the notifications land) and the next is read once it replied
+    Thread.detachNewThread {
+        while let line = readLine() {
+            let command = line.trimmingCharacters(in: .whitespaces)
+            if command.isEmpty { continue }
+
+            var payload: Data?
+            let fields = command.split(separator: " ")
+            if fields.first == "TYPE_TEXT" {
+                let size = fields.count > 1 ? Int(fields[1]) ?? -1 : -1
+                if size > maxTypeTextBytes {
+                    print("TYPE_ERROR 11 payload too large")
+                    fflush(stdout)
+                    exit(1)
+                }
+                var bytes = [UInt8](repeating: 0, count: max(size, 0))
+                if size < 0 || fread(&bytes, 1, bytes.count, stdin) != bytes.count {
+                    exit(1)
+                }
+                payload = Data(bytes)
+            }
+
+            let replied = DispatchSemaphore(value: 0)
+            DispatchQueue.main.async {
+                server.handle(command, payload: payload) { reply in
+                    print(reply)
+                    fflush(stdout)
+                    replied.signal()
+                }
+            }
+            replied.wait()
+        }
+        exit(0)
+    }
+
+    print("READY")
+    fflush(stdout)
+    CFRunLoopRun()
+    exit(0)
+}
+
+// --type: one-shot typing of UTF-8 text read from stdin (see typeText)
+if arguments.contains("--type") {
+    let data = FileHandle.standardInput.readDataToEndOfFile()
+    let text = String(decoding: data, as: UTF8.self)
+    guard let typed = typeText(text, backspace: optionValue(arguments, "--backspace") ?? 0) else {
+        exit(1)
+    }
+    usleep(20000)
+    print("TYPE_OK \(typed)")
+    exit(0)
+}
 
-keyDown.flags = .maskCommand
-keyUp.flags = .maskCommand
-keyDown.post(tap: .cgSessionEventTap)
-usleep(8000)
-keyUp.post(tap: .cgSessionEventTap)
+postPaste()
 usleep(20000)
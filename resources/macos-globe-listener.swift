@@ -1,82 +1,392 @@
+import Carbon.HIToolbox
 import Cocoa
 import Foundation
 import Darwin
 
-let mask = CGEventMask(1 << CGEventType.flagsChanged.rawValue)
+// Globe and the modifier reports only need flagsChanged. keyDown/keyUp are
+// tapped separately, and only once a binding needs an ordinary key, so the
+// listener keeps working (and asks for nothing more) without bindings.
+let flagsMask = CGEventMask(1 << CGEventType.flagsChanged.rawValue)
+let keyMask = CGEventMask(1 << CGEventType.keyDown.rawValue)
+    | CGEventMask(1 << CGEventType.keyUp.rawValue)
 var fnIsDown = false
 var eventTap: CFMachPort?
+var keyTap: CFMachPort?
 var lastModifierFlags: CGEventFlags = []
 
+// --binary-events: emit fixed 16-byte records instead of text lines, laid out
+// as in src/helpers/nativeEventStream.js. Key ids: 0 Globe, 1-4 the right
+// modifiers below, 16 + slot for bindings; MODIFIER_UP ids: 1-4 the release
+// names below.
+let binaryEvents = CommandLine.arguments.contains("--binary-events")
+let recordKeyDown: UInt8 = 1
+let recordKeyUp: UInt8 = 2
+let recordModifierUp: UInt8 = 3
+let bindingKeyIdBase: UInt8 = 16
+
+// All stdout writes happen on this queue, never in the tap callback, so a
+// slow reader cannot hold the callback long enough for tapDisabledByTimeout.
+// FileHandle writes are unbuffered, so no fflush is needed.
+let writerQueue = DispatchQueue(label: "openwhispr.globe-listener.writer", qos: .userInteractive)
+
+func writeLine(_ line: String) {
+    writerQueue.async {
+        FileHandle.standardOutput.write(Data("\(line)\n".utf8))
+    }
+}
+
+func emit(_ line: String, type: UInt8, keyId: UInt8, timestamp: CGEventTimestamp) {
+    guard binaryEvents else {
+        writeLine(line)
+        return
+    }
+    // Hardware event time, and callback time on CLOCK_UPTIME_RAW, the
+    // mach_absolute_time clock behind Node's process.hrtime
+    let eventMs = UInt32(truncatingIfNeeded: timestamp / 1_000_000)
+    let nowUs = UInt64(clock_gettime_nsec_np(CLOCK_UPTIME_RAW) / 1000)
+    writerQueue.async {
+        var record = [UInt8](repeating: 0, count: 16)
+        record[0] = 0xFE
+        record[1] = type
+        record[2] = keyId
+        for i in 0..<4 { record[4 + i] = UInt8(truncatingIfNeeded: eventMs >> (8 * UInt32(i))) }
+        for i in 0..<8 { record[8 + i] = UInt8(truncatingIfNeeded: nowUs >> (8 * UInt64(i))) }
+        FileHandle.standardOutput.write(Data(record))
+    }
+}
+
+// Lookup tables, built once so the callback allocates nothing to filter
+
+struct RightModifier {
+    let keyCode: Int
+    let flag: CGEventFlags
+    let keyId: UInt8
+    let downLine: String
+    let upLine: String
+}
+
+let rightModifiers: [RightModifier] = [
+    RightModifier(keyCode: kVK_RightOption, flag: .maskAlternate, keyId: 1,
+                  downLine: "RIGHT_MOD_DOWN:RightOption", upLine: "RIGHT_MOD_UP:RightOption"),
+    RightModifier(keyCode: kVK_RightCommand, flag: .maskCommand, keyId: 2,
+                  downLine: "RIGHT_MOD_DOWN:RightCommand", upLine: "RIGHT_MOD_UP:RightCommand"),
+    RightModifier(keyCode: kVK_RightControl, flag: .maskControl, keyId: 3,
+                  downLine: "RIGHT_MOD_DOWN:RightControl", upLine: "RIGHT_MOD_UP:RightControl"),
+    RightModifier(keyCode: kVK_RightShift, flag: .maskShift, keyId: 4,
+                  downLine: "RIGHT_MOD_DOWN:RightShift", upLine: "RIGHT_MOD_UP:RightShift"),
+]
+
+let modifierReleases: [(flag: CGEventFlags, line: String, keyId: UInt8)] = [
+    (.maskControl, "MODIFIER_UP:control", 1),
+    (.maskCommand, "MODIFIER_UP:command", 2),
+    (.maskAlternate, "MODIFIER_UP:option", 3),
+    (.maskShift, "MODIFIER_UP:shift", 4),
+]
+
+let modifierMask: CGEventFlags = [.maskControl, .maskCommand, .maskAlternate, .maskShift]
+
+// Bindings: extra hotkeys reported as KEY_DOWN:<id> / KEY_UP:<id>, added with
+// "--bind <id> <hotkey>" or the BIND / UNBIND commands on stdin.
+struct Binding {
+    var active = false
+    var id = ""
+    var keyCode = -1            // -1 for modifier-only hotkeys
+    var modifiers: CGEventFlags = []
+    var isDown = false
+    var downLine = ""
+    var upLine = ""
+}
+
+let maxBindings = 32
+var bindings = [Binding](repeating: Binding(), count: maxBindings)
+// Bit per binding slot: keyBindings for the keycode's keyDown/keyUp,
+// flagBindings for the bindings that a flagsChanged event can press or release
+var keyBindings = [UInt32](repeating: 0, count: 128)
+var flagBindings: UInt32 = 0
+
+let modifierNames: [String: CGEventFlags] = [
+    "command": .maskCommand, "cmd": .maskCommand,
+    "commandorcontrol": .maskCommand, "cmdorctrl": .maskCommand,
+    "super": .maskCommand, "meta": .maskCommand,
+    "control": .maskControl, "ctrl": .maskControl,
+    "alt": .maskAlternate, "option": .maskAlternate,
+    "shift": .maskShift,
+    "fn": .maskSecondaryFn,
+]
+
+let keyNames: [String: Int] = [
+    "a": kVK_ANSI_A, "b": kVK_ANSI_B, "c": kVK_ANSI_C, "d": kVK_ANSI_D, "e": kVK_ANSI_E,
+    "f": kVK_ANSI_F, "g": kVK_ANSI_G, "h": kVK_ANSI_H, "i": kVK_ANSI_I, "j": kVK_ANSI_J,
+    "k": kVK_ANSI_K, "l": kVK_ANSI_L, "m": kVK_ANSI_M, "n": kVK_ANSI_N, "o": kVK_ANSI_O,
+    "p": kVK_ANSI_P, "q": kVK_ANSI_Q, "r": kVK_ANSI_R, "s": kVK_ANSI_S, "t": kVK_ANSI_T,
+    "u": kVK_ANSI_U, "v": kVK_ANSI_V, "w": kVK_ANSI_W, "x": kVK_ANSI_X, "y": kVK_ANSI_Y,
+    "z": kVK_ANSI_Z,
+    "0": kVK_ANSI_0, "1": kVK_ANSI_1, "2": kVK_ANSI_2, "3": kVK_ANSI_3, "4": kVK_ANSI_4,
+    "5": kVK_ANSI_5, "6": kVK_ANSI_6, "7": kVK_ANSI_7, "8": kVK_ANSI_8, "9": kVK_ANSI_9,
+    "f1": kVK_F1, "f2": kVK_F2, "f3": kVK_F3, "f4": kVK_F4, "f5": kVK_F5, "f6": kVK_F6,
+    "f7": kVK_F7, "f8": kVK_F8, "f9": kVK_F9, "f10": kVK_F10, "f11": kVK_F11,
+    "f12": kVK_F12, "f13": kVK_F13, "f14": kVK_F14, "f15": kVK_F15, "f16": kVK_F16,
+    "f17": kVK_F17, "f18": kVK_F18, "f19": kVK_F19, "f20": kVK_F20,
+    "space": kVK_Space, "tab": kVK_Tab, "escape": kVK_Escape, "esc": kVK_Escape,
+    "return": kVK_Return, "enter": kVK_Return, "backspace": kVK_Delete,
+    "delete": kVK_ForwardDelete, "home": kVK_Home, "end": kVK_End,
+    "pageup": kVK_PageUp, "pagedown": kVK_PageDown, "up": kVK_UpArrow,
+    "down": kVK_DownArrow, "left": kVK_LeftArrow, "right": kVK_RightArrow,
+    "capslock": kVK_CapsLock,
+    "rightoption": kVK_RightOption, "rightalt": kVK_RightOption,
+    "rightcommand": kVK_RightCommand, "rightcmd": kVK_RightCommand,
+    "rightcontrol": kVK_RightControl, "rightctrl": kVK_RightControl,
+    "rightshift": kVK_RightShift,
+    "`": kVK_ANSI_Grave, "backquote": kVK_ANSI_Grave, "-": kVK_ANSI_Minus,
+    "minus": kVK_ANSI_Minus, "=": kVK_ANSI_Equal, "equal": kVK_ANSI_Equal,
+    "plus": kVK_ANSI_Equal, "[": kVK_ANSI_LeftBracket, "]": kVK_ANSI_RightBracket,
+    "\\": kVK_ANSI_Backslash, ";": kVK_ANSI_Semicolon, "'": kVK_ANSI_Quote,
+    ",": kVK_ANSI_Comma, ".": kVK_ANSI_Period, "/": kVK_ANSI_Slash,
+]
+
+// Flag a modifier key sets while held, or [] for ordinary keys
+func modifierFlag(forKeyCode keyCode: Int) -> CGEventFlags {
+    switch keyCode {
+    case kVK_Command, kVK_RightCommand: return .maskCommand
+    case kVK_Shift, kVK_RightShift: return .maskShift
+    case kVK_Option, kVK_RightOption: return .maskAlternate
+    case kVK_Control, kVK_RightControl: return .maskControl
+    case kVK_Function: return .maskSecondaryFn
+    default: return []
+    }
+}
+
+// Parse Electron-style hotkeys ("Command+Shift+K", "Control+Option", "F8")
+func parseHotkey(_ hotkey: String) -> (keyCode: Int, modifiers: CGEventFlags)? {
+    var keyCode = -1
+    var modifiers: CGEventFlags = []
+    for part in hotkey.split(separator: "+") {
+        let name = part.trimmingCharacters(in: .whitespaces).lowercased()
+        if name.isEmpty { continue }
+        if let flag = modifierNames[name] {
+            modifiers.insert(flag)
+        } else if let code = keyNames[name] {
+            keyCode = code
+        } else {
+            return nil
+        }
+    }
+    if keyCode < 0 && modifiers.isEmpty { return nil }
+    return (keyCode, modifiers)
+}
+
+func isValidBindingId(_ id: String) -> Bool {
+    return !id.isEmpty && id.utf8.count < 24 && !id.contains(" ") && !id.contains(":")
+}
+
+func rebuildBindingTables() {
+    for i in 0..<keyBindings.count { keyBindings[i] = 0 }
+    flagBindings = 0
+    for slot in 0..<maxBindings where bindings[slot].active {
+        let bit = UInt32(1) << UInt32(slot)
+        let keyCode = bindings[slot].keyCode
+        if keyCode >= 0 && keyCode < keyBindings.count && modifierFlag(forKeyCode: keyCode).isEmpty {
+            keyBindings[keyCode] |= bit
+        }
+        if keyCode < 0 || !bindings[slot].modifiers.isEmpty || !modifierFlag(forKeyCode: keyCode).isEmpty {
+            flagBindings |= bit
+        }
+    }
+}
+
+func setBinding(_ slot: Int, down: Bool, timestamp: CGEventTimestamp) {
+    bindings[slot].isDown = down
+    emit(down ? bindings[slot].downLine : bindings[slot].upLine,
+         type: down ? recordKeyDown : recordKeyUp,
+         keyId: bindingKeyIdBase + UInt8(slot),
+         timestamp: timestamp)
+}
+
+func currentTimestamp() -> CGEventTimestamp {
+    return CGEventTimestamp(clock_gettime_nsec_np(CLOCK_UPTIME_RAW))
+}
+
+// keyDown/keyUp can only be tapped with Input Monitoring permission, so the
+// tap is created the first time a binding needs it
+func ensureKeyTap() -> Bool {
+    if keyTap != nil { return true }
+    guard let tap = CGEvent.tapCreate(tap: .cgSessionEventTap,
+                                      place: .headInsertEventTap,
+                                      options: .listenOnly,
+                                      eventsOfInterest: keyMask,
+                                      callback: eventTapCallback,
+                                      userInfo: nil) else {
+        return false
+    }
+    let source = CFMachPortCreateRunLoopSource(kCFAllocatorDefault, tap, 0)
+    CFRunLoopAddSource(CFRunLoopGetMain(), source, .commonModes)
+    CGEvent.tapEnable(tap: tap, enable: true)
+    keyTap = tap
+    return true
+}
+
+// Errors are "<COMMAND>_ERROR <code> <message>" with the codes of
+// windows-key-listener: 1 invalid id or hotkey, 2 too many bindings,
+// 3 unknown binding, 4 key events unavailable (no Input Monitoring permission)
+func bind(id: String, hotkey: String) -> String {
+    guard isValidBindingId(id) else { return "BIND_ERROR 1 invalid binding id" }
+    guard let parsed = parseHotkey(hotkey) else { return "BIND_ERROR 1 invalid hotkey" }
+    if parsed.keyCode >= 0 && modifierFlag(forKeyCode: parsed.keyCode).isEmpty && !ensureKeyTap() {
+        return "BIND_ERROR 4 key events unavailable (no Input Monitoring permission)"
+    }
+    let existing = bindings.firstIndex { $0.active && $0.id == id }
+    guard let slot = existing ?? bindings.firstIndex(where: { !$0.active }) else {
+        return "BIND_ERROR 2 too many bindings"
+    }
+    // Replacing a held binding must not leave its press open
+    if bindings[slot].isDown { setBinding(slot, down: false, timestamp: currentTimestamp()) }
+    bindings[slot] = Binding(active: true, id: id, keyCode: parsed.keyCode,
+                             modifiers: parsed.modifiers, isDown: false,
+                             downLine: "KEY_DOWN:\(id)", upLine: "KEY_UP:\(id)")
+    rebuildBindingTables()
+    return "BIND_OK \(id) \(slot)"
+}
+
+func unbind(id: String) -> String {
+    guard let slot = bindings.firstIndex(where: { $0.active && $0.id == id }) else {
+        return "UNBIND_ERROR 3 unknown binding"
+    }
+    if bindings[slot].isDown { setBinding(slot, down: false, timestamp: currentTimestamp()) }
+    bindings[slot] = Binding()
+    rebuildBindingTables()
+    return "UNBIND_OK \(id)"
+}
+
+func handleCommand(_ line: String) {
+    let parts = line.split(separator: " ", maxSplits: 2).map(String.init)
+    switch parts.first {
+    case "BIND"? where parts.count == 3:
+        writeLine(bind(id: parts[1], hotkey: parts[2]))
+    case "UNBIND"? where parts.count >= 2:
+        writeLine(unbind(id: parts[1]))
+    default:
+        writeLine("ERROR unknown command")
+    }
+}
+
+func updateKeyBindings(_ candidates: UInt32, isDown: Bool, flags: CGEventFlags,
+                       timestamp: CGEventTimestamp) {
+    var remaining = candidates
+    while remaining != 0 {
+        let slot = remaining.trailingZeroBitCount
+        remaining &= remaining - 1
+        if isDown {
+            if !bindings[slot].isDown && flags.isSuperset(of: bindings[slot].modifiers) {
+                setBinding(slot, down: true, timestamp: timestamp)
+            }
+        } else if bindings[slot].isDown {
+            setBinding(slot, down: false, timestamp: timestamp)
+        }
+    }
+}
+
+func updateFlagBindings(keyCode: Int, flags: CGEventFlags, timestamp: CGEventTimestamp) {
+    var remaining = flagBindings
+    while remaining != 0 {
+        let slot = remaining.trailingZeroBitCount
+        remaining &= remaining - 1
+        let satisfied = flags.isSuperset(of: bindings[slot].modifiers)
+        let bindingKey = bindings[slot].keyCode
+
+        // A required modifier released while the hotkey is held ends the press
+        if bindings[slot].isDown && !satisfied {
+            setBinding(slot, down: false, timestamp: timestamp)
+        } else if bindingKey < 0 {
+            // Modifier-only hotkey
+            if satisfied && !bindings[slot].isDown {
+                setBinding(slot, down: true, timestamp: timestamp)
+            }
+        } else if bindingKey == keyCode {
+            // The hotkey's own key is a modifier (e.g. "RightOption")
+            let pressed = flags.contains(modifierFlag(forKeyCode: keyCode))
+            if pressed && satisfied && !bindings[slot].isDown {
+                setBinding(slot, down: true, timestamp: timestamp)
+            } else if !pressed && bindings[slot].isDown {
+                setBinding(slot, down: false, timestamp: timestamp)
+            }
+        }
+    }
+}
+
 func eventTapCallback(proxy: CGEventTapProxy, type: CGEventType, event: CGEvent, refcon: UnsafeMutableRawPointer?) -> Unmanaged<CGEvent>? {
     if type == .tapDisabledByTimeout || type == .tapDisabledByUserInput {
         if let tap = eventTap {
             CGEvent.tapEnable(tap: tap, enable: true)
         }
+        if let tap = keyTap {
+            CGEvent.tapEnable(tap: tap, enable: true)
+        }
+        return Unmanaged.passUnretained(event)
+    }
+
+    let keyCode = Int(event.getIntegerValueField(.keyboardEventKeycode))
+
+    if type == .keyDown || type == .keyUp {
+        // Most keystrokes stop here: only keycodes a binding uses go further
+        guard keyCode >= 0 && keyCode < keyBindings.count else {
+            return Unmanaged.passUnretained(event)
+        }
+        let candidates = keyBindings[keyCode]
+        if candidates != 0 {
+            let isDown = type == .keyDown
+            // Autorepeat keyDowns repeat a press that was already reported
+            if !isDown || event.getIntegerValueField(.keyboardEventAutorepeat) == 0 {
+                updateKeyBindings(candidates, isDown: isDown, flags: event.flags,
+                                  timestamp: event.timestamp)
+            }
+        }
         return Unmanaged.passUnretained(event)
     }
 
     let flags = event.flags
+    let timestamp = event.timestamp
     let containsFn = flags.contains(.maskSecondaryFn)
 
     if containsFn && !fnIsDown {
         fnIsDown = true
-        FileHandle.standardOutput.write("FN_DOWN\n".data(using: .utf8)!)
-        fflush(stdout)
+        emit("FN_DOWN", type: recordKeyDown, keyId: 0, timestamp: timestamp)
     } else if !containsFn && fnIsDown {
         fnIsDown = false
-        FileHandle.standardOutput.write("FN_UP\n".data(using: .utf8)!)
-        fflush(stdout)
+        emit("FN_UP", type: recordKeyUp, keyId: 0, timestamp: timestamp)
     }
 
     // Detect right-side modifier key down/up via keycode
-    let keyCode = event.getIntegerValueField(.keyboardEventKeycode)
-    let rightModifiers: [(Int64, CGEventFlags, String)] = [
-        (61, .maskAlternate, "RightOption"),
-        (54, .maskCommand, "RightCommand"),
-        (62, .maskControl, "RightControl"),
-        (60, .maskShift, "RightShift"),
-    ]
-    for (code, flag, name) in rightModifiers {
-        if keyCode == code {
-            if flags.contains(flag) {
-                FileHandle.standardOutput.write("RIGHT_MOD_DOWN:\(name)\n".data(using: .utf8)!)
-            } else {
-                FileHandle.standardOutput.write("RIGHT_MOD_UP:\(name)\n".data(using: .utf8)!)
-            }
-            fflush(stdout)
-            break
+    for modifier in rightModifiers where modifier.keyCode == keyCode {
+        if flags.contains(modifier.flag) {
+            emit(modifier.downLine, type: recordKeyDown, keyId: modifier.keyId, timestamp: timestamp)
+        } else {
+            emit(modifier.upLine, type: recordKeyUp, keyId: modifier.keyId, timestamp: timestamp)
         }
+        break
     }
 
-    let modifierMask: CGEventFlags = [.maskControl, .maskCommand, .maskAlternate, .maskShift]
     let currentModifiers = flags.intersection(modifierMask)
 
     if currentModifiers != lastModifierFlags {
         let released = lastModifierFlags.subtracting(currentModifiers)
-        let releases: [(CGEventFlags, String)] = [
-            (.maskControl, "control"),
-            (.maskCommand, "command"),
-            (.maskAlternate, "option"),
-            (.maskShift, "shift"),
-        ]
-
-        for (flag, name) in releases {
-            if released.contains(flag) {
-                FileHandle.standardOutput.write("MODIFIER_UP:\(name)\n".data(using: .utf8)!)
-                fflush(stdout)
-            }
+        for release in modifierReleases where released.contains(release.flag) {
+            emit(release.line, type: recordModifierUp, keyId: release.keyId, timestamp: timestamp)
         }
 
         lastModifierFlags = currentModifiers
     }
 
+    if flagBindings != 0 {
+        updateFlagBindings(keyCode: keyCode, flags: flags, timestamp: timestamp)
+    }
+
     return Unmanaged.passUnretained(event)
 }
 
 guard let createdTap = CGEvent.tapCreate(tap: .cgSessionEventTap,
                                          place: .headInsertEventTap,
                                          options: .listenOnly,
-                                         eventsOfInterest: mask,
+                                         eventsOfInterest: flagsMask,
                                          callback: eventTapCallback,
                                          userInfo: nil) else {
     FileHandle.standardError.write("Failed to create event tap\n".data(using: .utf8)!)
@@ -89,6 +399,39 @@ let runLoopSource = CFMachPortCreateRunLoopSource(kCFAllocatorDefault, createdTa
 CFRunLoopAddSource(CFRunLoopGetCurrent(), runLoopSource, .commonModes)
 CGEvent.tapEnable(tap: createdTap, enable: true)
 
+var argIndex = 1
+while argIndex < CommandLine.arguments.count {
+    if CommandLine.arguments[argIndex] == "--bind" && argIndex + 2 < CommandLine.arguments.count {
+        let reply = bind(id: CommandLine.arguments[argIndex + 1],
+                         hotkey: CommandLine.arguments[argIndex + 2])
+        if !reply.hasPrefix("BIND_OK") {
+            FileHandle.standardError.write("Invalid binding: \(reply)\n".data(using: .utf8)!)
+            exit(1)
+        }
+        argIndex += 3
+    } else {
+        argIndex += 1
+    }
+}
+
+// Announces BIND / UNBIND support; older listeners never print this
+writeLine("FEATURES bind")
+
+// Commands arrive on stdin; they are applied on the main run loop, the tap's
+// thread, so the binding tables need no lock. The parent closing the pipe
+// means it is gone.
+var stdinStat = stat()
+if fstat(STDIN_FILENO, &stdinStat) == 0 && (stdinStat.st_mode & S_IFMT) == S_IFIFO {
+    Thread.detachNewThread {
+        while let line = readLine() {
+            let command = line.trimmingCharacters(in: .whitespaces)
+            if command.isEmpty { continue }
+            DispatchQueue.main.async { handleCommand(command) }
+        }
+        DispatchQueue.main.async { CFRunLoopStop(CFRunLoopGetMain()) }
+    }
+}
+
 let signalSource = DispatchSource.makeSignalSource(signal: SIGTERM, queue: .main)
 signal(SIGTERM, SIG_IGN)
 signalSource.setEventHandler {
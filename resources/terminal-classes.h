@@ -0,0 +1,148 @@
+/*
+ * Terminal window classes for the native paste helpers.
+ *
+ * GENERATED by scripts/lib/terminal-classes.js from
+ * src/config/terminalClasses.json - edit the list there, not this file.
+ *
+ * terminal_class_match() looks a class up in a perfect hash table (seeded
+ * FNV-1a over the ASCII-lowercased name) after applying the user overrides
+ * from OPENWHISPR_TERMINAL_CLASSES: a comma-separated list where "name"
+ * marks a class as a terminal and "!name" unmarks one. The overrides are
+ * read once, on the first lookup.
+ */
+
+#ifndef OPENWHISPR_TERMINAL_CLASSES_H
+#define OPENWHISPR_TERMINAL_CLASSES_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+/* Windows: 10 classes */
+#define TERMINAL_CLASS_HASH_SEED 0x811c9dc7u
+#define TERMINAL_CLASS_HASH_SIZE 64
+static const char *const terminal_class_slots[TERMINAL_CLASS_HASH_SIZE] = {
+    [2] = "alacritty",
+    [8] = "mintty",
+    [10] = "tmobaxterm",
+    [13] = "virtualconsoleclass",
+    [31] = "cascadia_hosting_window_class",
+    [35] = "hyper",
+    [42] = "kitty",
+    [44] = "org.wezfurlong.wezterm",
+    [51] = "putty",
+    [56] = "consolewindowclass",
+};
+#else
+/* Linux: 45 classes */
+#define TERMINAL_CLASS_HASH_SEED 0x811c9e0bu
+#define TERMINAL_CLASS_HASH_SIZE 256
+static const char *const terminal_class_slots[TERMINAL_CLASS_HASH_SIZE] = {
+    [2] = "urxvt",
+    [7] = "hyper",
+    [8] = "org.wezfurlong.wezterm",
+    [11] = "rxvt",
+    [22] = "alacritty",
+    [29] = "deepin-terminal",
+    [39] = "terminal",
+    [41] = "tilix",
+    [45] = "ghostty",
+    [56] = "yakuake",
+    [64] = "com.mitchellh.ghostty",
+    [66] = "terminology",
+    [87] = "tilda",
+    [91] = "lxterminal",
+    [98] = "ptyxis",
+    [99] = "xterm",
+    [102] = "kitty",
+    [132] = "uxterm",
+    [135] = "kgx",
+    [136] = "cool-retro-term",
+    [137] = "com.raggesilver.blackbox",
+    [148] = "st",
+    [150] = "guake",
+    [152] = "gnome-terminal",
+    [154] = "xfce4-terminal",
+    [157] = "io.elementary.terminal",
+    [164] = "gnome-terminal-server",
+    [165] = "mate-terminal",
+    [167] = "contour",
+    [175] = "wezterm-gui",
+    [178] = "sakura",
+    [180] = "org.gnome.ptyxis",
+    [185] = "wezterm",
+    [187] = "rio",
+    [190] = "org.gnome.console",
+    [198] = "terminator",
+    [203] = "st-256color",
+    [206] = "qterminal",
+    [213] = "warp",
+    [223] = "blackbox",
+    [227] = "foot",
+    [234] = "dev.warp.warp",
+    [235] = "tabby",
+    [244] = "footclient",
+    [248] = "konsole",
+};
+#endif
+
+#define TERMINAL_CLASS_MAX_OVERRIDES 32
+
+static char terminal_override_buffer[1024];
+static const char *terminal_overrides[TERMINAL_CLASS_MAX_OVERRIDES];
+static int terminal_override_count = -1;
+
+static int terminal_class_equal(const char *a, const char *b) {
+    for (;; a++, b++) {
+        unsigned char ca = (unsigned char)*a, cb = (unsigned char)*b;
+        if (ca >= 'A' && ca <= 'Z') ca += 'a' - 'A';
+        if (cb >= 'A' && cb <= 'Z') cb += 'a' - 'A';
+        if (ca != cb) return 0;
+        if (!ca) return 1;
+    }
+}
+
+static void terminal_class_load_overrides(void) {
+    terminal_override_count = 0;
+    const char *value = getenv("OPENWHISPR_TERMINAL_CLASSES");
+    if (!value) return;
+
+    snprintf(terminal_override_buffer, sizeof(terminal_override_buffer), "%s", value);
+    char *p = terminal_override_buffer;
+    while (*p && terminal_override_count < TERMINAL_CLASS_MAX_OVERRIDES) {
+        while (*p == ',' || *p == ' ') p++;
+        char *start = p;
+        while (*p && *p != ',') p++;
+        char *end = p;
+        if (*p) p++;
+        while (end > start && end[-1] == ' ') end--;
+        *end = '\0';
+        if (*start) terminal_overrides[terminal_override_count++] = start;
+    }
+}
+
+static int terminal_class_in_table(const char *name) {
+    unsigned int hash = TERMINAL_CLASS_HASH_SEED;
+    for (const char *p = name; *p; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        hash = (hash ^ c) * 0x01000193u;
+    }
+    const char *slot = terminal_class_slots[hash & (TERMINAL_CLASS_HASH_SIZE - 1)];
+    return slot && terminal_class_equal(name, slot);
+}
+
+/* 1 if name is a terminal window class, 0 otherwise (NULL and "" included) */
+static int terminal_class_match(const char *name) {
+    if (!name || !*name) return 0;
+    if (terminal_override_count < 0) terminal_class_load_overrides();
+    for (int i = 0; i < terminal_override_count; i++) {
+        const char *entry = terminal_overrides[i];
+        int negated = entry[0] == '!';
+        if (terminal_class_equal(name, entry + negated)) return !negated;
+    }
+    return terminal_class_in_table(name);
+}
+
+#endif /* OPENWHISPR_TERMINAL_CLASSES_H */
@@ -0,0 +1,434 @@
+/**
+ * Windows Audio Capture for OpenWhispr
+ *
+ * Records the microphone through WASAPI shared mode as 16 kHz mono float32
+ * into a file-backed shared-memory ring, so local transcription can skip the
+ * MediaRecorder webm -> ffmpeg -> WAV round trip. The audio engine does the
+ * resampling and downmix (AUDCLNT_STREAMFLAGS_AUTOCONVERTPCM).
+ *
+ * Usage: windows-audio-capture.exe --ring PATH [--capacity SAMPLES]
+ *
+ * Prints READY once the ring is mapped, then answers one line per command,
+ * the same protocol as linux-audio-capture:
+ *   START [--device NAME]  -> START_OK <session> <start_us>
+ *   STOP                   -> STOP_OK <session> <samples> <first_sample_us>
+ *   STATUS                 -> STATUS_OK <capturing> <session> <samples>
+ *   VAD                    -> VAD_OK <samples> <count> <start>:<end> ...
+ *   QUIT
+ * NAME is matched against endpoint friendly names, which are the labels
+ * Chromium shows for the same devices. Times are QueryPerformanceCounter
+ * microseconds, the clock the other Windows helpers report on.
+ *
+ * The ring layout is documented in linux-audio-capture.c, the VAD in
+ * audio-vad.h.
+ *
+ * Compile with: cl /O2 windows-audio-capture.c /Fe:windows-audio-capture.exe ole32.lib shell32.lib
+ * Or with MinGW: gcc -O2 windows-audio-capture.c -o windows-audio-capture.exe -lole32 -lshell32
+ */
+
+#define COBJMACROS
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <objbase.h>
+#include <mmdeviceapi.h>
+#include <audioclient.h>
+#include <propsys.h>
+#include <shellapi.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <wchar.h>
+
+#include "audio-vad.h"
+
+#ifndef AUDCLNT_STREAMFLAGS_AUTOCONVERTPCM
+#define AUDCLNT_STREAMFLAGS_AUTOCONVERTPCM 0x80000000
+#endif
+#ifndef AUDCLNT_STREAMFLAGS_SRC_DEFAULT_QUALITY
+#define AUDCLNT_STREAMFLAGS_SRC_DEFAULT_QUALITY 0x08000000
+#endif
+
+/* Declared locally so the helper links against ole32 alone */
+static const CLSID CLSID_MMDeviceEnumerator_ = {
+    0xBCDE0395, 0xE52F, 0x467C, {0x8E, 0x3D, 0xC4, 0x57, 0x92, 0x91, 0x69, 0x2E}};
+static const IID IID_IMMDeviceEnumerator_ = {
+    0xA95664D2, 0x9614, 0x4F35, {0xA7, 0x46, 0xDE, 0x8D, 0xB6, 0x36, 0x17, 0xE6}};
+static const IID IID_IAudioClient_ = {
+    0x1CB9AD4C, 0xDBFA, 0x4C32, {0xB1, 0x78, 0xC2, 0xF5, 0x68, 0xA7, 0x03, 0xB2}};
+static const IID IID_IAudioCaptureClient_ = {
+    0xC8ADBD64, 0xE71E, 0x48A0, {0xA4, 0xDE, 0x18, 0x5C, 0x39, 0x5C, 0xD3, 0x17}};
+static const PROPERTYKEY PKEY_Device_FriendlyName_ = {
+    {0xA45C254E, 0xDF1C, 0x4EFD, {0x80, 0x20, 0x67, 0xD1, 0x46, 0xA8, 0x50, 0xE0}}, 14};
+
+#define RING_VERSION 1
+#define SAMPLE_RATE 16000
+#define DEFAULT_CAPACITY (1u << 23) /* ~8.7 minutes at 16 kHz */
+#define BUFFER_DURATION_HNS 1000000 /* 100 ms engine buffer */
+#define MAX_VAD_SEGMENTS 128
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t sampleRate;
+    uint32_t channels;
+    uint32_t capacity;
+    uint32_t session;
+    volatile LONG64 writeIndex;
+    uint64_t firstSampleUs;
+    volatile LONG capturing;
+    uint8_t reserved[20];
+} RingHeader;
+
+static RingHeader* g_header = NULL;
+static float* g_samples = NULL;
+
+static IMMDeviceEnumerator* g_enumerator = NULL;
+static IAudioClient* g_client = NULL;
+static IAudioCaptureClient* g_capture = NULL;
+static HANDLE g_bufferEvent = NULL;
+static HANDLE g_thread = NULL;
+static volatile LONG g_stopRequested = 0;
+
+static LARGE_INTEGER g_qpcFrequency;
+
+/* Same conversion as windows-paste-core.h, split so the multiply cannot overflow */
+static long long QpcTicksToMicros(LONGLONG ticks) {
+    if (g_qpcFrequency.QuadPart == 0) QueryPerformanceFrequency(&g_qpcFrequency);
+    return (long long)(ticks / g_qpcFrequency.QuadPart * 1000000LL +
+                       ticks % g_qpcFrequency.QuadPart * 1000000LL / g_qpcFrequency.QuadPart);
+}
+
+static long long MonotonicMicros(void) {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return QpcTicksToMicros(now.QuadPart);
+}
+
+static BOOL OpenRing(const wchar_t* path, uint32_t capacity) {
+    ULONGLONG size = sizeof(RingHeader) + (ULONGLONG)capacity * sizeof(float);
+    HANDLE file = CreateFileW(path, GENERIC_READ | GENERIC_WRITE,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                              CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY, NULL);
+    if (file == INVALID_HANDLE_VALUE) return FALSE;
+
+    HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READWRITE, (DWORD)(size >> 32),
+                                        (DWORD)(size & 0xFFFFFFFF), NULL);
+    CloseHandle(file);
+    if (!mapping) return FALSE;
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!view) return FALSE;
+
+    g_header = (RingHeader*)view;
+    g_samples = (float*)((char*)view + sizeof(RingHeader));
+    memcpy(g_header->magic, "OWRB", 4);
+    g_header->version = RING_VERSION;
+    g_header->sampleRate = SAMPLE_RATE;
+    g_header->channels = 1;
+    g_header->capacity = capacity;
+    return TRUE;
+}
+
+static void WriteRing(const float* data, UINT32 count) {
+    uint64_t index = (uint64_t)g_header->writeIndex;
+    uint32_t mask = g_header->capacity - 1;
+    for (UINT32 i = 0; i < count; i++) {
+        g_samples[(index + i) & mask] = data ? data[i] : 0.0f;
+    }
+    InterlockedExchange64(&g_header->writeIndex, (LONG64)(index + count));
+}
+
+/* Copy every packet the engine has ready. Returns FALSE if the device went away. */
+static BOOL DrainPackets(BOOL* first) {
+    UINT32 packet = 0;
+    while (SUCCEEDED(IAudioCaptureClient_GetNextPacketSize(g_capture, &packet)) && packet > 0) {
+        BYTE* data = NULL;
+        UINT32 frames = 0;
+        DWORD flags = 0;
+        UINT64 qpcPosition = 0;
+        HRESULT hr = IAudioCaptureClient_GetBuffer(g_capture, &data, &frames, &flags, NULL,
+                                                   &qpcPosition);
+        if (FAILED(hr)) return FALSE;
+
+        if (*first && frames > 0) {
+            /* qpcPosition is in 100 ns units on the QPC clock */
+            g_header->firstSampleUs = qpcPosition / 10;
+            *first = FALSE;
+        }
+        WriteRing((flags & AUDCLNT_BUFFERFLAGS_SILENT) ? NULL : (const float*)data, frames);
+        IAudioCaptureClient_ReleaseBuffer(g_capture, frames);
+    }
+    return TRUE;
+}
+
+static DWORD WINAPI CaptureThread(LPVOID param) {
+    (void)param;
+    CoInitializeEx(NULL, COINIT_MULTITHREADED);
+    BOOL first = TRUE;
+    while (!g_stopRequested) {
+        if (WaitForSingleObject(g_bufferEvent, 100) != WAIT_OBJECT_0) continue;
+        if (!DrainPackets(&first)) {
+            fprintf(stderr, "Capture device lost\n");
+            break;
+        }
+    }
+    /* Pick up whatever arrived between the last event and STOP */
+    DrainPackets(&first);
+    CoUninitialize();
+    return 0;
+}
+
+/* Case-insensitive substring match on friendly names */
+static BOOL NameContains(const wchar_t* name, const wchar_t* wanted) {
+    wchar_t a[256], b[256];
+    wcsncpy(a, name, 255);
+    a[255] = L'\0';
+    wcsncpy(b, wanted, 255);
+    b[255] = L'\0';
+    _wcslwr(a);
+    _wcslwr(b);
+    return wcsstr(a, b) != NULL;
+}
+
+/* Find an active capture endpoint by friendly name: exact match first, then substring */
+static IMMDevice* FindDevice(const wchar_t* wanted) {
+    IMMDeviceCollection* devices = NULL;
+    if (FAILED(IMMDeviceEnumerator_EnumAudioEndpoints(g_enumerator, eCapture, DEVICE_STATE_ACTIVE,
+                                                      &devices)))
+        return NULL;
+
+    IMMDevice* exact = NULL;
+    IMMDevice* partial = NULL;
+    UINT count = 0;
+    IMMDeviceCollection_GetCount(devices, &count);
+    for (UINT i = 0; i < count && !exact; i++) {
+        IMMDevice* device = NULL;
+        if (FAILED(IMMDeviceCollection_Item(devices, i, &device))) continue;
+
+        IPropertyStore* store = NULL;
+        PROPVARIANT value;
+        PropVariantInit(&value);
+        BOOL keep = FALSE;
+        if (SUCCEEDED(IMMDevice_OpenPropertyStore(device, STGM_READ, &store))) {
+            if (SUCCEEDED(IPropertyStore_GetValue(store, &PKEY_Device_FriendlyName_, &value)) &&
+                value.vt == VT_LPWSTR) {
+                if (_wcsicmp(value.pwszVal, wanted) == 0) {
+                    exact = device;
+                    keep = TRUE;
+                } else if (!partial && NameContains(value.pwszVal, wanted)) {
+                    partial = device;
+                    keep = TRUE;
+                }
+            }
+            PropVariantClear(&value);
+            IPropertyStore_Release(store);
+        }
+        if (!keep) IMMDevice_Release(device);
+    }
+    IMMDeviceCollection_Release(devices);
+
+    if (exact) {
+        if (partial) IMMDevice_Release(partial);
+        return exact;
+    }
+    return partial;
+}
+
+static void ReleaseStream(void) {
+    if (g_capture) {
+        IAudioCaptureClient_Release(g_capture);
+        g_capture = NULL;
+    }
+    if (g_client) {
+        IAudioClient_Release(g_client);
+        g_client = NULL;
+    }
+}
+
+static void StopCapture(void) {
+    if (!g_thread) return;
+    InterlockedExchange(&g_stopRequested, 1);
+    SetEvent(g_bufferEvent);
+    WaitForSingleObject(g_thread, INFINITE);
+    CloseHandle(g_thread);
+    g_thread = NULL;
+    IAudioClient_Stop(g_client);
+    ReleaseStream();
+    InterlockedExchange(&g_header->capturing, 0);
+}
+
+static void StartCapture(const char* deviceName, char* reply, size_t replySize) {
+    if (g_thread) {
+        snprintf(reply, replySize, "START_ERROR 1 already capturing");
+        return;
+    }
+
+    IMMDevice* device = NULL;
+    if (deviceName && *deviceName && _stricmp(deviceName, "default") != 0) {
+        wchar_t wanted[256];
+        if (!MultiByteToWideChar(CP_UTF8, 0, deviceName, -1, wanted, 256) ||
+            !(device = FindDevice(wanted))) {
+            snprintf(reply, replySize, "START_ERROR 3 device not found");
+            return;
+        }
+    } else if (FAILED(IMMDeviceEnumerator_GetDefaultAudioEndpoint(g_enumerator, eCapture,
+                                                                  eConsole, &device))) {
+        snprintf(reply, replySize, "START_ERROR 3 no capture device");
+        return;
+    }
+
+    HRESULT hr = IMMDevice_Activate(device, &IID_IAudioClient_, CLSCTX_ALL, NULL,
+                                    (void**)&g_client);
+    IMMDevice_Release(device);
+    if (FAILED(hr)) {
+        snprintf(reply, replySize, "START_ERROR 2 activate failed 0x%08lx", (unsigned long)hr);
+        return;
+    }
+
+    WAVEFORMATEX format;
+    ZeroMemory(&format, sizeof(format));
+    format.wFormatTag = WAVE_FORMAT_IEEE_FLOAT;
+    format.nChannels = 1;
+    format.nSamplesPerSec = SAMPLE_RATE;
+    format.wBitsPerSample = 32;
+    format.nBlockAlign = 4;
+    format.nAvgBytesPerSec = SAMPLE_RATE * 4;
+
+    hr = IAudioClient_Initialize(g_client, AUDCLNT_SHAREMODE_SHARED,
+                                 AUDCLNT_STREAMFLAGS_EVENTCALLBACK |
+                                     AUDCLNT_STREAMFLAGS_AUTOCONVERTPCM |
+                                     AUDCLNT_STREAMFLAGS_SRC_DEFAULT_QUALITY,
+                                 BUFFER_DURATION_HNS, 0, &format, NULL);
+    if (SUCCEEDED(hr)) hr = IAudioClient_SetEventHandle(g_client, g_bufferEvent);
+    if (SUCCEEDED(hr))
+        hr = IAudioClient_GetService(g_client, &IID_IAudioCaptureClient_, (void**)&g_capture);
+    if (FAILED(hr)) {
+        ReleaseStream();
+        snprintf(reply, replySize, "START_ERROR 2 initialize failed 0x%08lx", (unsigned long)hr);
+        return;
+    }
+
+    g_header->session++;
+    g_header->firstSampleUs = 0;
+    InterlockedExchange64(&g_header->writeIndex, 0);
+    InterlockedExchange(&g_header->capturing, 1);
+    InterlockedExchange(&g_stopRequested, 0);
+    ResetEvent(g_bufferEvent);
+
+    hr = IAudioClient_Start(g_client);
+    if (SUCCEEDED(hr)) g_thread = CreateThread(NULL, 0, CaptureThread, NULL, 0, NULL);
+    if (!g_thread) {
+        if (SUCCEEDED(hr)) IAudioClient_Stop(g_client);
+        ReleaseStream();
+        InterlockedExchange(&g_header->capturing, 0);
+        snprintf(reply, replySize, "START_ERROR 2 start failed 0x%08lx", (unsigned long)hr);
+        return;
+    }
+
+    snprintf(reply, replySize, "START_OK %u %lld", g_header->session, MonotonicMicros());
+}
+
+/* Speech segments of the session so far (see audio-vad.h). The reply can
+ * outgrow the command reply buffer, so it is printed directly. */
+static void PrintVad(void) {
+    uint64_t count = (uint64_t)InterlockedCompareExchange64(&g_header->writeIndex, 0, 0);
+    if (count > g_header->capacity) {
+        printf("VAD_ERROR 2 session is longer than the ring\n");
+        return;
+    }
+
+    /* Sessions start at slot 0, so while they fit the ring they are contiguous */
+    VadSegment segments[MAX_VAD_SEGMENTS];
+    int found = vad_segments(g_samples, (size_t)count, segments, MAX_VAD_SEGMENTS);
+    if (found < 0) {
+        printf("VAD_ERROR 1 out of memory\n");
+        return;
+    }
+    printf("VAD_OK %llu %d", (unsigned long long)count, found);
+    for (int i = 0; i < found; i++) {
+        printf(" %llu:%llu", (unsigned long long)segments[i].start,
+               (unsigned long long)segments[i].end);
+    }
+    printf("\n");
+}
+
+int main(void) {
+    /* Arguments are read as UTF-16 so temp paths under non-ASCII profiles survive */
+    int argc = 0;
+    wchar_t** argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    const wchar_t* ringPath = NULL;
+    uint32_t capacity = DEFAULT_CAPACITY;
+    for (int i = 1; argv && i < argc; i++) {
+        if (wcscmp(argv[i], L"--ring") == 0 && i + 1 < argc) {
+            ringPath = argv[++i];
+        } else if (wcscmp(argv[i], L"--capacity") == 0 && i + 1 < argc) {
+            capacity = (uint32_t)wcstoul(argv[++i], NULL, 10);
+        }
+    }
+
+    if (!ringPath || capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        fprintf(stderr, "Usage: windows-audio-capture --ring PATH [--capacity POWER_OF_TWO]\n");
+        return 1;
+    }
+    if (!OpenRing(ringPath, capacity)) {
+        fprintf(stderr, "Failed to map ring (error %lu)\n", GetLastError());
+        return 2;
+    }
+
+    CoInitializeEx(NULL, COINIT_MULTITHREADED);
+    if (FAILED(CoCreateInstance(&CLSID_MMDeviceEnumerator_, NULL, CLSCTX_ALL,
+                                &IID_IMMDeviceEnumerator_, (void**)&g_enumerator))) {
+        fprintf(stderr, "MMDeviceEnumerator unavailable\n");
+        return 3;
+    }
+    g_bufferEvent = CreateEventW(NULL, FALSE, FALSE, NULL);
+
+    printf("READY\n");
+    fflush(stdout);
+
+    char line[1024];
+    char reply[256];
+    while (fgets(line, sizeof(line), stdin)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        reply[0] = '\0';
+
+        if (strcmp(line, "QUIT") == 0) break;
+
+        if (strncmp(line, "START", 5) == 0 && (line[5] == '\0' || line[5] == ' ')) {
+            const char* device = NULL;
+            if (strncmp(line + 5, " --device ", 10) == 0) device = line + 15;
+            StartCapture(device, reply, sizeof(reply));
+        } else if (strcmp(line, "STOP") == 0) {
+            if (!g_thread) {
+                snprintf(reply, sizeof(reply), "STOP_ERROR 1 not capturing");
+            } else {
+                StopCapture();
+                snprintf(reply, sizeof(reply), "STOP_OK %u %llu %llu", g_header->session,
+                         (unsigned long long)g_header->writeIndex,
+                         (unsigned long long)g_header->firstSampleUs);
+            }
+        } else if (strcmp(line, "VAD") == 0) {
+            PrintVad();
+            fflush(stdout);
+        } else if (strcmp(line, "STATUS") == 0) {
+            snprintf(reply, sizeof(reply), "STATUS_OK %d %u %llu", g_thread ? 1 : 0,
+                     g_header->session, (unsigned long long)g_header->writeIndex);
+        } else if (line[0]) {
+            snprintf(reply, sizeof(reply), "ERROR unknown command %s", line);
+        }
+
+        if (reply[0]) {
+            printf("%s\n", reply);
+            fflush(stdout);
+        }
+    }
+
+    StopCapture();
+    IMMDeviceEnumerator_Release(g_enumerator);
+    CoUninitialize();
+    UnmapViewOfFile(g_header);
+    DeleteFileW(ringPath);
+    LocalFree(argv);
+    return 0;
+}
@@ -6,96 +6,157 @@
  *   - Ctrl+V for normal applications
  *   - Ctrl+Shift+V for terminal emulators
  *
+ * With --type, UTF-8 text read from stdin is typed directly as
+ * KEYEVENTF_UNICODE events instead, leaving the clipboard untouched.
+ * --backspace N erases N characters first and --require-window HWND exits
+ * with code 7 if the foreground window is no longer HWND.
+ *
+ * With --keys "SCRIPT" a keystroke script such as "paste enter" or
+ * "shift+enter" is sent as one SendInput batch (see SendKeyScript); exit
+ * code 8 means the script did not parse.
+ *
+ * With --server the helper stays resident and serves PASTE / DETECT /
+ * TYPE_TEXT / KEYS commands over stdin/stdout, avoiding a process launch per
+ * paste.
+ *
+ * The paste/typing code and the command protocol live in windows-paste-core.h,
+ * shared with windows-key-listener --serve.
+ *
  * Compile with: cl /O2 windows-fast-paste.c /Fe:windows-fast-paste.exe user32.lib
  * Or with MinGW: gcc -O2 windows-fast-paste.c -o windows-fast-paste.exe -luser32
  */
 
-#define WIN32_LEAN_AND_MEAN
-#include <windows.h>
-#include <stdio.h>
-#include <string.h>
-
-static const char* TERMINAL_CLASSES[] = {
-    "ConsoleWindowClass",
-    "CASCADIA_HOSTING_WINDOW_CLASS",
-    "mintty",
-    "VirtualConsoleClass",
-    "PuTTY",
-    "Alacritty",
-    "org.wezfurlong.wezterm",
-    "Hyper",
-    "TMobaXterm",
-    "kitty",
-    NULL
-};
-
-static BOOL IsTerminalClass(const char* className) {
-    for (int i = 0; TERMINAL_CLASSES[i] != NULL; i++) {
-        if (_stricmp(className, TERMINAL_CLASSES[i]) == 0) {
-            return TRUE;
+#include "windows-paste-core.h"
+#include <io.h>
+#include <fcntl.h>
+
+static char* ReadStdin(size_t* length) {
+    size_t capacity = 4096, used = 0;
+    char* data = (char*)malloc(capacity);
+    if (!data) return NULL;
+
+    _setmode(_fileno(stdin), _O_BINARY);
+    size_t n;
+    while ((n = fread(data + used, 1, capacity - used, stdin)) > 0) {
+        used += n;
+        if (used == capacity) {
+            char* grown = (char*)realloc(data, capacity * 2);
+            if (!grown) break;
+            data = grown;
+            capacity *= 2;
         }
     }
-    return FALSE;
-}
-
-static int SendPasteNormal(void) {
-    INPUT inputs[4];
-    ZeroMemory(inputs, sizeof(inputs));
-
-    inputs[0].type = INPUT_KEYBOARD;
-    inputs[0].ki.wVk = VK_CONTROL;
-
-    inputs[1].type = INPUT_KEYBOARD;
-    inputs[1].ki.wVk = 'V';
-
-    inputs[2].type = INPUT_KEYBOARD;
-    inputs[2].ki.wVk = 'V';
-    inputs[2].ki.dwFlags = KEYEVENTF_KEYUP;
-
-    inputs[3].type = INPUT_KEYBOARD;
-    inputs[3].ki.wVk = VK_CONTROL;
-    inputs[3].ki.dwFlags = KEYEVENTF_KEYUP;
-
-    UINT sent = SendInput(4, inputs, sizeof(INPUT));
-    return (sent == 4) ? 0 : 1;
+    *length = used;
+    return data;
 }
 
-static int SendPasteTerminal(void) {
-    INPUT inputs[6];
-    ZeroMemory(inputs, sizeof(inputs));
-
-    inputs[0].type = INPUT_KEYBOARD;
-    inputs[0].ki.wVk = VK_CONTROL;
-
-    inputs[1].type = INPUT_KEYBOARD;
-    inputs[1].ki.wVk = VK_SHIFT;
-
-    inputs[2].type = INPUT_KEYBOARD;
-    inputs[2].ki.wVk = 'V';
-
-    inputs[3].type = INPUT_KEYBOARD;
-    inputs[3].ki.wVk = 'V';
-    inputs[3].ki.dwFlags = KEYEVENTF_KEYUP;
-
-    inputs[4].type = INPUT_KEYBOARD;
-    inputs[4].ki.wVk = VK_SHIFT;
-    inputs[4].ki.dwFlags = KEYEVENTF_KEYUP;
+/*
+ * Server mode: stay resident and answer newline-delimited commands on stdin
+ * (see RunPasteCommand), matching the windows-key-listener READY/line
+ * protocol. EOF on stdin (parent exited) ends the server.
+ */
+static int RunServer(void) {
+    _setmode(_fileno(stdin), _O_BINARY);
 
-    inputs[5].type = INPUT_KEYBOARD;
-    inputs[5].ki.wVk = VK_CONTROL;
-    inputs[5].ki.dwFlags = KEYEVENTF_KEYUP;
+    printf("READY\n");
+    fflush(stdout);
 
-    UINT sent = SendInput(6, inputs, sizeof(INPUT));
-    return (sent == 6) ? 0 : 1;
+    char line[512];
+    char reply[512];
+    int got;
+    while ((got = ReadCommandLine(line, sizeof(line), stdin)) != 0) {
+        BOOL keepRunning = TRUE;
+        if (got < 0) {
+            snprintf(reply, sizeof(reply), "ERROR line too long (max %u bytes)",
+                     (unsigned)sizeof(line) - 2);
+        } else {
+            keepRunning = RunPasteCommand(line, stdin, reply, sizeof(reply));
+        }
+        if (reply[0]) {
+            printf("%s\n", reply);
+            fflush(stdout);
+        }
+        if (!keepRunning) break;
+    }
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
     BOOL detectOnly = FALSE;
+    BOOL typeMode = FALSE;
+    BOOL serverMode = FALSE;
+    char* keyScript = NULL;
+    int backspaces = 0;
+    HWND requireWindow = NULL;
 
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--detect-only") == 0) {
             detectOnly = TRUE;
+        } else if (strcmp(argv[i], "--type") == 0) {
+            typeMode = TRUE;
+        } else if (strcmp(argv[i], "--server") == 0) {
+            serverMode = TRUE;
+        } else if (strcmp(argv[i], "--keys") == 0 && i + 1 < argc) {
+            keyScript = argv[++i];
+        } else if (strcmp(argv[i], "--backspace") == 0 && i + 1 < argc) {
+            backspaces = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--require-window") == 0 && i + 1 < argc) {
+            requireWindow = (HWND)(UINT_PTR)strtoull(argv[++i], NULL, 0);
+        }
+    }
+
+    if (serverMode) {
+        return RunServer();
+    }
+
+    if (typeMode) {
+        if (requireWindow && GetForegroundWindow() != requireWindow) {
+            fprintf(stderr, "ERROR: Foreground window changed\n");
+            return 7;
+        }
+
+        size_t length = 0;
+        char* text = ReadStdin(&length);
+        if (!text) {
+            fprintf(stderr, "ERROR: Could not read text from stdin\n");
+            return 1;
+        }
+        int typed = TypeText(text, length, backspaces);
+        free(text);
+        if (typed < 0) {
+            fprintf(stderr, "ERROR: SendInput failed (error %lu)\n", GetLastError());
+            return 1;
         }
+        printf("TYPE_OK %d\n", typed);
+        fflush(stdout);
+        return 0;
+    }
+
+    if (keyScript) {
+        ScriptStep steps[KEY_SCRIPT_MAX_STEPS];
+        int stepCount = ParseKeyScript(keyScript, steps);
+        if (stepCount < 0) {
+            fprintf(stderr, "ERROR: Invalid key script\n");
+            return 8;
+        }
+
+        HWND foreground = GetForegroundWindow();
+        if (requireWindow && foreground != requireWindow) {
+            fprintf(stderr, "ERROR: Foreground window changed\n");
+            return 7;
+        }
+        const char* scriptClass = NULL;
+        BOOL scriptTerminal = FALSE;
+        if (foreground) LookupWindowClass(foreground, &scriptClass, &scriptTerminal);
+
+        int sent = SendKeyScript(steps, stepCount, scriptTerminal);
+        if (sent < 0) {
+            fprintf(stderr, "ERROR: SendInput failed (error %lu)\n", GetLastError());
+            return 1;
+        }
+        printf("KEYS_OK %d\n", sent);
+        fflush(stdout);
+        return 0;
     }
 
     HWND hwnd = GetForegroundWindow();
@@ -114,8 +175,11 @@ int main(int argc, char* argv[]) {
     BOOL isTerminal = IsTerminalClass(className);
 
     if (detectOnly) {
+        printf("WINDOW_ID 0x%llx\n", (unsigned long long)(UINT_PTR)hwnd);
         printf("WINDOW_CLASS %s\n", className);
         printf("IS_TERMINAL %s\n", isTerminal ? "true" : "false");
+        /* Lets callers tell this build from older ones that ignore the flags */
+        printf("FEATURES type server keys\n");
         fflush(stdout);
         return 0;
     }
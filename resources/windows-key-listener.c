@@ -5,106 +5,292 @@
  * Accepts a virtual key code as command line argument.
  * Outputs "KEY_DOWN" and "KEY_UP" to stdout.
  *
+ * One hook serves any number of hotkey bindings (up to MAX_BINDINGS): the
+ * positional key keeps the plain KEY_DOWN / KEY_UP lines, and each extra
+ * binding added with --bind ID HOTKEY (or BIND / UNBIND on stdin under
+ * --serve) reports "KEY_DOWN:<id>" / "KEY_UP:<id>". The hook finds the
+ * bindings for a key through a 256-entry VK -> binding bitmask table, so
+ * unrelated keystrokes cost one array lookup.
+ *
+ * With --serve the listener is also the resident paste agent: after READY it
+ * prints "FEATURES paste detect type bind binary-events keys" and answers the
+ * windows-fast-paste PASTE / DETECT / TYPE_TEXT / KEYS commands (windows-paste-core.h)
+ * on stdin. Key events then carry a timestamp, "KEY_DOWN <us>" / "KEY_UP <us>",
+ * on the same QueryPerformanceCounter clock as the paste replies.
+ *
+ * The hook never writes to stdout itself: it stamps each event and pushes it
+ * onto a lock-free ring that a writer thread drains to the pipe. A stalled
+ * pipe therefore can't hold the hook past LowLevelHooksTimeout, which would
+ * make Windows silently remove it.
+ *
+ * --binary-events replaces the KEY_DOWN / KEY_UP lines with fixed 16-byte
+ * records (see WriteEventRecord) carrying the binding slot, the hook's
+ * KBDLLHOOKSTRUCT.time and the QueryPerformanceCounter time in microseconds,
+ * which is the clock behind Node's process.hrtime on Windows. Command replies
+ * stay text; a record's 0xFE marker byte can never start a text line.
+ *
+ * Modifier state is tracked from the hook's own events as a bitmask rather
+ * than polled with GetAsyncKeyState, which is only used to resynchronize at
+ * hook install and after a quiet period in which events may have been missed.
+ *
  * Compile with: cl /O2 windows-key-listener.c /Fe:windows-key-listener.exe user32.lib
  * Or with MinGW: gcc -O2 windows-key-listener.c -o windows-key-listener.exe -luser32
  */
 
-#define WIN32_LEAN_AND_MEAN
-#include <windows.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
+#include "windows-paste-core.h"
+#include <io.h>
+#include <fcntl.h>
 
 static HHOOK g_hook = NULL;
-static DWORD g_targetVk = 0;
-static BOOL g_isKeyDown = FALSE;
-
-// Modifier key requirements
-static BOOL g_requireCtrl = FALSE;
-static BOOL g_requireAlt = FALSE;
-static BOOL g_requireShift = FALSE;
-static BOOL g_requireWin = FALSE;
-static BOOL g_useModifiersOnly = FALSE;
-
-// Check if required modifiers are currently pressed
-BOOL AreModifiersPressed(void) {
-    if (g_requireCtrl && !(GetAsyncKeyState(VK_CONTROL) & 0x8000)) return FALSE;
-    if (g_requireAlt && !(GetAsyncKeyState(VK_MENU) & 0x8000)) return FALSE;
-    if (g_requireShift && !(GetAsyncKeyState(VK_SHIFT) & 0x8000)) return FALSE;
-    if (g_requireWin &&
-        !(GetAsyncKeyState(VK_LWIN) & 0x8000) &&
-        !(GetAsyncKeyState(VK_RWIN) & 0x8000)) {
-        return FALSE;
+
+// Modifier requirement bits
+#define MOD_BIT_CTRL 0x01
+#define MOD_BIT_ALT 0x02
+#define MOD_BIT_SHIFT 0x04
+#define MOD_BIT_WIN 0x08
+
+// Held modifier keys, one bit per side: left keys use the MOD_BIT_* values and
+// right keys the same bits shifted up four, so (keys | keys >> 4) & 0x0F
+// gives the MOD_BIT_* set that is held on either side.
+#define MOD_RIGHT_SHIFT 4
+static BYTE g_modifierKeys = 0; // hook thread only
+static DWORD g_lastEventTime = 0;
+
+// The hook misses events while the secure desktop or lock screen is up, or
+// after Windows drops a slow hook, so the first event after this much
+// keyboard silence re-reads the real state instead of trusting the cache.
+#define MODIFIER_RESYNC_IDLE_MS 500
+
+// One bit per binding in g_vkBindings, so at most 32
+#define MAX_BINDINGS 32
+#define BINDING_ID_SIZE 24
+
+typedef struct {
+    BOOL active;
+    char id[BINDING_ID_SIZE]; // empty for the positional key (legacy output)
+    DWORD vk;                 // 0 for modifier-only hotkeys
+    BYTE modifiers;           // MOD_BIT_* required
+    BOOL isKeyDown;
+} Binding;
+
+// Both tables are only touched on the hook thread; other threads change them
+// through WM_BINDING_REQUEST so the hook never needs a lock.
+static Binding g_bindings[MAX_BINDINGS];
+static DWORD g_vkBindings[256];
+
+#define WM_BINDING_REQUEST (WM_APP + 1)
+
+typedef struct {
+    BOOL add;
+    Binding binding;
+    HANDLE done;
+    const char* error; // NULL on success
+    int slot;
+} BindingRequest;
+
+// Agent mode (--serve): stdout is shared by the event writer and the command thread
+static BOOL g_serveMode = FALSE;
+static BOOL g_binaryEvents = FALSE;
+static DWORD g_mainThreadId = 0;
+static CRITICAL_SECTION g_outputLock;
+
+// Hook -> writer event ring. The hook thread is the only producer and the
+// writer thread the only consumer, so each index has a single writer and no
+// lock is needed; InterlockedExchange publishes an index after its slot.
+#define EVENT_RING_SIZE 256 // power of two
+
+typedef struct {
+    LONGLONG ticks; // QueryPerformanceCounter at hook time
+    DWORD eventTime; // KBDLLHOOKSTRUCT.time (GetTickCount clock)
+    BYTE isKeyDown;
+    BYTE slot; // index into g_bindings
+    char id[BINDING_ID_SIZE]; // copied so a later UNBIND can't change the line
+} KeyEvent;
+
+// Binary event record, little-endian (matches src/helpers/nativeEventStream.js)
+#define EVENT_RECORD_MARKER 0xFE
+#define EVENT_RECORD_SIZE 16
+#define EVENT_RECORD_KEY_DOWN 1
+#define EVENT_RECORD_KEY_UP 2
+
+static KeyEvent g_eventRing[EVENT_RING_SIZE];
+static volatile LONG g_ringHead = 0; // next slot the hook fills
+static volatile LONG g_ringTail = 0; // next slot the writer drains
+static volatile LONG g_ringDropped = 0;
+static HANDLE g_ringSignal = NULL;
+
+// Called from the hook thread: O(1), never blocks on the pipe
+static void EmitKeyEvent(const Binding* binding, BOOL isKeyDown, DWORD eventTime) {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+
+    LONG head = g_ringHead;
+    if ((ULONG)head - (ULONG)g_ringTail >= EVENT_RING_SIZE) {
+        // Writer is stuck behind a full pipe; losing an event beats losing the hook
+        g_ringDropped++;
+        return;
     }
-    return TRUE;
+    KeyEvent* slot = &g_eventRing[(ULONG)head & (EVENT_RING_SIZE - 1)];
+    slot->ticks = now.QuadPart;
+    slot->eventTime = eventTime;
+    slot->isKeyDown = (BYTE)isKeyDown;
+    slot->slot = (BYTE)(binding - g_bindings);
+    memcpy(slot->id, binding->id, BINDING_ID_SIZE);
+    InterlockedExchange(&g_ringHead, (LONG)((ULONG)head + 1));
+    SetEvent(g_ringSignal);
 }
 
-// Map key name to virtual key code
-DWORD ParseKeyCode(const char* keyName) {
-    // Function keys (F1-F12)
-    if (_stricmp(keyName, "F1") == 0) return VK_F1;
-    if (_stricmp(keyName, "F2") == 0) return VK_F2;
-    if (_stricmp(keyName, "F3") == 0) return VK_F3;
-    if (_stricmp(keyName, "F4") == 0) return VK_F4;
-    if (_stricmp(keyName, "F5") == 0) return VK_F5;
-    if (_stricmp(keyName, "F6") == 0) return VK_F6;
-    if (_stricmp(keyName, "F7") == 0) return VK_F7;
-    if (_stricmp(keyName, "F8") == 0) return VK_F8;
-    if (_stricmp(keyName, "F9") == 0) return VK_F9;
-    if (_stricmp(keyName, "F10") == 0) return VK_F10;
-    if (_stricmp(keyName, "F11") == 0) return VK_F11;
-    if (_stricmp(keyName, "F12") == 0) return VK_F12;
-
-    // Extended function keys (F13-F24)
-    if (_stricmp(keyName, "F13") == 0) return VK_F13;
-    if (_stricmp(keyName, "F14") == 0) return VK_F14;
-    if (_stricmp(keyName, "F15") == 0) return VK_F15;
-    if (_stricmp(keyName, "F16") == 0) return VK_F16;
-    if (_stricmp(keyName, "F17") == 0) return VK_F17;
-    if (_stricmp(keyName, "F18") == 0) return VK_F18;
-    if (_stricmp(keyName, "F19") == 0) return VK_F19;
-    if (_stricmp(keyName, "F20") == 0) return VK_F20;
-    if (_stricmp(keyName, "F21") == 0) return VK_F21;
-    if (_stricmp(keyName, "F22") == 0) return VK_F22;
-    if (_stricmp(keyName, "F23") == 0) return VK_F23;
-    if (_stricmp(keyName, "F24") == 0) return VK_F24;
+/*
+ *   0  u8   0xFE marker
+ *   1  u8   1 = key down, 2 = key up
+ *   2  u8   binding slot (the positional key is 0; BIND_OK reports the rest)
+ *   3  u8   reserved, 0
+ *   4  u32  KBDLLHOOKSTRUCT.time in ms
+ *   8  i64  hook time in QueryPerformanceCounter microseconds
+ */
+static void WriteEventRecord(const KeyEvent* event) {
+    unsigned char record[EVENT_RECORD_SIZE] = {0};
+    record[0] = EVENT_RECORD_MARKER;
+    record[1] = event->isKeyDown ? EVENT_RECORD_KEY_DOWN : EVENT_RECORD_KEY_UP;
+    record[2] = event->slot;
+    for (int i = 0; i < 4; i++) record[4 + i] = (unsigned char)(event->eventTime >> (8 * i));
+    unsigned long long micros = (unsigned long long)QpcTicksToMicros(event->ticks);
+    for (int i = 0; i < 8; i++) record[8 + i] = (unsigned char)(micros >> (8 * i));
+    fwrite(record, 1, sizeof(record), stdout);
+}
+
+static DWORD WINAPI WriterThread(LPVOID param) {
+    (void)param;
+    static KeyEvent batch[EVENT_RING_SIZE];
+    LONG reportedDrops = 0;
+
+    for (;;) {
+        WaitForSingleObject(g_ringSignal, INFINITE);
 
+        LONG tail = g_ringTail;
+        LONG head = g_ringHead;
+        MemoryBarrier();
+        ULONG count = (ULONG)head - (ULONG)tail;
+        for (ULONG i = 0; i < count; i++) {
+            batch[i] = g_eventRing[((ULONG)tail + i) & (EVENT_RING_SIZE - 1)];
+        }
+        // Free the slots before touching the pipe so the hook keeps room
+        InterlockedExchange(&g_ringTail, head);
+
+        EnterCriticalSection(&g_outputLock);
+        for (ULONG i = 0; i < count; i++) {
+            if (g_binaryEvents) {
+                WriteEventRecord(&batch[i]);
+                continue;
+            }
+            const char* name = batch[i].isKeyDown ? "KEY_DOWN" : "KEY_UP";
+            printf("%s", name);
+            if (batch[i].id[0]) printf(":%s", batch[i].id);
+            if (g_serveMode) printf(" %lld", QpcTicksToMicros(batch[i].ticks));
+            printf("\n");
+        }
+        fflush(stdout);
+        LeaveCriticalSection(&g_outputLock);
+
+        LONG dropped = g_ringDropped;
+        if (dropped != reportedDrops) {
+            fprintf(stderr, "Warning: dropped %ld key events (stdout backpressure)\n",
+                    dropped - reportedDrops);
+            reportedDrops = dropped;
+        }
+    }
+    return 0;
+}
+
+typedef struct {
+    const char* name;
+    DWORD vk;
+} KeyName;
+
+// Named keys accepted in hotkeys (case-insensitive). F1-F24, single letters
+// and digits, and raw 0x.. / decimal VK codes are parsed without the table.
+static const KeyName KEY_NAMES[] = {
     // Special keys
-    if (_stricmp(keyName, "Pause") == 0) return VK_PAUSE;
-    if (_stricmp(keyName, "ScrollLock") == 0) return VK_SCROLL;
-    if (_stricmp(keyName, "Insert") == 0) return VK_INSERT;
-    if (_stricmp(keyName, "Home") == 0) return VK_HOME;
-    if (_stricmp(keyName, "End") == 0) return VK_END;
-    if (_stricmp(keyName, "PageUp") == 0) return VK_PRIOR;
-    if (_stricmp(keyName, "PageDown") == 0) return VK_NEXT;
-    if (_stricmp(keyName, "Space") == 0) return VK_SPACE;
-    if (_stricmp(keyName, "Escape") == 0 || _stricmp(keyName, "Esc") == 0) return VK_ESCAPE;
-    if (_stricmp(keyName, "Tab") == 0) return VK_TAB;
-    if (_stricmp(keyName, "CapsLock") == 0) return VK_CAPITAL;
-    if (_stricmp(keyName, "NumLock") == 0) return VK_NUMLOCK;
+    {"Pause", VK_PAUSE},
+    {"ScrollLock", VK_SCROLL},
+    {"Insert", VK_INSERT},
+    {"Home", VK_HOME},
+    {"End", VK_END},
+    {"PageUp", VK_PRIOR},
+    {"PageDown", VK_NEXT},
+    {"Space", VK_SPACE},
+    {"Escape", VK_ESCAPE},
+    {"Esc", VK_ESCAPE},
+    {"Tab", VK_TAB},
+    {"CapsLock", VK_CAPITAL},
+    {"NumLock", VK_NUMLOCK},
 
     // Right-side modifier keys (used as single-key hotkeys)
-    if (_stricmp(keyName, "RightAlt") == 0 || _stricmp(keyName, "RightOption") == 0) return VK_RMENU;
-    if (_stricmp(keyName, "RightControl") == 0 || _stricmp(keyName, "RightCtrl") == 0) return VK_RCONTROL;
-    if (_stricmp(keyName, "RightShift") == 0) return VK_RSHIFT;
-    if (_stricmp(keyName, "RightSuper") == 0 || _stricmp(keyName, "RightWin") == 0 ||
-        _stricmp(keyName, "RightMeta") == 0 || _stricmp(keyName, "RightCommand") == 0 ||
-        _stricmp(keyName, "RightCmd") == 0) return VK_RWIN;
+    {"RightAlt", VK_RMENU},
+    {"RightOption", VK_RMENU},
+    {"RightControl", VK_RCONTROL},
+    {"RightCtrl", VK_RCONTROL},
+    {"RightShift", VK_RSHIFT},
+    {"RightSuper", VK_RWIN},
+    {"RightWin", VK_RWIN},
+    {"RightMeta", VK_RWIN},
+    {"RightCommand", VK_RWIN},
+    {"RightCmd", VK_RWIN},
 
     // Backtick/tilde - the default hotkey
-    if (strcmp(keyName, "`") == 0 || _stricmp(keyName, "Backquote") == 0) return VK_OEM_3;
+    {"`", VK_OEM_3},
+    {"Backquote", VK_OEM_3},
 
     // Other punctuation
-    if (strcmp(keyName, "-") == 0 || _stricmp(keyName, "Minus") == 0) return VK_OEM_MINUS;
-    if (strcmp(keyName, "=") == 0 || _stricmp(keyName, "Equal") == 0) return VK_OEM_PLUS;
-    if (strcmp(keyName, "[") == 0) return VK_OEM_4;
-    if (strcmp(keyName, "]") == 0) return VK_OEM_6;
-    if (strcmp(keyName, "\\") == 0) return VK_OEM_5;
-    if (strcmp(keyName, ";") == 0) return VK_OEM_1;
-    if (strcmp(keyName, "'") == 0) return VK_OEM_7;
-    if (strcmp(keyName, ",") == 0) return VK_OEM_COMMA;
-    if (strcmp(keyName, ".") == 0) return VK_OEM_PERIOD;
-    if (strcmp(keyName, "/") == 0) return VK_OEM_2;
+    {"-", VK_OEM_MINUS},
+    {"Minus", VK_OEM_MINUS},
+    {"=", VK_OEM_PLUS},
+    {"Equal", VK_OEM_PLUS},
+    {"[", VK_OEM_4},
+    {"]", VK_OEM_6},
+    {"\\", VK_OEM_5},
+    {";", VK_OEM_1},
+    {"'", VK_OEM_7},
+    {",", VK_OEM_COMMA},
+    {".", VK_OEM_PERIOD},
+    {"/", VK_OEM_2},
+    {NULL, 0}
+};
+
+typedef struct {
+    const char* name;
+    BYTE bit;
+} ModifierName;
+
+static const ModifierName MODIFIER_NAMES[] = {
+    {"CommandOrControl", MOD_BIT_CTRL},
+    {"CmdOrCtrl", MOD_BIT_CTRL},
+    {"Control", MOD_BIT_CTRL},
+    {"Ctrl", MOD_BIT_CTRL},
+    {"Alt", MOD_BIT_ALT},
+    {"Option", MOD_BIT_ALT},
+    {"Shift", MOD_BIT_SHIFT},
+    // Windows key
+    {"Super", MOD_BIT_WIN},
+    {"Meta", MOD_BIT_WIN},
+    {"Win", MOD_BIT_WIN},
+    {"Command", MOD_BIT_WIN},
+    {"Cmd", MOD_BIT_WIN},
+    {NULL, 0}
+};
+
+// Map key name to virtual key code
+static DWORD ParseKeyCode(const char* keyName) {
+    // Function keys (F1-F24)
+    if ((keyName[0] == 'F' || keyName[0] == 'f') && keyName[1] >= '1' && keyName[1] <= '9') {
+        char* end = NULL;
+        long n = strtol(keyName + 1, &end, 10);
+        if (*end == '\0' && n >= 1 && n <= 24) return (DWORD)(VK_F1 + n - 1);
+    }
+
+    for (int i = 0; KEY_NAMES[i].name != NULL; i++) {
+        if (_stricmp(keyName, KEY_NAMES[i].name) == 0) return KEY_NAMES[i].vk;
+    }
 
     // Single letter/number - convert to VK code
     if (strlen(keyName) == 1) {
@@ -122,67 +308,212 @@ DWORD ParseKeyCode(const char* keyName) {
     return (DWORD)atoi(keyName);
 }
 
+// Parse a compound hotkey like "CommandOrControl+Shift+F11" into binding's
+// vk and modifiers. Returns FALSE if it names neither a key nor a modifier.
+static BOOL ParseCompoundHotkey(const char* hotkey, Binding* binding) {
+    char buffer[256];
+    strncpy(buffer, hotkey, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+
+    binding->vk = 0;
+    binding->modifiers = 0;
+
+    char* context = NULL;
+    char* token = strtok_s(buffer, "+", &context);
+
+    while (token != NULL) {
+        // Trim leading/trailing spaces
+        while (*token == ' ') token++;
+        char* end = token + strlen(token) - 1;
+        while (end > token && *end == ' ') *end-- = '\0';
+
+        BYTE modifier = 0;
+        for (int i = 0; MODIFIER_NAMES[i].name != NULL; i++) {
+            if (_stricmp(token, MODIFIER_NAMES[i].name) == 0) {
+                modifier = MODIFIER_NAMES[i].bit;
+                break;
+            }
+        }
+        if (modifier) {
+            binding->modifiers |= modifier;
+        } else {
+            // This should be the main key
+            binding->vk = ParseKeyCode(token);
+        }
+
+        token = strtok_s(NULL, "+", &context);
+    }
+
+    return binding->vk < 256 && (binding->vk != 0 || binding->modifiers != 0);
+}
+
+// Held-key bit for a modifier VK, or 0 for ordinary keys. Low-level hooks
+// see the sided codes; a generic VK_CONTROL etc. (injected) counts as left.
+static BYTE ModifierKeyForVk(DWORD vk) {
+    switch (vk) {
+        case VK_CONTROL: case VK_LCONTROL: return MOD_BIT_CTRL;
+        case VK_RCONTROL: return MOD_BIT_CTRL << MOD_RIGHT_SHIFT;
+        case VK_MENU: case VK_LMENU: return MOD_BIT_ALT;
+        case VK_RMENU: return MOD_BIT_ALT << MOD_RIGHT_SHIFT;
+        case VK_SHIFT: case VK_LSHIFT: return MOD_BIT_SHIFT;
+        case VK_RSHIFT: return MOD_BIT_SHIFT << MOD_RIGHT_SHIFT;
+        case VK_LWIN: return MOD_BIT_WIN;
+        case VK_RWIN: return MOD_BIT_WIN << MOD_RIGHT_SHIFT;
+        default: return 0;
+    }
+}
+
+static BYTE ModifierBitsFromKeys(BYTE keys) {
+    return (BYTE)((keys | (keys >> MOD_RIGHT_SHIFT)) & 0x0F);
+}
+
+// Modifier bit a key event belongs to, or 0 for ordinary keys
+static BYTE ModifierBitForVk(DWORD vk) {
+    return ModifierBitsFromKeys(ModifierKeyForVk(vk));
+}
+
+// Rebuild the held-modifier cache from the real keyboard state. Only used
+// when the cache may have missed events: at hook install and after silence.
+static void ResyncModifierKeys(void) {
+    static const DWORD SIDED_MODIFIER_VKS[] = {
+        VK_LCONTROL, VK_RCONTROL, VK_LMENU, VK_RMENU, VK_LSHIFT, VK_RSHIFT, VK_LWIN, VK_RWIN
+    };
+    BYTE keys = 0;
+    for (size_t i = 0; i < sizeof(SIDED_MODIFIER_VKS) / sizeof(SIDED_MODIFIER_VKS[0]); i++) {
+        if (GetAsyncKeyState((int)SIDED_MODIFIER_VKS[i]) & 0x8000) {
+            keys |= ModifierKeyForVk(SIDED_MODIFIER_VKS[i]);
+        }
+    }
+    g_modifierKeys = keys;
+}
+
+// Check if the required modifiers are currently pressed
+static BOOL AreModifiersPressed(BYTE modifiers) {
+    return (ModifierBitsFromKeys(g_modifierKeys) & modifiers) == modifiers;
+}
+
+// Recompute which bindings each VK can affect: its main key plus every
+// left/right variant of its required modifiers.
+static void RebuildVkTable(void) {
+    static const DWORD MODIFIER_VKS[] = {
+        VK_CONTROL, VK_LCONTROL, VK_RCONTROL, VK_MENU, VK_LMENU, VK_RMENU,
+        VK_SHIFT, VK_LSHIFT, VK_RSHIFT, VK_LWIN, VK_RWIN
+    };
+
+    ZeroMemory(g_vkBindings, sizeof(g_vkBindings));
+    for (int i = 0; i < MAX_BINDINGS; i++) {
+        const Binding* binding = &g_bindings[i];
+        if (!binding->active) continue;
+        DWORD bit = (DWORD)1 << i;
+        if (binding->vk) g_vkBindings[binding->vk] |= bit;
+        for (size_t m = 0; m < sizeof(MODIFIER_VKS) / sizeof(MODIFIER_VKS[0]); m++) {
+            if (binding->modifiers & ModifierBitForVk(MODIFIER_VKS[m])) {
+                g_vkBindings[MODIFIER_VKS[m]] |= bit;
+            }
+        }
+    }
+}
+
+static Binding* FindBinding(const char* id) {
+    for (int i = 0; i < MAX_BINDINGS; i++) {
+        if (g_bindings[i].active && strcmp(g_bindings[i].id, id) == 0) return &g_bindings[i];
+    }
+    return NULL;
+}
+
+// Add, replace or remove a binding; *slotIndex receives the slot it landed
+// in. Runs on the hook thread only.
+static const char* ApplyBinding(BOOL add, const Binding* binding, int* slotIndex) {
+    Binding* existing = FindBinding(binding->id);
+    if (existing) {
+        // Never leave a held hotkey without its KEY_UP
+        if (existing->isKeyDown) EmitKeyEvent(existing, FALSE, GetTickCount());
+        existing->active = FALSE;
+    } else if (!add) {
+        return "3 unknown binding";
+    }
+
+    if (add) {
+        Binding* slot = NULL;
+        for (int i = 0; i < MAX_BINDINGS && !slot; i++) {
+            if (!g_bindings[i].active) slot = &g_bindings[i];
+        }
+        if (!slot) {
+            RebuildVkTable();
+            return "2 too many bindings";
+        }
+        *slot = *binding;
+        slot->active = TRUE;
+        slot->isKeyDown = FALSE;
+        if (slotIndex) *slotIndex = (int)(slot - g_bindings);
+    }
+    RebuildVkTable();
+    return NULL;
+}
+
+static void UpdateBinding(Binding* binding, const KBDLLHOOKSTRUCT* kbd, BOOL isKeyDown,
+                          BOOL isKeyUp) {
+    DWORD vk = kbd->vkCode;
+    // A required modifier released while the hotkey is held ends the press
+    if (binding->isKeyDown && isKeyUp && (ModifierBitForVk(vk) & binding->modifiers)) {
+        binding->isKeyDown = FALSE;
+        EmitKeyEvent(binding, FALSE, kbd->time);
+        return;
+    }
+
+    if (binding->vk == 0) {
+        // Modifier-only hotkey
+        if (isKeyDown && !binding->isKeyDown && AreModifiersPressed(binding->modifiers)) {
+            binding->isKeyDown = TRUE;
+            EmitKeyEvent(binding, TRUE, kbd->time);
+        } else if (isKeyUp && binding->isKeyDown && !AreModifiersPressed(binding->modifiers)) {
+            binding->isKeyDown = FALSE;
+            EmitKeyEvent(binding, FALSE, kbd->time);
+        }
+        return;
+    }
+
+    if (vk != binding->vk) return;
+    if (isKeyDown) {
+        // Only trigger if modifiers are satisfied and not already down
+        if (!binding->isKeyDown && AreModifiersPressed(binding->modifiers)) {
+            binding->isKeyDown = TRUE;
+            EmitKeyEvent(binding, TRUE, kbd->time);
+        }
+    } else if (isKeyUp && binding->isKeyDown) {
+        // Target key released
+        binding->isKeyDown = FALSE;
+        EmitKeyEvent(binding, FALSE, kbd->time);
+    }
+}
+
 LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam) {
     if (nCode == HC_ACTION) {
         KBDLLHOOKSTRUCT* kbd = (KBDLLHOOKSTRUCT*)lParam;
+
+        // Our own paste/typing keystrokes must not trigger or release a hotkey,
+        // nor change what the user is physically holding
+        if (kbd->dwExtraInfo == OPENWHISPR_INPUT_TAG) {
+            return CallNextHookEx(g_hook, nCode, wParam, lParam);
+        }
         BOOL isKeyDown = (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN);
         BOOL isKeyUp = (wParam == WM_KEYUP || wParam == WM_SYSKEYUP);
 
-        // Check if a required modifier was released while we're in key-down state
-        if (g_isKeyDown && isKeyUp) {
-            BOOL modifierReleased = FALSE;
-            if (g_requireCtrl && (kbd->vkCode == VK_CONTROL || kbd->vkCode == VK_LCONTROL || kbd->vkCode == VK_RCONTROL)) {
-                modifierReleased = TRUE;
-            }
-            if (g_requireAlt && (kbd->vkCode == VK_MENU || kbd->vkCode == VK_LMENU || kbd->vkCode == VK_RMENU)) {
-                modifierReleased = TRUE;
-            }
-            if (g_requireShift && (kbd->vkCode == VK_SHIFT || kbd->vkCode == VK_LSHIFT || kbd->vkCode == VK_RSHIFT)) {
-                modifierReleased = TRUE;
-            }
-            if (g_requireWin && (kbd->vkCode == VK_LWIN || kbd->vkCode == VK_RWIN)) {
-                modifierReleased = TRUE;
-            }
-            if (modifierReleased) {
-                g_isKeyDown = FALSE;
-                printf("KEY_UP\n");
-                fflush(stdout);
-            }
-        }
+        if (kbd->time - g_lastEventTime > MODIFIER_RESYNC_IDLE_MS) ResyncModifierKeys();
+        g_lastEventTime = kbd->time;
 
-        if (g_useModifiersOnly) {
-            if (isKeyDown) {
-                if (!g_isKeyDown && AreModifiersPressed()) {
-                    g_isKeyDown = TRUE;
-                    printf("KEY_DOWN\n");
-                    fflush(stdout);
-                }
-            } else if (isKeyUp) {
-                if (g_isKeyDown && !AreModifiersPressed()) {
-                    g_isKeyDown = FALSE;
-                    printf("KEY_UP\n");
-                    fflush(stdout);
-                }
-            }
-            return CallNextHookEx(g_hook, nCode, wParam, lParam);
+        // Applied before the bindings run, so a modifier counts as held on
+        // its own key-down (GetAsyncKeyState only updates after the hook)
+        BYTE modifierKey = ModifierKeyForVk(kbd->vkCode);
+        if (modifierKey) {
+            if (isKeyDown) g_modifierKeys |= modifierKey;
+            else if (isKeyUp) g_modifierKeys &= (BYTE)~modifierKey;
         }
 
-        // Check for the target key
-        if (kbd->vkCode == g_targetVk) {
-            if (isKeyDown) {
-                // Only trigger if modifiers are satisfied and not already down
-                if (!g_isKeyDown && AreModifiersPressed()) {
-                    g_isKeyDown = TRUE;
-                    printf("KEY_DOWN\n");
-                    fflush(stdout);
-                }
-            } else if (isKeyUp) {
-                // Target key released
-                if (g_isKeyDown) {
-                    g_isKeyDown = FALSE;
-                    printf("KEY_UP\n");
-                    fflush(stdout);
-                }
+        DWORD mask = kbd->vkCode < 256 ? g_vkBindings[kbd->vkCode] : 0;
+        if (mask) {
+            for (int i = 0; mask; i++, mask >>= 1) {
+                if (mask & 1) UpdateBinding(&g_bindings[i], kbd, isKeyDown, isKeyUp);
             }
         }
     }
@@ -200,101 +531,219 @@ BOOL WINAPI ConsoleHandler(DWORD signal) {
     return TRUE;
 }
 
-// Parse a compound hotkey like "CommandOrControl+Shift+F11"
-// Sets g_requireCtrl, g_requireAlt, g_requireShift and returns the main key VK code
-DWORD ParseCompoundHotkey(const char* hotkey) {
-    char buffer[256];
-    strncpy(buffer, hotkey, sizeof(buffer) - 1);
-    buffer[sizeof(buffer) - 1] = '\0';
-
-    // Reset modifier requirements
-    g_requireCtrl = FALSE;
-    g_requireAlt = FALSE;
-    g_requireShift = FALSE;
-    g_requireWin = FALSE;
-    g_useModifiersOnly = FALSE;
-
-    DWORD mainKeyVk = 0;
-    char* token = strtok(buffer, "+");
+static BOOL IsValidBindingId(const char* id) {
+    size_t length = strlen(id);
+    if (length == 0 || length >= BINDING_ID_SIZE) return FALSE;
+    for (size_t i = 0; i < length; i++) {
+        if (id[i] == ':' || id[i] <= ' ') return FALSE;
+    }
+    return TRUE;
+}
 
-    while (token != NULL) {
-        // Trim leading/trailing spaces
-        while (*token == ' ') token++;
-        char* end = token + strlen(token) - 1;
-        while (end > token && *end == ' ') *end-- = '\0';
+/*
+ * Binding commands, answered in order with the paste commands:
+ *
+ *   BIND <id> <hotkey>  -> BIND_OK <id> <slot> | BIND_ERROR <code> <message>
+ *   UNBIND <id>         -> UNBIND_OK <id> | UNBIND_ERROR <code> <message>
+ *
+ * BIND on an existing id replaces its hotkey. The change is handed to the
+ * hook thread and applied between keystrokes, so the hook stays installed.
+ * Returns FALSE if line is not a binding command.
+ */
+static BOOL RunBindingCommand(char* line, char* reply, size_t replySize) {
+    char* context = NULL;
+    char* cmd = strtok_s(line, " \t\r\n", &context);
+    BOOL add = cmd && strcmp(cmd, "BIND") == 0;
+    if (!cmd || (!add && strcmp(cmd, "UNBIND") != 0)) return FALSE;
+
+    char* id = strtok_s(NULL, " \t\r\n", &context);
+    char* hotkey = add ? strtok_s(NULL, " \t\r\n", &context) : NULL;
+
+    BindingRequest request;
+    ZeroMemory(&request, sizeof(request));
+    request.add = add;
+    if (!id || !IsValidBindingId(id)) {
+        snprintf(reply, replySize, "%s_ERROR 1 invalid binding id", cmd);
+        return TRUE;
+    }
+    strcpy(request.binding.id, id);
+    if (add && (!hotkey || !ParseCompoundHotkey(hotkey, &request.binding))) {
+        snprintf(reply, replySize, "BIND_ERROR 1 invalid hotkey");
+        return TRUE;
+    }
 
-        // Check for modifiers
-        if (_stricmp(token, "CommandOrControl") == 0 ||
-            _stricmp(token, "Control") == 0 ||
-            _stricmp(token, "Ctrl") == 0 ||
-            _stricmp(token, "CmdOrCtrl") == 0) {
-            g_requireCtrl = TRUE;
-        } else if (_stricmp(token, "Alt") == 0 ||
-                   _stricmp(token, "Option") == 0) {
-            g_requireAlt = TRUE;
-        } else if (_stricmp(token, "Shift") == 0) {
-            g_requireShift = TRUE;
-        } else if (_stricmp(token, "Super") == 0 ||
-                   _stricmp(token, "Meta") == 0 ||
-                   _stricmp(token, "Win") == 0 ||
-                   _stricmp(token, "Command") == 0 ||
-                   _stricmp(token, "Cmd") == 0) {
-            // Windows key
-            g_requireWin = TRUE;
+    request.done = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (!request.done ||
+        !PostThreadMessage(g_mainThreadId, WM_BINDING_REQUEST, 0, (LPARAM)&request)) {
+        snprintf(reply, replySize, "%s_ERROR 4 hook thread unavailable (error %lu)", cmd,
+                 GetLastError());
+    } else {
+        WaitForSingleObject(request.done, INFINITE);
+        if (request.error) {
+            snprintf(reply, replySize, "%s_ERROR %s", cmd, request.error);
         } else {
-            // This should be the main key
-            mainKeyVk = ParseKeyCode(token);
+            if (add) {
+                snprintf(reply, replySize, "BIND_OK %s %d", id, request.slot);
+            } else {
+                snprintf(reply, replySize, "UNBIND_OK %s", id);
+            }
         }
+    }
+    if (request.done) CloseHandle(request.done);
+    return TRUE;
+}
 
-        token = strtok(NULL, "+");
+// Paste commands run here rather than on the hook thread: SendInput and the
+// paste delays would otherwise stall every keystroke in the system.
+static DWORD WINAPI CommandThread(LPVOID param) {
+    (void)param;
+    char line[512];
+    char scratch[512];
+    char reply[512];
+    int got;
+    while ((got = ReadCommandLine(line, sizeof(line), stdin)) != 0) {
+        BOOL keepRunning = TRUE;
+        reply[0] = '\0';
+        if (got < 0) {
+            snprintf(reply, sizeof(reply), "ERROR line too long (max %u bytes)",
+                     (unsigned)sizeof(line) - 2);
+        } else {
+            // strtok_s modifies its input, so the binding check parses a copy
+            memcpy(scratch, line, sizeof(line));
+            if (!RunBindingCommand(scratch, reply, sizeof(reply))) {
+                keepRunning = RunPasteCommand(line, stdin, reply, sizeof(reply));
+            }
+        }
+        if (reply[0]) {
+            EnterCriticalSection(&g_outputLock);
+            printf("%s\n", reply);
+            fflush(stdout);
+            LeaveCriticalSection(&g_outputLock);
+        }
+        if (!keepRunning) break;
     }
+    // QUIT or EOF (Electron exited): end the message loop
+    PostThreadMessage(g_mainThreadId, WM_QUIT, 0, 0);
+    return 0;
+}
 
-    return mainKeyVk;
+static void PrintUsage(const char* program) {
+    fprintf(stderr, "Usage: %s [<key>] [--bind <id> <key>]... [--serve] [--binary-events]\n",
+            program);
+    fprintf(stderr, "Examples:\n");
+    fprintf(stderr, "  %s `                        (backtick)\n", program);
+    fprintf(stderr, "  %s F8                       (function key F1-F12)\n", program);
+    fprintf(stderr, "  %s F13                      (extended function key F13-F24)\n", program);
+    fprintf(stderr, "  %s CommandOrControl+F11     (with modifier)\n", program);
+    fprintf(stderr, "  %s Ctrl+Shift+Space         (multiple modifiers)\n", program);
+    fprintf(stderr, "  %s F8 --bind cancel Escape  (second binding, reports KEY_DOWN:cancel)\n",
+            program);
 }
 
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        fprintf(stderr, "Usage: %s <key>\n", argv[0]);
-        fprintf(stderr, "Examples:\n");
-        fprintf(stderr, "  %s `                        (backtick)\n", argv[0]);
-        fprintf(stderr, "  %s F8                       (function key F1-F12)\n", argv[0]);
-        fprintf(stderr, "  %s F13                      (extended function key F13-F24)\n", argv[0]);
-        fprintf(stderr, "  %s CommandOrControl+F11     (with modifier)\n", argv[0]);
-        fprintf(stderr, "  %s Ctrl+Shift+Space         (multiple modifiers)\n", argv[0]);
-        return 1;
-    }
+    int bindingCount = 0;
+
+    for (int i = 1; i < argc; i++) {
+        Binding binding;
+        ZeroMemory(&binding, sizeof(binding));
+        const char* hotkey = NULL;
+
+        if (strcmp(argv[i], "--serve") == 0) {
+            g_serveMode = TRUE;
+            continue;
+        } else if (strcmp(argv[i], "--binary-events") == 0) {
+            g_binaryEvents = TRUE;
+            continue;
+        } else if (strcmp(argv[i], "--bind") == 0 && i + 2 < argc) {
+            if (!IsValidBindingId(argv[i + 1])) {
+                fprintf(stderr, "Error: Invalid binding id '%s'\n", argv[i + 1]);
+                return 1;
+            }
+            strcpy(binding.id, argv[i + 1]);
+            hotkey = argv[i + 2];
+            i += 2;
+        } else if (i == 1 && strncmp(argv[i], "--", 2) != 0) {
+            hotkey = argv[i];
+        } else {
+            continue;
+        }
 
-    g_targetVk = ParseCompoundHotkey(argv[1]);
-    if (g_targetVk == 0 && (g_requireCtrl || g_requireAlt || g_requireShift || g_requireWin)) {
-        g_useModifiersOnly = TRUE;
+        if (!ParseCompoundHotkey(hotkey, &binding)) {
+            fprintf(stderr, "Error: Invalid key '%s'\n", hotkey);
+            return 1;
+        }
+        if (ApplyBinding(TRUE, &binding, NULL) != NULL) {
+            fprintf(stderr, "Error: Too many bindings\n");
+            return 1;
+        }
+        bindingCount++;
+
+        // Log what we're listening for
+        fprintf(stderr, "Listening for: %s%s%s (VK=0x%02lX, Ctrl=%d, Alt=%d, Shift=%d, Win=%d, ModOnly=%d)\n",
+                binding.id, binding.id[0] ? "=" : "", hotkey, binding.vk,
+                !!(binding.modifiers & MOD_BIT_CTRL), !!(binding.modifiers & MOD_BIT_ALT),
+                !!(binding.modifiers & MOD_BIT_SHIFT), !!(binding.modifiers & MOD_BIT_WIN),
+                binding.vk == 0);
     }
 
-    if (g_targetVk == 0 && !g_useModifiersOnly) {
-        fprintf(stderr, "Error: Invalid key '%s'\n", argv[1]);
+    // Without --serve nothing could add a binding later
+    if (bindingCount == 0 && !g_serveMode) {
+        PrintUsage(argv[0]);
         return 1;
     }
 
-    // Log what we're listening for
-    fprintf(stderr, "Listening for: %s (VK=0x%02X, Ctrl=%d, Alt=%d, Shift=%d, Win=%d, ModOnly=%d)\n",
-            argv[1], g_targetVk, g_requireCtrl, g_requireAlt, g_requireShift, g_requireWin, g_useModifiersOnly);
-
     // Set up console handler for clean shutdown
     SetConsoleCtrlHandler(ConsoleHandler, TRUE);
 
-    // Install the low-level keyboard hook
+    // Start the event writer before the hook can produce anything
+    InitializeCriticalSection(&g_outputLock);
+    QueryPerformanceFrequency(&g_qpcFrequency);
+    g_ringSignal = CreateEvent(NULL, FALSE, FALSE, NULL);
+    HANDLE writer = g_ringSignal ? CreateThread(NULL, 0, WriterThread, NULL, 0, NULL) : NULL;
+    if (!writer) {
+        fprintf(stderr, "Error: Failed to start event writer (error %lu)\n", GetLastError());
+        return 1;
+    }
+    CloseHandle(writer);
+
+    // Install the low-level keyboard hook, starting from the real modifier state
+    ResyncModifierKeys();
+    g_lastEventTime = GetTickCount();
     g_hook = SetWindowsHookEx(WH_KEYBOARD_LL, LowLevelKeyboardProc, NULL, 0);
     if (!g_hook) {
         fprintf(stderr, "Error: Failed to install keyboard hook (error %lu)\n", GetLastError());
         return 1;
     }
 
+    // Records may contain 0x0A, which text-mode stdout would expand to CRLF
+    if (g_binaryEvents) _setmode(_fileno(stdout), _O_BINARY);
+
     // Signal that we're ready
+    EnterCriticalSection(&g_outputLock);
     printf("READY\n");
+    if (g_serveMode) {
+        g_mainThreadId = GetCurrentThreadId();
+        _setmode(_fileno(stdin), _O_BINARY);
+        printf("FEATURES paste detect type bind binary-events keys\n");
+        // Create the thread queue before the command thread can post to it
+        MSG peek;
+        PeekMessage(&peek, NULL, WM_USER, WM_USER, PM_NOREMOVE);
+        HANDLE thread = CreateThread(NULL, 0, CommandThread, NULL, 0, NULL);
+        if (thread) CloseHandle(thread);
+    }
     fflush(stdout);
+    LeaveCriticalSection(&g_outputLock);
 
-    // Message loop - required for low-level hooks to work
+    // Message loop - required for low-level hooks to work. Binding changes
+    // arrive here too, so they apply between hook callbacks.
     MSG msg;
     while (GetMessage(&msg, NULL, 0, 0) > 0) {
+        if (msg.hwnd == NULL && msg.message == WM_BINDING_REQUEST) {
+            BindingRequest* request = (BindingRequest*)msg.lParam;
+            request->error = ApplyBinding(request->add, &request->binding, &request->slot);
+            SetEvent(request->done);
+            continue;
+        }
         TranslateMessage(&msg);
         DispatchMessage(&msg);
     }
@@ -0,0 +1,515 @@
+/**
+ * Shared paste/typing core for the OpenWhispr Windows helpers
+ *
+ * Included by windows-fast-paste.c (one-shot and --server modes) and by
+ * windows-key-listener.c (--serve), so both binaries answer the same
+ * PASTE / DETECT / TYPE_TEXT command protocol from one implementation.
+ *
+ * Every event injected here carries OPENWHISPR_INPUT_TAG in dwExtraInfo,
+ * which lets the key listener's low-level hook skip our own keystrokes.
+ */
+
+#ifndef OPENWHISPR_WINDOWS_PASTE_CORE_H
+#define OPENWHISPR_WINDOWS_PASTE_CORE_H
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string.h>
+
+#define OPENWHISPR_INPUT_TAG ((ULONG_PTR)0x4F575350) /* "OWSP" */
+
+#include "terminal-classes.h"
+
+static BOOL IsTerminalClass(const char* className) {
+    return terminal_class_match(className) ? TRUE : FALSE;
+}
+
+/* INPUT events per SendInput call: large enough that typical dictations go
+ * out in one or two calls, small enough to stay well inside the input queue */
+#define TYPE_BATCH_EVENTS 256
+/* Largest TYPE_TEXT payload the command loop accepts */
+#define TYPE_TEXT_MAX_BYTES (1024 * 1024)
+
+static void SetKey(INPUT* input, WORD vk, WORD scan, DWORD flags) {
+    input->type = INPUT_KEYBOARD;
+    input->ki.wVk = vk;
+    input->ki.wScan = scan;
+    input->ki.dwFlags = flags;
+    input->ki.time = 0;
+    input->ki.dwExtraInfo = OPENWHISPR_INPUT_TAG;
+}
+
+static int SendPasteNormal(void) {
+    INPUT inputs[4];
+    ZeroMemory(inputs, sizeof(inputs));
+
+    SetKey(&inputs[0], VK_CONTROL, 0, 0);
+    SetKey(&inputs[1], 'V', 0, 0);
+    SetKey(&inputs[2], 'V', 0, KEYEVENTF_KEYUP);
+    SetKey(&inputs[3], VK_CONTROL, 0, KEYEVENTF_KEYUP);
+
+    UINT sent = SendInput(4, inputs, sizeof(INPUT));
+    return (sent == 4) ? 0 : 1;
+}
+
+static int SendPasteTerminal(void) {
+    INPUT inputs[6];
+    ZeroMemory(inputs, sizeof(inputs));
+
+    SetKey(&inputs[0], VK_CONTROL, 0, 0);
+    SetKey(&inputs[1], VK_SHIFT, 0, 0);
+    SetKey(&inputs[2], 'V', 0, 0);
+    SetKey(&inputs[3], 'V', 0, KEYEVENTF_KEYUP);
+    SetKey(&inputs[4], VK_SHIFT, 0, KEYEVENTF_KEYUP);
+    SetKey(&inputs[5], VK_CONTROL, 0, KEYEVENTF_KEYUP);
+
+    UINT sent = SendInput(6, inputs, sizeof(INPUT));
+    return (sent == 6) ? 0 : 1;
+}
+
+/* Type UTF-8 text as Unicode key events. Surrogate pairs are sent as two
+ * consecutive units, which SendInput delivers as one character. Newlines
+ * and tabs use their virtual keys since many controls ignore them as
+ * VK_PACKET characters. Returns the number of characters typed, or -1. */
+static int TypeText(const char* utf8, size_t length, int backspaces) {
+    int units = MultiByteToWideChar(CP_UTF8, 0, utf8, (int)length, NULL, 0);
+    if (units < 0 || (units == 0 && length > 0)) return -1;
+
+    WCHAR* text = (WCHAR*)malloc((units + 1) * sizeof(WCHAR));
+    if (!text) return -1;
+    MultiByteToWideChar(CP_UTF8, 0, utf8, (int)length, text, units);
+
+    INPUT batch[TYPE_BATCH_EVENTS];
+    UINT count = 0;
+    int typed = 0;
+
+    for (int i = 0; i < backspaces; i++) {
+        if (count + 2 > TYPE_BATCH_EVENTS) {
+            if (SendInput(count, batch, sizeof(INPUT)) != count) {
+                free(text);
+                return -1;
+            }
+            count = 0;
+        }
+        SetKey(&batch[count++], VK_BACK, 0, 0);
+        SetKey(&batch[count++], VK_BACK, 0, KEYEVENTF_KEYUP);
+    }
+
+    for (int i = 0; i < units; i++) {
+        WCHAR c = text[i];
+        if (c == L'\r') continue;
+
+        /* Flush when full, never splitting a surrogate pair across calls */
+        UINT needed = IS_HIGH_SURROGATE(c) ? 4 : 2;
+        if (count + needed > TYPE_BATCH_EVENTS && !IS_LOW_SURROGATE(c)) {
+            if (SendInput(count, batch, sizeof(INPUT)) != count) {
+                free(text);
+                return -1;
+            }
+            count = 0;
+        }
+
+        if (c == L'\n' || c == L'\t') {
+            WORD vk = c == L'\n' ? VK_RETURN : VK_TAB;
+            SetKey(&batch[count++], vk, 0, 0);
+            SetKey(&batch[count++], vk, 0, KEYEVENTF_KEYUP);
+        } else {
+            SetKey(&batch[count++], 0, c, KEYEVENTF_UNICODE);
+            SetKey(&batch[count++], 0, c, KEYEVENTF_UNICODE | KEYEVENTF_KEYUP);
+        }
+        if (!IS_LOW_SURROGATE(c)) typed++;
+    }
+
+    if (count > 0 && SendInput(count, batch, sizeof(INPUT)) != count) {
+        free(text);
+        return -1;
+    }
+    free(text);
+    return typed;
+}
+
+/* ---- Keystroke scripts ----
+ *
+ * A script is a space-separated list of steps, sent in one SendInput call:
+ *   enter, shift+enter, ctrl+a, tab, ...  a chord of modifiers and one key
+ *   paste                                  Ctrl+V, or Ctrl+Shift+V in terminals
+ *   wait:MS                                flush what is queued, sleep MS
+ * Modifiers are ctrl, shift, alt and win (super/meta); keys are a-z, 0-9,
+ * f1-f24 and the names in SCRIPT_KEYS. "paste enter" pastes and submits
+ * without a second round trip to the helper. */
+#define KEY_SCRIPT_MAX_STEPS 32
+#define KEY_SCRIPT_MAX_MODIFIERS 4
+#define KEY_SCRIPT_MAX_WAIT_MS 1000
+
+typedef struct {
+    const char* name;
+    WORD vk;
+    BOOL extended;
+} ScriptKeyName;
+
+static const ScriptKeyName SCRIPT_KEYS[] = {
+    {"enter", VK_RETURN, FALSE},   {"return", VK_RETURN, FALSE},  {"tab", VK_TAB, FALSE},
+    {"space", VK_SPACE, FALSE},    {"backspace", VK_BACK, FALSE}, {"escape", VK_ESCAPE, FALSE},
+    {"esc", VK_ESCAPE, FALSE},     {"delete", VK_DELETE, TRUE},   {"insert", VK_INSERT, TRUE},
+    {"home", VK_HOME, TRUE},       {"end", VK_END, TRUE},         {"pageup", VK_PRIOR, TRUE},
+    {"pagedown", VK_NEXT, TRUE},   {"up", VK_UP, TRUE},           {"down", VK_DOWN, TRUE},
+    {"left", VK_LEFT, TRUE},       {"right", VK_RIGHT, TRUE},     {NULL, 0, FALSE}
+};
+
+static const ScriptKeyName SCRIPT_MODIFIERS[] = {
+    {"ctrl", VK_CONTROL, FALSE}, {"control", VK_CONTROL, FALSE}, {"shift", VK_SHIFT, FALSE},
+    {"alt", VK_MENU, FALSE},     {"win", VK_LWIN, TRUE},         {"super", VK_LWIN, TRUE},
+    {"meta", VK_LWIN, TRUE},     {NULL, 0, FALSE}
+};
+
+typedef struct {
+    WORD modifiers[KEY_SCRIPT_MAX_MODIFIERS];
+    BOOL modifierExtended[KEY_SCRIPT_MAX_MODIFIERS];
+    int modifierCount;
+    WORD vk;
+    BOOL extended;
+    BOOL paste;
+    int waitMs; /* > 0: a wait step, nothing else is set */
+} ScriptStep;
+
+static BOOL LookupScriptKey(const ScriptKeyName* table, const char* name, WORD* vk,
+                            BOOL* extended) {
+    for (int i = 0; table[i].name != NULL; i++) {
+        if (_stricmp(name, table[i].name) == 0) {
+            *vk = table[i].vk;
+            *extended = table[i].extended;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static BOOL ParseScriptKey(const char* name, WORD* vk, BOOL* extended) {
+    *extended = FALSE;
+    size_t length = strlen(name);
+    if (length == 1 && isalnum((unsigned char)name[0])) {
+        *vk = (WORD)toupper((unsigned char)name[0]);
+        return TRUE;
+    }
+    if ((name[0] == 'f' || name[0] == 'F') && length >= 2 && length <= 3) {
+        int n = atoi(name + 1);
+        if (n >= 1 && n <= 24) {
+            *vk = (WORD)(VK_F1 + n - 1);
+            return TRUE;
+        }
+    }
+    return LookupScriptKey(SCRIPT_KEYS, name, vk, extended);
+}
+
+/* Parse one step such as "shift+enter" or "wait:50". Modifies token. */
+static BOOL ParseScriptStep(char* token, ScriptStep* step) {
+    ZeroMemory(step, sizeof(*step));
+
+    if (_strnicmp(token, "wait:", 5) == 0) {
+        step->waitMs = atoi(token + 5);
+        return step->waitMs > 0 && step->waitMs <= KEY_SCRIPT_MAX_WAIT_MS;
+    }
+
+    char* context = NULL;
+    char* part = strtok_s(token, "+", &context);
+    while (part) {
+        char* next = strtok_s(NULL, "+", &context);
+        if (!next) {
+            if (_stricmp(part, "paste") == 0 && step->modifierCount == 0) {
+                step->paste = TRUE;
+                return TRUE;
+            }
+            return ParseScriptKey(part, &step->vk, &step->extended);
+        }
+        if (step->modifierCount == KEY_SCRIPT_MAX_MODIFIERS ||
+            !LookupScriptKey(SCRIPT_MODIFIERS, part, &step->modifiers[step->modifierCount],
+                             &step->modifierExtended[step->modifierCount])) {
+            return FALSE;
+        }
+        step->modifierCount++;
+        part = next;
+    }
+    return FALSE;
+}
+
+/* Parse a whole script up front, so a typo sends nothing. Returns the step
+ * count, or -1 if a step is invalid or there are too many. Modifies script. */
+static int ParseKeyScript(char* script, ScriptStep* steps) {
+    int count = 0;
+    char* context = NULL;
+    char* token = strtok_s(script, " \t\r\n", &context);
+    while (token) {
+        if (count == KEY_SCRIPT_MAX_STEPS || !ParseScriptStep(token, &steps[count])) return -1;
+        count++;
+        token = strtok_s(NULL, " \t\r\n", &context);
+    }
+    return count > 0 ? count : -1;
+}
+
+static void AddChord(INPUT* events, UINT* count, const WORD* modifiers, const BOOL* extended,
+                     int modifierCount, WORD vk, BOOL vkExtended) {
+    for (int i = 0; i < modifierCount; i++) {
+        SetKey(&events[(*count)++], modifiers[i], 0, extended[i] ? KEYEVENTF_EXTENDEDKEY : 0);
+    }
+    DWORD flags = vkExtended ? KEYEVENTF_EXTENDEDKEY : 0;
+    SetKey(&events[(*count)++], vk, 0, flags);
+    SetKey(&events[(*count)++], vk, 0, flags | KEYEVENTF_KEYUP);
+    for (int i = modifierCount - 1; i >= 0; i--) {
+        SetKey(&events[(*count)++], modifiers[i], 0,
+               (extended[i] ? KEYEVENTF_EXTENDEDKEY : 0) | KEYEVENTF_KEYUP);
+    }
+}
+
+/* Send parsed steps, batching everything between waits into one SendInput
+ * call. Returns the number of events sent, or -1 if SendInput failed. */
+static int SendKeyScript(const ScriptStep* steps, int stepCount, BOOL isTerminal) {
+    static const WORD pasteModifiers[] = {VK_CONTROL, VK_SHIFT};
+    static const BOOL pasteExtended[] = {FALSE, FALSE};
+    INPUT events[KEY_SCRIPT_MAX_STEPS * 2 * (KEY_SCRIPT_MAX_MODIFIERS + 1)];
+    UINT count = 0;
+    int sent = 0;
+
+    for (int i = 0; i <= stepCount; i++) {
+        BOOL flush = i == stepCount || steps[i].waitMs > 0;
+        if (flush && count > 0) {
+            if (SendInput(count, events, sizeof(INPUT)) != count) return -1;
+            sent += (int)count;
+            count = 0;
+        }
+        if (i == stepCount) break;
+
+        const ScriptStep* step = &steps[i];
+        if (step->waitMs > 0) {
+            Sleep(step->waitMs);
+        } else if (step->paste) {
+            AddChord(events, &count, pasteModifiers, pasteExtended, isTerminal ? 2 : 1, 'V', FALSE);
+        } else {
+            AddChord(events, &count, step->modifiers, step->modifierExtended, step->modifierCount,
+                     step->vk, step->extended);
+        }
+    }
+    return sent;
+}
+
+/* Last foreground window and its class. Class names never change for the
+ * life of a window, so repeated pastes into the same app skip the lookup. */
+static HWND g_cachedHwnd = NULL;
+static char g_cachedClass[256];
+static BOOL g_cachedIsTerminal = FALSE;
+
+static BOOL LookupWindowClass(HWND hwnd, const char** className, BOOL* isTerminal) {
+    if (hwnd != g_cachedHwnd || !IsWindow(hwnd)) {
+        if (GetClassNameA(hwnd, g_cachedClass, sizeof(g_cachedClass)) == 0) {
+            g_cachedHwnd = NULL;
+            return FALSE;
+        }
+        g_cachedHwnd = hwnd;
+        g_cachedIsTerminal = IsTerminalClass(g_cachedClass);
+    }
+    *className = g_cachedClass;
+    *isTerminal = g_cachedIsTerminal;
+    return TRUE;
+}
+
+static LARGE_INTEGER g_qpcFrequency;
+
+/* QueryPerformanceCounter ticks in microseconds. Both helpers report times on
+ * this clock, so a KEY_UP from the listener and a paste start compare directly.
+ * Split into whole seconds and remainder so the multiply cannot overflow. */
+static long long QpcTicksToMicros(LONGLONG ticks) {
+    if (g_qpcFrequency.QuadPart == 0) QueryPerformanceFrequency(&g_qpcFrequency);
+    return (long long)(ticks / g_qpcFrequency.QuadPart * 1000000LL +
+                       ticks % g_qpcFrequency.QuadPart * 1000000LL / g_qpcFrequency.QuadPart);
+}
+
+static long long MonotonicMicros(void) {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return QpcTicksToMicros(now.QuadPart);
+}
+
+/*
+ * fgets for the command loops: returns 1 with a line in line, 0 on EOF, or -1
+ * if the line did not fit in size bytes. The rest of an over-long line is
+ * read and dropped, so it can't be taken for a second command (and reply).
+ */
+static int ReadCommandLine(char* line, size_t size, FILE* in) {
+    if (!fgets(line, (int)size, in)) return 0;
+    if (strchr(line, '\n') || feof(in)) return 1;
+    int c;
+    while ((c = fgetc(in)) != EOF && c != '\n') {
+    }
+    return -1;
+}
+
+/*
+ * Run one command of the resident paste protocol and write its single reply
+ * line (without newline) into reply; reply is left empty for blank lines.
+ * TYPE_TEXT payload bytes are read from in. Returns FALSE on QUIT or when the
+ * input stream broke mid-payload, which ends the caller's command loop.
+ *
+ *   PASTE [--pre-delay MS] [--post-delay MS]
+ *       -> PASTE_OK <class> <combo> <elapsed_us> <start_us> | PASTE_ERROR <code> <message>
+ *   DETECT
+ *       -> DETECT_OK <hwnd> <0|1> <class> | DETECT_ERROR <code> <message>
+ *   TYPE_TEXT <nbytes> [--backspace N] [--require-window HWND] + <nbytes of UTF-8>
+ *       -> TYPE_OK <elapsed_us> <chars> <start_us> | TYPE_ERROR <code> <message>
+ *   KEYS [--terminal] [--require-window HWND] <script...>
+ *       -> KEYS_OK <elapsed_us> <events> <start_us> | KEYS_ERROR <code> <message>
+ *   QUIT
+ *
+ * start_us is MonotonicMicros() when the command began. The delays default
+ * to the one-shot values (5 ms before, 20 ms after). KEYS takes the rest of
+ * the line as a keystroke script (see SendKeyScript); "paste" steps follow
+ * the foreground window's class unless --terminal forces Ctrl+Shift+V.
+ * Error 8 means the script did not parse and nothing was sent. A TYPE_TEXT
+ * over TYPE_TEXT_MAX_BYTES is refused with error 11 before anything is
+ * allocated, and the command loop then ends: the payload can't be skipped
+ * without trusting its byte count.
+ */
+static BOOL RunPasteCommand(char* line, FILE* in, char* reply, size_t replySize) {
+    reply[0] = '\0';
+
+    char* context = NULL;
+    char* cmd = strtok_s(line, " \t\r\n", &context);
+    if (!cmd) return TRUE;
+
+    if (strcmp(cmd, "QUIT") == 0) return FALSE;
+
+    long long start = MonotonicMicros();
+    int preDelay = 5;
+    int postDelay = 20;
+    int backspaces = 0;
+    size_t textLength = 0;
+    HWND requireWindow = NULL;
+
+    if (strcmp(cmd, "KEYS") == 0) {
+        /* Options come first; every other token is a script step */
+        ScriptStep steps[KEY_SCRIPT_MAX_STEPS];
+        int stepCount = 0;
+        BOOL forceTerminal = FALSE;
+        BOOL valid = TRUE;
+        char* arg;
+        while (valid && (arg = strtok_s(NULL, " \t\r\n", &context)) != NULL) {
+            char* value = NULL;
+            if (stepCount == 0 && strcmp(arg, "--terminal") == 0) {
+                forceTerminal = TRUE;
+            } else if (stepCount == 0 && strcmp(arg, "--require-window") == 0 &&
+                       (value = strtok_s(NULL, " \t\r\n", &context))) {
+                requireWindow = (HWND)(UINT_PTR)strtoull(value, NULL, 0);
+            } else if (stepCount < KEY_SCRIPT_MAX_STEPS && ParseScriptStep(arg, &steps[stepCount])) {
+                stepCount++;
+            } else {
+                valid = FALSE;
+            }
+        }
+
+        HWND hwnd = GetForegroundWindow();
+        if (!valid || stepCount == 0) {
+            snprintf(reply, replySize, "KEYS_ERROR 8 invalid key script");
+        } else if (requireWindow && hwnd != requireWindow) {
+            snprintf(reply, replySize, "KEYS_ERROR 7 foreground window changed");
+        } else {
+            const char* className = NULL;
+            BOOL isTerminal = forceTerminal;
+            if (!forceTerminal && hwnd) LookupWindowClass(hwnd, &className, &isTerminal);
+            int sent = SendKeyScript(steps, stepCount, isTerminal);
+            if (sent < 0) {
+                snprintf(reply, replySize, "KEYS_ERROR 1 SendInput failed (error %lu)",
+                         GetLastError());
+            } else {
+                snprintf(reply, replySize, "KEYS_OK %lld %d %lld", MonotonicMicros() - start, sent,
+                         start);
+            }
+        }
+        return TRUE;
+    }
+
+    BOOL typeText = strcmp(cmd, "TYPE_TEXT") == 0;
+    if (typeText) {
+        char* lengthArg = strtok_s(NULL, " \t\r\n", &context);
+        textLength = lengthArg ? (size_t)strtoul(lengthArg, NULL, 10) : 0;
+    }
+
+    char* arg;
+    while ((arg = strtok_s(NULL, " \t\r\n", &context)) != NULL) {
+        char* value = NULL;
+        if (strcmp(arg, "--pre-delay") == 0 && (value = strtok_s(NULL, " \t\r\n", &context))) {
+            preDelay = atoi(value);
+        } else if (strcmp(arg, "--post-delay") == 0 &&
+                   (value = strtok_s(NULL, " \t\r\n", &context))) {
+            postDelay = atoi(value);
+        } else if (strcmp(arg, "--backspace") == 0 &&
+                   (value = strtok_s(NULL, " \t\r\n", &context))) {
+            backspaces = atoi(value);
+        } else if (strcmp(arg, "--require-window") == 0 &&
+                   (value = strtok_s(NULL, " \t\r\n", &context))) {
+            requireWindow = (HWND)(UINT_PTR)strtoull(value, NULL, 0);
+        }
+    }
+
+    if (typeText && textLength > TYPE_TEXT_MAX_BYTES) {
+        snprintf(reply, replySize, "TYPE_ERROR 11 payload too large");
+        return FALSE;
+    }
+
+    if (typeText) {
+        /* Always consume the payload so the stream stays in sync */
+        char* text = (char*)malloc(textLength ? textLength : 1);
+        if (!text || fread(text, 1, textLength, in) != textLength) {
+            free(text);
+            return FALSE;
+        }
+        if (requireWindow && GetForegroundWindow() != requireWindow) {
+            snprintf(reply, replySize, "TYPE_ERROR 7 foreground window changed");
+        } else {
+            int typed = TypeText(text, textLength, backspaces);
+            if (typed < 0) {
+                snprintf(reply, replySize, "TYPE_ERROR 1 SendInput failed (error %lu)",
+                         GetLastError());
+            } else {
+                snprintf(reply, replySize, "TYPE_OK %lld %d %lld", MonotonicMicros() - start,
+                         typed, start);
+            }
+        }
+        free(text);
+        return TRUE;
+    }
+
+    BOOL detect = strcmp(cmd, "DETECT") == 0;
+    if (!detect && strcmp(cmd, "PASTE") != 0) {
+        snprintf(reply, replySize, "ERROR unknown command %s", cmd);
+        return TRUE;
+    }
+
+    const char* prefix = detect ? "DETECT" : "PASTE";
+    HWND hwnd = GetForegroundWindow();
+    const char* className = NULL;
+    BOOL isTerminal = FALSE;
+    if (!hwnd) {
+        snprintf(reply, replySize, "%s_ERROR 2 no foreground window", prefix);
+    } else if (!LookupWindowClass(hwnd, &className, &isTerminal)) {
+        snprintf(reply, replySize, "%s_ERROR 1 could not get window class (error %lu)", prefix,
+                 GetLastError());
+    } else if (detect) {
+        snprintf(reply, replySize, "DETECT_OK 0x%llx %d %s", (unsigned long long)(UINT_PTR)hwnd,
+                 isTerminal ? 1 : 0, className);
+    } else {
+        if (preDelay > 0) Sleep(preDelay);
+        int result = isTerminal ? SendPasteTerminal() : SendPasteNormal();
+        if (result != 0) {
+            snprintf(reply, replySize, "PASTE_ERROR 1 SendInput failed (error %lu)",
+                     GetLastError());
+        } else {
+            if (postDelay > 0) Sleep(postDelay);
+            snprintf(reply, replySize, "PASTE_OK %s %s %lld %lld", className,
+                     isTerminal ? "ctrl+shift+v" : "ctrl+v", MonotonicMicros() - start, start);
+        }
+    }
+    return TRUE;
+}
+
+#endif /* OPENWHISPR_WINDOWS_PASTE_CORE_H */
@@ -0,0 +1,374 @@
+#!/usr/bin/env node
+/**
+ * Micro-benchmark for the native paste helpers.
+ *
+ * Runs the platform's helper N times against a throwaway test window and
+ * prints p50/p95/p99 per phase, for one-shot mode (a process per paste, as
+ * before the resident helpers) and daemon mode (one resident process):
+ *
+ *   spawn    spawn() until the process is running
+ *   connect  one-shot: launch overhead outside the paste itself (process start,
+ *            display connection); daemon: spawn until READY
+ *   total    one-shot: spawn until exit; daemon: command until reply
+ *   focus    the helper's own wait for the target window (linux-fast-paste)
+ *   inject   the helper's own paste time after focus
+ *
+ * Linux: starts Xvfb when there is no DISPLAY (or with --xvfb) and pastes into
+ * an xev window, so nothing lands in your real session. Needs Xvfb, xev and
+ * xwininfo (x11-utils).
+ *
+ * Windows: pastes into a small WinForms TextBox started through PowerShell.
+ * Keyboard input only reaches a foreground window, so the test window is shown
+ * (topmost, 200x60) rather than hidden; don't type while it runs.
+ *
+ * Usage: node scripts/bench-native-paste.js [--iterations N] [--mode oneshot|daemon|both]
+ *                                           [--xvfb] [--json] [--output FILE]
+ */
+
+const { spawn, spawnSync } = require("child_process");
+const fs = require("fs");
+const path = require("path");
+
+const projectRoot = path.resolve(__dirname, "..");
+const binDir = path.join(projectRoot, "resources", "bin");
+
+const TARGET_TITLE = "openwhispr-paste-bench";
+const COMMAND_TIMEOUT_MS = 5000;
+// Let the target drain each paste so runs don't queue behind each other
+const SETTLE_MS = 30;
+
+function log(message) {
+  console.error(`[bench-native-paste] ${message}`);
+}
+
+function parseArgs(argv) {
+  const options = { iterations: 50, mode: "both", xvfb: false, json: false, output: null };
+  for (let i = 0; i < argv.length; i += 1) {
+    const arg = argv[i];
+    if (arg === "--iterations" && argv[i + 1]) {
+      options.iterations = Math.max(1, parseInt(argv[++i], 10) || options.iterations);
+    } else if (arg === "--mode" && argv[i + 1]) {
+      options.mode = argv[++i];
+    } else if (arg === "--xvfb") {
+      options.xvfb = true;
+    } else if (arg === "--json") {
+      options.json = true;
+    } else if (arg === "--output" && argv[i + 1]) {
+      options.output = argv[++i];
+    } else {
+      console.error(`Unknown argument: ${arg}`);
+      process.exit(1);
+    }
+  }
+  if (!["oneshot", "daemon", "both"].includes(options.mode)) {
+    console.error(`--mode must be oneshot, daemon or both`);
+    process.exit(1);
+  }
+  return options;
+}
+
+const sleep = (ms) => new Promise((resolve) => setTimeout(resolve, ms));
+const nowMs = () => Number(process.hrtime.bigint()) / 1e6;
+
+function percentile(sorted, p) {
+  if (sorted.length === 0) return null;
+  const index = Math.min(sorted.length - 1, Math.ceil((p / 100) * sorted.length) - 1);
+  return sorted[Math.max(index, 0)];
+}
+
+function summarize(samples) {
+  const summary = {};
+  for (const [phase, values] of Object.entries(samples)) {
+    if (values.length === 0) continue;
+    const sorted = [...values].sort((a, b) => a - b);
+    const round = (value) => Math.round(value * 1000) / 1000;
+    summary[phase] = {
+      n: sorted.length,
+      p50: round(percentile(sorted, 50)),
+      p95: round(percentile(sorted, 95)),
+      p99: round(percentile(sorted, 99)),
+      min: round(sorted[0]),
+      max: round(sorted[sorted.length - 1]),
+    };
+  }
+  return summary;
+}
+
+function hasCommand(command) {
+  const probe = spawnSync(process.platform === "win32" ? "where" : "which", [command]);
+  return probe.status === 0;
+}
+
+function waitForLine(proc, predicate, timeoutMs, label) {
+  return new Promise((resolve, reject) => {
+    let buffer = "";
+    const timer = setTimeout(() => {
+      cleanup();
+      reject(new Error(`Timed out waiting for ${label}`));
+    }, timeoutMs);
+    const onData = (chunk) => {
+      buffer += chunk.toString();
+      let newline;
+      while ((newline = buffer.indexOf("\n")) !== -1) {
+        const line = buffer.slice(0, newline).trim();
+        buffer = buffer.slice(newline + 1);
+        if (predicate(line)) {
+          cleanup();
+          resolve(line);
+          return;
+        }
+      }
+    };
+    const onExit = (code) => {
+      cleanup();
+      reject(new Error(`${label}: process exited with code ${code}`));
+    };
+    const cleanup = () => {
+      clearTimeout(timer);
+      proc.stdout.off("data", onData);
+      proc.off("exit", onExit);
+    };
+    proc.stdout.on("data", onData);
+    proc.on("exit", onExit);
+  });
+}
+
+// --- Test targets ---------------------------------------------------------
+
+async function startLinuxTarget(options) {
+  const cleanups = [];
+  if (options.xvfb || !process.env.DISPLAY) {
+    if (!hasCommand("Xvfb")) throw new Error("Xvfb not found (install xvfb) and no DISPLAY set");
+    const display = `:${90 + (process.pid % 9)}`;
+    const xvfb = spawn("Xvfb", [display, "-screen", "0", "1024x768x24", "-nolisten", "tcp"], {
+      stdio: "ignore",
+    });
+    cleanups.push(() => xvfb.kill());
+    process.env.DISPLAY = display;
+    await sleep(500);
+    log(`Started Xvfb on ${display}`);
+  }
+
+  for (const tool of ["xev", "xwininfo"]) {
+    if (!hasCommand(tool)) throw new Error(`${tool} not found (install x11-utils)`);
+  }
+  const xev = spawn("xev", ["-name", TARGET_TITLE, "-event", "keyboard"], {
+    stdio: ["ignore", "pipe", "ignore"],
+  });
+  // xev reports every key event; drain it so the pipe never fills
+  xev.stdout.resume();
+  cleanups.push(() => xev.kill());
+
+  let windowId = null;
+  for (let attempt = 0; attempt < 50 && !windowId; attempt += 1) {
+    await sleep(100);
+    const info = spawnSync("xwininfo", ["-name", TARGET_TITLE], { encoding: "utf8" });
+    windowId = /Window id: (0x[0-9a-f]+)/i.exec(info.stdout || "")?.[1] || null;
+  }
+  if (!windowId) throw new Error("Test window did not appear");
+  log(`Test window ${windowId} on ${process.env.DISPLAY}`);
+
+  return { windowId, stop: () => cleanups.reverse().forEach((cleanup) => cleanup()) };
+}
+
+async function startWindowsTarget() {
+  const script = [
+    "Add-Type -AssemblyName System.Windows.Forms",
+    "$form = New-Object System.Windows.Forms.Form",
+    `$form.Text = '${TARGET_TITLE}'`,
+    "$form.TopMost = $true",
+    "$form.StartPosition = 'Manual'",
+    "$form.Location = New-Object System.Drawing.Point(0, 0)",
+    "$form.Size = New-Object System.Drawing.Size(200, 60)",
+    "$box = New-Object System.Windows.Forms.TextBox",
+    "$box.Multiline = $true",
+    "$box.MaxLength = 0",
+    "$box.Dock = 'Fill'",
+    "$form.Controls.Add($box)",
+    "$form.Add_Shown({ $form.Activate(); $box.Focus(); [Console]::Out.WriteLine('READY'); })",
+    // Keep the control small so thousands of pastes don't slow it down
+    "$box.Add_TextChanged({ if ($box.TextLength -gt 10000) { $box.Clear() } })",
+    "[System.Windows.Forms.Application]::Run($form)",
+  ].join("; ");
+  const proc = spawn("powershell.exe", ["-NoProfile", "-STA", "-Command", script], {
+    stdio: ["ignore", "pipe", "ignore"],
+    windowsHide: false,
+  });
+  await waitForLine(proc, (line) => line === "READY", 15000, "test window");
+  log("Test window ready");
+  return { windowId: null, stop: () => proc.kill() };
+}
+
+// --- Helpers under test ---------------------------------------------------
+
+function helperFor(platform, target) {
+  if (platform === "linux") {
+    const windowArgs = target.windowId ? ["--window", target.windowId] : [];
+    return {
+      name: "linux-fast-paste",
+      binary: path.join(binDir, "linux-fast-paste"),
+      oneShotArgs: windowArgs,
+      daemonArgs: ["--daemon"],
+      command: ["PASTE", ...windowArgs].join(" "),
+      // PASTE_OK <elapsed_us> <focus_us> [<start_us> ...]
+      parse(line) {
+        const [status, elapsedUs, focusUs] = line.split(/\s+/);
+        if (status !== "PASTE_OK") return null;
+        const elapsedMs = Number(elapsedUs) / 1000;
+        const focusMs = Number(focusUs) / 1000;
+        return { elapsedMs, focusMs, injectMs: Math.max(elapsedMs - focusMs, 0) };
+      },
+    };
+  }
+  if (platform === "win32") {
+    return {
+      name: "windows-fast-paste",
+      binary: path.join(binDir, "windows-fast-paste.exe"),
+      oneShotArgs: [],
+      daemonArgs: ["--server"],
+      // The timings clipboard.js uses with the resident server
+      command: "PASTE --pre-delay 5 --post-delay 0",
+      // PASTE_OK <class> <combo> <elapsed_us> <start_us>; one-shot replies omit timing
+      parse(line) {
+        const fields = line.split(/\s+/);
+        if (fields[0] !== "PASTE_OK") return null;
+        if (fields.length < 5) return {};
+        return { injectMs: Number(fields[fields.length - 2]) / 1000 };
+      },
+    };
+  }
+  return null;
+}
+
+async function runOneShot(helper, iterations) {
+  const samples = { spawn: [], connect: [], total: [], focus: [], inject: [] };
+  for (let i = 0; i < iterations; i += 1) {
+    const result = await new Promise((resolve, reject) => {
+      const start = nowMs();
+      let spawnedAt = null;
+      let stdout = "";
+      const proc = spawn(helper.binary, helper.oneShotArgs, { stdio: ["ignore", "pipe", "pipe"] });
+      proc.on("spawn", () => {
+        spawnedAt = nowMs();
+      });
+      proc.stdout.on("data", (chunk) => {
+        stdout += chunk.toString();
+      });
+      proc.stderr.resume();
+      const timer = setTimeout(() => proc.kill("SIGKILL"), COMMAND_TIMEOUT_MS);
+      proc.on("error", reject);
+      proc.on("exit", (code) => {
+        clearTimeout(timer);
+        if (code !== 0) {
+          reject(new Error(`${helper.name} exited with code ${code}`));
+          return;
+        }
+        resolve({ start, spawnedAt: spawnedAt ?? start, end: nowMs(), stdout });
+      });
+    });
+
+    const timing = helper.parse(result.stdout.trim().split("\n").pop() || "") || {};
+    const totalMs = result.end - result.start;
+    samples.spawn.push(result.spawnedAt - result.start);
+    samples.total.push(totalMs);
+    if (timing.elapsedMs !== undefined) samples.connect.push(totalMs - timing.elapsedMs);
+    if (timing.focusMs !== undefined) samples.focus.push(timing.focusMs);
+    if (timing.injectMs !== undefined) samples.inject.push(timing.injectMs);
+    await sleep(SETTLE_MS);
+  }
+  return samples;
+}
+
+async function runDaemon(helper, iterations) {
+  const samples = { spawn: [], connect: [], total: [], focus: [], inject: [] };
+
+  const start = nowMs();
+  const proc = spawn(helper.binary, helper.daemonArgs, { stdio: ["pipe", "pipe", "pipe"] });
+  proc.stderr.resume();
+  proc.on("spawn", () => samples.spawn.push(nowMs() - start));
+  await waitForLine(proc, (line) => line === "READY", COMMAND_TIMEOUT_MS, `${helper.name} READY`);
+  samples.connect.push(nowMs() - start);
+
+  try {
+    for (let i = 0; i < iterations; i += 1) {
+      const sent = nowMs();
+      const reply = waitForLine(proc, (line) => line.length > 0, COMMAND_TIMEOUT_MS, "reply");
+      proc.stdin.write(`${helper.command}\n`);
+      const line = await reply;
+      samples.total.push(nowMs() - sent);
+
+      const timing = helper.parse(line);
+      if (!timing) throw new Error(`${helper.name}: ${line}`);
+      if (timing.focusMs !== undefined) samples.focus.push(timing.focusMs);
+      if (timing.injectMs !== undefined) samples.inject.push(timing.injectMs);
+      await sleep(SETTLE_MS);
+    }
+  } finally {
+    proc.stdin.end("QUIT\n");
+  }
+  return samples;
+}
+
+function printTable(results) {
+  for (const [mode, summary] of Object.entries(results.modes)) {
+    console.log(`\n${results.helper} ${mode} (${results.iterations} pastes, ms)`);
+    console.log("phase        p50       p95       p99       min       max");
+    for (const [phase, stats] of Object.entries(summary)) {
+      const cells = [stats.p50, stats.p95, stats.p99, stats.min, stats.max].map((value) =>
+        value.toFixed(3).padStart(9)
+      );
+      console.log(`${phase.padEnd(8)}${cells.join(" ")}${stats.n === 1 ? "  (once)" : ""}`);
+    }
+  }
+}
+
+async function main() {
+  const options = parseArgs(process.argv.slice(2));
+  const platform = process.platform;
+  if (platform !== "linux" && platform !== "win32") {
+    // macos-fast-paste would paste into whatever app is frontmost
+    log("Only Linux (Xvfb) and Windows test targets are supported");
+    process.exit(0);
+  }
+
+  const target = platform === "linux" ? await startLinuxTarget(options) : await startWindowsTarget();
+  const helper = helperFor(platform, target);
+  try {
+    if (!fs.existsSync(helper.binary)) {
+      throw new Error(`${helper.binary} not found; run npm run compile:native first`);
+    }
+
+    const results = {
+      helper: helper.name,
+      platform,
+      iterations: options.iterations,
+      date: new Date().toISOString(),
+      modes: {},
+    };
+    if (options.mode !== "daemon") {
+      log(`Running ${options.iterations} one-shot pastes`);
+      results.modes.oneshot = summarize(await runOneShot(helper, options.iterations));
+    }
+    if (options.mode !== "oneshot") {
+      log(`Running ${options.iterations} daemon pastes`);
+      results.modes.daemon = summarize(await runDaemon(helper, options.iterations));
+    }
+
+    if (options.json) {
+      console.log(JSON.stringify(results, null, 2));
+    } else {
+      printTable(results);
+    }
+    if (options.output) {
+      fs.writeFileSync(options.output, JSON.stringify(results, null, 2));
+      log(`Results written to ${options.output}`);
+    }
+  } finally {
+    target.stop();
+  }
+}
+
+main().catch((error) => {
+  console.error(`[bench-native-paste] ${error.message}`);
+  process.exit(1);
+});
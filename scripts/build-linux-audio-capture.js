@@ -0,0 +1,116 @@
+#!/usr/bin/env node
+
+const { spawnSync } = require("child_process");
+const crypto = require("crypto");
+const fs = require("fs");
+const path = require("path");
+
+const isLinux = process.platform === "linux";
+if (!isLinux) {
+  process.exit(0);
+}
+
+const projectRoot = path.resolve(__dirname, "..");
+const cSource = path.join(projectRoot, "resources", "linux-audio-capture.c");
+// Voice activity detection shared by the audio capture helpers
+const vadHeader = path.join(projectRoot, "resources", "audio-vad.h");
+const outputDir = path.join(projectRoot, "resources", "bin");
+const outputBinary = path.join(outputDir, "linux-audio-capture");
+const hashFile = path.join(outputDir, ".linux-audio-capture.hash");
+
+function log(message) {
+  console.log(`[linux-audio-capture] ${message}`);
+}
+
+function ensureDir(dirPath) {
+  if (!fs.existsSync(dirPath)) {
+    fs.mkdirSync(dirPath, { recursive: true });
+  }
+}
+
+if (!fs.existsSync(cSource)) {
+  console.error(`[linux-audio-capture] C source not found at ${cSource}`);
+  process.exit(1);
+}
+
+ensureDir(outputDir);
+
+let needsBuild = true;
+if (fs.existsSync(outputBinary)) {
+  try {
+    const binaryStat = fs.statSync(outputBinary);
+    const sourceStat = fs.statSync(cSource);
+    const headerStat = fs.statSync(vadHeader);
+    if (binaryStat.mtimeMs >= Math.max(sourceStat.mtimeMs, headerStat.mtimeMs)) {
+      needsBuild = false;
+    }
+  } catch {
+    needsBuild = true;
+  }
+}
+
+function computeBuildHash() {
+  const sourceContent = fs.readFileSync(cSource, "utf8") + fs.readFileSync(vadHeader, "utf8");
+  return crypto.createHash("sha256").update(sourceContent).digest("hex");
+}
+
+if (!needsBuild && fs.existsSync(outputBinary)) {
+  try {
+    const currentHash = computeBuildHash();
+
+    if (fs.existsSync(hashFile)) {
+      const savedHash = fs.readFileSync(hashFile, "utf8").trim();
+      if (savedHash !== currentHash) {
+        log("Source changed, rebuild needed");
+        needsBuild = true;
+      }
+    } else {
+      fs.writeFileSync(hashFile, currentHash);
+    }
+  } catch (err) {
+    log(`Hash check failed: ${err.message}, forcing rebuild`);
+    needsBuild = true;
+  }
+}
+
+if (!needsBuild) {
+  process.exit(0);
+}
+
+function attemptCompile(command, args) {
+  log(`Compiling with ${[command, ...args].join(" ")}`);
+  return spawnSync(command, args, {
+    stdio: "inherit",
+    env: process.env,
+  });
+}
+
+// Talks the PulseAudio protocol, which pipewire-pulse also serves
+const compileArgs = ["-O2", cSource, "-o", outputBinary, "-lpulse-simple", "-lpulse", "-lpthread"];
+
+let result = attemptCompile("gcc", compileArgs);
+
+if (result.status !== 0) {
+  result = attemptCompile("cc", compileArgs);
+}
+
+if (result.status !== 0) {
+  console.warn(
+    "[linux-audio-capture] Failed to compile Linux audio capture helper. Install libpulse-dev to enable native recording. Falling back to MediaRecorder."
+  );
+  process.exit(0);
+}
+
+try {
+  fs.chmodSync(outputBinary, 0o755);
+} catch (error) {
+  console.warn(`[linux-audio-capture] Unable to set executable permissions: ${error.message}`);
+}
+
+try {
+  fs.writeFileSync(hashFile, computeBuildHash());
+} catch (err) {
+  log(`Warning: Could not save source hash: ${err.message}`);
+}
+
+log("Successfully built Linux audio capture binary.");
@@ -4,6 +4,7 @@ const { spawnSync } = require("child_process");
 const crypto = require("crypto");
 const fs = require("fs");
 const path = require("path");
+const { generateTerminalClassHeader } = require("./lib/terminal-classes");
 
 const isLinux = process.platform === "linux";
 if (!isLinux) {
@@ -33,12 +34,16 @@ if (!fs.existsSync(cSource)) {
 
 ensureDir(outputDir);
 
+// Shared terminal class table, generated from src/config/terminalClasses.json
+const terminalHeader = generateTerminalClassHeader();
+
 let needsBuild = true;
 if (fs.existsSync(outputBinary)) {
   try {
     const binaryStat = fs.statSync(outputBinary);
     const sourceStat = fs.statSync(cSource);
-    if (binaryStat.mtimeMs >= sourceStat.mtimeMs) {
+    const headerStat = fs.statSync(terminalHeader);
+    if (binaryStat.mtimeMs >= Math.max(sourceStat.mtimeMs, headerStat.mtimeMs)) {
       needsBuild = false;
     }
   } catch {
@@ -46,11 +51,11 @@ if (fs.existsSync(outputBinary)) {
   }
 }
 
-function hasUinputHeaders() {
+function hasHeader(header) {
   for (const compiler of ["gcc", "cc"]) {
     try {
       const result = spawnSync(compiler, ["-E", "-x", "c", "-"], {
-        input: "#include <linux/uinput.h>\n",
+        input: `#include <${header}>\n`,
         stdio: ["pipe", "pipe", "pipe"],
         env: process.env,
       });
@@ -60,11 +65,16 @@ function hasUinputHeaders() {
   return false;
 }
 
-const uinputAvailable = hasUinputHeaders();
+const uinputAvailable = hasHeader("linux/uinput.h");
+// zwp_virtual_keyboard_v1 only needs libwayland-client; the protocol itself
+// is described in the C source
+const waylandAvailable = hasHeader("wayland-client.h");
 
 function computeBuildHash() {
-  const sourceContent = fs.readFileSync(cSource, "utf8");
-  const flags = uinputAvailable ? "uinput" : "nouinput";
+  const sourceContent =
+    fs.readFileSync(cSource, "utf8") + fs.readFileSync(terminalHeader, "utf8");
+  const flags =
+    (uinputAvailable ? "uinput" : "nouinput") + (waylandAvailable ? "+wayland" : "+nowayland");
   return crypto.createHash("sha256").update(sourceContent + flags).digest("hex");
 }
 
@@ -115,6 +125,13 @@ if (uinputAvailable) {
   log("uinput headers not found, building without uinput support");
 }
 
+if (waylandAvailable) {
+  log("wayland-client headers found, enabling the Wayland virtual keyboard");
+  compileArgs.push("-DHAVE_WAYLAND", "-lwayland-client");
+} else {
+  log("wayland-client headers not found, building without the Wayland virtual keyboard");
+}
+
 let result = attemptCompile("gcc", compileArgs);
 
 if (result.status !== 0) {
@@ -0,0 +1,127 @@
+#!/usr/bin/env node
+
+const { spawnSync } = require("child_process");
+const crypto = require("crypto");
+const fs = require("fs");
+const path = require("path");
+
+const isMac = process.platform === "darwin";
+if (!isMac) {
+  process.exit(0);
+}
+
+const projectRoot = path.resolve(__dirname, "..");
+const swiftSource = path.join(projectRoot, "resources", "macos-audio-capture.swift");
+// Voice activity detection in C, imported as the bridging header
+const vadHeader = path.join(projectRoot, "resources", "audio-vad.h");
+const outputDir = path.join(projectRoot, "resources", "bin");
+const outputBinary = path.join(outputDir, "macos-audio-capture");
+const hashFile = path.join(outputDir, ".macos-audio-capture.hash");
+const moduleCacheDir = path.join(outputDir, ".swift-module-cache");
+
+function log(message) {
+  console.log(`[audio-capture] ${message}`);
+}
+
+function ensureDir(dirPath) {
+  if (!fs.existsSync(dirPath)) {
+    fs.mkdirSync(dirPath, { recursive: true });
+  }
+}
+
+if (!fs.existsSync(swiftSource)) {
+  console.error(`[audio-capture] Swift source not found at ${swiftSource}`);
+  process.exit(1);
+}
+
+ensureDir(outputDir);
+ensureDir(moduleCacheDir);
+
+let needsBuild = true;
+if (fs.existsSync(outputBinary)) {
+  try {
+    const binaryStat = fs.statSync(outputBinary);
+    const sourceStat = fs.statSync(swiftSource);
+    const headerStat = fs.statSync(vadHeader);
+    if (binaryStat.mtimeMs >= Math.max(sourceStat.mtimeMs, headerStat.mtimeMs)) {
+      needsBuild = false;
+    }
+  } catch {
+    needsBuild = true;
+  }
+}
+
+if (!needsBuild && fs.existsSync(outputBinary)) {
+  try {
+    const sourceContent = fs.readFileSync(swiftSource, "utf8") + fs.readFileSync(vadHeader, "utf8");
+    const currentHash = crypto.createHash("sha256").update(sourceContent).digest("hex");
+
+    if (fs.existsSync(hashFile)) {
+      const savedHash = fs.readFileSync(hashFile, "utf8").trim();
+      if (savedHash !== currentHash) {
+        log("Source hash changed, rebuild needed");
+        needsBuild = true;
+      }
+    } else {
+      fs.writeFileSync(hashFile, currentHash);
+    }
+  } catch (err) {
+    log(`Hash check failed: ${err.message}, forcing rebuild`);
+    needsBuild = true;
+  }
+}
+
+if (!needsBuild) {
+  process.exit(0);
+}
+
+function attemptCompile(command, args) {
+  log(`Compiling with ${[command, ...args].join(" ")}`);
+  return spawnSync(command, args, {
+    stdio: "inherit",
+    env: {
+      ...process.env,
+      SWIFT_MODULE_CACHE_PATH: moduleCacheDir,
+    },
+  });
+}
+
+const compileArgs = [
+  swiftSource,
+  "-import-objc-header",
+  vadHeader,
+  "-O",
+  "-module-cache-path",
+  moduleCacheDir,
+  "-o",
+  outputBinary,
+];
+
+let result = attemptCompile("xcrun", ["swiftc", ...compileArgs]);
+
+if (result.status !== 0) {
+  result = attemptCompile("swiftc", compileArgs);
+}
+
+if (result.status !== 0) {
+  console.warn(
+    "[audio-capture] Failed to compile macOS audio capture binary. Recording will use MediaRecorder."
+  );
+  process.exit(0);
+}
+
+try {
+  fs.chmodSync(outputBinary, 0o755);
+} catch (error) {
+  console.warn(`[audio-capture] Unable to set executable permissions: ${error.message}`);
+}
+
+try {
+  const sourceContent = fs.readFileSync(swiftSource, "utf8") + fs.readFileSync(vadHeader, "utf8");
+  const hash = crypto.createHash("sha256").update(sourceContent).digest("hex");
+  fs.writeFileSync(hashFile, hash);
+} catch (err) {
+  log(`Warning: Could not save source hash: ${err.message}`);
+}
+
+log("Successfully built macOS audio capture binary.");
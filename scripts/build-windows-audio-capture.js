@@ -0,0 +1,170 @@
+#!/usr/bin/env node
+/**
+ * Builds the Windows audio capture helper (WASAPI) when a C compiler is
+ * available. There is no prebuilt download; without the binary, recording
+ * keeps using MediaRecorder.
+ */
+
+const { spawnSync } = require("child_process");
+const fs = require("fs");
+const path = require("path");
+
+const isWindows = process.platform === "win32";
+if (!isWindows) {
+  // Only needed on Windows
+  process.exit(0);
+}
+
+const projectRoot = path.resolve(__dirname, "..");
+const cSource = path.join(projectRoot, "resources", "windows-audio-capture.c");
+// Voice activity detection shared by the audio capture helpers
+const vadHeader = path.join(projectRoot, "resources", "audio-vad.h");
+const outputDir = path.join(projectRoot, "resources", "bin");
+const outputBinary = path.join(outputDir, "windows-audio-capture.exe");
+
+function log(message) {
+  console.log(`[windows-audio-capture] ${message}`);
+}
+
+function ensureDir(dirPath) {
+  if (!fs.existsSync(dirPath)) {
+    fs.mkdirSync(dirPath, { recursive: true });
+  }
+}
+
+// Check if binary exists and is up-to-date
+function isBinaryUpToDate() {
+  if (!fs.existsSync(outputBinary)) {
+    return false;
+  }
+
+  // If source doesn't exist, can't check if rebuild needed - assume binary is good
+  if (!fs.existsSync(cSource)) {
+    return true;
+  }
+
+  try {
+    const binaryStat = fs.statSync(outputBinary);
+    const sourceStat = fs.statSync(cSource);
+    const headerMtime = fs.existsSync(vadHeader) ? fs.statSync(vadHeader).mtimeMs : 0;
+    return binaryStat.mtimeMs >= Math.max(sourceStat.mtimeMs, headerMtime);
+  } catch {
+    return false;
+  }
+}
+
+/**
+ * Quote a path for use in shell commands on Windows.
+ * @param {string} p - Path to quote
+ * @returns {string} - Quoted path safe for shell use
+ */
+function quotePath(p) {
+  // Use double quotes and escape any existing quotes
+  return `"${p.replace(/"/g, '\\"')}"`;
+}
+
+// Try to compile locally
+function tryCompile() {
+  if (!fs.existsSync(cSource)) {
+    log("C source not found, cannot compile locally");
+    return false;
+  }
+
+  log("Attempting local compilation...");
+
+  // For MSVC, we need to use a command string because /Fe: doesn't work well with spawn args
+  // For GCC/Clang, we can use shell: false with proper args array
+  const compilers = [
+    // MSVC (Visual Studio) - uses command string due to /Fe: syntax
+    {
+      name: "MSVC",
+      check: { command: "cl", args: [] },
+      useShell: true,
+      getCommand: () =>
+        `cl /O2 /nologo ${quotePath(cSource)} /Fe:${quotePath(outputBinary)} ole32.lib shell32.lib`,
+    },
+    // MinGW-w64 - can use shell: false
+    {
+      name: "MinGW-w64",
+      check: { command: "gcc", args: ["--version"] },
+      useShell: false,
+      command: "gcc",
+      args: ["-O2", cSource, "-o", outputBinary, "-lole32", "-lshell32"],
+    },
+    // Clang (LLVM) - can use shell: false
+    {
+      name: "Clang",
+      check: { command: "clang", args: ["--version"] },
+      useShell: false,
+      command: "clang",
+      args: ["-O2", cSource, "-o", outputBinary, "-lole32", "-lshell32"],
+    },
+  ];
+
+  for (const compiler of compilers) {
+    log(`Trying ${compiler.name}...`);
+
+    // Check if compiler is available
+    const checkResult = spawnSync(compiler.check.command, compiler.check.args, {
+      stdio: "pipe",
+      shell: true,
+    });
+
+    if (checkResult.status !== 0 && checkResult.error) {
+      log(`${compiler.name} not found, trying next...`);
+      continue;
+    }
+
+    let result;
+    if (compiler.useShell) {
+      const cmd = compiler.getCommand();
+      log(`Compiling with: ${cmd}`);
+      result = spawnSync(cmd, [], {
+        stdio: "inherit",
+        cwd: projectRoot,
+        shell: true,
+      });
+    } else {
+      log(`Compiling with: ${compiler.command} ${compiler.args.join(" ")}`);
+      result = spawnSync(compiler.command, compiler.args, {
+        stdio: "inherit",
+        cwd: projectRoot,
+        shell: false,
+      });
+    }
+
+    if (result.status === 0 && fs.existsSync(outputBinary)) {
+      log(`Successfully built with ${compiler.name}`);
+      return true;
+    }
+
+    log(`${compiler.name} compilation failed, trying next...`);
+  }
+
+  return false;
+}
+
+async function main() {
+  ensureDir(outputDir);
+
+  // Check if rebuild is needed
+  if (isBinaryUpToDate()) {
+    log("Binary is up to date, skipping build");
+    return;
+  }
+
+  const compiled = tryCompile();
+  if (compiled) {
+    return;
+  }
+
+  // Optional helper - warn but don't fail
+  console.warn("[windows-audio-capture] Could not build Windows audio capture binary.");
+  console.warn("[windows-audio-capture] Recording on Windows will use MediaRecorder.");
+  console.warn("[windows-audio-capture] To compile locally, install Visual Studio Build Tools or MinGW-w64.");
+}
+
+main().catch((error) => {
+  console.error("[windows-audio-capture] Unexpected error:", error);
+  // Don't fail the build
+});
@@ -13,6 +13,7 @@
 const { spawnSync } = require("child_process");
 const fs = require("fs");
 const path = require("path");
+const { generateTerminalClassHeader } = require("./lib/terminal-classes");
 
 const isWindows = process.platform === "win32";
 if (!isWindows) {
@@ -22,6 +23,10 @@ if (!isWindows) {
 
 const projectRoot = path.resolve(__dirname, "..");
 const cSource = path.join(projectRoot, "resources", "windows-fast-paste.c");
+// Paste/typing code shared by both Windows helpers
+const coreHeader = path.join(projectRoot, "resources", "windows-paste-core.h");
+// Terminal class table, generated from src/config/terminalClasses.json
+const terminalHeader = generateTerminalClassHeader();
 const outputDir = path.join(projectRoot, "resources", "bin");
 const outputBinary = path.join(outputDir, "windows-fast-paste.exe");
 
@@ -47,7 +52,12 @@ function isBinaryUpToDate() {
   try {
     const binaryStat = fs.statSync(outputBinary);
     const sourceStat = fs.statSync(cSource);
-    return binaryStat.mtimeMs >= sourceStat.mtimeMs;
+    const headerMtime = Math.max(
+      ...[coreHeader, terminalHeader].map((header) =>
+        fs.existsSync(header) ? fs.statSync(header).mtimeMs : 0
+      )
+    );
+    return binaryStat.mtimeMs >= Math.max(sourceStat.mtimeMs, headerMtime);
   } catch {
     return false;
   }
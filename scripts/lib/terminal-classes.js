@@ -0,0 +1,175 @@
+/**
+ * Generates resources/terminal-classes.h from src/config/terminalClasses.json,
+ * the one list of terminal window classes shared by the native paste helpers
+ * and clipboard.js.
+ *
+ * Each platform's classes go into a perfect hash table: a seeded FNV-1a over
+ * the ASCII-lowercased name picks a slot, and the seed is searched until no
+ * two classes share a slot, so a lookup is one hash and one compare.
+ */
+
+const fs = require("fs");
+const path = require("path");
+
+const projectRoot = path.resolve(__dirname, "..", "..");
+const listPath = path.join(projectRoot, "src", "config", "terminalClasses.json");
+const headerPath = path.join(projectRoot, "resources", "terminal-classes.h");
+
+const FNV_OFFSET = 0x811c9dc5;
+const FNV_PRIME = 0x01000193;
+const MAX_SEED_ATTEMPTS = 1000000;
+
+function hashClass(name, seed) {
+  let hash = seed >>> 0;
+  for (const char of name.toLowerCase()) {
+    hash ^= char.charCodeAt(0) & 0xff;
+    hash = Math.imul(hash, FNV_PRIME) >>> 0;
+  }
+  return hash;
+}
+
+function buildTable(classes) {
+  const names = [...new Set(classes.map((name) => name.toLowerCase()))];
+  for (const name of names) {
+    if (!/^[\x21-\x7e]+$/.test(name)) throw new Error(`Unsupported terminal class "${name}"`);
+  }
+
+  let size = 1;
+  while (size < names.length * 4) size *= 2;
+
+  for (let attempt = 0; attempt < MAX_SEED_ATTEMPTS; attempt++) {
+    const seed = (FNV_OFFSET + attempt) >>> 0;
+    const slots = new Array(size).fill(null);
+    const placed = names.every((name) => {
+      const slot = hashClass(name, seed) & (size - 1);
+      if (slots[slot]) return false;
+      slots[slot] = name;
+      return true;
+    });
+    if (placed) return { seed, size, slots };
+  }
+  throw new Error("No collision-free seed found for the terminal class table");
+}
+
+function renderTable(platform, { seed, size, slots }) {
+  const entries = slots
+    .map((name, slot) => (name ? `    [${slot}] = "${name}",` : null))
+    .filter(Boolean)
+    .join("\n");
+  return [
+    `/* ${platform}: ${slots.filter(Boolean).length} classes */`,
+    `#define TERMINAL_CLASS_HASH_SEED 0x${seed.toString(16).padStart(8, "0")}u`,
+    `#define TERMINAL_CLASS_HASH_SIZE ${size}`,
+    `static const char *const terminal_class_slots[TERMINAL_CLASS_HASH_SIZE] = {`,
+    entries,
+    `};`,
+  ].join("\n");
+}
+
+function renderHeader(list) {
+  return `/*
+ * Terminal window classes for the native paste helpers.
+ *
+ * GENERATED by scripts/lib/terminal-classes.js from
+ * src/config/terminalClasses.json - edit the list there, not this file.
+ *
+ * terminal_class_match() looks a class up in a perfect hash table (seeded
+ * FNV-1a over the ASCII-lowercased name) after applying the user overrides
+ * from OPENWHISPR_TERMINAL_CLASSES: a comma-separated list where "name"
+ * marks a class as a terminal and "!name" unmarks one. The overrides are
+ * read once, on the first lookup.
+ */
+
+#ifndef OPENWHISPR_TERMINAL_CLASSES_H
+#define OPENWHISPR_TERMINAL_CLASSES_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+${renderTable("Windows", buildTable(list.windows))}
+#else
+${renderTable("Linux", buildTable(list.linux))}
+#endif
+
+#define TERMINAL_CLASS_MAX_OVERRIDES 32
+
+static char terminal_override_buffer[1024];
+static const char *terminal_overrides[TERMINAL_CLASS_MAX_OVERRIDES];
+static int terminal_override_count = -1;
+
+static int terminal_class_equal(const char *a, const char *b) {
+    for (;; a++, b++) {
+        unsigned char ca = (unsigned char)*a, cb = (unsigned char)*b;
+        if (ca >= 'A' && ca <= 'Z') ca += 'a' - 'A';
+        if (cb >= 'A' && cb <= 'Z') cb += 'a' - 'A';
+        if (ca != cb) return 0;
+        if (!ca) return 1;
+    }
+}
+
+static void terminal_class_load_overrides(void) {
+    terminal_override_count = 0;
+    const char *value = getenv("OPENWHISPR_TERMINAL_CLASSES");
+    if (!value) return;
+
+    snprintf(terminal_override_buffer, sizeof(terminal_override_buffer), "%s", value);
+    char *p = terminal_override_buffer;
+    while (*p && terminal_override_count < TERMINAL_CLASS_MAX_OVERRIDES) {
+        while (*p == ',' || *p == ' ') p++;
+        char *start = p;
+        while (*p && *p != ',') p++;
+        char *end = p;
+        if (*p) p++;
+        while (end > start && end[-1] == ' ') end--;
+        *end = '\\0';
+        if (*start) terminal_overrides[terminal_override_count++] = start;
+    }
+}
+
+static int terminal_class_in_table(const char *name) {
+    unsigned int hash = TERMINAL_CLASS_HASH_SEED;
+    for (const char *p = name; *p; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        hash = (hash ^ c) * 0x01000193u;
+    }
+    const char *slot = terminal_class_slots[hash & (TERMINAL_CLASS_HASH_SIZE - 1)];
+    return slot && terminal_class_equal(name, slot);
+}
+
+/* 1 if name is a terminal window class, 0 otherwise (NULL and "" included) */
+static int terminal_class_match(const char *name) {
+    if (!name || !*name) return 0;
+    if (terminal_override_count < 0) terminal_class_load_overrides();
+    for (int i = 0; i < terminal_override_count; i++) {
+        const char *entry = terminal_overrides[i];
+        int negated = entry[0] == '!';
+        if (terminal_class_equal(name, entry + negated)) return !negated;
+    }
+    return terminal_class_in_table(name);
+}
+
+#endif /* OPENWHISPR_TERMINAL_CLASSES_H */
+`;
+}
+
+/**
+ * Regenerate the header if the list changed. The file is only rewritten
+ * when its content differs, so unchanged builds keep their mtimes.
+ * @returns {string} path of the header
+ */
+function generateTerminalClassHeader() {
+  const list = JSON.parse(fs.readFileSync(listPath, "utf8"));
+  const content = renderHeader(list);
+  const current = fs.existsSync(headerPath) ? fs.readFileSync(headerPath, "utf8") : null;
+  if (current !== content) fs.writeFileSync(headerPath, content);
+  return headerPath;
+}
+
+module.exports = { generateTerminalClassHeader, headerPath };
+
+if (require.main === module) {
+  console.log(`[terminal-classes] Wrote ${generateTerminalClassHeader()}`);
+}
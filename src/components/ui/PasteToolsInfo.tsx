@@ -62,7 +62,12 @@ export default function PasteToolsInfo({
   // Linux with tools available
   if (pasteToolsInfo.platform === "linux" && pasteToolsInfo.available) {
     const method = pasteToolsInfo.method || "xdotool";
-    const methodLabel = method === "xtest" ? "built-in (XTest)" : method;
+    const methodLabel =
+      method === "xtest"
+        ? "built-in (XTest)"
+        : method === "virtual-keyboard"
+          ? "built-in (Wayland virtual keyboard)"
+          : method;
     const methodSuffix =
       pasteToolsInfo.isWayland && method === "xdotool"
         ? t("pasteToolsInfo.xwaylandAppsOnly")
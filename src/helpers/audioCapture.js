@@ -0,0 +1,302 @@
+/**
+ * AudioCaptureManager - Records the microphone with the native capture helper
+ * (resources/{linux,windows,macos}-audio-capture) instead of MediaRecorder.
+ *
+ * The helper stays resident and writes 16 kHz mono float32 samples into a
+ * file-backed shared-memory ring (layout documented in linux-audio-capture.c).
+ * On STOP it reports how many samples the session produced, and the samples
+ * are read straight out of the ring: no webm encode in the renderer and no
+ * ffmpeg decode before whisper.cpp or Parakeet.
+ *
+ * Node can't mmap, but reads through the same file hit the page cache the
+ * helper writes into, so fs.readSync sees the samples without a copy on disk.
+ *
+ * The ring holds about 8.7 minutes, so while recording the samples are also
+ * drained into a growing buffer every DRAIN_INTERVAL_MS; a recording longer
+ * than the ring is read from that buffer rather than lost.
+ *
+ * Before handing the samples on, the helper's VAD (resources/audio-vad.h)
+ * finds the speech segments; leading and trailing silence and long pauses
+ * are cut so inference only runs on speech.
+ */
+
+const fs = require("fs");
+const path = require("path");
+const debugLogger = require("./debugLogger");
+const startupManifest = require("./startupManifest");
+const NativeHelperDaemon = require("./nativeHelperDaemon");
+const { getSafeTempDir } = require("./safeTempDir");
+
+const RING_HEADER_BYTES = 64;
+const RING_MAGIC = "OWRB";
+const START_TIMEOUT_MS = 3000;
+// STOP joins the capture thread, which can sit in a read for one chunk
+const STOP_TIMEOUT_MS = 2000;
+// Far inside the ring's 8.7 minutes, so a busy main process can't fall behind
+const DRAIN_INTERVAL_MS = 10000;
+const INITIAL_RECORDING_SAMPLES = 16000 * 60;
+
+const BINARY_NAMES = {
+  linux: "linux-audio-capture",
+  win32: "windows-audio-capture.exe",
+  darwin: "macos-audio-capture",
+};
+
+// "VAD_OK <samples> <count> <start>:<end> ..." -> [{ start, end }]
+function parseVadReply(reply) {
+  return reply
+    .split(" ")
+    .slice(3)
+    .map((range) => {
+      const [start, end] = range.split(":").map(Number);
+      return { start, end };
+    })
+    .filter(({ start, end }) => Number.isFinite(start) && end > start);
+}
+
+// Concatenate the speech segments. With no VAD result, or nothing the VAD
+// took for speech, the recording is passed on whole and the model decides.
+function trimToSegments(recorded, speech) {
+  if (!speech || speech.length === 0) {
+    return { samples: recorded, segments: [{ start: 0, end: recorded.length }] };
+  }
+
+  const total = speech.reduce((sum, { start, end }) => sum + (end - start), 0);
+  const samples = new Float32Array(total);
+  const segments = [];
+  let offset = 0;
+  for (const { start, end } of speech) {
+    samples.set(recorded.subarray(start, end), offset);
+    segments.push({ start: offset, end: offset + (end - start) });
+    offset += end - start;
+  }
+  return { samples, segments };
+}
+
+class AudioCaptureManager {
+  constructor() {
+    this.binaryName = BINARY_NAMES[process.platform] || null;
+    this.daemon = null;
+    this.ringPath = null;
+    this.session = null;
+    this.recorded = null;
+    this.recordedLength = 0;
+    this.drainTimer = null;
+  }
+
+  isAvailable() {
+    return this.resolveBinary() !== null;
+  }
+
+  _ringDirectory() {
+    // tmpfs on Linux keeps the ring out of the disk writeback path entirely
+    if (process.platform === "linux") {
+      try {
+        if (fs.statSync("/dev/shm").isDirectory()) return "/dev/shm";
+      } catch {}
+    }
+    return getSafeTempDir();
+  }
+
+  _getDaemon() {
+    if (this.daemon) return this.daemon;
+    const binaryPath = this.resolveBinary();
+    if (!binaryPath) return null;
+
+    this.ringPath = path.join(this._ringDirectory(), `openwhispr-audio-${process.pid}.ring`);
+    this.daemon = new NativeHelperDaemon({
+      name: "audio-capture",
+      binaryPath,
+      args: ["--ring", this.ringPath],
+    });
+    this.daemon.on("exit", () => {
+      this.session = null;
+      this._stopDraining();
+    });
+    return this.daemon;
+  }
+
+  /**
+   * Start recording. deviceName is the MediaDevices label of the microphone
+   * the renderer would have opened; null records from the system default.
+   */
+  async start({ deviceName = null } = {}) {
+    const daemon = this._getDaemon();
+    if (!daemon) throw new Error("Native audio capture helper not found");
+
+    // The name runs to the end of the command line
+    const device = deviceName ? deviceName.replace(/[\r\n]+/g, " ").trim() : "";
+    const reply = await daemon.send(device ? `START --device ${device}` : "START", {
+      timeoutMs: START_TIMEOUT_MS,
+    });
+    const [, session, startUs] = reply.split(" ");
+    this.session = Number(session);
+    this.recorded = new Float32Array(INITIAL_RECORDING_SAMPLES);
+    this.recordedLength = 0;
+    this._stopDraining();
+    this.drainTimer = setInterval(() => this._drainSafely(), DRAIN_INTERVAL_MS);
+    this.drainTimer.unref?.();
+    debugLogger.debug("[AudioCapture] Capture started", { session: this.session, device });
+    return { session: this.session, startUs: Number(startUs) };
+  }
+
+  /**
+   * Stop recording and return the session's speech as a Float32Array, with
+   * the segment boundaries (sample offsets into it) where pauses were cut.
+   * speech is the VAD's ranges in the untrimmed recording (null without a
+   * VAD result) and recordedSamples its length.
+   */
+  async stop() {
+    if (!this.daemon || this.session === null) throw new Error("Native capture is not running");
+    const reply = await this.daemon.send("STOP", { timeoutMs: STOP_TIMEOUT_MS });
+    this.session = null;
+    this._stopDraining();
+
+    const [, session, count, firstSampleUs] = reply.split(" ");
+    const { samples: recorded, sampleRate } = this.readSamples(0, Number(count));
+
+    let speech = null;
+    try {
+      speech = parseVadReply(await this.daemon.send("VAD", { timeoutMs: STOP_TIMEOUT_MS }));
+    } catch (error) {
+      debugLogger.debug("[AudioCapture] VAD unavailable, keeping the full recording", {
+        error: error.message,
+      });
+    }
+    const { samples, segments } = trimToSegments(recorded, speech);
+
+    debugLogger.debug("[AudioCapture] Capture stopped", {
+      session: Number(session),
+      recordedSeconds: recorded.length / sampleRate,
+      speechSeconds: samples.length / sampleRate,
+      segments: segments.length,
+    });
+    return {
+      samples,
+      sampleRate,
+      segments,
+      speech,
+      recordedSamples: recorded.length,
+      firstSampleUs: Number(firstSampleUs) || null,
+    };
+  }
+
+  /**
+   * Speech segments of the session so far, while it is still recording:
+   * { samples, segments } with segments as sample offsets into the session.
+   */
+  async speechSoFar() {
+    if (!this.daemon || this.session === null) throw new Error("Native capture is not running");
+    const reply = await this.daemon.send("VAD", { timeoutMs: STOP_TIMEOUT_MS });
+    return { samples: Number(reply.split(" ")[1]), segments: parseVadReply(reply) };
+  }
+
+  /**
+   * Read samples [from, to) of the current (or last stopped) session. The
+   * part already drained comes from the recording buffer, the rest straight
+   * out of the ring.
+   */
+  readSamples(from, to) {
+    if (!this.recorded) throw new Error("No native recording to read");
+    const sampleRate = this._drain();
+    const end = Math.min(to, this.recordedLength);
+    const samples = new Float32Array(Math.max(0, end - from));
+    samples.set(this.recorded.subarray(from, Math.max(from, end)));
+    return { samples, sampleRate };
+  }
+
+  _stopDraining() {
+    if (this.drainTimer) {
+      clearInterval(this.drainTimer);
+      this.drainTimer = null;
+    }
+  }
+
+  _drainSafely() {
+    try {
+      this._drain();
+    } catch (error) {
+      debugLogger.warn("[AudioCapture] Could not drain the audio ring", { error: error.message });
+    }
+  }
+
+  /**
+   * Append the samples written since the last drain to the recording buffer.
+   * Returns the ring's sample rate.
+   */
+  _drain() {
+    const fd = fs.openSync(this.ringPath, "r");
+    try {
+      const header = Buffer.alloc(RING_HEADER_BYTES);
+      fs.readSync(fd, header, 0, RING_HEADER_BYTES, 0);
+      if (header.toString("ascii", 0, 4) !== RING_MAGIC) {
+        throw new Error("Audio ring has an unexpected layout");
+      }
+      const sampleRate = header.readUInt32LE(8);
+      const capacity = header.readUInt32LE(16);
+      const written = Number(header.readBigUInt64LE(24));
+      if (!this.recorded) return sampleRate;
+
+      this._reserve(written);
+      if (written - this.recordedLength > capacity) {
+        // Only if draining stalled for the whole ring: the overwritten part
+        // stays silent, so sample offsets still match the helper's
+        debugLogger.warn("[AudioCapture] Audio ring overrun, part of the recording is missing", {
+          missingSamples: written - this.recordedLength - capacity,
+        });
+        this.recordedLength = written - capacity;
+      }
+
+      const bytes = Buffer.from(this.recorded.buffer);
+      // Copy in at most two pieces: up to the end of the ring, then from its start
+      while (this.recordedLength < written) {
+        const slot = this.recordedLength % capacity;
+        const run = Math.min(written - this.recordedLength, capacity - slot);
+        fs.readSync(fd, bytes, this.recordedLength * 4, run * 4, RING_HEADER_BYTES + slot * 4);
+        this.recordedLength += run;
+      }
+      return sampleRate;
+    } finally {
+      fs.closeSync(fd);
+    }
+  }
+
+  _reserve(length) {
+    if (length <= this.recorded.length) return;
+    let size = this.recorded.length;
+    while (size < length) size *= 2;
+    const grown = new Float32Array(size);
+    grown.set(this.recorded.subarray(0, this.recordedLength));
+    this.recorded = grown;
+  }
+
+  /**
+   * Stop the helper (app quit) and remove its ring file.
+   */
+  shutdown() {
+    if (this.daemon) {
+      this.daemon.stop();
+      this.daemon = null;
+    }
+    this._stopDraining();
+    this.session = null;
+    this.recorded = null;
+    this.recordedLength = 0;
+    if (this.ringPath) {
+      try {
+        fs.unlinkSync(this.ringPath);
+      } catch {}
+      this.ringPath = null;
+    }
+  }
+
+  /**
+   * Find the helper binary in the same places as the other native helpers
+   */
+  resolveBinary() {
+    return this.binaryName ? startupManifest.resolveHelper(this.binaryName) : null;
+  }
+}
+
+module.exports = AudioCaptureManager;
+module.exports.trimToSegments = trimToSegments;
@@ -1,6 +1,7 @@
 import ReasoningService from "../services/ReasoningService";
 import { API_ENDPOINTS, buildApiUrl, normalizeBaseUrl } from "../config/constants";
 import logger from "../utils/logger";
+import dictationTrace from "../utils/dictationTrace";
 import { isBuiltInMicrophone } from "../utils/audioDeviceUtils";
 import { isSecureEndpoint } from "../utils/urlUtils";
 import { withSessionRefresh } from "../lib/neonAuth";
@@ -44,6 +45,7 @@ class AudioManager {
     this.cachedEndpointProvider = null;
     this.cachedEndpointBaseUrl = null;
     this.recordingStartTime = null;
+    this.stopRequestedAt = null;
     this.reasoningAvailabilityCache = { value: false, expiresAt: 0 };
     this.cachedReasoningPreference = null;
     this.isStreaming = false;
@@ -64,6 +66,8 @@ class AudioManager {
     this.stopRequestedDuringStreamingStart = false;
     this.streamingFallbackRecorder = null;
     this.streamingFallbackChunks = [];
+    this.nativeCaptureAvailable = null;
+    this.nativeCaptureActive = false;
   }
 
   getWorkletBlobUrl() {
@@ -122,6 +126,37 @@ registerProcessor("pcm-streaming-processor", PCMStreamingProcessor);
     return null;
   }
 
+  // Model settings for transcribing while the key is still held (native capture only)
+  getSpeculativeOptions() {
+    if (localStorage.getItem("speculativeTranscription") !== "true") return null;
+    const provider = localStorage.getItem("localTranscriptionProvider") || "whisper";
+    if (provider === "nvidia") {
+      const model = localStorage.getItem("parakeetModel") || "parakeet-tdt-0.6b-v3";
+      const language = validateLanguageForModel(localStorage.getItem("preferredLanguage"), model);
+      return { provider, model, language: language || null };
+    }
+    return {
+      provider,
+      model: localStorage.getItem("whisperModel") || "base",
+      language: getBaseLanguageCode(localStorage.getItem("preferredLanguage")) || null,
+      initialPrompt: this.getCustomDictionaryPrompt(),
+    };
+  }
+
+  // With a prefix already decoded during recording, only the tail after it is left
+  async transcribeWithSpeculation(transcribe, arrayBuffer, options, speculative) {
+    if (!speculative) return transcribe(arrayBuffer, options);
+
+    const { segments: _segments, ...tailOptions } = options;
+    const tail = speculative.tailBuffer
+      ? await transcribe(speculative.tailBuffer, tailOptions)
+      : null;
+    if (tail && !tail.success && tail.message !== "No audio detected") return tail;
+
+    const text = [speculative.prefixText, tail?.text].filter(Boolean).join(" ");
+    return text ? { success: true, text } : { success: false, message: "No audio detected" };
+  }
+
   setCallbacks({ onStateChange, onError, onTranscriptionComplete, onPartialTranscript }) {
     this.onStateChange = onStateChange;
     this.onError = onError;
@@ -201,14 +236,138 @@ registerProcessor("pcm-streaming-processor", PCMStreamingProcessor);
     }
   }
 
+  // Local transcription records through the native capture helper when it
+  // is installed: it hands back 16 kHz mono PCM, so there is no webm encode
+  // here and no ffmpeg decode in the main process.
+  async shouldUseNativeCapture() {
+    if (localStorage.getItem("useLocalWhisper") !== "true") return false;
+    if (!window.electronAPI?.nativeAudioStart) return false;
+    if (this.nativeCaptureAvailable === null) {
+      try {
+        this.nativeCaptureAvailable = !!(await window.electronAPI.nativeAudioAvailable?.());
+      } catch {
+        this.nativeCaptureAvailable = false;
+      }
+    }
+    return this.nativeCaptureAvailable;
+  }
+
+  // Label of the microphone getAudioConstraints would open, null for the
+  // system default, or undefined when it can't be named (no labels before
+  // permission is granted, or the selected device is gone)
+  async getNativeCaptureDeviceName() {
+    const preferBuiltIn = localStorage.getItem("preferBuiltInMic") !== "false";
+    const selectedDeviceId = localStorage.getItem("selectedMicDeviceId") || "";
+    if (!preferBuiltIn && (!selectedDeviceId || selectedDeviceId === "default")) return null;
+
+    try {
+      const devices = await navigator.mediaDevices.enumerateDevices();
+      const audioInputs = devices.filter((d) => d.kind === "audioinput");
+      const device = preferBuiltIn
+        ? audioInputs.find((d) => isBuiltInMicrophone(d.label))
+        : audioInputs.find((d) => d.deviceId === selectedDeviceId);
+      if (!device) return preferBuiltIn ? null : undefined;
+      if (!device.label) return undefined;
+      // Chromium prefixes the aliases of the default devices on Windows and macOS
+      return device.label.replace(/^(Default|Communications) - /, "");
+    } catch {
+      return undefined;
+    }
+  }
+
+  async startNativeRecording() {
+    const deviceName = await this.getNativeCaptureDeviceName();
+    if (deviceName === undefined) return false;
+
+    const micStart = performance.now();
+    const result = await window.electronAPI.nativeAudioStart({
+      deviceName,
+      speculative: this.getSpeculativeOptions(),
+    });
+    if (!result?.success) {
+      logger.debug(
+        "Native capture unavailable, using MediaRecorder",
+        { error: result?.error },
+        "audio"
+      );
+      return false;
+    }
+    dictationTrace.span("microphone open", micStart, performance.now(), { native: true });
+    logger.info(
+      "Recording started with native capture",
+      { device: deviceName || "default" },
+      "audio"
+    );
+
+    this.nativeCaptureActive = true;
+    this.recordingStartTime = Date.now();
+    this.isRecording = true;
+    this.onStateChange?.({ isRecording: true, isProcessing: false });
+    return true;
+  }
+
+  async stopNativeRecording() {
+    this.nativeCaptureActive = false;
+    this.isRecording = false;
+    this.isProcessing = true;
+    this.onStateChange?.({ isRecording: false, isProcessing: true });
+
+    const result = await window.electronAPI.nativeAudioStop();
+    if (this.stopRequestedAt) {
+      dictationTrace.span("audio stop", this.stopRequestedAt, performance.now(), { native: true });
+      this.stopRequestedAt = null;
+    }
+    this.recordingStartTime = null;
+
+    if (!result?.success || !result.audioBuffer) {
+      this.isProcessing = false;
+      this.onStateChange?.({ isRecording: false, isProcessing: false });
+      this.onError?.({
+        title: "Recording Error",
+        description: `Failed to read recorded audio: ${result?.error || "no audio returned"}`,
+      });
+      return;
+    }
+
+    const audioBlob = new Blob([result.audioBuffer], { type: "audio/wav" });
+    logger.info(
+      "Recording stopped",
+      {
+        blobSize: audioBlob.size,
+        blobType: audioBlob.type,
+        native: true,
+        durationSeconds: result.durationSeconds,
+        speechSeconds: result.speechSeconds,
+        speculativeSeconds: result.speculative?.committedSeconds ?? null,
+      },
+      "audio"
+    );
+    await this.processAudio(audioBlob, {
+      durationSeconds: result.durationSeconds,
+      segments: result.segments,
+      speculative: result.speculative,
+    });
+  }
+
   async startRecording() {
     try {
-      if (this.isRecording || this.isProcessing || this.mediaRecorder?.state === "recording") {
+      if (
+        this.isRecording ||
+        this.isProcessing ||
+        this.nativeCaptureActive ||
+        this.mediaRecorder?.state === "recording"
+      ) {
         return false;
       }
 
+      if ((await this.shouldUseNativeCapture()) && (await this.startNativeRecording())) {
+        return true;
+      }
+
+      const micStart = performance.now();
       const constraints = await this.getAudioConstraints();
       const stream = await navigator.mediaDevices.getUserMedia(constraints);
+      dictationTrace.span("microphone open", micStart);
 
       const audioTrack = stream.getAudioTracks()[0];
       if (audioTrack) {
@@ -235,6 +394,10 @@ registerProcessor("pcm-streaming-processor", PCMStreamingProcessor);
       };
 
       this.mediaRecorder.onstop = async () => {
+        if (this.stopRequestedAt) {
+          dictationTrace.span("audio stop", this.stopRequestedAt);
+          this.stopRequestedAt = null;
+        }
         this.isRecording = false;
         this.isProcessing = true;
         this.onStateChange?.({ isRecording: false, isProcessing: true });
@@ -291,7 +454,13 @@ registerProcessor("pcm-streaming-processor", PCMStreamingProcessor);
   }
 
   stopRecording() {
+    if (this.nativeCaptureActive) {
+      this.stopRequestedAt = performance.now();
+      this.stopNativeRecording();
+      return true;
+    }
     if (this.mediaRecorder?.state === "recording") {
+      this.stopRequestedAt = performance.now();
       this.mediaRecorder.stop();
       return true;
     }
@@ -299,6 +468,15 @@ registerProcessor("pcm-streaming-processor", PCMStreamingProcessor);
   }
 
   cancelRecording() {
+    if (this.nativeCaptureActive) {
+      this.nativeCaptureActive = false;
+      window.electronAPI.nativeAudioStop().catch(() => {});
+      this.isRecording = false;
+      this.isProcessing = false;
+      this.recordingStartTime = null;
+      this.onStateChange?.({ isRecording: false, isProcessing: false });
+      return true;
+    }
     if (this.mediaRecorder && this.mediaRecorder.state === "recording") {
       this.mediaRecorder.onstop = () => {
         this.isRecording = false;
@@ -379,9 +557,14 @@ registerProcessor("pcm-streaming-processor", PCMStreamingProcessor);
         return;
       }
 
-      this.onTranscriptionComplete?.(result);
-
       const roundTripDurationMs = Math.round(performance.now() - pipelineStart);
+      dictationTrace.span("transcription", pipelineStart, performance.now(), {
+        model: activeModel,
+        transcriptionMs: result?.timings?.transcriptionProcessingDurationMs ?? null,
+        reasoningMs: result?.timings?.reasoningProcessingDurationMs ?? null,
+      });
+
+      this.onTranscriptionComplete?.(result);
 
       const timingData = {
         mode: useLocalWhisper ? `local-${localProvider}` : "cloud",
@@ -449,6 +632,11 @@ registerProcessor("pcm-streaming-processor", PCMStreamingProcessor);
         options.initialPrompt = dictionaryPrompt;
       }
 
+      // Speech pauses from native capture let long recordings be decoded in parallel chunks
+      if (metadata.segments?.length > 1) {
+        options.segments = metadata.segments;
+      }
+
       logger.debug(
         "Local transcription starting",
         {
@@ -459,7 +647,12 @@ registerProcessor("pcm-streaming-processor", PCMStreamingProcessor);
       );
 
       const transcriptionStart = performance.now();
-      const result = await window.electronAPI.transcribeLocalWhisper(arrayBuffer, options);
+      const result = await this.transcribeWithSpeculation(
+        window.electronAPI.transcribeLocalWhisper,
+        arrayBuffer,
+        options,
+        metadata.speculative
+      );
       timings.transcriptionProcessingDurationMs = Math.round(
         performance.now() - transcriptionStart
       );
@@ -521,6 +714,9 @@ registerProcessor("pcm-streaming-processor", PCMStreamingProcessor);
       if (language) {
         options.language = language;
       }
+      if (metadata.segments?.length > 1) {
+        options.segments = metadata.segments;
+      }
 
       logger.debug(
         "Parakeet transcription starting",
@@ -533,7 +729,12 @@ registerProcessor("pcm-streaming-processor", PCMStreamingProcessor);
       );
 
       const transcriptionStart = performance.now();
-      const result = await window.electronAPI.transcribeLocalParakeet(arrayBuffer, options);
+      const result = await this.transcribeWithSpeculation(
+        window.electronAPI.transcribeLocalParakeet,
+        arrayBuffer,
+        options,
+        metadata.speculative
+      );
       timings.transcriptionProcessingDurationMs = Math.round(
         performance.now() - transcriptionStart
       );
@@ -1968,6 +2169,8 @@ registerProcessor("pcm-streaming-processor", PCMStreamingProcessor);
           sampleRate: 16000,
           language: preferredLang && preferredLang !== "auto" ? preferredLang : undefined,
           keyterms: this.getKeyterms(),
+          // Reasoning rewrites the transcript at the end, so only type raw text live
+          liveTyping: localStorage.getItem("useReasoningModel") !== "true",
         });
 
         if (!res.success) {
@@ -2128,6 +2331,7 @@ registerProcessor("pcm-streaming-processor", PCMStreamingProcessor);
       return { success: false };
     });
     const tTerminate = performance.now();
+    dictationTrace.span("streaming stop", t0, tTerminate);
 
     finalText = this.streamingFinalText || "";
 
@@ -2245,6 +2449,7 @@ registerProcessor("pcm-streaming-processor", PCMStreamingProcessor);
 
     if (finalText) {
       const tBeforePaste = performance.now();
+      dictationTrace.span("streaming finalize", tTerminate, tBeforePaste);
       this.onTranscriptionComplete?.({
         success: true,
         text: finalText,
@@ -2339,6 +2544,10 @@ registerProcessor("pcm-streaming-processor", PCMStreamingProcessor);
     if (this.mediaRecorder?.state === "recording") {
       this.stopRecording();
     }
+    if (this.nativeCaptureActive) {
+      this.nativeCaptureActive = false;
+      window.electronAPI?.nativeAudioStop?.().catch(() => {});
+    }
     if (this.persistentAudioContext && this.persistentAudioContext.state !== "closed") {
       this.persistentAudioContext.close().catch(() => {});
       this.persistentAudioContext = null;
@@ -0,0 +1,225 @@
+/**
+ * Chunked transcription of long local recordings.
+ *
+ * whisper-server decodes one request at a time, so a five-minute dictation
+ * sent as one request keeps a few cores busy while the rest of the machine
+ * idles. When native capture supplied VAD segments (see audioCapture.js),
+ * the speech is cut at those pauses into chunks, the chunks are decoded
+ * concurrently, and the texts are joined back in recording order. Cutting at
+ * pauses means no word is split between two chunks.
+ *
+ * LocalServerPool keeps the extra warm servers that makes possible: they are
+ * started one after another in the background on the first long dictation,
+ * join the work queue as soon as each is ready, and are stopped again after
+ * a while without long dictations.
+ */
+
+const os = require("os");
+const debugLogger = require("./debugLogger");
+
+// whisper.cpp works in 30 s windows; smaller chunks only add per-request overhead
+const MIN_CHUNK_SECONDS = 30;
+// Below this a single request is as fast as splitting it
+const MIN_CHUNKED_SECONDS = 45;
+const THREADS_PER_WORKER = 4;
+const MAX_WORKERS = 4;
+// Share of RAM the pool may fill with model copies, primary server included
+const POOL_MEMORY_FRACTION = 0.25;
+const POOL_IDLE_TIMEOUT_MS = 10 * 60 * 1000;
+
+// Renderer segments are seconds into the trimmed audio -> sample ranges
+function segmentsToSamples(segments, sampleRate, totalSamples) {
+  if (!Array.isArray(segments)) return [];
+  return segments
+    .map(({ start, end }) => ({
+      start: Math.max(0, Math.round(start * sampleRate)),
+      end: Math.min(totalSamples, Math.round(end * sampleRate)),
+    }))
+    .filter(({ start, end }) => end > start)
+    .sort((a, b) => a.start - b.start);
+}
+
+/**
+ * Group consecutive segments into chunks of at least targetSamples, cutting
+ * only between segments. With maxSamples set, a segment that alone exceeds it
+ * is cut at fixed offsets, as there is no pause to cut at.
+ */
+function planChunks(segments, totalSamples, { targetSamples, maxSamples = Infinity }) {
+  if (!segments || segments.length === 0) segments = [{ start: 0, end: totalSamples }];
+
+  const chunks = [];
+  let current = null;
+  for (const segment of segments) {
+    if (!current) {
+      current = { ...segment };
+    } else if (
+      current.end - current.start >= targetSamples ||
+      segment.end - current.start > maxSamples
+    ) {
+      chunks.push(current);
+      current = { ...segment };
+    } else {
+      current.end = segment.end;
+    }
+  }
+  if (current) chunks.push(current);
+
+  if (!Number.isFinite(maxSamples)) return chunks;
+  return chunks.flatMap(({ start, end }) => {
+    const pieces = [];
+    for (let offset = start; offset < end; offset += maxSamples) {
+      pieces.push({ start: offset, end: Math.min(offset + maxSamples, end) });
+    }
+    return pieces;
+  });
+}
+
+/**
+ * Run transcribeChunk(worker, chunk, index) over all chunks, each worker
+ * taking the next chunk as soon as it is free, and return the results in
+ * chunk order. joining holds promises for workers that are still starting;
+ * each one picks up chunks once it resolves, if any are left.
+ */
+async function transcribeChunks(chunks, workers, transcribeChunk, joining = []) {
+  const results = new Array(chunks.length);
+  let next = 0;
+
+  const run = async (worker) => {
+    while (next < chunks.length) {
+      const index = next++;
+      results[index] = await transcribeChunk(worker, chunks[index], index);
+    }
+  };
+
+  let finish;
+  const finished = new Promise((resolve) => {
+    finish = () => resolve(null);
+  });
+  const late = joining.map((pending) =>
+    Promise.race([pending.catch(() => null), finished]).then((worker) =>
+      worker && next < chunks.length ? run(worker) : null
+    )
+  );
+
+  try {
+    await Promise.all(workers.map(run));
+  } finally {
+    finish();
+  }
+  await Promise.all(late);
+  return results;
+}
+
+class LocalServerPool {
+  /**
+   * createServer() returns a stopped server (start/stop/ready, like
+   * WhisperServerManager); startServer(server) starts it for the pool's model.
+   */
+  constructor({ name, createServer, startServer }) {
+    this.name = name;
+    this.createServer = createServer;
+    this.startServer = startServer;
+    this.workers = [];
+    this.modelKey = null;
+    this.lastStart = Promise.resolve();
+    this.idleTimer = null;
+  }
+
+  /**
+   * How many servers (the primary one included) suit this machine for a model
+   * of modelBytes: one per THREADS_PER_WORKER cores, within the memory budget.
+   */
+  static workerCount(modelBytes) {
+    const byCores = Math.min(MAX_WORKERS, Math.floor(os.cpus().length / THREADS_PER_WORKER));
+    const byMemory =
+      modelBytes > 0 ? Math.floor((os.totalmem() * POOL_MEMORY_FRACTION) / modelBytes) : byCores;
+    return Math.max(1, Math.min(byCores, byMemory));
+  }
+
+  /**
+   * Make sure count extra servers exist for modelKey. Returns the ones that
+   * are ready now and promises for the ones still starting.
+   */
+  acquire(modelKey, count) {
+    if (this.modelKey !== modelKey) {
+      this.stop();
+      this.modelKey = modelKey;
+    }
+    this._scheduleIdleStop();
+
+    // Drop servers that have died since the last dictation
+    this.workers = this.workers.filter((worker) => worker.starting || worker.server.ready);
+
+    while (this.workers.length < count) {
+      const server = this.createServer();
+      const worker = { server, starting: null };
+      // One at a time: port probing isn't atomic, and parallel model loads
+      // would compete for the same disk
+      worker.starting = this.lastStart
+        .then(() => this.startServer(server))
+        .then(
+          () => {
+            worker.starting = null;
+            debugLogger.debug(`[${this.name}] Pool worker ready`, { port: server.port });
+            return server;
+          },
+          (error) => {
+            debugLogger.warn(`[${this.name}] Pool worker failed to start`, {
+              error: error.message,
+            });
+            this.workers = this.workers.filter((entry) => entry !== worker);
+            server.stop().catch(() => {});
+            return null;
+          }
+        );
+      this.lastStart = worker.starting;
+      this.workers.push(worker);
+    }
+
+    const ready = [];
+    const joining = [];
+    for (const worker of this.workers.slice(0, count)) {
+      if (worker.starting) joining.push(worker.starting);
+      else ready.push(worker.server);
+    }
+    return { ready, joining };
+  }
+
+  _scheduleIdleStop() {
+    if (this.idleTimer) clearTimeout(this.idleTimer);
+    this.idleTimer = setTimeout(() => {
+      debugLogger.debug(`[${this.name}] Stopping idle pool workers`, {
+        workers: this.workers.length,
+      });
+      this.stop();
+    }, POOL_IDLE_TIMEOUT_MS);
+    this.idleTimer.unref?.();
+  }
+
+  stop() {
+    if (this.idleTimer) {
+      clearTimeout(this.idleTimer);
+      this.idleTimer = null;
+    }
+    const workers = this.workers;
+    this.workers = [];
+    this.modelKey = null;
+    return Promise.all(
+      workers.map(async (worker) => {
+        // A server still loading is stopped once its start settles
+        if (worker.starting) await worker.starting;
+        await worker.server.stop().catch(() => {});
+      })
+    );
+  }
+}
+
+module.exports = {
+  MIN_CHUNK_SECONDS,
+  MIN_CHUNKED_SECONDS,
+  THREADS_PER_WORKER,
+  segmentsToSamples,
+  planChunks,
+  transcribeChunks,
+  LocalServerPool,
+};
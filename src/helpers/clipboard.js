@@ -4,8 +4,17 @@ const { killProcess } = require("../utils/process");
 const path = require("path");
 const fs = require("fs");
 const debugLogger = require("./debugLogger");
+const NativeHelperDaemon = require("./nativeHelperDaemon");
+const startupManifest = require("./startupManifest");
+const StreamingTextInjector = require("./streamingTextInjector");
+const PasteStrategyCache = require("./pasteStrategyCache");
+const { isTerminalClass } = require("./terminalClasses");
+const { hrtimeMicros } = require("./nativeEventStream");
 
 const CACHE_TTL_MS = 30000;
+// A paste target detected at recording start only serves that dictation's paste
+// (it is cleared once the paste finishes), and never once it is this old
+const PRE_DETECTED_TARGET_TTL_MS = 2 * 60 * 1000;
 
 // macOS accessibility: once granted, permissions persist across app sessions,
 // so use a long TTL. Denied results re-check quickly so granting takes effect fast.
@@ -52,6 +61,14 @@ const PASTE_DELAYS = {
   linux: 50,
 };
 
+// windows-fast-paste --server sleeps per PASTE command. The 20 ms one-shot post
+// delay only kept the process alive while input drained; the resident server
+// doesn't need it, and the clipboard restore delay still follows.
+const WINDOWS_SERVER_PASTE_TIMING = {
+  preDelayMs: 5,
+  postDelayMs: 0,
+};
+
 const RESTORE_DELAYS = {
   darwin: 450,
   win32_nircmd: 80,
@@ -59,6 +76,81 @@ const RESTORE_DELAYS = {
   linux: 200,
 };
 
+// How long linux-fast-paste keeps CLIPBOARD waiting for the target to read it
+const SELECTION_SERVE_TIMEOUT_MS = 1000;
+// The native helpers refuse PASTE_TEXT / TYPE_TEXT payloads above this (error 11)
+const NATIVE_TEXT_PAYLOAD_MAX_BYTES = 1024 * 1024;
+
+// Texts up to this many characters are typed by the native helper instead of pasted,
+// skipping the clipboard write and restore delay. Off (0) unless turned on via
+// OPENWHISPR_TYPE_INJECTION_MAX_CHARS or the typeInjectionMaxChars paste option.
+const TYPE_INJECTION_MAX_CHARS = 0;
+
+// A KEYS reply comes after the script's wait: steps (up to 32 x 1000 ms) have run,
+// so its timeout is their sum plus the usual command allowance
+const KEYS_REPLY_MARGIN_MS = 2000;
+const keyScriptTimeoutMs = (steps) =>
+  steps
+    .split(/\s+/)
+    .map((step) => /^wait:(\d+)$/.exec(step))
+    .reduce((total, wait) => total + (wait ? Number(wait[1]) : 0), KEYS_REPLY_MARGIN_MS);
+
+// linux-fast-paste and macos-fast-paste report
+// "PASTE_OK <elapsed_us> <focus_us> <start_us> [served_us]"; focus_us is how long they
+// actually waited for the target window to take focus (0 when none was needed), and the
+// keystroke follows right after. start_us is the command's arrival on the process.hrtime
+// clock. PASTE_TEXT (and the macOS agent's --consume-timeout) add served_us, when the
+// target took the text relative to start (-1 if it never did); macOS then also reports
+// whether the pasteboard was changed by someone else meanwhile.
+function parseFastPasteTiming(line) {
+  const [status, elapsedUs, focusUs, startUs, servedUs, changed] = (line || "").split(/\s+/);
+  if (status !== "PASTE_OK") return {};
+  const timing = {
+    elapsedMs: Number(elapsedUs) / 1000 || 0,
+    focusWaitMs: Number(focusUs) / 1000 || 0,
+  };
+  if (Number(startUs) > 0) {
+    timing.startUs = Number(startUs);
+  }
+  if (servedUs !== undefined) {
+    timing.servedMs = Number(servedUs) >= 0 ? Number(servedUs) / 1000 : null;
+  }
+  if (changed !== undefined) {
+    timing.clipboardChanged = changed === "1";
+  }
+  return timing;
+}
+
+// Windows helpers report "PASTE_OK <class> <combo> <elapsed_us> [start_us]". start_us is
+// QueryPerformanceCounter time, the same clock as the key listener's KEY_UP stamps.
+function parseWindowsPasteTiming(line, keyUpUs) {
+  const fields = (line || "").split(/\s+/);
+  if (fields[0] !== "PASTE_OK" || fields.length < 5) return {};
+  const startUs = Number(fields[fields.length - 1]);
+  const timing = { elapsedMs: Number(fields[fields.length - 2]) / 1000 || 0 };
+  if (startUs > 0) timing.startUs = startUs;
+  if (keyUpUs && startUs >= keyUpUs) {
+    timing.keyUpToPasteMs = (startUs - keyUpUs) / 1000;
+  }
+  return timing;
+}
+
+// Lay a helper's paste timing out on the dictation latency trace
+function tracePasteTiming(track, timing) {
+  const { startUs, elapsedMs, focusWaitMs, servedMs } = timing;
+  if (!startUs) return;
+  debugLogger.traceSpan("paste command", startUs, startUs + elapsedMs * 1000, { track });
+  if (focusWaitMs) {
+    debugLogger.traceSpan("focus wait", startUs, startUs + focusWaitMs * 1000, { track });
+  }
+  if (focusWaitMs !== undefined) {
+    debugLogger.traceEvent("keystroke sent", { ts: startUs + focusWaitMs * 1000, track });
+  }
+  if (servedMs != null) {
+    debugLogger.traceEvent("clipboard served", { ts: startUs + servedMs * 1000, track });
+  }
+}
+
 function writeClipboardInRenderer(webContents, text) {
   if (!webContents || !webContents.executeJavaScript) {
     return Promise.reject(new Error("Invalid webContents for clipboard write"));
@@ -73,12 +165,32 @@ class ClipboardManager {
     this.commandAvailabilityCache = new Map();
     this.nircmdPath = null;
     this.nircmdChecked = false;
-    this.fastPastePath = null;
-    this.fastPasteChecked = false;
-    this.winFastPastePath = null;
-    this.winFastPasteChecked = false;
-    this.linuxFastPastePath = null;
-    this.linuxFastPasteChecked = false;
+    this.linuxPasteDaemon = null;
+    this.preDetectedPasteTarget = null;
+    this.preDetectGeneration = 0;
+    this.windowsHelperFeatures = null;
+    this.windowsPasteDaemon = null;
+    this.pasteAgent = null;
+    this.macPasteDaemon = null;
+    this.macPasteInFlight = null;
+    this.streamingInjector = null;
+    this.pasteStrategies = new PasteStrategyCache();
+  }
+
+  /**
+   * Use the Windows key listener as the resident paste agent while it runs with
+   * paste support, so pastes reuse the hook process instead of a second helper.
+   * @param {import("./windowsKeyManager")} agent
+   */
+  setPasteAgent(agent) {
+    this.pasteAgent = agent;
+    agent?.on("features", (features) => {
+      if (features.has("paste") && this.windowsPasteDaemon) {
+        debugLogger.debug("Key listener serves pastes, stopping windows-fast-paste server");
+        this.windowsPasteDaemon.stop();
+        this.windowsPasteDaemon = null;
+      }
+    });
   }
 
   _isWayland() {
@@ -147,77 +259,547 @@ class ClipboardManager {
     };
   }
 
-  _resolveNativeBinary(binaryName, platform, cacheKeyChecked, cacheKeyPath) {
-    if (this[cacheKeyChecked]) {
-      return this[cacheKeyPath];
+  _resolveNativeBinary(binaryName, platform) {
+    if (process.platform !== platform) {
+      return null;
     }
-    this[cacheKeyChecked] = true;
+    return startupManifest.resolveHelper(binaryName, { executable: true });
+  }
 
-    if (process.platform !== platform) {
+  resolveFastPasteBinary() {
+    return this._resolveNativeBinary("macos-fast-paste", "darwin");
+  }
+
+  resolveWindowsFastPasteBinary() {
+    return this._resolveNativeBinary("windows-fast-paste.exe", "win32");
+  }
+
+  resolveLinuxFastPasteBinary() {
+    return this._resolveNativeBinary("linux-fast-paste", "linux");
+  }
+
+  // Resident linux-fast-paste process. On Wayland it also owns a persistent
+  // uinput keyboard so pastes skip the per-device setup and settle delay, and
+  // on wlroots compositors a zwp_virtual_keyboard_v1 keyboard that needs no
+  // /dev/uinput access at all.
+  _getLinuxPasteDaemon() {
+    if (this.linuxPasteDaemon) return this.linuxPasteDaemon;
+
+    const binaryPath = this.resolveLinuxFastPasteBinary();
+    if (!binaryPath) return null;
+
+    const { isWayland, xwaylandAvailable, isWlroots } = getLinuxSessionInfo();
+    const withUinput = isWayland && this._canAccessUinput();
+    if (isWayland && !xwaylandAvailable && !withUinput && !isWlroots) return null;
+
+    const args = ["--daemon"];
+    if (withUinput) args.push("--uinput");
+    if (isWlroots) args.push("--wayland");
+    this.linuxPasteDaemon = new NativeHelperDaemon({ name: "linux-fast-paste", binaryPath, args });
+    return this.linuxPasteDaemon;
+  }
+
+  // Flags that route a Wayland paste or KEYS command to the virtual keyboards:
+  // the compositor's when it has the protocol, else uinput
+  _linuxVirtualKeyboardArgs() {
+    const args = ["--uinput"];
+    if (getLinuxSessionInfo().isWlroots) args.unshift("--wayland");
+    return args;
+  }
+
+  /**
+   * Ask the resident linux-fast-paste daemon for the active window, its WM_CLASS
+   * and the terminal verdict in a single round trip.
+   * @returns {Promise<{windowId: string, windowClass: string|null, isTerminal: boolean}|null>}
+   */
+  async detectLinuxPasteTarget() {
+    const daemon = this._getLinuxPasteDaemon();
+    if (!daemon) return null;
+    try {
+      const reply = await daemon.send("DETECT", { timeoutMs: 500 });
+      const match = /^DETECT_OK (\S+) ([01]) ?(.*)$/.exec(reply);
+      if (!match) return null;
+      return {
+        windowId: match[1],
+        windowClass: match[3].toLowerCase().trim() || null,
+        isTerminal: match[2] === "1",
+      };
+    } catch (error) {
+      debugLogger.debug("linux-fast-paste DETECT failed", { error: error.message }, "clipboard");
       return null;
     }
+  }
 
-    const candidates = new Set([
-      path.join(__dirname, "..", "..", "resources", "bin", binaryName),
-      path.join(__dirname, "..", "..", "resources", binaryName),
-    ]);
+  /**
+   * Ask the resident macos-fast-paste helper for the frontmost app.
+   * @returns {Promise<{pid: number, bundleId: string|null}|null>}
+   */
+  async detectMacPasteTarget() {
+    const daemon = this._getMacPasteDaemon();
+    if (!daemon) return null;
+    try {
+      const reply = await daemon.send("DETECT", { timeoutMs: 500 });
+      const match = /^DETECT_OK (\d+) (\S+)$/.exec(reply);
+      if (!match || match[1] === "0") return null;
+      return { pid: Number(match[1]), bundleId: match[2] === "-" ? null : match[2] };
+    } catch (error) {
+      debugLogger.debug("macos-fast-paste DETECT failed", { error: error.message }, "clipboard");
+      return null;
+    }
+  }
 
-    if (process.resourcesPath) {
-      [
-        path.join(process.resourcesPath, binaryName),
-        path.join(process.resourcesPath, "bin", binaryName),
-        path.join(process.resourcesPath, "resources", binaryName),
-        path.join(process.resourcesPath, "resources", "bin", binaryName),
-        path.join(process.resourcesPath, "app.asar.unpacked", "resources", binaryName),
-        path.join(process.resourcesPath, "app.asar.unpacked", "resources", "bin", binaryName),
-      ].forEach((candidate) => candidates.add(candidate));
+  /**
+   * Record the paste target when dictation starts, while the user's window is
+   * still active. Runs over the daemon, so it never blocks the main thread.
+   */
+  preDetectPasteTarget() {
+    this._clearPreDetectedPasteTarget();
+    const detect =
+      process.platform === "darwin"
+        ? this.detectMacPasteTarget()
+        : process.platform === "linux"
+          ? this.detectLinuxPasteTarget()
+          : null;
+    if (!detect) return;
+    const generation = this.preDetectGeneration;
+    const detectedAt = Date.now();
+    detect.then((target) => {
+      // A later dictation, or this dictation's paste, has moved on since
+      if (generation !== this.preDetectGeneration) return;
+      this.preDetectedPasteTarget = target ? { ...target, detectedAt } : null;
+    });
+  }
+
+  _clearPreDetectedPasteTarget() {
+    this.preDetectGeneration++;
+    this.preDetectedPasteTarget = null;
+  }
+
+  _getPreDetectedPasteTarget() {
+    const target = this.preDetectedPasteTarget;
+    this.preDetectedPasteTarget = null;
+    if (!target || Date.now() - target.detectedAt > PRE_DETECTED_TARGET_TTL_MS) return null;
+    return target;
+  }
+
+  _getTypeInjectionMaxChars(options = {}) {
+    const configured =
+      options.typeInjectionMaxChars ?? process.env.OPENWHISPR_TYPE_INJECTION_MAX_CHARS;
+    const value = Number(configured);
+    return configured !== undefined && configured !== "" && Number.isFinite(value)
+      ? value
+      : TYPE_INJECTION_MAX_CHARS;
+  }
+
+  _shouldTypeText(text, options = {}) {
+    // Typed newlines would submit forms or run commands in terminals; pastes don't
+    return (
+      !!text && text.length <= this._getTypeInjectionMaxChars(options) && !/[\r\n]/.test(text)
+    );
+  }
+
+  /**
+   * Type short text directly with the platform's native helper (XTest keysym
+   * remapping, KEYEVENTF_UNICODE or CGEvent Unicode strings), bypassing the
+   * clipboard entirely.
+   * @returns {Promise<boolean>} false when the caller should paste instead
+   */
+  async typeText(text) {
+    const startTime = Date.now();
+    try {
+      if (!(await this._canTypeText())) return false;
+      const target =
+        process.platform === "linux"
+          ? (await this.detectLinuxPasteTarget()) || this._getPreDetectedPasteTarget()
+          : null;
+      const reply = await this._sendTypeEdit(text, { windowId: target?.windowId });
+
+      debugLogger.info(
+        "Text typed directly",
+        { reply, textLength: text.length, elapsedMs: Date.now() - startTime },
+        "clipboard"
+      );
+      return true;
+    } catch (error) {
+      debugLogger.debug(
+        "Direct typing unavailable, pasting instead",
+        { error: error.message },
+        "clipboard"
+      );
+      return false;
+    }
+  }
+
+  async _canTypeText() {
+    if (process.platform === "linux") {
+      // XTest only reaches X clients, so native Wayland windows keep pasting
+      return !this._isWayland() && !!this._getLinuxPasteDaemon();
+    }
+    if (process.platform === "win32") {
+      if (this.pasteAgent?.hasFeature("type")) return true;
+      const binaryPath = this.resolveWindowsFastPasteBinary();
+      return !!binaryPath && (await this._windowsHelperFeatures(binaryPath)).has("type");
     }
+    return !!this.resolveFastPasteBinary();
+  }
 
-    for (const candidate of candidates) {
+  /**
+   * Send one typing edit to the native helper: erase deleteCount characters, then
+   * type text. requireWindowId makes the helper refuse if focus has moved away
+   * from that window (Linux and Windows). Rejects when the edit was not applied.
+   */
+  async _sendTypeEdit(text, { deleteCount = 0, windowId = null, requireWindowId = null } = {}) {
+    if (process.platform === "linux") {
+      const daemon = this._getLinuxPasteDaemon();
+      if (!daemon) throw new Error("linux-fast-paste daemon unavailable");
+      const payload = Buffer.from(text, "utf8");
+      const args = ["TYPE_TEXT", payload.length];
+      if (windowId) args.push("--window", windowId);
+      if (deleteCount) args.push("--backspace", deleteCount);
+      if (requireWindowId) args.push("--require-window", requireWindowId);
+      return daemon.send(args.join(" "), { payload });
+    }
+
+    const windowsDaemon =
+      process.platform === "win32" ? await this._getWindowsCommandChannel("type") : null;
+    if (windowsDaemon) {
       try {
-        const stats = fs.statSync(candidate);
-        if (stats.isFile()) {
-          try {
-            fs.accessSync(candidate, fs.constants.X_OK);
-          } catch {
-            fs.chmodSync(candidate, 0o755);
-          }
-          this[cacheKeyPath] = candidate;
-          return candidate;
-        }
-      } catch {
-        continue;
+        const payload = Buffer.from(text, "utf8");
+        const args = ["TYPE_TEXT", payload.length];
+        if (deleteCount) args.push("--backspace", deleteCount);
+        if (requireWindowId) args.push("--require-window", requireWindowId);
+        return await windowsDaemon.send(args.join(" "), { payload });
+      } catch (error) {
+        // A refused edit must not be retried through the one-shot helper
+        if (/TYPE_ERROR/.test(error.message)) throw error;
+      }
+    }
+
+    const macDaemon = process.platform === "darwin" ? this._getMacPasteDaemon() : null;
+    if (macDaemon) {
+      try {
+        const payload = Buffer.from(text, "utf8");
+        const args = ["TYPE_TEXT", payload.length];
+        if (deleteCount) args.push("--backspace", deleteCount);
+        return await macDaemon.send(args.join(" "), { payload });
+      } catch (error) {
+        debugLogger.debug(
+          "macos-fast-paste daemon unavailable, typing with one-shot",
+          { error: error.message },
+          "clipboard"
+        );
       }
     }
 
+    const binaryPath =
+      process.platform === "win32"
+        ? this.resolveWindowsFastPasteBinary()
+        : this.resolveFastPasteBinary();
+    if (!binaryPath) throw new Error("native type helper unavailable");
+    const args = ["--type"];
+    if (deleteCount) args.push("--backspace", String(deleteCount));
+    if (requireWindowId && process.platform === "win32") {
+      args.push("--require-window", requireWindowId);
+    }
+    return this._typeWithOneShotHelper(binaryPath, text, args);
+  }
+
+  /**
+   * Send a keystroke script such as "enter", "shift+enter" or "paste enter" to
+   * the focused window as one native batch (see "Keystroke scripts" in
+   * linux-fast-paste.c and windows-paste-core.h). Resolves with the helper's
+   * KEYS_OK reply; rejects if the keys were not sent or the platform helper
+   * has no script support.
+   */
+  async sendKeys(script, { windowId = null, requireWindowId = null } = {}) {
+    const steps = String(script).replace(/[\r\n]+/g, " ").trim();
+    if (!steps) throw new Error("empty key script");
+
+    if (process.platform === "linux") {
+      const daemon = this._getLinuxPasteDaemon();
+      if (!daemon) throw new Error("linux-fast-paste daemon unavailable");
+      const args = ["KEYS"];
+      const virtualKeyboard = daemon.args.some((arg) => arg === "--uinput" || arg === "--wayland");
+      if (this._isWayland() && virtualKeyboard) {
+        args.push(...this._linuxVirtualKeyboardArgs());
+      } else {
+        if (windowId) args.push("--window", windowId);
+        if (requireWindowId) args.push("--require-window", requireWindowId);
+      }
+      return daemon.send([...args, steps].join(" "), { timeoutMs: keyScriptTimeoutMs(steps) });
+    }
+
+    if (process.platform === "win32") {
+      const binaryPath = this.resolveWindowsFastPasteBinary();
+      const supported =
+        this.pasteAgent?.hasFeature("keys") ||
+        (!!binaryPath && (await this._windowsHelperFeatures(binaryPath)).has("keys"));
+      const channel = supported ? await this._getWindowsCommandChannel("keys") : null;
+      if (!channel) throw new Error("windows-fast-paste build has no key script support");
+      const args = ["KEYS"];
+      if (requireWindowId) args.push("--require-window", requireWindowId);
+      return channel.send([...args, steps].join(" "), { timeoutMs: keyScriptTimeoutMs(steps) });
+    }
+
+    throw new Error(`key scripts are not supported on ${process.platform}`);
+  }
+
+  async _getForegroundWindowId() {
+    if (process.platform === "linux") {
+      return (await this.detectLinuxPasteTarget())?.windowId || null;
+    }
+    if (process.platform === "win32") {
+      if (this.pasteAgent?.hasFeature("detect")) {
+        try {
+          const reply = await this.pasteAgent.sendCommand("DETECT");
+          return reply.split(/\s+/)[1] || null;
+        } catch {
+          // Fall through to the one-shot detect
+        }
+      }
+      const binaryPath = this.resolveWindowsFastPasteBinary();
+      const output = binaryPath ? await this._runWindowsDetect(binaryPath) : "";
+      return /^WINDOW_ID (\S+)/m.exec(output)?.[1] || null;
+    }
     return null;
   }
 
-  resolveFastPasteBinary() {
-    return this._resolveNativeBinary(
-      "macos-fast-paste",
-      "darwin",
-      "fastPasteChecked",
-      "fastPastePath"
+  /**
+   * Start typing a live streaming transcript into the focused window. Returns
+   * false when the platform helper can't type; the transcript is then pasted
+   * once at the end as before.
+   */
+  async beginStreamingInjection() {
+    this.streamingInjector = null;
+    if (!(await this._canTypeText())) return false;
+
+    const windowId = await this._getForegroundWindowId();
+    this.streamingInjector = new StreamingTextInjector(({ deleteCount, text }) =>
+      this._sendTypeEdit(text, { deleteCount, requireWindowId: windowId })
     );
+    debugLogger.debug("Streaming injection started", { windowId }, "streaming");
+    return true;
   }
 
-  resolveWindowsFastPasteBinary() {
-    return this._resolveNativeBinary(
-      "windows-fast-paste.exe",
-      "win32",
-      "winFastPasteChecked",
-      "winFastPastePath"
+  cancelStreamingInjection() {
+    this.streamingInjector = null;
+  }
+
+  updateStreamingInjection(text) {
+    this.streamingInjector?.update(text);
+  }
+
+  /**
+   * Replace the live text with the final transcript. Resolves true when the
+   * final text is on screen, false if nothing was typed (caller pastes), and
+   * throws if typing broke off part way, since a paste would duplicate text.
+   */
+  async finishStreamingInjection(finalText) {
+    const injector = this.streamingInjector;
+    this.streamingInjector = null;
+    if (!injector) return false;
+
+    if (await injector.finish(finalText)) {
+      debugLogger.info(
+        "Streaming injection complete",
+        { edits: injector.edits, textLength: finalText.length },
+        "streaming"
+      );
+      return true;
+    }
+    if (!injector.injectedText) return false;
+
+    clipboard.writeText(finalText);
+    throw new Error(
+      "Live typing was interrupted. The full transcript has been copied to the clipboard."
     );
   }
 
-  resolveLinuxFastPasteBinary() {
-    return this._resolveNativeBinary(
-      "linux-fast-paste",
-      "linux",
-      "linuxFastPasteChecked",
-      "linuxFastPastePath"
+  _runWindowsDetect(binaryPath) {
+    return new Promise((resolve) => {
+      let stdout = "";
+      const proc = spawn(binaryPath, ["--detect-only"], {
+        stdio: ["ignore", "pipe", "ignore"],
+        windowsHide: true,
+      });
+      proc.stdout.on("data", (data) => {
+        stdout += data.toString();
+      });
+      proc.on("close", () => resolve(stdout));
+      proc.on("error", () => resolve(""));
+    });
+  }
+
+  // Prebuilt windows-fast-paste downloads can predate --type and --server, and an
+  // old binary ignores unknown flags and presses Ctrl+V. --detect-only is harmless
+  // on every version and lists "FEATURES ..." on builds that have them.
+  _windowsHelperFeatures(binaryPath) {
+    if (!this.windowsHelperFeatures) {
+      this.windowsHelperFeatures = this._runWindowsDetect(binaryPath).then((output) => {
+        const match = /^FEATURES (.*)$/m.exec(output);
+        return new Set(match ? match[1].trim().split(/\s+/) : []);
+      });
+    }
+    return this.windowsHelperFeatures;
+  }
+
+  // Resident macos-fast-paste (--server): trust is checked and the Cmd+V events
+  // built once, and PASTE waits for the target app's activation notification
+  // instead of a fixed delay.
+  _getMacPasteDaemon() {
+    if (this.macPasteDaemon) return this.macPasteDaemon;
+    const binaryPath = this.resolveFastPasteBinary();
+    if (!binaryPath) return null;
+    this.macPasteDaemon = new NativeHelperDaemon({
+      name: "macos-fast-paste",
+      binaryPath,
+      args: ["--server"],
+    });
+    return this.macPasteDaemon;
+  }
+
+  // Resident windows-fast-paste (--server), so pastes skip the 30-80 ms process
+  // launch that Defender scanning adds on Windows.
+  async _getWindowsPasteDaemon() {
+    const binaryPath = this.resolveWindowsFastPasteBinary();
+    if (!binaryPath || !(await this._windowsHelperFeatures(binaryPath)).has("server")) {
+      return null;
+    }
+    if (!this.windowsPasteDaemon) {
+      this.windowsPasteDaemon = new NativeHelperDaemon({
+        name: "windows-fast-paste",
+        binaryPath,
+        args: ["--server"],
+      });
+    }
+    return this.windowsPasteDaemon;
+  }
+
+  /**
+   * Resident helper for Windows paste-protocol commands: the key listener agent
+   * when its running build has the feature, otherwise the windows-fast-paste
+   * server. Both accept send(command, { payload, timeoutMs }).
+   */
+  async _getWindowsCommandChannel(feature) {
+    const agent = this.pasteAgent;
+    if (agent?.hasFeature(feature)) {
+      return {
+        name: "windows-key-listener",
+        send: (command, options) => agent.sendCommand(command, options),
+      };
+    }
+    return this._getWindowsPasteDaemon();
+  }
+
+  _typeWithOneShotHelper(binaryPath, text, args = ["--type"]) {
+    return new Promise((resolve, reject) => {
+      const proc = spawn(binaryPath, args, {
+        stdio: ["pipe", "pipe", "pipe"],
+        windowsHide: true,
+      });
+      let stdout = "";
+      let stderr = "";
+
+      proc.stdout.on("data", (data) => {
+        stdout += data.toString();
+      });
+
+      proc.stderr.on("data", (data) => {
+        stderr += data.toString();
+      });
+
+      let timedOut = false;
+      const timeoutId = setTimeout(() => {
+        timedOut = true;
+        killProcess(proc, "SIGKILL");
+      }, 3000);
+
+      proc.on("close", (code) => {
+        if (timedOut) return reject(new Error("type helper timed out"));
+        clearTimeout(timeoutId);
+        const output = stdout.trim();
+        // Older helpers ignore --type and would paste instead; only TYPE_OK counts
+        if (code === 0 && output.startsWith("TYPE_OK")) {
+          resolve(output);
+        } else {
+          reject(
+            new Error(`type helper exited with code ${code}${stderr ? `: ${stderr.trim()}` : ""}`)
+          );
+        }
+      });
+
+      proc.on("error", (error) => {
+        if (timedOut) return;
+        clearTimeout(timeoutId);
+        reject(error);
+      });
+
+      proc.stdin.on("error", () => {});
+      proc.stdin.end(text);
+    });
+  }
+
+  /**
+   * X11 only: have the resident linux-fast-paste daemon own CLIPBOARD and hand
+   * the text straight to the target's paste request. The original clipboard is
+   * restored as soon as the target has read it rather than after a fixed delay.
+   * @returns {Promise<boolean>} false when the regular clipboard flow should run,
+   * including when the target never read the text; rejects when the daemon may
+   * have pasted without answering
+   */
+  async pasteLinuxWithSelection(text, originalClipboard) {
+    if (!text || this._isWayland()) return false;
+    const daemon = this._getLinuxPasteDaemon();
+    if (!daemon) return false;
+
+    const target = (await this.detectLinuxPasteTarget()) || this._getPreDetectedPasteTarget();
+    const payload = Buffer.from(text, "utf8");
+    if (payload.length > NATIVE_TEXT_PAYLOAD_MAX_BYTES) return false;
+    const args = ["PASTE_TEXT", payload.length, "--timeout", SELECTION_SERVE_TIMEOUT_MS];
+    if (target?.isTerminal) args.push("--terminal");
+    if (target?.windowId) args.push("--window", target.windowId);
+
+    let timing;
+    try {
+      const reply = await daemon.send(args.join(" "), {
+        payload,
+        timeoutMs: SELECTION_SERVE_TIMEOUT_MS + 1000,
+      });
+      timing = parseFastPasteTiming(reply);
+      tracePasteTiming(daemon.name, timing);
+    } catch (error) {
+      // A PASTE_TEXT that timed out may already have sent Ctrl+V
+      if (error.outcomeUnknown) throw error;
+      debugLogger.debug(
+        "linux-fast-paste selection paste unavailable, using clipboard flow",
+        { error: error.message },
+        "clipboard"
+      );
+      return false;
+    }
+
+    if (timing.servedMs == null) {
+      // The target never asked for CLIPBOARD, so the text did not land
+      debugLogger.debug(
+        "linux-fast-paste selection was not requested, using clipboard flow",
+        { windowClass: target?.windowClass, ...timing },
+        "clipboard"
+      );
+      return false;
+    }
+    clipboard.writeText(originalClipboard);
+
+    debugLogger.info(
+      "Paste successful",
+      {
+        method: "linux-fast-paste selection",
+        windowClass: target?.windowClass,
+        isTerminal: !!target?.isTerminal,
+        ...timing,
+      },
+      "clipboard"
     );
+    return true;
   }
 
   _isYdotoolDaemonRunning() {
@@ -295,18 +877,63 @@ class ClipboardManager {
   }
 
   async pasteText(text, options = {}) {
+    if (options.keysAfter) {
+      const { keysAfter, ...pasteOptions } = options;
+      await this.pasteText(text, pasteOptions);
+      await this._sendKeysAfterPaste(keysAfter);
+      return;
+    }
+
     const startTime = Date.now();
+    const traceStartUs = hrtimeMicros();
     const platform = process.platform;
     let method = "unknown";
     const webContents = options.webContents;
 
     try {
+      if (options.fromStreaming && (await this.finishStreamingInjection(text))) {
+        method = "streaming-type";
+        this.safeLog("✅ Paste operation complete", {
+          platform,
+          method,
+          elapsedMs: Date.now() - startTime,
+          textLength: text.length,
+        });
+        return;
+      }
+
+      if (this._shouldTypeText(text, options) && (await this.typeText(text))) {
+        method = "type";
+        this.safeLog("✅ Paste operation complete", {
+          platform,
+          method,
+          elapsedMs: Date.now() - startTime,
+          textLength: text.length,
+        });
+        return;
+      }
+
+      // Until the previous macOS paste is consumed, the clipboard still holds its
+      // text rather than the user's
+      if (platform === "darwin") await this.macPasteInFlight;
+
       const originalClipboard = clipboard.readText();
       this.safeLog(
         "💾 Saved original clipboard content:",
         originalClipboard.substring(0, 50) + "..."
       );
 
+      if (platform === "linux" && (await this.pasteLinuxWithSelection(text, originalClipboard))) {
+        method = "linux-selection";
+        this.safeLog("✅ Paste operation complete", {
+          platform,
+          method,
+          elapsedMs: Date.now() - startTime,
+          textLength: text.length,
+        });
+        return;
+      }
+
       if (platform === "linux" && this._isWayland()) {
         this._writeClipboardWayland(text, webContents);
       } else {
@@ -356,6 +983,24 @@ class ClipboardManager {
         error: error.message,
       });
       throw error;
+    } finally {
+      this._clearPreDetectedPasteTarget();
+      debugLogger.traceSpan("paste", traceStartUs, hrtimeMicros(), { args: { method } });
+    }
+  }
+
+  // pasteText's keysAfter, e.g. "enter" to submit a chat box. The text is on
+  // screen by now, so a failure here is logged rather than thrown.
+  async _sendKeysAfterPaste(script) {
+    try {
+      const reply = await this.sendKeys(script);
+      debugLogger.debug("Keys sent after paste", { script, reply }, "clipboard");
+    } catch (error) {
+      debugLogger.warn(
+        "Could not send keys after paste",
+        { script, error: error.message },
+        "clipboard"
+      );
     }
   }
 
@@ -364,6 +1009,13 @@ class ClipboardManager {
     const useFastPaste = !!fastPasteBinary;
     const pasteDelay = options.fromStreaming ? (useFastPaste ? 15 : 50) : PASTE_DELAYS.darwin;
 
+    if (useFastPaste) {
+      const pasted = this._pasteMacOSWithDaemon(originalClipboard, pasteDelay);
+      // The next paste only waits for this one to settle, whatever the outcome
+      this.macPasteInFlight = pasted.catch(() => false);
+      if (await pasted) return;
+    }
+
     return new Promise((resolve, reject) => {
       setTimeout(() => {
         const pasteProcess = useFastPaste
@@ -397,8 +1049,7 @@ class ClipboardManager {
                 ? "CGEvent binary lacks accessibility trust, falling back to osascript"
                 : `CGEvent paste failed (code ${code}), falling back to osascript`
             );
-            this.fastPasteChecked = true;
-            this.fastPastePath = null;
+            startupManifest.disableHelper("macos-fast-paste");
             this.pasteMacOSWithOsascript(originalClipboard).then(resolve).catch(reject);
           } else {
             this.accessibilityCache = { value: null, expiresAt: 0 };
@@ -414,8 +1065,7 @@ class ClipboardManager {
 
           if (useFastPaste) {
             this.safeLog("CGEvent paste error, falling back to osascript");
-            this.fastPasteChecked = true;
-            this.fastPastePath = null;
+            startupManifest.disableHelper("macos-fast-paste");
             this.pasteMacOSWithOsascript(originalClipboard).then(resolve).catch(reject);
           } else {
             const errorMsg = `Paste command failed: ${error.message}. Text is copied to clipboard - please paste manually with Cmd+V.`;
@@ -435,6 +1085,55 @@ class ClipboardManager {
     });
   }
 
+  /**
+   * Paste through the resident helper. The fixed pre-paste delay becomes the
+   * upper bound of its wait for the dictation target (or any app other than
+   * ours) to be frontmost, and the reply waits until the target has consumed
+   * the paste, with RESTORE_DELAYS.darwin as the fallback when it can't tell.
+   * @returns {Promise<boolean>} false when the caller should use the one-shot path;
+   * rejects when the daemon may have pasted without answering
+   */
+  async _pasteMacOSWithDaemon(originalClipboard, timeoutMs) {
+    const daemon = this._getMacPasteDaemon();
+    if (!daemon) return false;
+
+    const target = this._getPreDetectedPasteTarget();
+    const args = ["PASTE", "--timeout", timeoutMs, "--consume-timeout", RESTORE_DELAYS.darwin];
+    if (target?.pid) args.push("--pid", target.pid);
+    let timing;
+    try {
+      const reply = await daemon.send(args.join(" "), {
+        timeoutMs: timeoutMs + RESTORE_DELAYS.darwin + 2000,
+      });
+      timing = parseFastPasteTiming(reply);
+      tracePasteTiming(daemon.name, timing);
+      debugLogger.debug(
+        "macos-fast-paste daemon paste",
+        { bundleId: target?.bundleId, ...timing },
+        "clipboard"
+      );
+    } catch (error) {
+      // A PASTE that timed out may already have sent Cmd+V
+      if (error.outcomeUnknown) throw error;
+      debugLogger.debug(
+        "macos-fast-paste daemon unavailable, spawning one-shot",
+        { error: error.message },
+        "clipboard"
+      );
+      return false;
+    }
+
+    this.safeLog("Text pasted successfully via CGEvent daemon");
+    if (timing.servedMs === undefined) {
+      // Helper without --consume-timeout support
+      setTimeout(() => clipboard.writeText(originalClipboard), RESTORE_DELAYS.darwin);
+    } else if (!timing.clipboardChanged) {
+      // Consumed, or the fallback timeout already ran in the helper
+      clipboard.writeText(originalClipboard);
+    }
+    return true;
+  }
+
   async pasteMacOSWithOsascript(originalClipboard) {
     return new Promise((resolve, reject) => {
       const pasteProcess = spawn("osascript", [
@@ -483,17 +1182,104 @@ class ClipboardManager {
     });
   }
 
+  /**
+   * Try paste attempts ({ method, run }) in the order the strategy cache
+   * suggests for windowClass, recording each outcome. Resolves true on the
+   * first success; failures are appended to failures as { method, error }.
+   * A failure with outcomeUnknown (e.g. a helper timeout) is thrown right away.
+   */
+  async _pasteWithStrategies(windowClass, attempts, failures = []) {
+    for (const attempt of this.pasteStrategies.order(windowClass, attempts)) {
+      const startedAt = Date.now();
+      try {
+        await attempt.run();
+        this.pasteStrategies.recordSuccess(windowClass, attempt.method, Date.now() - startedAt);
+        return true;
+      } catch (error) {
+        this.pasteStrategies.recordFailure(windowClass, attempt.method, Date.now() - startedAt);
+        // The keystroke may already have gone out; another method would paste twice
+        if (error?.outcomeUnknown) throw error;
+        failures.push({ method: attempt.method, error });
+        debugLogger.warn(
+          "Paste method failed, trying next",
+          { method: attempt.method, windowClass, error: error?.message || String(error) },
+          "clipboard"
+        );
+      }
+    }
+    return false;
+  }
+
+  // Class of the foreground window for the strategy cache, but only from a
+  // resident helper: a one-shot --detect-only would cost more than it saves
+  async _getWindowsPasteTargetClass() {
+    try {
+      const channel = this.pasteAgent?.hasFeature("detect")
+        ? await this._getWindowsCommandChannel("detect")
+        : this.windowsPasteDaemon;
+      if (!channel) return null;
+      const reply = await channel.send("DETECT");
+      return reply.split(/\s+/).slice(3).join(" ") || null;
+    } catch {
+      return null;
+    }
+  }
+
   async pasteWindows(originalClipboard) {
+    const attempts = [];
     const fastPastePath = this.resolveWindowsFastPasteBinary();
-
     if (fastPastePath) {
-      return this.pasteWithFastPaste(fastPastePath, originalClipboard);
+      attempts.push({
+        method: "fast-paste",
+        run: () => this.pasteWithFastPaste(fastPastePath, originalClipboard),
+      });
     }
-
-    return this.pasteWithNircmdOrPowerShell(originalClipboard);
+    const nircmdPath = this.getNircmdPath();
+    if (nircmdPath) {
+      attempts.push({
+        method: "nircmd",
+        run: () => this.pasteWithNircmd(nircmdPath, originalClipboard),
+      });
+    }
+    attempts.push({ method: "powershell", run: () => this.pasteWithPowerShell(originalClipboard) });
+
+    const windowClass = await this._getWindowsPasteTargetClass();
+    const failures = [];
+    if (await this._pasteWithStrategies(windowClass, attempts, failures)) return;
+    // PowerShell's error carries the "paste manually" hint
+    const powershellFailure = failures.find(({ method }) => method === "powershell");
+    throw (powershellFailure || failures[failures.length - 1]).error;
   }
 
   async pasteWithFastPaste(fastPastePath, originalClipboard) {
+    const daemon = await this._getWindowsCommandChannel("paste");
+    if (daemon) {
+      try {
+        await new Promise((resolve) => setTimeout(resolve, PASTE_DELAYS.win32_fast));
+        const args = ["PASTE", "--pre-delay", WINDOWS_SERVER_PASTE_TIMING.preDelayMs];
+        args.push("--post-delay", WINDOWS_SERVER_PASTE_TIMING.postDelayMs);
+        const reply = await daemon.send(args.join(" "));
+        const timing = parseWindowsPasteTiming(reply, this.pasteAgent?.lastKeyUpUs);
+        tracePasteTiming(daemon.name, timing);
+        this.safeLog("✅ Windows fast-paste server success", {
+          helper: daemon.name,
+          output: reply,
+          ...timing,
+        });
+        setTimeout(() => {
+          clipboard.writeText(originalClipboard);
+          this.safeLog("🔄 Clipboard restored");
+        }, RESTORE_DELAYS.win32_nircmd);
+        return;
+      } catch (error) {
+        // A PASTE that timed out may already have sent Ctrl+V
+        if (error.outcomeUnknown) throw error;
+        this.safeLog("⚠️ Windows fast-paste server unavailable, spawning one-shot", {
+          error: error.message,
+        });
+      }
+    }
+
     return new Promise((resolve, reject) => {
       setTimeout(() => {
         let hasTimedOut = false;
@@ -539,7 +1325,7 @@ class ClipboardManager {
               `❌ Windows fast-paste failed (code ${code}), falling back to nircmd/PowerShell`,
               { elapsedMs: elapsed, stderr: stderrData.trim() }
             );
-            this.pasteWithNircmdOrPowerShell(originalClipboard).then(resolve).catch(reject);
+            reject(new Error(`windows-fast-paste exited with code ${code}`));
           }
         });
 
@@ -550,7 +1336,7 @@ class ClipboardManager {
             elapsedMs: Date.now() - startTime,
             error: error.message,
           });
-          this.pasteWithNircmdOrPowerShell(originalClipboard).then(resolve).catch(reject);
+          reject(error);
         });
 
         const timeoutId = setTimeout(() => {
@@ -558,20 +1344,12 @@ class ClipboardManager {
           this.safeLog("⏱️ Windows fast-paste timeout, falling back to nircmd/PowerShell");
           killProcess(pasteProcess, "SIGKILL");
           pasteProcess.removeAllListeners();
-          this.pasteWithNircmdOrPowerShell(originalClipboard).then(resolve).catch(reject);
+          reject(new Error("windows-fast-paste timed out"));
         }, 2000);
       }, PASTE_DELAYS.win32_fast);
     });
   }
 
-  async pasteWithNircmdOrPowerShell(originalClipboard) {
-    const nircmdPath = this.getNircmdPath();
-    if (nircmdPath) {
-      return this.pasteWithNircmd(nircmdPath, originalClipboard);
-    }
-    return this.pasteWithPowerShell(originalClipboard);
-  }
-
   async pasteWithNircmd(nircmdPath, originalClipboard) {
     return new Promise((resolve, reject) => {
       const pasteDelay = PASTE_DELAYS.win32_nircmd;
@@ -612,7 +1390,7 @@ class ClipboardManager {
               elapsedMs: elapsed,
               stderr: errorOutput,
             });
-            this.pasteWithPowerShell(originalClipboard).then(resolve).catch(reject);
+            reject(new Error(`nircmd exited with code ${code}`));
           }
         });
 
@@ -624,7 +1402,7 @@ class ClipboardManager {
             elapsedMs: elapsed,
             error: error.message,
           });
-          this.pasteWithPowerShell(originalClipboard).then(resolve).catch(reject);
+          reject(error);
         });
 
         const timeoutId = setTimeout(() => {
@@ -633,7 +1411,7 @@ class ClipboardManager {
           this.safeLog(`⏱️ nircmd timeout, falling back to PowerShell`, { elapsedMs: elapsed });
           killProcess(pasteProcess, "SIGKILL");
           pasteProcess.removeAllListeners();
-          this.pasteWithPowerShell(originalClipboard).then(resolve).catch(reject);
+          reject(new Error("nircmd timed out"));
         }, 2000);
       }, pasteDelay);
     });
@@ -769,31 +1547,6 @@ class ClipboardManager {
       }, RESTORE_DELAYS.linux);
     };
 
-    const terminalClasses = [
-      "konsole",
-      "gnome-terminal",
-      "terminal",
-      "kitty",
-      "alacritty",
-      "terminator",
-      "xterm",
-      "urxvt",
-      "rxvt",
-      "tilix",
-      "terminology",
-      "wezterm",
-      "foot",
-      "st",
-      "yakuake",
-      "ghostty",
-      "guake",
-      "tilda",
-      "hyper",
-      "tabby",
-      "sakura",
-      "warp",
-    ];
-
     // Pre-detect the target window BEFORE our window takes focus or blurs,
     // so the fast-paste binary and fallback tools know where to send keystrokes.
     const preDetectTargetWindow = () => {
@@ -819,28 +1572,70 @@ class ClipboardManager {
       }
     };
 
-    const targetWindowId = preDetectTargetWindow();
-    const xdotoolWindowClass = preDetectWindowClass(targetWindowId);
-
+    // The resident helper answers DETECT without launching a process or blocking
+    // the main thread; the target seen at recording start covers a busy or
+    // uinput-only daemon. xdotool is the last resort.
+    const nativeTarget =
+      (await this.detectLinuxPasteTarget()) || this._getPreDetectedPasteTarget();
+    const targetWindowId = nativeTarget ? nativeTarget.windowId : preDetectTargetWindow();
+    const targetWindowClass = nativeTarget
+      ? nativeTarget.windowClass
+      : preDetectWindowClass(targetWindowId);
+
+    const attempts = [];
     if (linuxFastPaste) {
-      const earlyIsTerminal = xdotoolWindowClass
-        ? terminalClasses.some((t) => xdotoolWindowClass.includes(t))
-        : false;
+      const earlyIsTerminal = nativeTarget
+        ? nativeTarget.isTerminal
+        : targetWindowClass
+          ? isTerminalClass(targetWindowClass)
+          : false;
+
+      const linuxPasteDaemon = this._getLinuxPasteDaemon();
+
+      const spawnFastPaste = async (args, label) => {
+        if (linuxPasteDaemon) {
+          try {
+            const reply = await linuxPasteDaemon.send(["PASTE", ...args].join(" "));
+            const timing = parseFastPasteTiming(reply);
+            tracePasteTiming(linuxPasteDaemon.name, timing);
+            debugLogger.debug(
+              `linux-fast-paste daemon paste (${label})`,
+              { args, ...timing },
+              "clipboard"
+            );
+            return timing;
+          } catch (daemonError) {
+            // A PASTE that timed out may already have sent Ctrl+V
+            if (daemonError?.outcomeUnknown) throw daemonError;
+            debugLogger.debug(
+              "linux-fast-paste daemon unavailable, spawning one-shot",
+              { error: daemonError?.message },
+              "clipboard"
+            );
+          }
+        }
+        return spawnOneShot(args, label);
+      };
 
-      const spawnFastPaste = (args, label) =>
+      const spawnOneShot = (args, label) =>
         new Promise((resolve, reject) => {
           debugLogger.debug(
             `Attempting native linux-fast-paste (${label})`,
-            { linuxFastPaste, args, targetWindowId, xdotoolWindowClass, earlyIsTerminal },
+            { linuxFastPaste, args, targetWindowId, targetWindowClass, earlyIsTerminal },
             "clipboard"
           );
           const proc = spawn(linuxFastPaste, args);
           let stderr = "";
+          let stdout = "";
 
           proc.stderr?.on("data", (data) => {
             stderr += data.toString();
           });
 
+          proc.stdout?.on("data", (data) => {
+            stdout += data.toString();
+          });
+
           let timedOut = false;
           const timeoutId = setTimeout(() => {
             timedOut = true;
@@ -851,7 +1646,14 @@ class ClipboardManager {
             if (timedOut) return reject(new Error("linux-fast-paste timed out"));
             clearTimeout(timeoutId);
             if (code === 0) {
-              resolve();
+              const timing = parseFastPasteTiming(stdout.trim());
+              tracePasteTiming("linux-fast-paste", timing);
+              debugLogger.debug(
+                `linux-fast-paste one-shot paste (${label})`,
+                { args, ...timing },
+                "clipboard"
+              );
+              resolve(timing);
             } else {
               reject(
                 new Error(
@@ -868,85 +1670,55 @@ class ClipboardManager {
           });
         });
 
-      if (isWayland) {
-        const uinputArgs = ["--uinput"];
-        if (earlyIsTerminal) uinputArgs.push("--terminal");
+      const xtestArgs = [];
+      if (targetWindowId) xtestArgs.push("--window", targetWindowId);
+      if (earlyIsTerminal) xtestArgs.push("--terminal");
 
-        try {
-          await spawnFastPaste(uinputArgs, "uinput");
-          this.safeLog("✅ Paste successful using native linux-fast-paste (uinput)");
+      const nativeAttempt = (method, args, label) => ({
+        method,
+        run: async () => {
+          const timing = await spawnFastPaste(args, label);
+          this.safeLog(`✅ Paste successful using native linux-fast-paste (${label})`);
           debugLogger.info(
             "Paste successful",
-            { tool: "linux-fast-paste", method: "uinput" },
+            { tool: "linux-fast-paste", method, ...timing },
             "clipboard"
           );
           restoreClipboard();
-          return;
-        } catch (uinputError) {
-          debugLogger.warn("uinput paste failed", { error: uinputError?.message }, "clipboard");
-
-          if (xwaylandAvailable) {
-            const xtestArgs = [];
-            if (targetWindowId) xtestArgs.push("--window", targetWindowId);
-            if (earlyIsTerminal) xtestArgs.push("--terminal");
-
-            try {
-              await spawnFastPaste(xtestArgs, "XTest/XWayland fallback");
-              this.safeLog("✅ Paste successful using native linux-fast-paste (XTest/XWayland)");
-              debugLogger.info(
-                "Paste successful",
-                { tool: "linux-fast-paste", method: "xtest-xwayland" },
-                "clipboard"
-              );
-              restoreClipboard();
-              return;
-            } catch (xtestError) {
-              debugLogger.warn(
-                "XTest/XWayland fallback also failed",
-                { error: xtestError?.message },
-                "clipboard"
-              );
-            }
-          }
+        },
+      });
 
-          this.safeLog(
-            `⚠️ Native linux-fast-paste failed: ${uinputError?.message || uinputError}, falling back to system tools`
-          );
+      if (isWayland) {
+        const virtualKeyboardArgs = this._linuxVirtualKeyboardArgs();
+        if (earlyIsTerminal) virtualKeyboardArgs.push("--terminal");
+        attempts.push(
+          nativeAttempt(
+            "uinput",
+            virtualKeyboardArgs,
+            isWlroots ? "Wayland virtual keyboard/uinput" : "uinput"
+          )
+        );
+        if (xwaylandAvailable) {
+          attempts.push(nativeAttempt("xtest-xwayland", xtestArgs, "XTest/XWayland"));
         }
       } else {
-        const xtestArgs = [];
-        if (targetWindowId) xtestArgs.push("--window", targetWindowId);
-        if (earlyIsTerminal) xtestArgs.push("--terminal");
-
-        try {
-          await spawnFastPaste(xtestArgs, "XTest");
-          this.safeLog("✅ Paste successful using native linux-fast-paste (XTest)");
-          debugLogger.info(
-            "Paste successful",
-            { tool: "linux-fast-paste", method: "xtest" },
-            "clipboard"
-          );
-          restoreClipboard();
-          return;
-        } catch (error) {
-          this.safeLog(
-            `⚠️ Native linux-fast-paste failed: ${error?.message || error}, falling back to system tools`
-          );
-          debugLogger.warn(
-            "Native linux-fast-paste failed, falling back",
-            { error: error?.message },
-            "clipboard"
-          );
-        }
+        attempts.push(nativeAttempt("xtest", xtestArgs, "XTest"));
       }
     }
 
     // Terminals use Ctrl+Shift+V instead of Ctrl+V
     const isTerminal = () => {
-      if (xdotoolWindowClass) {
-        const isTerminalWindow = terminalClasses.some((term) => xdotoolWindowClass.includes(term));
+      if (nativeTarget) {
+        if (nativeTarget.isTerminal) {
+          this.safeLog(`🖥️ Terminal detected via linux-fast-paste: ${targetWindowClass}`);
+        }
+        return nativeTarget.isTerminal;
+      }
+
+      if (targetWindowClass) {
+        const isTerminalWindow = isTerminalClass(targetWindowClass);
         if (isTerminalWindow) {
-          this.safeLog(`🖥️ Terminal detected via xdotool: ${xdotoolWindowClass}`);
+          this.safeLog(`🖥️ Terminal detected via xdotool: ${targetWindowClass}`);
         }
         return isTerminalWindow;
       }
@@ -959,7 +1731,7 @@ class ClipboardManager {
             const classResult = spawnSync("kdotool", ["getwindowclassname", windowId]);
             if (classResult.status === 0) {
               const className = classResult.stdout.toString().toLowerCase().trim();
-              const isTerminalWindow = terminalClasses.some((term) => className.includes(term));
+              const isTerminalWindow = isTerminalClass(className);
               if (isTerminalWindow) {
                 this.safeLog(`🖥️ Terminal detected via kdotool: ${className}`);
               }
@@ -971,40 +1743,43 @@ class ClipboardManager {
       return false;
     };
 
-    const inTerminal = isTerminal();
-    const pasteKeys = inTerminal ? "ctrl+shift+v" : "ctrl+v";
+    // Only the system tools need the verdict, and they may never run
+    let terminalVerdict = null;
+    const inTerminal = () => {
+      if (terminalVerdict === null) terminalVerdict = isTerminal();
+      return terminalVerdict;
+    };
+    const pasteKeys = () => (inTerminal() ? "ctrl+shift+v" : "ctrl+v");
 
     const canUseWtype = isWayland && isWlroots;
     const canUseYdotool = ydotoolDaemonRunning;
     const canUseXdotool = isWayland ? xwaylandAvailable && xdotoolExists : xdotoolExists;
 
     // windowactivate ensures the target window (not ours) receives the keystroke
-    const xdotoolArgs = targetWindowId
-      ? ["windowactivate", "--sync", targetWindowId, "key", pasteKeys]
-      : ["key", pasteKeys];
+    const xdotoolArgs = () =>
+      targetWindowId
+        ? ["windowactivate", "--sync", targetWindowId, "key", pasteKeys()]
+        : ["key", pasteKeys()];
 
     if (targetWindowId) {
       this.safeLog(
-        `🎯 Targeting window ID ${targetWindowId} for paste (class: ${xdotoolWindowClass})`
+        `🎯 Targeting window ID ${targetWindowId} for paste (class: ${targetWindowClass})`
       );
     }
 
     // Raw keycodes work across both ydotool 0.1.x and 1.0.x (key names silently fail on 1.0.x)
     // 29 = KEY_LEFTCTRL, 42 = KEY_LEFTSHIFT, 47 = KEY_V
-    const ydotoolArgs = inTerminal
-      ? ["key", "29:1", "42:1", "47:1", "47:0", "42:0", "29:0"]
-      : ["key", "29:1", "47:1", "47:0", "29:0"];
-
-    const wtypeEntry = canUseWtype
-      ? [
-          inTerminal
-            ? {
-                cmd: "wtype",
-                args: ["-M", "ctrl", "-M", "shift", "-k", "v", "-m", "shift", "-m", "ctrl"],
-              }
-            : { cmd: "wtype", args: ["-M", "ctrl", "-k", "v", "-m", "ctrl"] },
-        ]
-      : [];
+    const ydotoolArgs = () =>
+      inTerminal()
+        ? ["key", "29:1", "42:1", "47:1", "47:0", "42:0", "29:0"]
+        : ["key", "29:1", "47:1", "47:0", "29:0"];
+
+    const wtypeArgs = () =>
+      inTerminal()
+        ? ["-M", "ctrl", "-M", "shift", "-k", "v", "-m", "shift", "-m", "ctrl"]
+        : ["-M", "ctrl", "-k", "v", "-m", "ctrl"];
+
+    const wtypeEntry = canUseWtype ? [{ cmd: "wtype", args: wtypeArgs }] : [];
     const xdotoolEntry = canUseXdotool ? [{ cmd: "xdotool", args: xdotoolArgs }] : [];
     const ydotoolEntry = canUseYdotool ? [{ cmd: "ydotool", args: ydotoolArgs }] : [];
 
@@ -1029,9 +1804,7 @@ class ClipboardManager {
         candidateTools: candidates.map((c) => c.cmd),
         availableTools: available.map((c) => c.cmd),
         targetWindowId,
-        xdotoolWindowClass,
-        inTerminal,
-        pasteKeys,
+        targetWindowClass,
       },
       "clipboard"
     );
@@ -1123,29 +1896,30 @@ class ClipboardManager {
         }, delay);
       });
 
-    const failedAttempts = [];
     for (const tool of available) {
-      try {
-        await pasteWith(tool);
-        this.safeLog(`✅ Paste successful using ${tool.cmd}`);
-        debugLogger.info("Paste successful", { tool: tool.cmd }, "clipboard");
-        return;
-      } catch (error) {
-        const failureInfo = {
-          tool: tool.cmd,
-          args: tool.args,
-          error: error?.message || String(error),
-        };
-        failedAttempts.push(failureInfo);
-        this.safeLog(`⚠️ Paste with ${tool.cmd} failed:`, error?.message || error);
-        debugLogger.warn("Paste tool failed, trying next", failureInfo, "clipboard");
-      }
+      attempts.push({
+        method: tool.cmd,
+        run: async () => {
+          await pasteWith({ cmd: tool.cmd, args: tool.args() });
+          this.safeLog(`✅ Paste successful using ${tool.cmd}`);
+          debugLogger.info("Paste successful", { tool: tool.cmd }, "clipboard");
+        },
+      });
     }
 
+    // Native helper first, then the system tools, unless this app has taught
+    // the strategy cache otherwise
+    const failures = [];
+    if (await this._pasteWithStrategies(targetWindowClass, attempts, failures)) return;
+    const failedAttempts = failures.map(({ method, error }) => ({
+      tool: method,
+      error: error?.message || String(error),
+    }));
+
     debugLogger.error("All paste tools failed", { failedAttempts }, "clipboard");
 
     // xdotool type fallback for terminals where Ctrl+Shift+V simulation fails
-    if (inTerminal && xdotoolExists && !isWayland) {
+    if (inTerminal() && xdotoolExists && !isWayland) {
       debugLogger.debug(
         "Trying xdotool type fallback for terminal",
         {
@@ -1375,14 +2149,39 @@ Would you like to open System Settings now?`;
     tryNextCommand();
   }
 
+  /**
+   * Start the resident paste helper ahead of the first paste. Resolves once it
+   * is ready, or with null when this platform or session has none to start.
+   */
   preWarmAccessibility() {
     if (process.platform === "linux") {
-      this.resolveLinuxFastPasteBinary();
-      return;
+      return this._getLinuxPasteDaemon()?.start() ?? Promise.resolve(null);
+    }
+    if (process.platform === "win32") {
+      if (this.pasteAgent?.hasFeature("paste")) return Promise.resolve(null);
+      return this._getWindowsPasteDaemon().then((daemon) => daemon?.start() ?? null);
+    }
+    if (process.platform !== "darwin") return Promise.resolve(null);
+    return this.checkAccessibilityPermissions().then((trusted) => {
+      // An untrusted helper exits before READY, so only start it once trusted
+      return trusted ? this._getMacPasteDaemon()?.start() ?? null : null;
+    });
+  }
+
+  stopNativeHelpers() {
+    if (this.linuxPasteDaemon) {
+      this.linuxPasteDaemon.stop();
+      this.linuxPasteDaemon = null;
+    }
+    if (this.windowsPasteDaemon) {
+      this.windowsPasteDaemon.stop();
+      this.windowsPasteDaemon = null;
+    }
+    if (this.macPasteDaemon) {
+      this.macPasteDaemon.stop();
+      this.macPasteDaemon = null;
     }
-    if (process.platform !== "darwin") return;
-    this.checkAccessibilityPermissions().catch(() => {});
-    this.resolveFastPasteBinary();
+    this.pasteStrategies.flush();
   }
 
   async readClipboard() {
@@ -1447,7 +2246,9 @@ Would you like to open System Settings now?`;
     }
 
     const hasUinput = this._canAccessUinput();
-    const nativeBinaryUsable = hasNativeBinary && (!isWayland || hasUinput || xwaylandAvailable);
+    // wlroots compositors take keys from linux-fast-paste's virtual keyboard
+    const nativeBinaryUsable =
+      hasNativeBinary && (!isWayland || hasUinput || xwaylandAvailable || isWlroots);
     const available = nativeBinaryUsable || tools.length > 0;
     let recommendedInstall;
     if (!nativeBinaryUsable && tools.length === 0) {
@@ -1458,7 +2259,7 @@ Would you like to open System Settings now?`;
       } else {
         recommendedInstall = "xdotool";
       }
-    } else if (isWayland && hasNativeBinary && !hasUinput && tools.length === 0) {
+    } else if (isWayland && hasNativeBinary && !hasUinput && !isWlroots && tools.length === 0) {
       recommendedInstall = "usermod -aG input $USER";
     }
 
@@ -1466,9 +2267,11 @@ Would you like to open System Settings now?`;
       platform: "linux",
       available,
       method: nativeBinaryUsable
-        ? isWayland && hasUinput
-          ? "uinput"
-          : "xtest"
+        ? isWayland && isWlroots
+          ? "virtual-keyboard"
+          : isWayland && hasUinput
+            ? "uinput"
+            : "xtest"
         : available
           ? tools[0]
           : null,
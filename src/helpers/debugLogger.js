@@ -1,6 +1,7 @@
 const fs = require("fs");
 const path = require("path");
 const { app } = require("electron");
+const { hrtimeMicros } = require("./nativeEventStream");
 
 const LOG_LEVELS = {
   trace: 10,
@@ -11,6 +12,12 @@ const LOG_LEVELS = {
   fatal: 60,
 };
 
+// Dictation latency traces kept for the Chrome trace JSON export
+const MAX_DICTATION_TRACES = 20;
+// Hook events this long before a dictation begins are its trigger
+const TRACE_BACKLOG_US = 2000000;
+const MAX_TRACE_BACKLOG = 16;
+
 const normalizeLevel = (value) => {
   if (!value) return null;
   const lower = String(value).toLowerCase();
@@ -40,6 +47,10 @@ class DebugLogger {
     this.logStream = null;
     this.fileLoggingEnabled = false;
     this.fileLoggingPending = this.debugMode; // Track if we need to initialize file logging later
+    this.dictationTraces = [];
+    this.activeTrace = null;
+    this.traceBacklog = [];
+    this.traceCount = 0;
 
     // IMPORTANT: Do NOT call initializeFileLogging() here!
     // It uses app.getPath() which is unsafe before app.whenReady().
@@ -388,6 +399,154 @@ class DebugLogger {
     this.debug(`STT Pipeline - ${stage}`, details, "stt");
   }
 
+  /**
+   * Start the latency trace of a new dictation, closing the previous one.
+   * Trace timestamps are microseconds on the process.hrtime clock, which the
+   * native helpers stamp their events and replies with.
+   */
+  beginDictationTrace(args = {}) {
+    if (!this.isDebugEnabled()) return;
+    this.endDictationTrace();
+
+    const now = hrtimeMicros();
+    this.traceCount += 1;
+    this.activeTrace = {
+      id: this.traceCount,
+      startedAt: new Date().toISOString(),
+      args,
+      events: this.traceBacklog.filter((event) => now - event.ts <= TRACE_BACKLOG_US),
+    };
+    this.traceBacklog = [];
+  }
+
+  /**
+   * Record a span (with dur) or an instant in the current dictation trace.
+   * Events arriving before a dictation begins (the hotkey that starts it) are
+   * held briefly and adopted by the next trace.
+   * @param {string} name
+   * @param {Object} [options]
+   * @param {number} [options.ts] - start in hrtime microseconds, default now
+   * @param {number} [options.dur] - duration in microseconds
+   * @param {string} [options.track] - row in the trace viewer, e.g. the helper name
+   * @param {Object} [options.args]
+   */
+  traceEvent(name, { ts, dur, track = "main", args } = {}) {
+    if (!this.isDebugEnabled()) return;
+    const event = { name, track, ts: Math.round(ts ?? hrtimeMicros()), dur, args };
+    if (this.activeTrace) {
+      this.activeTrace.events.push(event);
+      return;
+    }
+    this.traceBacklog.push(event);
+    if (this.traceBacklog.length > MAX_TRACE_BACKLOG) this.traceBacklog.shift();
+  }
+
+  traceSpan(name, startUs, endUs, options = {}) {
+    this.traceEvent(name, { ...options, ts: startUs, dur: Math.max(endUs - startUs, 0) });
+  }
+
+  /**
+   * Trace entry from the renderer, timed with performance.now() there.
+   * performance.timeOrigin is wall-clock based in both processes, so the
+   * renderer time is mapped onto the hrtime clock through it.
+   */
+  traceEntry(entry) {
+    if (!entry || typeof entry !== "object" || !this.isDebugEnabled()) return;
+    if (entry.type === "begin") {
+      this.beginDictationTrace(entry.args);
+      return;
+    }
+    if (entry.type === "end") {
+      this.endDictationTrace();
+      return;
+    }
+
+    const offsetUs = (performance.timeOrigin + performance.now()) * 1000 - hrtimeMicros();
+    const toTraceUs = (ms) => (entry.timeOrigin + ms) * 1000 - offsetUs;
+    const startUs = toTraceUs(entry.start);
+    const options = { track: entry.track || "renderer", args: entry.args };
+    if (typeof entry.end === "number") {
+      this.traceSpan(String(entry.name), startUs, toTraceUs(entry.end), options);
+    } else {
+      this.traceEvent(String(entry.name), { ...options, ts: startUs });
+    }
+  }
+
+  endDictationTrace() {
+    if (!this.activeTrace) return;
+    this.dictationTraces.push(this.activeTrace);
+    if (this.dictationTraces.length > MAX_DICTATION_TRACES) this.dictationTraces.shift();
+    this.activeTrace = null;
+
+    // Rewritten after every dictation, next to the debug log
+    if (this.logFile) {
+      fs.writeFile(
+        this.logFile.replace(/\.log$/, ".trace.json"),
+        JSON.stringify(this.buildChromeTrace()),
+        () => {}
+      );
+    }
+  }
+
+  /**
+   * The recent dictations in Chrome trace event format (chrome://tracing,
+   * ui.perfetto.dev), one process row per dictation and one thread row per
+   * track.
+   */
+  buildChromeTrace() {
+    const traces = this.activeTrace
+      ? [...this.dictationTraces, this.activeTrace]
+      : this.dictationTraces;
+    const traceEvents = [];
+
+    for (const trace of traces) {
+      const pid = trace.id;
+      traceEvents.push({
+        name: "process_name",
+        ph: "M",
+        pid,
+        tid: 0,
+        args: { name: `Dictation ${trace.id} (${trace.startedAt})`, ...trace.args },
+      });
+
+      const tids = new Map();
+      for (const event of trace.events) {
+        let tid = tids.get(event.track);
+        if (tid === undefined) {
+          tid = tids.size + 1;
+          tids.set(event.track, tid);
+          traceEvents.push({ name: "thread_name", ph: "M", pid, tid, args: { name: event.track } });
+        }
+        const record = { name: event.name, cat: "dictation", ts: event.ts, pid, tid };
+        if (event.dur != null) {
+          record.ph = "X";
+          record.dur = Math.round(event.dur);
+        } else {
+          record.ph = "i";
+          record.s = "t";
+        }
+        if (event.args) record.args = event.args;
+        traceEvents.push(record);
+      }
+    }
+
+    return { traceEvents, displayTimeUnit: "ms" };
+  }
+
+  /**
+   * Write the recent dictation traces to the logs folder.
+   * @returns {string|null} path of the written file
+   */
+  exportDictationTraces() {
+    if (!app.isReady()) return null;
+    const logsDir = path.join(app.getPath("userData"), "logs");
+    fs.mkdirSync(logsDir, { recursive: true });
+    const timestamp = new Date().toISOString().replace(/[:.]/g, "-");
+    const tracePath = path.join(logsDir, `latency-trace-${timestamp}.json`);
+    fs.writeFileSync(tracePath, JSON.stringify(this.buildChromeTrace()));
+    return tracePath;
+  }
+
   getLogPath() {
     return this.logFile;
   }
@@ -17,6 +17,8 @@ const PERSISTED_KEYS = [
   "LOCAL_WHISPER_MODEL",
   "REASONING_PROVIDER",
   "LOCAL_REASONING_MODEL",
+  "LOCAL_MODEL_IDLE_MINUTES",
+  "OPENWHISPR_TERMINAL_CLASSES",
   "DICTATION_KEY",
   "ACTIVATION_MODE",
   "FLOATING_ICON_AUTO_HIDE",
@@ -224,6 +224,45 @@ function wavToFloat32Samples(wavBuffer) {
   return float32;
 }
 
+// True for the exact format whisper.cpp wants (16-bit PCM, mono, 16 kHz),
+// which needs no ffmpeg pass
+function isPcm16kMonoWav(buffer) {
+  if (!isWavFormat(buffer) || buffer.length < 36) return false;
+  if (buffer.toString("ascii", 12, 16) !== "fmt ") return false;
+  return (
+    buffer.readUInt16LE(20) === 1 &&
+    buffer.readUInt16LE(22) === 1 &&
+    buffer.readUInt32LE(24) === 16000 &&
+    buffer.readUInt16LE(34) === 16
+  );
+}
+
+// Wrap float32 samples (e.g. from the native capture ring) as a 16-bit PCM
+// mono WAV, the format both wavToFloat32Samples and whisper-server read
+function float32ToWav(samples, sampleRate = 16000) {
+  const dataSize = samples.length * 2;
+  const wav = Buffer.alloc(44 + dataSize);
+  wav.write("RIFF", 0, "ascii");
+  wav.writeUInt32LE(36 + dataSize, 4);
+  wav.write("WAVE", 8, "ascii");
+  wav.write("fmt ", 12, "ascii");
+  wav.writeUInt32LE(16, 16);
+  wav.writeUInt16LE(1, 20); // PCM
+  wav.writeUInt16LE(1, 22); // mono
+  wav.writeUInt32LE(sampleRate, 24);
+  wav.writeUInt32LE(sampleRate * 2, 28);
+  wav.writeUInt16LE(2, 32);
+  wav.writeUInt16LE(16, 34);
+  wav.write("data", 36, "ascii");
+  wav.writeUInt32LE(dataSize, 40);
+
+  for (let i = 0; i < samples.length; i++) {
+    const clamped = Math.max(-1, Math.min(1, samples[i]));
+    wav.writeInt16LE(Math.round(clamped * 32767), 44 + i * 2);
+  }
+  return wav;
+}
+
 function computeFloat32RMS(float32Buffer) {
   const numSamples = float32Buffer.length / 4;
   if (numSamples === 0) return 0;
@@ -246,6 +285,8 @@ module.exports = {
   isWavFormat,
   convertToWav,
   wavToFloat32Samples,
+  isPcm16kMonoWav,
+  float32ToWav,
   computeFloat32RMS,
   clearCache,
 };
@@ -1,7 +1,27 @@
 const { spawn } = require("child_process");
-const path = require("path");
 const EventEmitter = require("events");
 const fs = require("fs");
+const debugLogger = require("./debugLogger");
+const startupManifest = require("./startupManifest");
+const {
+  NativeEventStream,
+  BINARY_EVENTS_ENABLED,
+  BINARY_EVENTS_FLAG,
+  EVENT_TYPES,
+} = require("./nativeEventStream");
+
+// Key ids in macos-globe-listener binary records; bindings are 16 + slot
+const RECORD_KEYS = ["Globe", "RightOption", "RightCommand", "RightControl", "RightShift"];
+const RECORD_MODIFIERS = [null, "control", "command", "option", "shift"];
+const RECORD_BINDING_BASE = 16;
+const RECORD_TRACE_NAMES = {
+  [EVENT_TYPES.KEY_DOWN]: "key down",
+  [EVENT_TYPES.KEY_UP]: "key up",
+  [EVENT_TYPES.MODIFIER_UP]: "modifier up",
+};
+
+const COMMAND_TIMEOUT_MS = 2000;
+const KEY_LINE = /^(FN_|RIGHT_MOD_|MODIFIER_UP:|KEY_DOWN:|KEY_UP:)/;
 
 class GlobeKeyManager extends EventEmitter {
   constructor() {
@@ -9,6 +29,10 @@ class GlobeKeyManager extends EventEmitter {
     this.process = null;
     this.isSupported = process.platform === "darwin";
     this.hasReportedError = false;
+    this.features = new Set();
+    this.pending = [];
+    this.bindings = new Map();
+    this.bindingSlots = new Map();
   }
 
   start() {
@@ -40,37 +64,53 @@ class GlobeKeyManager extends EventEmitter {
     }
 
     this.hasReportedError = false;
-    this.process = spawn(listenerPath);
-
-    this.process.stdout.setEncoding("utf8");
-    this.process.stdout.on("data", (chunk) => {
-      chunk
-        .split(/\r?\n/)
-        .map((line) => line.trim())
-        .filter(Boolean)
-        .forEach((line) => {
-          if (line === "FN_DOWN") {
-            this.emit("globe-down");
-          } else if (line === "FN_UP") {
-            this.emit("globe-up");
-          } else if (line.startsWith("RIGHT_MOD_DOWN:")) {
-            const modifier = line.replace("RIGHT_MOD_DOWN:", "").trim();
-            if (modifier) {
-              this.emit("right-modifier-down", modifier);
-            }
-          } else if (line.startsWith("RIGHT_MOD_UP:")) {
-            const modifier = line.replace("RIGHT_MOD_UP:", "").trim();
-            if (modifier) {
-              this.emit("right-modifier-up", modifier);
-            }
-          } else if (line.startsWith("MODIFIER_UP:")) {
-            const modifier = line.replace("MODIFIER_UP:", "").trim().toLowerCase();
-            if (modifier) {
-              this.emit("modifier-up", modifier);
-            }
+    this.features = new Set();
+    this.bindings = new Map();
+    this.bindingSlots = new Map();
+    // Older listeners ignore arguments and stdin and keep sending text lines
+    this.process = spawn(listenerPath, BINARY_EVENTS_ENABLED ? [BINARY_EVENTS_FLAG] : [], {
+      stdio: ["pipe", "pipe", "pipe"],
+    });
+    this.process.stdin.on("error", () => {});
+
+    const events = new NativeEventStream({
+      onRecord: (record) => this._handleRecord(record),
+      onLine: (line) => {
+        if (KEY_LINE.test(line)) {
+          // Text lines carry no helper timestamp, so this is the receive time
+          debugLogger.traceEvent(line, { track: "macos-globe-listener" });
+        }
+        if (line === "FN_DOWN") {
+          this.emit("globe-down");
+        } else if (line === "FN_UP") {
+          this.emit("globe-up");
+        } else if (line.startsWith("RIGHT_MOD_DOWN:")) {
+          const modifier = line.replace("RIGHT_MOD_DOWN:", "").trim();
+          if (modifier) {
+            this.emit("right-modifier-down", modifier);
+          }
+        } else if (line.startsWith("RIGHT_MOD_UP:")) {
+          const modifier = line.replace("RIGHT_MOD_UP:", "").trim();
+          if (modifier) {
+            this.emit("right-modifier-up", modifier);
+          }
+        } else if (line.startsWith("MODIFIER_UP:")) {
+          const modifier = line.replace("MODIFIER_UP:", "").trim().toLowerCase();
+          if (modifier) {
+            this.emit("modifier-up", modifier);
           }
-        });
+        } else if (line.startsWith("KEY_DOWN:") || line.startsWith("KEY_UP:")) {
+          const [name, bindingId] = line.split(":");
+          this.emit(name === "KEY_DOWN" ? "binding-down" : "binding-up", bindingId.trim());
+        } else if (line.startsWith("FEATURES")) {
+          this.features = new Set(line.split(/\s+/).slice(1));
+          this.emit("features", this.features);
+        } else if (this.pending.length > 0) {
+          this._resolveCommand(line);
+        }
+      },
     });
+    this.process.stdout.on("data", (chunk) => events.push(chunk));
 
     this.process.stderr.setEncoding("utf8");
     this.process.stderr.on("data", (data) => {
@@ -88,6 +128,8 @@ class GlobeKeyManager extends EventEmitter {
 
     this.process.on("exit", (code, signal) => {
       this.process = null;
+      this.features = new Set();
+      this._rejectPending(new Error("Globe key listener exited"));
       if (code !== 0 && signal !== "SIGINT" && signal !== "SIGTERM") {
         const error = new Error(
           `Globe key listener exited with code ${code ?? "null"} signal ${signal ?? "null"}`
@@ -97,11 +139,139 @@ class GlobeKeyManager extends EventEmitter {
     });
   }
 
+  // Records add { timestampUs, latencyUs, eventTimeMs } to the same events
+  _handleRecord({ type, keyId, timestampUs, latencyUs, eventTimeMs }) {
+    const timing = { timestampUs, latencyUs, eventTimeMs };
+    debugLogger.traceEvent(RECORD_TRACE_NAMES[type] || "key event", {
+      ts: timestampUs,
+      track: "macos-globe-listener",
+      args: { keyId, latencyUs },
+    });
+    if (type === EVENT_TYPES.MODIFIER_UP) {
+      const modifier = RECORD_MODIFIERS[keyId];
+      if (modifier) this.emit("modifier-up", modifier, timing);
+      return;
+    }
+    const isDown = type === EVENT_TYPES.KEY_DOWN;
+    if (!isDown && type !== EVENT_TYPES.KEY_UP) return;
+    if (keyId >= RECORD_BINDING_BASE) {
+      const bindingId = this.bindingSlots.get(keyId - RECORD_BINDING_BASE);
+      if (bindingId) this.emit(isDown ? "binding-down" : "binding-up", bindingId, timing);
+    } else if (keyId === 0) {
+      this.emit(isDown ? "globe-down" : "globe-up", timing);
+    } else if (RECORD_KEYS[keyId]) {
+      this.emit(isDown ? "right-modifier-down" : "right-modifier-up", RECORD_KEYS[keyId], timing);
+    }
+  }
+
+  /**
+   * Whether the running listener supports a command group ("bind")
+   */
+  hasFeature(feature) {
+    return !!this.process && this.features.has(feature);
+  }
+
+  /**
+   * Watch a hotkey from the listener's event tap, reported as binding-down /
+   * binding-up with the id. Re-binding an id replaces its hotkey. Hotkeys with
+   * an ordinary key need Input Monitoring permission (BIND_ERROR 4).
+   * @param {string} id - Binding name (no spaces or ":")
+   * @param {string} hotkey - Electron-style hotkey, e.g. "Command+Shift+K"
+   */
+  bind(id, hotkey) {
+    if (!this.hasFeature("bind")) {
+      return Promise.reject(new Error("Globe key listener does not support bindings"));
+    }
+    return this.sendCommand(`BIND ${id} ${hotkey}`).then((reply) => {
+      // "BIND_OK <id> <slot>": binary records name bindings by slot
+      const slot = Number(reply.split(/\s+/)[2]);
+      for (const [existing, boundId] of this.bindingSlots) {
+        if (boundId === id) this.bindingSlots.delete(existing);
+      }
+      if (Number.isInteger(slot)) this.bindingSlots.set(slot, id);
+      this.bindings.set(id, hotkey);
+      return reply;
+    });
+  }
+
+  unbind(id) {
+    if (!this.hasFeature("bind") || !this.bindings.has(id)) {
+      return Promise.resolve(null);
+    }
+    this.bindings.delete(id);
+    for (const [slot, boundId] of this.bindingSlots) {
+      if (boundId === id) this.bindingSlots.delete(slot);
+    }
+    return this.sendCommand(`UNBIND ${id}`);
+  }
+
+  /**
+   * Whether a binding currently reports this hotkey's presses and releases
+   */
+  ownsHotkey(hotkey) {
+    return this.hasFeature("bind") && [...this.bindings.values()].includes(hotkey);
+  }
+
+  /**
+   * Send a command line and resolve with its reply, matched in FIFO order;
+   * "ERROR" and "<COMMAND>_ERROR" replies reject.
+   */
+  sendCommand(command, { timeoutMs = COMMAND_TIMEOUT_MS } = {}) {
+    const proc = this.process;
+    if (!proc) {
+      return Promise.reject(new Error("Globe key listener is not running"));
+    }
+
+    return new Promise((resolve, reject) => {
+      const entry = { resolve, reject, timer: null };
+      entry.timer = setTimeout(() => {
+        const index = this.pending.indexOf(entry);
+        if (index !== -1) this.pending.splice(index, 1);
+        // A late reply would be matched to the next command, so stop binding
+        this.features = new Set();
+        this.bindings = new Map();
+        reject(new Error(`Globe key listener timed out on "${command}"`));
+      }, timeoutMs);
+
+      this.pending.push(entry);
+      try {
+        proc.stdin.write(`${command}\n`);
+      } catch (error) {
+        clearTimeout(entry.timer);
+        this.pending.splice(this.pending.indexOf(entry), 1);
+        reject(error);
+      }
+    });
+  }
+
+  _resolveCommand(line) {
+    const entry = this.pending.shift();
+    clearTimeout(entry.timer);
+    const [status] = line.split(" ", 1);
+    if (status === "ERROR" || status.endsWith("_ERROR")) {
+      entry.reject(new Error(`macos-globe-listener: ${line}`));
+    } else {
+      entry.resolve(line);
+    }
+  }
+
+  _rejectPending(error) {
+    const pending = this.pending;
+    this.pending = [];
+    for (const entry of pending) {
+      clearTimeout(entry.timer);
+      entry.reject(error);
+    }
+  }
+
   stop() {
     if (this.process) {
       this.process.kill();
       this.process = null;
     }
+    this.features = new Set();
+    this.bindings = new Map();
+    this._rejectPending(new Error("Globe key listener stopped"));
   }
 
   reportError(error) {
@@ -123,42 +293,7 @@ class GlobeKeyManager extends EventEmitter {
   }
 
   resolveListenerBinary() {
-    const candidates = new Set([
-      path.join(__dirname, "..", "..", "resources", "bin", "macos-globe-listener"),
-      path.join(__dirname, "..", "..", "resources", "macos-globe-listener"),
-    ]);
-
-    if (process.resourcesPath) {
-      [
-        path.join(process.resourcesPath, "macos-globe-listener"),
-        path.join(process.resourcesPath, "bin", "macos-globe-listener"),
-        path.join(process.resourcesPath, "resources", "macos-globe-listener"),
-        path.join(process.resourcesPath, "resources", "bin", "macos-globe-listener"),
-        path.join(process.resourcesPath, "app.asar.unpacked", "resources", "macos-globe-listener"),
-        path.join(
-          process.resourcesPath,
-          "app.asar.unpacked",
-          "resources",
-          "bin",
-          "macos-globe-listener"
-        ),
-      ].forEach((candidate) => candidates.add(candidate));
-    }
-
-    const candidatePaths = [...candidates];
-
-    for (const candidate of candidatePaths) {
-      try {
-        const stats = fs.statSync(candidate);
-        if (stats.isFile()) {
-          return candidate;
-        }
-      } catch {
-        continue;
-      }
-    }
-
-    return null;
+    return startupManifest.resolveHelper("macos-globe-listener");
   }
 }
 
@@ -5,6 +5,9 @@ const https = require("https");
 const crypto = require("crypto");
 const AppUtils = require("../utils");
 const debugLogger = require("./debugLogger");
+const { float32ToWav } = require("./ffmpegUtils");
+const { hrtimeMicros } = require("./nativeEventStream");
+const SpeculativeTranscriber = require("./speculativeTranscription");
 const GnomeShortcutManager = require("./gnomeShortcut");
 const AssemblyAiStreaming = require("./assemblyAiStreaming");
 const { i18nMain, changeLanguage } = require("./i18nMain");
@@ -22,6 +25,9 @@ class IPCHandlers {
     this.windowManager = managers.windowManager;
     this.updateManager = managers.updateManager;
     this.windowsKeyManager = managers.windowsKeyManager;
+    this.linuxKeyManager = managers.linuxKeyManager;
+    this.audioCaptureManager = managers.audioCaptureManager;
+    this.speculativeTranscriber = null;
     this.getTrayManager = managers.getTrayManager;
     this.sessionId = crypto.randomUUID();
     this.assemblyAiStreaming = null;
@@ -29,6 +35,21 @@ class IPCHandlers {
     this.setupHandlers();
   }
 
+  // Decode one speculative window on the warm local server the dictation will use
+  _speculativeTranscribeFn({ provider, model, language, initialPrompt }) {
+    return async (wavBuffer) => {
+      const result =
+        provider === "nvidia"
+          ? await this.parakeetManager.transcribeLocalParakeet(wavBuffer, { model, language })
+          : await this.whisperManager.transcribeLocalWhisper(wavBuffer, {
+              model,
+              language,
+              initialPrompt,
+            });
+      return result?.success ? result.text : "";
+    };
+  }
+
   _syncStartupEnv(setVars, clearVars = []) {
     let changed = false;
     for (const [key, value] of Object.entries(setVars)) {
@@ -201,6 +222,68 @@ class IPCHandlers {
       return this.clipboardManager.checkPasteTools();
     });
 
+    // Native microphone capture (local transcription without MediaRecorder)
+    ipcMain.handle("native-audio-available", async () => {
+      return !!this.audioCaptureManager?.isAvailable();
+    });
+
+    ipcMain.handle("native-audio-start", async (event, options = {}) => {
+      try {
+        this.speculativeTranscriber?.cancel();
+        this.speculativeTranscriber = null;
+        const { startUs } = await this.audioCaptureManager.start(options);
+        if (options.speculative) {
+          this.speculativeTranscriber = new SpeculativeTranscriber({
+            capture: this.audioCaptureManager,
+            transcribe: this._speculativeTranscribeFn(options.speculative),
+          });
+          this.speculativeTranscriber.start();
+        }
+        return { success: true, startUs };
+      } catch (error) {
+        debugLogger.debug("Native audio capture did not start", { error: error.message });
+        return { success: false, error: error.message };
+      }
+    });
+
+    ipcMain.handle("native-audio-stop", async () => {
+      try {
+        const speculativeTranscriber = this.speculativeTranscriber;
+        this.speculativeTranscriber = null;
+        speculativeTranscriber?.cancel();
+        const stopped = await this.audioCaptureManager.stop();
+        const { samples, sampleRate, segments, recordedSamples, firstSampleUs } = stopped;
+        let speculative = null;
+        if (speculativeTranscriber) {
+          try {
+            speculative = await speculativeTranscriber.finish(stopped);
+          } catch (error) {
+            debugLogger.debug("Speculative transcription discarded", { error: error.message });
+          }
+        }
+        if (firstSampleUs) {
+          debugLogger.traceSpan("native capture", firstSampleUs, hrtimeMicros(), {
+            track: "audio-capture",
+            args: { recordedSamples, speechSamples: samples.length },
+          });
+        }
+        return {
+          success: true,
+          audioBuffer: float32ToWav(samples, sampleRate),
+          durationSeconds: recordedSamples / sampleRate,
+          speechSeconds: samples.length / sampleRate,
+          segments: segments.map(({ start, end }) => ({
+            start: start / sampleRate,
+            end: end / sampleRate,
+          })),
+          speculative,
+        };
+      } catch (error) {
+        debugLogger.warn("Native audio capture failed to stop", { error: error.message });
+        return { success: false, error: error.message };
+      }
+    });
+
     // Whisper handlers
     ipcMain.handle("transcribe-local-whisper", async (event, audioBlob, options = {}) => {
       debugLogger.log("transcribe-local-whisper called", {
@@ -519,6 +602,11 @@ class IPCHandlers {
           this.windowsKeyManager.stop();
         }
 
+        // On Linux, stop the evdev key listener so captured keys don't trigger dictation
+        if (process.platform === "linux" && this.linuxKeyManager) {
+          this.linuxKeyManager.stop();
+        }
+
         // On GNOME Wayland, unregister the keybinding during capture
         if (hotkeyManager.isUsingGnome() && hotkeyManager.gnomeManager) {
           debugLogger.log("[IPC] Unregistering GNOME keybinding for hotkey capture mode");
@@ -562,6 +650,16 @@ class IPCHandlers {
           }
         }
 
+        if (process.platform === "linux" && this.linuxKeyManager && effectiveHotkey) {
+          const activationMode = this.windowManager.getActivationMode();
+          if (
+            effectiveHotkey !== "GLOBE" &&
+            (activationMode === "push" || isRightSideModifier(effectiveHotkey))
+          ) {
+            this.linuxKeyManager.start(effectiveHotkey);
+          }
+        }
+
         // On GNOME Wayland, re-register the keybinding with the effective hotkey
         if (hotkeyManager.isUsingGnome() && hotkeyManager.gnomeManager && effectiveHotkey) {
           const gnomeHotkey = GnomeShortcutManager.convertToGnomeFormat(effectiveHotkey);
@@ -1052,6 +1150,22 @@ class IPCHandlers {
       return { success: true };
     });
 
+    ipcMain.on("trace-dictation", (event, entry) => {
+      debugLogger.traceEntry(entry);
+    });
+
+    ipcMain.handle("export-latency-trace", async () => {
+      if (!debugLogger.isDebugEnabled()) {
+        return { success: false, error: "Debug logging is disabled" };
+      }
+      try {
+        return { success: true, path: debugLogger.exportDictationTraces() };
+      } catch (error) {
+        debugLogger.error("Failed to export latency trace:", error);
+        return { success: false, error: error.message };
+      }
+    });
+
     const SYSTEM_SETTINGS_URLS = {
       darwin: {
         microphone: "x-apple.systempreferences:com.apple.preference.security?Privacy_Microphone",
@@ -1719,16 +1833,21 @@ class IPCHandlers {
         }
 
         // Set up callbacks to forward events to renderer
+        // Started in parallel with the connection; callbacks chain on it in order
+        const liveTyping = this._beginLiveTyping(options.liveTyping);
+
         this.assemblyAiStreaming.onPartialTranscript = (text) => {
           if (win && !win.isDestroyed()) {
             win.webContents.send("assemblyai-partial-transcript", text);
           }
+          liveTyping.then((typing) => typing?.partial(text));
         };
 
         this.assemblyAiStreaming.onFinalTranscript = (text) => {
           if (win && !win.isDestroyed()) {
             win.webContents.send("assemblyai-final-transcript", text);
           }
+          liveTyping.then((typing) => typing?.final(text));
         };
 
         this.assemblyAiStreaming.onError = (error) => {
@@ -1964,16 +2083,21 @@ class IPCHandlers {
           debugLogger.debug("Using cached Deepgram streaming token", {}, "streaming");
         }
 
+        // Started in parallel with the connection; callbacks chain on it in order
+        const liveTyping = this._beginLiveTyping(options.liveTyping);
+
         this.deepgramStreaming.onPartialTranscript = (text) => {
           if (win && !win.isDestroyed()) {
             win.webContents.send("deepgram-partial-transcript", text);
           }
+          liveTyping.then((typing) => typing?.partial(text));
         };
 
         this.deepgramStreaming.onFinalTranscript = (text) => {
           if (win && !win.isDestroyed()) {
             win.webContents.send("deepgram-final-transcript", text);
           }
+          liveTyping.then((typing) => typing?.final(text));
         };
 
         this.deepgramStreaming.onError = (error) => {
@@ -2042,6 +2166,35 @@ class IPCHandlers {
     });
   }
 
+  /**
+   * Live typing of a streaming transcript into the focused app, enabled with
+   * OPENWHISPR_STREAMING_LIVE_TYPING=true. Providers report finals as the
+   * accumulated transcript and partials as the current segment only, so the
+   * on-screen text is always the two joined. Resolves to null when disabled.
+   */
+  async _beginLiveTyping(requested) {
+    this.clipboardManager.cancelStreamingInjection();
+    if (!requested || process.env.OPENWHISPR_STREAMING_LIVE_TYPING !== "true") return null;
+
+    // Keystrokes would land in our own panel instead of the target app
+    const mainWindow = this.windowManager?.mainWindow;
+    if (mainWindow && !mainWindow.isDestroyed() && mainWindow.isFocused()) return null;
+
+    if (!(await this.clipboardManager.beginStreamingInjection())) return null;
+
+    let finalText = "";
+    return {
+      partial: (text) => {
+        const live = [finalText, text.trim()].filter(Boolean).join(" ");
+        this.clipboardManager.updateStreamingInjection(live);
+      },
+      final: (text) => {
+        finalText = text;
+        this.clipboardManager.updateStreamingInjection(text);
+      },
+    };
+  }
+
   broadcastToWindows(channel, payload) {
     const windows = BrowserWindow.getAllWindows();
     windows.forEach((win) => {
@@ -0,0 +1,228 @@
+/**
+ * LinuxKeyManager - Handles key up/down detection for Push-to-Talk on Linux
+ *
+ * Runs the native evdev listener (resources/linux-key-listener.c), which reads
+ * /dev/input directly and so sees key releases on X11 and Wayland alike. It
+ * speaks the Windows listener's READY / KEY_DOWN / KEY_UP protocol and emits
+ * the same key-down / key-up events as WindowsKeyManager.
+ *
+ * Reading /dev/input needs membership of the "input" group. Without it, or
+ * without a keyboard that can produce the hotkey, the listener exits and
+ * "unavailable" is emitted so the global-shortcut path stays in charge.
+ */
+
+const { spawn } = require("child_process");
+const EventEmitter = require("events");
+const debugLogger = require("./debugLogger");
+const startupManifest = require("./startupManifest");
+const {
+  NativeEventStream,
+  BINARY_EVENTS_ENABLED,
+  BINARY_EVENTS_FLAG,
+  EVENT_TYPES,
+  hrtimeMicros,
+} = require("./nativeEventStream");
+
+// linux-key-listener exit codes that mean "not usable here" rather than a crash
+const EXIT_REASONS = {
+  2: "permission_denied",
+  3: "no_keyboard",
+};
+
+class LinuxKeyManager extends EventEmitter {
+  constructor() {
+    super();
+    this.process = null;
+    this.isSupported = process.platform === "linux";
+    this.hasReportedError = false;
+    this.currentKey = null;
+    this.isReady = false;
+  }
+
+  /**
+   * Start listening for the specified key
+   * @param {string} key - The key to listen for (e.g., "`", "F8", "Control+Super")
+   */
+  start(key = "`") {
+    if (!this.isSupported) {
+      return;
+    }
+
+    if (this.process && this.currentKey === key) {
+      return;
+    }
+
+    this.stop();
+
+    const listenerPath = this.resolveListenerBinary();
+    if (!listenerPath) {
+      this.emit("unavailable", new Error("Linux key listener binary not found"), {
+        reason: "binary_not_found",
+      });
+      return;
+    }
+
+    this.hasReportedError = false;
+    this.isReady = false;
+    this.currentKey = key;
+
+    debugLogger.debug("[LinuxKeyManager] Starting key listener", {
+      key,
+      binaryPath: listenerPath,
+    });
+
+    try {
+      const args = [key];
+      if (BINARY_EVENTS_ENABLED) args.push(BINARY_EVENTS_FLAG);
+      // stdin stays open so the listener exits if we go away without stop()
+      this.process = spawn(listenerPath, args, { stdio: ["pipe", "pipe", "pipe"] });
+    } catch (error) {
+      debugLogger.error("[LinuxKeyManager] Failed to spawn process", { error: error.message });
+      this.reportError(error);
+      return;
+    }
+
+    this.process.stdin.on("error", () => {});
+    const events = new NativeEventStream({
+      onLine: (line) => this._handleLine(line, key),
+      onRecord: (record) => this._handleRecord(record, key),
+    });
+    this.process.stdout.on("data", (chunk) => events.push(chunk));
+
+    this.process.stderr.setEncoding("utf8");
+    this.process.stderr.on("data", (data) => {
+      const message = data.toString().trim();
+      if (message.length > 0) {
+        debugLogger.debug("[LinuxKeyManager] Native stderr", { message });
+      }
+    });
+
+    this.process.on("error", (error) => {
+      this.reportError(error);
+      this.process = null;
+    });
+
+    const proc = this.process;
+    proc.on("exit", (code, signal) => {
+      if (this.process === proc) this.process = null;
+      this.isReady = false;
+      if (code === 0 || signal === "SIGTERM") return;
+
+      const reason = EXIT_REASONS[code];
+      if (reason) {
+        debugLogger.debug("[LinuxKeyManager] Listener unavailable", { key, reason });
+        this.emit("unavailable", new Error(`Linux key listener unavailable: ${reason}`), {
+          reason,
+        });
+        return;
+      }
+      const error = new Error(
+        `Linux key listener exited with code ${code ?? "null"} signal ${signal ?? "null"}`
+      );
+      this.reportError(error);
+    });
+  }
+
+  _handleLine(line, key) {
+    const [event, timestamp] = line.split(" ");
+    if (event === "KEY_DOWN" || event === "KEY_UP") {
+      const timestampUs = timestamp ? Number(timestamp) : null;
+      this._emitKey(event === "KEY_DOWN", key, {
+        timestampUs,
+        latencyUs: timestampUs ? hrtimeMicros() - timestampUs : null,
+      });
+    } else if (line === "READY") {
+      debugLogger.debug("[LinuxKeyManager] Listener ready", { key });
+      this.isReady = true;
+      this.emit("ready");
+    } else {
+      debugLogger.debug("[LinuxKeyManager] Unknown output", { line });
+    }
+  }
+
+  _handleRecord(record, key) {
+    if (record.type !== EVENT_TYPES.KEY_DOWN && record.type !== EVENT_TYPES.KEY_UP) return;
+    const { timestampUs, latencyUs, eventTimeMs } = record;
+    this._emitKey(record.type === EVENT_TYPES.KEY_DOWN, key, {
+      timestampUs,
+      latencyUs,
+      eventTimeMs,
+    });
+  }
+
+  _emitKey(isDown, key, timing) {
+    debugLogger.traceEvent(isDown ? "key down" : "key up", {
+      ts: timing.timestampUs ?? undefined,
+      track: "linux-key-listener",
+      args: { key, latencyUs: timing.latencyUs },
+    });
+    debugLogger.debug(`[LinuxKeyManager] ${isDown ? "KEY_DOWN" : "KEY_UP"} detected`, {
+      key,
+      ...timing,
+    });
+    this.emit(isDown ? "key-down" : "key-up", key, timing);
+  }
+
+  /**
+   * Whether the listener is reading keyboards for this hotkey
+   */
+  ownsHotkey(hotkey) {
+    return !!this.process && this.isReady && this.currentKey === hotkey;
+  }
+
+  /**
+   * Stop the key listener
+   */
+  stop() {
+    if (this.process) {
+      debugLogger.debug("[LinuxKeyManager] Stopping key listener");
+      try {
+        this.process.kill();
+      } catch {
+        // Ignore kill errors
+      }
+      this.process = null;
+    }
+    this.isReady = false;
+    this.currentKey = null;
+  }
+
+  /**
+   * Check if the listener binary is present
+   */
+  isAvailable() {
+    return this.resolveListenerBinary() !== null;
+  }
+
+  /**
+   * Report an error (only once per session to avoid log spam)
+   */
+  reportError(error) {
+    if (this.hasReportedError) {
+      return;
+    }
+    this.hasReportedError = true;
+
+    if (this.process) {
+      try {
+        this.process.kill();
+      } catch {
+        // Ignore
+      } finally {
+        this.process = null;
+      }
+    }
+
+    debugLogger.warn("[LinuxKeyManager] Error occurred", { error: error.message });
+    this.emit("error", error);
+  }
+
+  /**
+   * Find the listener binary in various possible locations
+   */
+  resolveListenerBinary() {
+    return startupManifest.resolveHelper("linux-key-listener");
+  }
+}
+
+module.exports = LinuxKeyManager;
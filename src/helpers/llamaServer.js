@@ -6,6 +6,7 @@ const http = require("http");
 const debugLogger = require("./debugLogger");
 const { killProcess } = require("../utils/process");
 const { getSafeTempDir } = require("./safeTempDir");
+const { hrtimeMicros } = require("./nativeEventStream");
 
 const PORT_RANGE_START = 8200;
 const PORT_RANGE_END = 8220;
@@ -25,6 +26,8 @@ class LlamaServerManager {
     this.healthCheckInterval = null;
     this.healthCheckFailures = 0;
     this.cachedServerBinaryPath = null;
+    // Cost of the last start, also recorded in the dictation trace
+    this.loadMs = null;
   }
 
   getServerBinaryPath() {
@@ -115,9 +118,13 @@ class LlamaServerManager {
     if (!serverBinary) throw new Error("llama-server binary not found");
     if (!fs.existsSync(modelPath)) throw new Error(`Model file not found: ${modelPath}`);
 
+    const loadStartUs = hrtimeMicros();
     this.port = await this.findAvailablePort();
     this.modelPath = modelPath;
+    this.loadMs = null;
 
+    // llama.cpp memory-maps the GGUF by default (no --no-mmap here), so the
+    // weights stay in the shared page cache across restarts
     const args = [
       "--model",
       modelPath,
@@ -184,10 +191,18 @@ class LlamaServerManager {
 
     await this.waitForReady(() => ({ stderr: stderrBuffer, exitCode }));
     this.startHealthCheck();
+    // /health only turns ready after llama-server's own warm-up run
+    const loadEndUs = hrtimeMicros();
+    this.loadMs = Math.round((loadEndUs - loadStartUs) / 1000);
+    debugLogger.traceSpan("model load", loadStartUs, loadEndUs, {
+      track: "local-servers",
+      args: { server: "llama-server", model: path.basename(modelPath) },
+    });
 
     debugLogger.info("llama-server started successfully", {
       port: this.port,
       model: path.basename(modelPath),
+      loadMs: this.loadMs,
     });
   }
 
@@ -291,6 +306,7 @@ class LlamaServerManager {
 
     return new Promise((resolve, reject) => {
       const startTime = Date.now();
+      const startUs = hrtimeMicros();
 
       const req = http.request(
         {
@@ -322,6 +338,14 @@ class LlamaServerManager {
 
             try {
               const response = JSON.parse(data);
+              // Prompt processing ends with the first generated token
+              const promptMs = response.timings?.prompt_ms;
+              if (Number.isFinite(promptMs)) {
+                debugLogger.traceSpan("first token", startUs, startUs + promptMs * 1000, {
+                  track: "local-servers",
+                  args: { server: "llama-server", promptTokens: response.timings.prompt_n },
+                });
+              }
               // Extract text from OpenAI-compatible response
               const text = response.choices?.[0]?.message?.content || "";
               resolve(text.trim());
@@ -393,6 +417,7 @@ class LlamaServerManager {
       port: this.port,
       modelPath: this.modelPath,
       modelName: this.modelPath ? path.basename(this.modelPath, ".gguf") : null,
+      loadMs: this.loadMs,
     };
   }
 }
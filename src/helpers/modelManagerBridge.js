@@ -11,6 +11,7 @@ const {
 
 const modelRegistryData = require("../models/modelRegistryData.json");
 const LlamaServerManager = require("./llamaServer");
+const WarmServerKeeper = require("./warmServerKeeper");
 const debugLogger = require("./debugLogger");
 
 const MIN_FILE_SIZE = 1_000_000; // 1MB minimum for valid model files
@@ -42,6 +43,15 @@ class ModelManager {
     this.activeRequests = new Map(); // Track HTTP requests for cancellation
     this.serverManager = new LlamaServerManager();
     this.currentServerModelId = null;
+    // Reloads the server in the background if it goes away, per the idle policy
+    this.warmKeeper = new WarmServerKeeper({
+      name: "llama-server",
+      isRunning: () => this.serverManager.ready || !!this.serverManager.startupPromise,
+      restart: async (modelId) => {
+        if (!(await this.prewarmServer(modelId))) throw new Error("llama-server did not start");
+      },
+      stop: () => this.stopServer(),
+    });
     this._initialized = false;
 
     // IMPORTANT: Do NOT call app.getPath() here!
@@ -377,6 +387,7 @@ class ModelManager {
         model: modelId,
       });
     }
+    this.warmKeeper.arm(modelId);
 
     // Build messages for chat completion
     const messages = [
@@ -417,6 +428,7 @@ class ModelManager {
   }
 
   async stopServer() {
+    this.warmKeeper.disarm();
     await this.serverManager.stop();
     this.currentServerModelId = null;
   }
@@ -443,7 +455,8 @@ class ModelManager {
         threads: 4,
       });
       this.currentServerModelId = modelId;
-      debugLogger.info("llama-server pre-warmed", { modelId });
+      this.warmKeeper.arm(modelId);
+      debugLogger.info("llama-server pre-warmed", { modelId, loadMs: this.serverManager.loadMs });
       return true;
     } catch (error) {
       debugLogger.warn("Failed to pre-warm llama-server", { error: error.message });
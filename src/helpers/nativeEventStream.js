@@ -0,0 +1,90 @@
+/**
+ * NativeEventStream - Splits native listener stdout into text lines and the
+ * fixed-size binary key event records enabled by --binary-events.
+ *
+ * Records are timestamped by the helper on the same clock as
+ * process.hrtime (QueryPerformanceCounter on Windows, mach_absolute_time on
+ * macOS), so key-to-handler and key-to-recording latency can be measured
+ * exactly instead of from the time a text line happened to be parsed.
+ *
+ * Record layout (16 bytes, little-endian):
+ *   0  u8   0xFE marker (never the first byte of a UTF-8 text line)
+ *   1  u8   event type, see EVENT_TYPES
+ *   2  u8   key id (listener-specific: binding slot, or Globe/modifier index)
+ *   3  u8   reserved
+ *   4  u32  hardware event time in ms (KBDLLHOOKSTRUCT.time, CGEventGetTimestamp)
+ *   8  u64  helper callback time in microseconds on the process.hrtime clock
+ *
+ * Text (READY, FEATURES, command replies) still arrives as lines, interleaved
+ * with records, and listeners without the flag only ever send text.
+ */
+
+// Opt-in until the prebuilt listener binaries in releases support it
+const BINARY_EVENTS_ENABLED = process.env.OPENWHISPR_BINARY_KEY_EVENTS === "true";
+const BINARY_EVENTS_FLAG = "--binary-events";
+
+const RECORD_MARKER = 0xfe;
+const RECORD_SIZE = 16;
+
+const EVENT_TYPES = {
+  KEY_DOWN: 1,
+  KEY_UP: 2,
+  MODIFIER_UP: 3,
+};
+
+function hrtimeMicros() {
+  return Number(process.hrtime.bigint() / 1000n);
+}
+
+class NativeEventStream {
+  /**
+   * @param {Object} handlers
+   * @param {(line: string) => void} handlers.onLine
+   * @param {(record: {type: number, keyId: number, eventTimeMs: number,
+   *   timestampUs: number, latencyUs: number}) => void} handlers.onRecord
+   */
+  constructor({ onLine, onRecord }) {
+    this.onLine = onLine;
+    this.onRecord = onRecord;
+    this.buffer = Buffer.alloc(0);
+  }
+
+  push(chunk) {
+    const receivedUs = hrtimeMicros();
+    this.buffer = this.buffer.length ? Buffer.concat([this.buffer, chunk]) : chunk;
+
+    let offset = 0;
+    while (offset < this.buffer.length) {
+      if (this.buffer[offset] === RECORD_MARKER) {
+        if (this.buffer.length - offset < RECORD_SIZE) break;
+        const timestampUs = Number(this.buffer.readBigUInt64LE(offset + 8));
+        this.onRecord({
+          type: this.buffer[offset + 1],
+          keyId: this.buffer[offset + 2],
+          eventTimeMs: this.buffer.readUInt32LE(offset + 4),
+          timestampUs,
+          // Helper callback -> Node delivery, including pipe and event loop delay
+          latencyUs: receivedUs - timestampUs,
+        });
+        offset += RECORD_SIZE;
+        continue;
+      }
+
+      const newline = this.buffer.indexOf(0x0a, offset);
+      if (newline === -1) break;
+      const line = this.buffer.toString("utf8", offset, newline).trim();
+      offset = newline + 1;
+      if (line) this.onLine(line);
+    }
+
+    this.buffer = this.buffer.subarray(offset);
+  }
+}
+
+module.exports = {
+  NativeEventStream,
+  BINARY_EVENTS_ENABLED,
+  BINARY_EVENTS_FLAG,
+  EVENT_TYPES,
+  hrtimeMicros,
+};
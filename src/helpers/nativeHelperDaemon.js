@@ -0,0 +1,228 @@
+/**
+ * NativeHelperDaemon - Keeps a native helper binary resident and talks to it
+ * over a newline-delimited stdin/stdout protocol.
+ *
+ * The helper signals readiness with "READY" (same as windows-key-listener),
+ * then answers every command with exactly one reply line. Replies are matched
+ * to commands in FIFO order. If the helper exits or stops answering, pending
+ * commands are rejected with outcomeUnknown set: the helper may already have
+ * run them, so callers must not repeat them through the one-shot spawn path.
+ */
+
+const { spawn } = require("child_process");
+const EventEmitter = require("events");
+const { killProcess } = require("../utils/process");
+const debugLogger = require("./debugLogger");
+
+const READY_TIMEOUT_MS = 2000;
+const COMMAND_TIMEOUT_MS = 2000;
+// After a failed start, don't respawn on every paste
+const RESTART_COOLDOWN_MS = 30000;
+
+// The command was written but never answered, so it may have run
+function outcomeUnknown(error) {
+  error.outcomeUnknown = true;
+  return error;
+}
+
+class NativeHelperDaemon extends EventEmitter {
+  /**
+   * @param {Object} options
+   * @param {string} options.name - Label used in logs
+   * @param {string} options.binaryPath - Path to the native helper
+   * @param {string[]} options.args - Arguments that enable daemon mode
+   */
+  constructor({ name, binaryPath, args = [] }) {
+    super();
+    this.name = name;
+    this.binaryPath = binaryPath;
+    this.args = args;
+    this.process = null;
+    this.isReady = false;
+    this.pending = [];
+    this.buffer = "";
+    this.startPromise = null;
+    this.failedAt = 0;
+  }
+
+  /**
+   * Start the helper if it isn't running. Resolves once READY is received.
+   */
+  start() {
+    if (this.isReady) return Promise.resolve();
+    if (this.startPromise) return this.startPromise;
+    if (this.failedAt && Date.now() - this.failedAt < RESTART_COOLDOWN_MS) {
+      return Promise.reject(new Error(`${this.name} daemon unavailable (recent failure)`));
+    }
+
+    this.startPromise = new Promise((resolve, reject) => {
+      let settled = false;
+      const settle = (error) => {
+        if (settled) return;
+        settled = true;
+        clearTimeout(readyTimer);
+        this.startPromise = null;
+        if (error) {
+          this.failedAt = Date.now();
+          reject(error);
+        } else {
+          this.failedAt = 0;
+          resolve();
+        }
+      };
+
+      let proc;
+      try {
+        proc = spawn(this.binaryPath, this.args, {
+          stdio: ["pipe", "pipe", "pipe"],
+          windowsHide: true,
+        });
+      } catch (error) {
+        settle(error);
+        return;
+      }
+      this.process = proc;
+      this.buffer = "";
+
+      const readyTimer = setTimeout(() => {
+        settle(new Error(`${this.name} daemon did not become ready`));
+        this.stop();
+      }, READY_TIMEOUT_MS);
+
+      proc.stdout.setEncoding("utf8");
+      proc.stdout.on("data", (chunk) => {
+        this.buffer += chunk;
+        let newline;
+        while ((newline = this.buffer.indexOf("\n")) !== -1) {
+          const line = this.buffer.slice(0, newline).trim();
+          this.buffer = this.buffer.slice(newline + 1);
+          if (!line) continue;
+
+          if (!this.isReady) {
+            if (line === "READY") {
+              this.isReady = true;
+              debugLogger.debug(`[${this.name}] Daemon ready`, { pid: proc.pid });
+              settle();
+            }
+            continue;
+          }
+          this._handleLine(line);
+        }
+      });
+
+      proc.stderr.setEncoding("utf8");
+      proc.stderr.on("data", (data) => {
+        const message = data.toString().trim();
+        if (message) {
+          debugLogger.debug(`[${this.name}] Native stderr`, { message });
+        }
+      });
+
+      proc.stdin.on("error", () => {});
+
+      proc.on("error", (error) => {
+        settle(error);
+        this._handleExit(proc, error);
+      });
+
+      proc.on("exit", (code, signal) => {
+        const error = new Error(
+          `${this.name} daemon exited with code ${code ?? "null"} signal ${signal ?? "null"}`
+        );
+        settle(error);
+        this._handleExit(proc, error);
+      });
+    });
+
+    return this.startPromise;
+  }
+
+  /**
+   * Send one command line and resolve with the helper's reply line.
+   * Replies beginning with "ERROR" or "<COMMAND>_ERROR" reject.
+   * An optional payload Buffer is written straight after the command line,
+   * for commands that announce a byte count (e.g. PASTE_TEXT). Rejections for a
+   * command that reached the helper but got no reply (timeout, exit) have
+   * outcomeUnknown.
+   */
+  async send(command, { timeoutMs = COMMAND_TIMEOUT_MS, payload = null } = {}) {
+    await this.start();
+    const proc = this.process;
+    if (!proc) {
+      throw new Error(`${this.name} daemon is not running`);
+    }
+
+    return new Promise((resolve, reject) => {
+      const entry = { command, resolve, reject, timer: null };
+      entry.timer = setTimeout(() => {
+        const index = this.pending.indexOf(entry);
+        if (index !== -1) this.pending.splice(index, 1);
+        entry.reject(outcomeUnknown(new Error(`${this.name} daemon timed out on "${command}"`)));
+        // Replies are matched positionally, so a missed reply desyncs the stream
+        this.stop();
+      }, timeoutMs);
+
+      this.pending.push(entry);
+      try {
+        const line = `${command}\n`;
+        proc.stdin.write(payload ? Buffer.concat([Buffer.from(line), payload]) : line);
+      } catch (error) {
+        clearTimeout(entry.timer);
+        this.pending.splice(this.pending.indexOf(entry), 1);
+        reject(error);
+      }
+    });
+  }
+
+  _handleLine(line) {
+    const entry = this.pending.shift();
+    if (!entry) {
+      debugLogger.debug(`[${this.name}] Unsolicited output`, { line });
+      return;
+    }
+    clearTimeout(entry.timer);
+
+    const [status] = line.split(" ", 1);
+    if (status === "ERROR" || status.endsWith("_ERROR")) {
+      entry.reject(new Error(`${this.name}: ${line}`));
+    } else {
+      entry.resolve(line);
+    }
+  }
+
+  _handleExit(proc, error) {
+    // A restarted helper may already have replaced this one
+    if (this.process !== proc) return;
+    this.process = null;
+    this.isReady = false;
+    // A copy: error may also have rejected start(), where nothing was sent
+    this._rejectPending(outcomeUnknown(new Error(error.message)));
+    this.emit("exit", error);
+  }
+
+  _rejectPending(error) {
+    const pending = this.pending;
+    this.pending = [];
+    for (const entry of pending) {
+      clearTimeout(entry.timer);
+      entry.reject(error);
+    }
+  }
+
+  stop() {
+    if (this.process) {
+      debugLogger.debug(`[${this.name}] Stopping daemon`);
+      try {
+        this.process.stdin.end("QUIT\n");
+      } catch {
+        // Ignore write errors on a dying pipe
+      }
+      killProcess(this.process, "SIGTERM");
+    }
+    this.process = null;
+    this.isReady = false;
+    this._rejectPending(outcomeUnknown(new Error(`${this.name} daemon stopped`)));
+  }
+}
+
+module.exports = NativeHelperDaemon;
@@ -10,6 +10,7 @@ const {
   checkDiskSpace,
 } = require("./downloadUtils");
 const ParakeetServerManager = require("./parakeetServer");
+const WarmServerKeeper = require("./warmServerKeeper");
 const { getModelsDirForService } = require("./modelDirUtils");
 
 const modelRegistryData = require("../models/modelRegistryData.json");
@@ -35,6 +36,17 @@ class ParakeetManager {
     this.currentDownloadProcess = null;
     this.isInitialized = false;
     this.serverManager = new ParakeetServerManager();
+    // Reloads the server in the background if it goes away, per the idle policy
+    this.warmKeeper = new WarmServerKeeper({
+      name: "parakeet-ws",
+      isRunning: () =>
+        this.serverManager.wsServer.ready || !!this.serverManager.wsServer.startupPromise,
+      restart: async (model) => {
+        const result = await this.serverManager.startServer(model);
+        if (!result.success) throw new Error(result.reason);
+      },
+      stop: () => this.stopServer(),
+    });
   }
 
   getModelsDir() {
@@ -78,10 +90,14 @@ class ParakeetManager {
 
           try {
             const serverStartTime = Date.now();
-            await this.serverManager.startServer(parakeetModel);
+            const result = await this.serverManager.startServer(parakeetModel);
+            if (!result.success) throw new Error(result.reason);
+            this.warmKeeper.arm(parakeetModel);
             debugLogger.info("Parakeet server pre-warmed successfully", {
               model: parakeetModel,
               startupTimeMs: Date.now() - serverStartTime,
+              loadMs: this.serverManager.wsServer.loadMs,
+              warmUpMs: this.serverManager.wsServer.warmUpMs,
             });
           } catch (err) {
             debugLogger.warn("Parakeet server pre-warm failed (will start on first use)", {
@@ -167,10 +183,13 @@ class ParakeetManager {
 
   async startServer(modelName) {
     this.validateModelName(modelName);
-    return this.serverManager.startServer(modelName);
+    const result = await this.serverManager.startServer(modelName);
+    if (result.success) this.warmKeeper.arm(modelName);
+    return result;
   }
 
   async stopServer() {
+    this.warmKeeper.disarm();
     await this.serverManager.stopServer();
   }
 
@@ -226,8 +245,13 @@ class ParakeetManager {
 
     const startTime = Date.now();
     const language = options.language || "auto";
-    const result = await this.serverManager.transcribe(audioBuffer, { modelName: model, language });
+    const result = await this.serverManager.transcribe(audioBuffer, {
+      modelName: model,
+      language,
+      segments: options.segments || null,
+    });
     const elapsed = Date.now() - startTime;
+    this.warmKeeper.arm(model);
 
     debugLogger.logSTTPipeline("transcribeLocalParakeet - completed", {
       elapsed,
@@ -11,12 +11,15 @@ const {
 } = require("./ffmpegUtils");
 const { getSafeTempDir } = require("./safeTempDir");
 const ParakeetWsServer = require("./parakeetWsServer");
+const { segmentsToSamples, planChunks, transcribeChunks } = require("./chunkedTranscription");
 
 const SAMPLE_RATE = 16000;
 const BYTES_PER_SAMPLE = 4; // float32
 const MAX_SEGMENT_SECONDS = 30;
 const MAX_SEGMENT_BYTES = MAX_SEGMENT_SECONDS * SAMPLE_RATE * BYTES_PER_SAMPLE;
 const SILENCE_RMS_THRESHOLD = 0.001;
+// Segments sent at once; sherpa-onnx batches concurrent requests into one decode
+const PARALLEL_SEGMENTS = 4;
 
 class ParakeetServerManager {
   constructor() {
@@ -86,7 +89,7 @@ class ParakeetServerManager {
   }
 
   async transcribe(audioBuffer, options = {}) {
-    const { modelName = "parakeet-tdt-0.6b-v3", language = "auto" } = options;
+    const { modelName = "parakeet-tdt-0.6b-v3", language = "auto", segments = null } = options;
 
     const modelDir = path.join(this.getModelsDir(), modelName);
     if (!this.isModelDownloaded(modelName)) {
@@ -120,21 +123,31 @@ class ParakeetServerManager {
         return { ...result, language };
       }
 
+      // Cut at the VAD's speech pauses when native capture supplied them,
+      // otherwise at fixed offsets
+      const sampleCount = samples.length / BYTES_PER_SAMPLE;
+      const maxSamples = MAX_SEGMENT_SECONDS * SAMPLE_RATE;
+      const speech = segmentsToSamples(segments, SAMPLE_RATE, sampleCount);
+      const chunks = planChunks(speech, sampleCount, { targetSamples: maxSamples, maxSamples });
+
       debugLogger.debug("Parakeet segmenting long audio", {
         durationSeconds,
-        segmentCount: Math.ceil(samples.length / MAX_SEGMENT_BYTES),
+        segmentCount: chunks.length,
+        atPauses: Array.isArray(segments) && segments.length > 1,
       });
 
-      const texts = [];
-      let totalElapsed = 0;
+      const results = await transcribeChunks(
+        chunks,
+        new Array(Math.min(PARALLEL_SEGMENTS, chunks.length)).fill(this.wsServer),
+        (server, { start, end }) =>
+          server.transcribe(
+            samples.subarray(start * BYTES_PER_SAMPLE, end * BYTES_PER_SAMPLE),
+            SAMPLE_RATE
+          )
+      );
 
-      for (let offset = 0; offset < samples.length; offset += MAX_SEGMENT_BYTES) {
-        const end = Math.min(offset + MAX_SEGMENT_BYTES, samples.length);
-        const segment = samples.subarray(offset, end);
-        const result = await this.wsServer.transcribe(segment, SAMPLE_RATE);
-        totalElapsed += result.elapsed || 0;
-        if (result.text) texts.push(result.text);
-      }
+      const texts = results.map((result) => result.text).filter(Boolean);
+      const totalElapsed = results.reduce((sum, result) => sum + (result.elapsed || 0), 0);
 
       return { text: texts.join(" "), elapsed: totalElapsed, language };
     } finally {
@@ -10,6 +10,7 @@ const {
   gracefulStopProcess,
 } = require("../utils/serverUtils");
 const { getSafeTempDir } = require("./safeTempDir");
+const { hrtimeMicros } = require("./nativeEventStream");
 
 const PORT_RANGE_START = 6006;
 const PORT_RANGE_END = 6029;
@@ -26,8 +27,12 @@ class ParakeetWsServer {
     this.modelDir = null;
     this.startupPromise = null;
     this.healthCheckInterval = null;
-    this.transcribing = false;
+    // Requests in flight; the server batches concurrent ones into one decode
+    this.activeTranscriptions = 0;
     this.cachedWsBinaryPath = null;
+    // Cost of the last start, also recorded in the dictation trace
+    this.loadMs = null;
+    this.warmUpMs = null;
   }
 
   getWsBinaryPath() {
@@ -66,8 +71,11 @@ class ParakeetWsServer {
     if (!wsBinary) throw new Error("sherpa-onnx WS server binary not found");
     if (!fs.existsSync(modelDir)) throw new Error(`Model directory not found: ${modelDir}`);
 
+    const loadStartUs = hrtimeMicros();
     this.port = await findAvailablePort(PORT_RANGE_START, PORT_RANGE_END);
     this.modelName = modelName;
+    this.loadMs = null;
+    this.warmUpMs = null;
     this.modelDir = modelDir;
 
     const args = [
@@ -123,10 +131,17 @@ class ParakeetWsServer {
 
     await this._waitForReady(readyFromStderr, () => ({ stderr: stderrBuffer, exitCode }));
     this._startHealthCheck();
+    const loadEndUs = hrtimeMicros();
+    this.loadMs = Math.round((loadEndUs - loadStartUs) / 1000);
+    debugLogger.traceSpan("model load", loadStartUs, loadEndUs, {
+      track: "local-servers",
+      args: { server: "parakeet-ws", model: modelName },
+    });
 
     debugLogger.info("parakeet-ws server started successfully", {
       port: this.port,
       model: modelName,
+      loadMs: this.loadMs,
     });
 
     await this._warmUp();
@@ -137,8 +152,15 @@ class ParakeetWsServer {
       const sampleRate = 16000;
       const numSamples = sampleRate;
       const silentSamples = Buffer.alloc(numSamples * 4);
+      const startUs = hrtimeMicros();
       await this.transcribe(silentSamples, sampleRate);
-      debugLogger.debug("parakeet-ws warm-up inference complete");
+      const endUs = hrtimeMicros();
+      this.warmUpMs = Math.round((endUs - startUs) / 1000);
+      debugLogger.traceSpan("first inference", startUs, endUs, {
+        track: "local-servers",
+        args: { server: "parakeet-ws", model: this.modelName },
+      });
+      debugLogger.debug("parakeet-ws warm-up inference complete", { warmUpMs: this.warmUpMs });
     } catch (err) {
       debugLogger.warn("parakeet-ws warm-up failed (non-fatal)", {
         error: err.message,
@@ -186,7 +208,7 @@ class ParakeetWsServer {
         this.stopHealthCheck();
         return;
       }
-      if (this.transcribing) return;
+      if (this.activeTranscriptions > 0) return;
 
       if (!this._isProcessAlive()) {
         debugLogger.warn("parakeet-ws health check failed: process not alive");
@@ -208,16 +230,20 @@ class ParakeetWsServer {
       throw new Error("parakeet-ws server is not running");
     }
 
-    this.transcribing = true;
+    this.activeTranscriptions++;
 
     return new Promise((resolve, reject) => {
       const startTime = Date.now();
       let result = "";
 
+      // Timeout, error and close can all fire for one request; count it once
+      let settled = false;
       const done =
         (fn) =>
         (...args) => {
-          this.transcribing = false;
+          if (settled) return;
+          settled = true;
+          this.activeTranscriptions--;
           fn(...args);
         };
 
@@ -310,6 +336,8 @@ class ParakeetWsServer {
       running: this.ready && this.process !== null,
       port: this.port,
       modelName: this.modelName,
+      loadMs: this.loadMs,
+      warmUpMs: this.warmUpMs,
     };
   }
 }
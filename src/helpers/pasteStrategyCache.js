@@ -0,0 +1,177 @@
+/**
+ * PasteStrategyCache - Remembers, per target application, which paste method
+ * worked, so the next paste into that app tries it first.
+ *
+ * Linux pastes fall back uinput -> XTest -> wtype/xdotool/ydotool and Windows
+ * pastes fast-paste -> nircmd -> PowerShell. A method that fails in one app
+ * (a sandboxed client ignoring XTest, an elevated window dropping SendInput)
+ * usually fails there every time, often only after a 2 s timeout. Outcomes
+ * are keyed by the window class (WM_CLASS on Linux, GetClassNameA on Windows)
+ * and kept in paste-strategies.json in the user data directory.
+ *
+ * Ordering keeps the platform's default order except that the method that
+ * last succeeded in the app goes first, and methods that failed there
+ * FAILURE_STREAK times in a row go last. Demotions expire after
+ * DEMOTION_TTL_MS, so an updated app or helper gets another chance.
+ */
+
+const fs = require("fs");
+const path = require("path");
+const debugLogger = require("./debugLogger");
+
+const FAILURE_STREAK = 2;
+const DEMOTION_TTL_MS = 7 * 24 * 60 * 60 * 1000;
+const MAX_CLASSES = 200;
+const SAVE_DELAY_MS = 2000;
+// Weight of the newest sample in the smoothed latency
+const LATENCY_SMOOTHING = 0.3;
+
+class PasteStrategyCache {
+  constructor(filePath = null) {
+    this.filePath = filePath;
+    this.classes = null;
+    this.saveTimer = null;
+  }
+
+  _defaultPath() {
+    try {
+      const { app } = require("electron");
+      return path.join(app.getPath("userData"), "paste-strategies.json");
+    } catch {
+      return null;
+    }
+  }
+
+  _load() {
+    if (this.classes) return this.classes;
+    this.classes = {};
+    this.filePath = this.filePath || this._defaultPath();
+    if (!this.filePath) return this.classes;
+    try {
+      const data = JSON.parse(fs.readFileSync(this.filePath, "utf8"));
+      if (data && typeof data.classes === "object") this.classes = data.classes;
+    } catch (error) {
+      if (error.code !== "ENOENT") {
+        debugLogger.debug("Ignoring unreadable paste strategy cache", { error: error.message });
+      }
+    }
+    return this.classes;
+  }
+
+  _key(windowClass) {
+    return typeof windowClass === "string" && windowClass.trim()
+      ? windowClass.trim().toLowerCase()
+      : null;
+  }
+
+  /**
+   * Sort attempts ({ method, ... }) for windowClass: last success first,
+   * repeatedly failing methods last, default order otherwise. Without a
+   * class the default order is returned unchanged.
+   */
+  order(windowClass, attempts) {
+    const key = this._key(windowClass);
+    const entry = key ? this._load()[key] : null;
+    if (!entry) return attempts;
+
+    const now = Date.now();
+    const rank = ({ method }) => {
+      const stats = entry.methods[method];
+      if (!stats) return 1;
+      if (stats.failStreak >= FAILURE_STREAK && now - stats.lastFailureAt < DEMOTION_TTL_MS) {
+        return 2;
+      }
+      return method === entry.best ? 0 : 1;
+    };
+    // Array.prototype.sort is stable, so equal ranks keep the default order
+    return [...attempts].sort((a, b) => rank(a) - rank(b));
+  }
+
+  recordSuccess(windowClass, method, latencyMs) {
+    const { entry, stats } = this._stats(windowClass, method);
+    if (!stats) return;
+    entry.best = method;
+    stats.successes++;
+    stats.failStreak = 0;
+    stats.latencyMs =
+      stats.latencyMs === null
+        ? latencyMs
+        : Math.round(stats.latencyMs + LATENCY_SMOOTHING * (latencyMs - stats.latencyMs));
+    this._scheduleSave();
+  }
+
+  recordFailure(windowClass, method, latencyMs) {
+    const { entry, stats } = this._stats(windowClass, method);
+    if (!stats) return;
+    if (entry.best === method) entry.best = null;
+    stats.failures++;
+    stats.failStreak++;
+    stats.lastFailureAt = Date.now();
+    if (stats.failStreak === FAILURE_STREAK) {
+      debugLogger.info(
+        "Paste method keeps failing in this app, trying it last from now on",
+        { windowClass, method, latencyMs },
+        "clipboard"
+      );
+    }
+    this._scheduleSave();
+  }
+
+  _stats(windowClass, method) {
+    const key = this._key(windowClass);
+    if (!key) return {};
+    const classes = this._load();
+    if (!classes[key]) {
+      this._evictOldest(classes);
+      classes[key] = { best: null, methods: {} };
+    }
+    const entry = classes[key];
+    entry.usedAt = Date.now();
+    if (!entry.methods[method]) {
+      entry.methods[method] = {
+        successes: 0,
+        failures: 0,
+        failStreak: 0,
+        lastFailureAt: 0,
+        latencyMs: null,
+      };
+    }
+    return { entry, stats: entry.methods[method] };
+  }
+
+  _evictOldest(classes) {
+    const keys = Object.keys(classes);
+    if (keys.length < MAX_CLASSES) return;
+    keys.sort((a, b) => (classes[a].usedAt || 0) - (classes[b].usedAt || 0));
+    for (const key of keys.slice(0, keys.length - MAX_CLASSES + 1)) delete classes[key];
+  }
+
+  _scheduleSave() {
+    if (!this.filePath || this.saveTimer) return;
+    this.saveTimer = setTimeout(() => {
+      this.saveTimer = null;
+      this.flush();
+    }, SAVE_DELAY_MS);
+    this.saveTimer.unref?.();
+  }
+
+  /**
+   * Write pending outcomes now (also called on quit).
+   */
+  flush() {
+    if (this.saveTimer) {
+      clearTimeout(this.saveTimer);
+      this.saveTimer = null;
+    }
+    if (!this.filePath || !this.classes) return;
+    try {
+      const tmpPath = `${this.filePath}.tmp`;
+      fs.writeFileSync(tmpPath, JSON.stringify({ version: 1, classes: this.classes }));
+      fs.renameSync(tmpPath, this.filePath);
+    } catch (error) {
+      debugLogger.debug("Could not save paste strategy cache", { error: error.message });
+    }
+  }
+}
+
+module.exports = PasteStrategyCache;
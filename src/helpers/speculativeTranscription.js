@@ -0,0 +1,152 @@
+/**
+ * SpeculativeTranscriber - Transcribes a native recording while the hotkey is
+ * still held, so only the last few seconds are left to decode at key-up.
+ *
+ * Every ROLL_INTERVAL_MS it asks the capture helper for the speech segments
+ * recorded so far (the VAD command works mid-session). Once a pause has
+ * clearly ended a stretch of speech, the audio up to that pause is sent to
+ * the warm local server as one window, its text is kept, and the commit
+ * point moves past it. Windows end inside pauses, so no word is cut in two.
+ *
+ * At stop, finish() hands back the committed text and a WAV of the speech
+ * after the commit point; the renderer decodes only that and joins the two.
+ * Speech without a long enough pause is never committed early and simply
+ * stays in the tail.
+ */
+
+const debugLogger = require("./debugLogger");
+const { trimToSegments } = require("./audioCapture");
+const { float32ToWav } = require("./ffmpegUtils");
+const { hrtimeMicros } = require("./nativeEventStream");
+
+const ROLL_INTERVAL_MS = 1000;
+// The VAD ends a segment after 0.7 s of silence, and pads it by 0.3 s of that
+const SETTLE_SECONDS = 0.5;
+// Shorter windows cost a request each and give whisper too little context
+const MIN_WINDOW_SECONDS = 3;
+
+class SpeculativeTranscriber {
+  /**
+   * transcribe(wavBuffer) resolves with the window's text ("" for none).
+   */
+  constructor({ capture, transcribe, sampleRate = 16000 }) {
+    this.capture = capture;
+    this.transcribe = transcribe;
+    this.sampleRate = sampleRate;
+    this.committedEnd = 0;
+    this.texts = [];
+    this.inFlight = null;
+    this.timer = null;
+    this.failed = false;
+    this.stopped = false;
+  }
+
+  start() {
+    this.timer = setInterval(() => this._tick(), ROLL_INTERVAL_MS);
+  }
+
+  _tick() {
+    if (this.inFlight || this.stopped || this.failed) return;
+    this.inFlight = this._roll()
+      .catch((error) => {
+        // A prefix with a hole in it is worse than none; decode it all at stop
+        debugLogger.debug("[Speculative] Window failed, falling back to full decode", {
+          error: error.message,
+        });
+        this.failed = true;
+      })
+      .finally(() => {
+        this.inFlight = null;
+      });
+  }
+
+  async _roll() {
+    const { samples: recorded, segments } = await this.capture.speechSoFar();
+    const window = this._nextWindow(recorded, segments);
+    if (!window) return;
+
+    const { end, speech } = window;
+    const { samples, sampleRate } = this.capture.readSamples(this.committedEnd, end);
+    const { samples: trimmed } = trimToSegments(samples, speech);
+
+    const startUs = hrtimeMicros();
+    const text = await this.transcribe(float32ToWav(trimmed, sampleRate));
+    debugLogger.traceSpan("speculative window", startUs, hrtimeMicros(), {
+      track: "speculative",
+      args: { fromSeconds: this.committedEnd / sampleRate, toSeconds: end / sampleRate },
+    });
+
+    if (text) this.texts.push(text);
+    this.committedEnd = end;
+  }
+
+  // The longest run of settled segments past the commit point, as an end
+  // offset and segments relative to the commit point
+  _nextWindow(recorded, segments) {
+    const settle = SETTLE_SECONDS * this.sampleRate;
+    const pending = segments.filter(({ end }) => end > this.committedEnd);
+    let settled = pending.length - 1;
+    if (settled >= 0 && recorded - pending[settled].end < settle) settled--;
+    if (settled < 0) return null;
+
+    const speech = pending.slice(0, settled + 1).map(({ start, end }) => ({
+      start: Math.max(start, this.committedEnd) - this.committedEnd,
+      end: end - this.committedEnd,
+    }));
+    const speechSamples = speech.reduce((sum, { start, end }) => sum + (end - start), 0);
+    if (speechSamples < MIN_WINDOW_SECONDS * this.sampleRate) return null;
+
+    return { end: pending[settled].end, speech };
+  }
+
+  /**
+   * Stop rolling and return { prefixText, committedSeconds, tailBuffer,
+   * tailSeconds } for the capture's final stop() result, or null when nothing
+   * was committed (the recording is then decoded whole as usual). tailBuffer
+   * is null when no speech follows the commit point.
+   */
+  async finish({ speech, recordedSamples, sampleRate }) {
+    this.cancel();
+    if (this.inFlight) await this.inFlight;
+    if (this.failed || this.committedEnd === 0) return null;
+
+    const tailSpeech = (speech || [{ start: 0, end: recordedSamples }])
+      .filter(({ end }) => end > this.committedEnd)
+      .map(({ start, end }) => ({
+        start: Math.max(start, this.committedEnd) - this.committedEnd,
+        end: end - this.committedEnd,
+      }));
+
+    let tailBuffer = null;
+    let tailSeconds = 0;
+    if (tailSpeech.length > 0) {
+      const { samples } = this.capture.readSamples(this.committedEnd, recordedSamples);
+      const { samples: tail } = trimToSegments(samples, tailSpeech);
+      tailBuffer = float32ToWav(tail, sampleRate);
+      tailSeconds = tail.length / sampleRate;
+    }
+
+    const result = {
+      prefixText: this.texts.join(" "),
+      committedSeconds: this.committedEnd / sampleRate,
+      tailBuffer,
+      tailSeconds,
+    };
+    debugLogger.debug("[Speculative] Finished", {
+      windows: this.texts.length,
+      committedSeconds: result.committedSeconds,
+      tailSeconds,
+    });
+    return result;
+  }
+
+  cancel() {
+    this.stopped = true;
+    if (this.timer) {
+      clearInterval(this.timer);
+      this.timer = null;
+    }
+  }
+}
+
+module.exports = SpeculativeTranscriber;
@@ -0,0 +1,367 @@
+/**
+ * StartupManifest - Records what app launch needs from disk once per install,
+ * and reports where launch time goes.
+ *
+ * Every native helper (key listeners, paste helpers, audio capture) used to be
+ * found by stat-ing up to eight candidate paths on each start. The manifest
+ * keeps each resolved path with its size, mtime and SHA-256 in
+ * startup-manifest.json in the user data directory, keyed by the install (app
+ * version, app path and resources path). Later launches check the recorded
+ * path with a single stat, and only search again when the install or the file
+ * changed. The hash is computed in the background, once per helper build, so
+ * the startup report names exactly which build ran.
+ *
+ * Resident helpers (key listener, paste daemon, local model servers) are
+ * queued with background() and started together by startBackground() once the
+ * windows are up. Before, they started one after another on the way to the
+ * first window, or after a fixed delay. mark() records the launch phases. Once
+ * every background task has settled, the startup timing report is logged and
+ * kept in the manifest as lastStartup.
+ */
+
+const crypto = require("crypto");
+const fs = require("fs");
+const path = require("path");
+const debugLogger = require("./debugLogger");
+const { hrtimeMicros } = require("./nativeEventStream");
+
+const MANIFEST_VERSION = 1;
+const SAVE_DELAY_MS = 2000;
+// A resident helper that is not ready by then counts as failed in the report
+const BACKGROUND_TIMEOUT_MS = 15000;
+
+// process.hrtime has no fixed origin, so anchor it to the process start once
+const processStartUs = hrtimeMicros() - Math.round(process.uptime() * 1e6);
+const sinceStartMs = (us = hrtimeMicros()) => Math.round((us - processStartUs) / 1000);
+
+function helperCandidates(binaryName) {
+  const candidates = new Set([
+    path.join(__dirname, "..", "..", "resources", "bin", binaryName),
+    path.join(__dirname, "..", "..", "resources", binaryName),
+  ]);
+
+  if (process.resourcesPath) {
+    [
+      path.join(process.resourcesPath, binaryName),
+      path.join(process.resourcesPath, "bin", binaryName),
+      path.join(process.resourcesPath, "resources", binaryName),
+      path.join(process.resourcesPath, "resources", "bin", binaryName),
+      path.join(process.resourcesPath, "app.asar.unpacked", "resources", binaryName),
+      path.join(process.resourcesPath, "app.asar.unpacked", "resources", "bin", binaryName),
+    ].forEach((candidate) => candidates.add(candidate));
+  }
+
+  return [...candidates];
+}
+
+function electronApp() {
+  try {
+    const { app } = require("electron");
+    return app && app.isReady() ? app : null;
+  } catch {
+    return null;
+  }
+}
+
+class StartupManifest {
+  constructor() {
+    this.filePath = null;
+    this.data = null;
+    this.previousBinaries = {};
+    this.isPackaged = false;
+    this.saveTimer = null;
+    this.resolved = new Map();
+    this.phases = [];
+    this.queue = [];
+    this.tasks = [];
+    this.backgroundStarted = false;
+  }
+
+  _installKey(app) {
+    return [app.getVersion(), app.getAppPath(), process.resourcesPath || ""].join("|");
+  }
+
+  _load() {
+    if (this.data) return this.data;
+    const app = electronApp();
+    // Before app ready there is no user data path yet; stay in memory
+    if (!app) return { install: null, binaries: {} };
+
+    const install = this._installKey(app);
+    this.data = { version: MANIFEST_VERSION, install, binaries: {}, lastStartup: null };
+    this.filePath = path.join(app.getPath("userData"), "startup-manifest.json");
+    this.isPackaged = app.isPackaged;
+    try {
+      const saved = JSON.parse(fs.readFileSync(this.filePath, "utf8"));
+      if (saved && saved.version === MANIFEST_VERSION) {
+        this.data.lastStartup = saved.lastStartup || null;
+        // Entries from another install only serve to notice a changed helper
+        this.previousBinaries = saved.install === install ? {} : saved.binaries || {};
+        if (saved.install === install && saved.binaries) this.data.binaries = saved.binaries;
+      }
+    } catch (error) {
+      if (error.code !== "ENOENT") {
+        debugLogger.debug("Ignoring unreadable startup manifest", { error: error.message });
+      }
+    }
+    return this.data;
+  }
+
+  /**
+   * Path of a native helper in resources/ (or resources/bin), or null if this
+   * build doesn't ship it. executable: make sure the file can be run, for
+   * helpers whose mode can get lost when the package is unpacked.
+   */
+  resolveHelper(binaryName, { executable = false } = {}) {
+    if (this.resolved.has(binaryName)) return this.resolved.get(binaryName).path;
+
+    const binaries = this._load().binaries;
+    const recorded = binaries[binaryName];
+    if (recorded && this._stillValid(recorded)) {
+      this.resolved.set(binaryName, { path: recorded.path, cached: true });
+      return recorded.path;
+    }
+
+    const found = this._search(binaryName, executable);
+    if (found) {
+      binaries[binaryName] = { path: found.path, size: found.size, mtimeMs: found.mtimeMs };
+      this._hashInBackground(binaryName, binaries[binaryName]);
+    } else if (this.isPackaged) {
+      // A packaged install can't grow a helper later, so remember the miss too
+      binaries[binaryName] = { path: null };
+    }
+    this._scheduleSave();
+    this.resolved.set(binaryName, { path: found?.path ?? null, cached: false });
+    return found?.path ?? null;
+  }
+
+  _stillValid(recorded) {
+    if (recorded.path === null) return this.isPackaged;
+    try {
+      const stats = fs.statSync(recorded.path);
+      return stats.isFile() && stats.size === recorded.size && stats.mtimeMs === recorded.mtimeMs;
+    } catch {
+      return false;
+    }
+  }
+
+  _search(binaryName, executable) {
+    for (const candidate of helperCandidates(binaryName)) {
+      try {
+        const stats = fs.statSync(candidate);
+        if (!stats.isFile()) continue;
+        if (executable && !this._ensureExecutable(candidate)) continue;
+        return { path: candidate, size: stats.size, mtimeMs: stats.mtimeMs };
+      } catch {
+        continue;
+      }
+    }
+    return null;
+  }
+
+  // A read-only install (mounted DMG, system package) can't be chmod-ed;
+  // such a candidate is skipped
+  _ensureExecutable(candidate) {
+    try {
+      fs.accessSync(candidate, fs.constants.X_OK);
+      return true;
+    } catch {
+      try {
+        fs.chmodSync(candidate, 0o755);
+        return true;
+      } catch {
+        return false;
+      }
+    }
+  }
+
+  /**
+   * Stop handing out a helper for the rest of the session, e.g. one that
+   * crashed or lacks a permission; resolveHelper() returns null for it from
+   * now on. The manifest entry is kept, so the next launch tries it again.
+   */
+  disableHelper(binaryName) {
+    this.resolved.set(binaryName, { path: null, cached: false, disabled: true });
+  }
+
+  _hashInBackground(binaryName, entry) {
+    const hash = crypto.createHash("sha256");
+    fs.createReadStream(entry.path)
+      .on("data", (chunk) => hash.update(chunk))
+      .on("error", () => {})
+      .on("end", () => {
+        entry.sha256 = hash.digest("hex");
+        const previous = this.previousBinaries?.[binaryName];
+        if (previous?.sha256 && previous.sha256 !== entry.sha256) {
+          debugLogger.info("Native helper changed since the last install", {
+            helper: binaryName,
+            path: entry.path,
+            sha256: entry.sha256,
+          });
+        }
+        this._scheduleSave();
+      });
+  }
+
+  /**
+   * Record that a launch phase just finished.
+   */
+  mark(phase) {
+    this.phases.push({ phase, atMs: sinceStartMs() });
+  }
+
+  /**
+   * Start task (returning a promise) with the other resident helpers once the
+   * windows are up, or right away if they already are. A task can return null
+   * when there is nothing to start on this machine.
+   */
+  background(name, task) {
+    if (this.backgroundStarted) {
+      this._run(name, task);
+    } else {
+      this.queue.push({ name, task });
+    }
+  }
+
+  /**
+   * Start everything queued with background() in parallel, on the next turn of
+   * the event loop, and log the startup report when it has all settled.
+   */
+  startBackground() {
+    if (this.backgroundStarted) return;
+    this.mark("interactive");
+    this.backgroundStarted = true;
+    setImmediate(() => {
+      for (const { name, task } of this.queue.splice(0)) this._run(name, task);
+      Promise.allSettled(this.tasks.map((entry) => entry.done)).then(() => this.report());
+    });
+  }
+
+  _run(name, task) {
+    const entry = { name, startMs: sinceStartMs(), readyMs: null, ok: false, error: null };
+    let timer = null;
+    const timeout = new Promise((_, reject) => {
+      timer = setTimeout(() => reject(new Error("not ready in time")), BACKGROUND_TIMEOUT_MS);
+      timer.unref?.();
+    });
+    entry.done = Promise.race([Promise.resolve().then(task), timeout])
+      .then((result) => {
+        entry.ok = true;
+        if (result === null) entry.skipped = true;
+      })
+      .catch((error) => {
+        entry.error = error?.message || String(error);
+        debugLogger.debug(`[Startup] ${name} failed to start`, { error: entry.error });
+      })
+      .finally(() => {
+        clearTimeout(timer);
+        entry.readyMs = sinceStartMs();
+      });
+    this.tasks.push(entry);
+  }
+
+  /**
+   * Resolve when emitter emits readyEvent, reject on one of failEvents. Attach
+   * it before starting the helper, which can fail synchronously.
+   */
+  whenEmitted(emitter, readyEvent, failEvents = ["error"]) {
+    return new Promise((resolve, reject) => {
+      const cleanup = () => {
+        emitter.off(readyEvent, onReady);
+        for (const event of failEvents) emitter.off(event, onFail);
+      };
+      const onReady = () => {
+        cleanup();
+        resolve();
+      };
+      const onFail = (error) => {
+        cleanup();
+        reject(error instanceof Error ? error : new Error(String(error)));
+      };
+      emitter.on(readyEvent, onReady);
+      for (const event of failEvents) emitter.on(event, onFail);
+    });
+  }
+
+  /**
+   * The startup timing report: launch phases with their durations, resident
+   * helpers with when they were started and ready (ms since process start),
+   * and the helper binaries this launch resolved.
+   */
+  buildReport() {
+    let previousMs = 0;
+    const phases = this.phases.map(({ phase, atMs }) => {
+      const entry = { phase, atMs, durationMs: atMs - previousMs };
+      previousMs = atMs;
+      return entry;
+    });
+
+    const helpers = this.tasks.map(({ name, startMs, readyMs, ok, skipped, error }) => ({
+      name,
+      startMs,
+      readyMs,
+      durationMs: readyMs === null ? null : readyMs - startMs,
+      status: skipped ? "skipped" : ok ? "ready" : "failed",
+      ...(error ? { error } : {}),
+    }));
+
+    const binaries = {};
+    const recorded = this._load().binaries;
+    for (const [name, { path: binaryPath, cached }] of this.resolved) {
+      binaries[name] = { path: binaryPath, cached, sha256: recorded[name]?.sha256 || null };
+    }
+
+    const interactive = this.phases.find(({ phase }) => phase === "interactive");
+    const readyMs = helpers.reduce((latest, helper) => Math.max(latest, helper.readyMs ?? 0), 0);
+    return {
+      recordedAt: new Date().toISOString(),
+      interactiveMs: interactive ? interactive.atMs : null,
+      helpersReadyMs: readyMs || null,
+      phases,
+      helpers,
+      binaries,
+    };
+  }
+
+  report() {
+    const report = this.buildReport();
+    debugLogger.info("Startup timing", report);
+    if (this.data) {
+      this.data.lastStartup = report;
+      this.flush();
+    }
+    return report;
+  }
+
+  _scheduleSave() {
+    if (!this.data || this.saveTimer) return;
+    this.saveTimer = setTimeout(() => {
+      this.saveTimer = null;
+      this.flush();
+    }, SAVE_DELAY_MS);
+    this.saveTimer.unref?.();
+  }
+
+  /**
+   * Write the manifest now (also called on quit).
+   */
+  flush() {
+    if (this.saveTimer) {
+      clearTimeout(this.saveTimer);
+      this.saveTimer = null;
+    }
+    if (!this.filePath || !this.data) return;
+    try {
+      const tmpPath = `${this.filePath}.tmp`;
+      fs.writeFileSync(tmpPath, JSON.stringify(this.data));
+      fs.renameSync(tmpPath, this.filePath);
+    } catch (error) {
+      debugLogger.debug("Could not save startup manifest", { error: error.message });
+    }
+  }
+}
+
+// Singleton instance
+const startupManifest = new StartupManifest();
+
+module.exports = startupManifest;
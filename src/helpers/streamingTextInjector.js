@@ -0,0 +1,101 @@
+/**
+ * StreamingTextInjector - Types a live transcript into the focused window as it
+ * is recognized.
+ *
+ * Every update names the full text that should be on screen. The injector diffs
+ * it against what it has already typed and sends a single edit: erase the
+ * changed tail with backspaces, then append the rest. While an edit is in
+ * flight further updates only replace the pending target, so a slow helper
+ * never queues stale hypotheses.
+ */
+
+const debugLogger = require("./debugLogger");
+
+const segmenter =
+  typeof Intl !== "undefined" && Intl.Segmenter
+    ? new Intl.Segmenter(undefined, { granularity: "grapheme" })
+    : null;
+
+// Backspace removes one user-perceived character, so diff on grapheme clusters
+function splitGraphemes(text) {
+  if (!text) return [];
+  return segmenter ? Array.from(segmenter.segment(text), (s) => s.segment) : Array.from(text);
+}
+
+class StreamingTextInjector {
+  /**
+   * @param {(edit: {deleteCount: number, text: string}) => Promise<void>} applyEdit
+   */
+  constructor(applyEdit) {
+    this.applyEdit = applyEdit;
+    this.injected = [];
+    this.target = null;
+    this.flushing = null;
+    this.failed = false;
+    this.edits = 0;
+  }
+
+  get injectedText() {
+    return this.injected.join("");
+  }
+
+  update(text) {
+    if (this.failed) return;
+    this.target = text;
+    if (!this.flushing) {
+      this.flushing = this._flush().finally(() => {
+        this.flushing = null;
+        // An update may have landed after the loop exited but before this ran
+        if (this.target !== null) this.update(this.target);
+      });
+    }
+  }
+
+  async _flush() {
+    while (this.target !== null && !this.failed) {
+      const next = splitGraphemes(this.target);
+      this.target = null;
+
+      let common = 0;
+      while (
+        common < next.length &&
+        common < this.injected.length &&
+        next[common] === this.injected[common]
+      ) {
+        common++;
+      }
+
+      const deleteCount = this.injected.length - common;
+      const text = next.slice(common).join("");
+      if (deleteCount === 0 && !text) continue;
+
+      try {
+        await this.applyEdit({ deleteCount, text });
+        this.injected = next;
+        this.edits++;
+      } catch (error) {
+        // The screen state is now unknown; stop touching it
+        this.failed = true;
+        debugLogger.warn(
+          "Streaming injection stopped",
+          { error: error.message, edits: this.edits, injectedLength: this.injected.length },
+          "streaming"
+        );
+      }
+    }
+  }
+
+  /**
+   * Bring the screen to the final text.
+   * @returns {Promise<boolean>} true if the final text is exactly what was typed
+   */
+  async finish(finalText) {
+    this.update(finalText);
+    while (this.flushing) {
+      await this.flushing;
+    }
+    return !this.failed && this.injectedText === finalText;
+  }
+}
+
+module.exports = StreamingTextInjector;
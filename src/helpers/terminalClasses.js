@@ -0,0 +1,40 @@
+/**
+ * Terminal window classes, from the same src/config/terminalClasses.json the
+ * native paste helpers are built with (see scripts/lib/terminal-classes.js),
+ * so the JS fallbacks and the helpers never disagree on the paste combo.
+ *
+ * Classes match exactly, ignoring ASCII case. OPENWHISPR_TERMINAL_CLASSES
+ * adds ("name") or removes ("!name") entries, as it does for the helpers.
+ */
+
+const TERMINAL_CLASSES = require("../config/terminalClasses.json");
+
+let cached = null;
+
+function classSets() {
+  const overrides = process.env.OPENWHISPR_TERMINAL_CLASSES || "";
+  if (cached && cached.overrides === overrides) return cached;
+
+  const sets = {};
+  for (const platform of ["linux", "windows"]) {
+    sets[platform] = new Set(TERMINAL_CLASSES[platform].map((name) => name.toLowerCase()));
+  }
+  for (const entry of overrides.split(",").map((item) => item.trim().toLowerCase())) {
+    if (!entry) continue;
+    for (const set of Object.values(sets)) {
+      if (entry.startsWith("!")) set.delete(entry.slice(1));
+      else set.add(entry);
+    }
+  }
+  cached = { overrides, sets };
+  return cached;
+}
+
+function isTerminalClass(windowClass, platform = process.platform) {
+  if (!windowClass) return false;
+  const { sets } = classSets();
+  const set = platform === "win32" ? sets.windows : sets.linux;
+  return set.has(String(windowClass).trim().toLowerCase());
+}
+
+module.exports = { isTerminalClass };
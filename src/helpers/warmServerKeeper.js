@@ -0,0 +1,106 @@
+/**
+ * WarmServerKeeper - Keeps a local model server (whisper-server, sherpa-onnx,
+ * llama-server) loaded between dictations, under one idle policy.
+ *
+ * The servers are started on demand, so a server that crashed, or died while
+ * the machine slept, used to be reloaded by the next dictation. Once a server
+ * has been started (pre-warm or first use), the keeper watches it and reloads
+ * it in the background as soon as it is gone.
+ *
+ * LOCAL_MODEL_IDLE_MINUTES sets the idle policy. With the default of 0, models
+ * stay loaded for as long as the app runs. With N > 0, a server unused for N
+ * minutes is stopped to free its memory and is not reloaded until it is next
+ * needed.
+ */
+
+const debugLogger = require("./debugLogger");
+
+const WATCH_INTERVAL_MS = 15000;
+const MAX_RESTART_BACKOFF_MS = 5 * 60 * 1000;
+
+function idleTimeoutMs() {
+  const minutes = Number(process.env.LOCAL_MODEL_IDLE_MINUTES);
+  return Number.isFinite(minutes) && minutes > 0 ? minutes * 60 * 1000 : 0;
+}
+
+class WarmServerKeeper {
+  /**
+   * isRunning() says whether the server is up (or starting), restart() loads
+   * the model last passed to arm(), and stop() unloads it.
+   */
+  constructor({ name, isRunning, restart, stop }) {
+    this.name = name;
+    this.isRunning = isRunning;
+    this.restart = restart;
+    this.stopServer = stop;
+    this.model = null;
+    this.lastUsed = 0;
+    this.watchTimer = null;
+    this.restarting = false;
+    this.nextRestartAt = 0;
+    this.restartBackoffMs = WATCH_INTERVAL_MS;
+  }
+
+  /**
+   * Record that model is loaded and in use; called after every start and
+   * every request.
+   */
+  arm(model) {
+    this.model = model;
+    this.lastUsed = Date.now();
+    this.restartBackoffMs = WATCH_INTERVAL_MS;
+    if (!this.watchTimer) {
+      this.watchTimer = setInterval(() => this._check(), WATCH_INTERVAL_MS);
+      this.watchTimer.unref?.();
+    }
+  }
+
+  /**
+   * Stop watching, e.g. when the server is stopped on purpose.
+   */
+  disarm() {
+    this.model = null;
+    if (this.watchTimer) {
+      clearInterval(this.watchTimer);
+      this.watchTimer = null;
+    }
+  }
+
+  async _check() {
+    if (!this.model || this.restarting) return;
+
+    const idleMs = idleTimeoutMs();
+    if (idleMs > 0 && Date.now() - this.lastUsed >= idleMs) {
+      debugLogger.info(`[${this.name}] Unloading idle model`, {
+        model: this.model,
+        idleMinutes: idleMs / 60000,
+      });
+      this.disarm();
+      await this.stopServer().catch(() => {});
+      return;
+    }
+
+    if (this.isRunning() || Date.now() < this.nextRestartAt) return;
+
+    const model = this.model;
+    this.restarting = true;
+    debugLogger.warn(`[${this.name}] Server is gone, reloading in the background`, { model });
+    try {
+      await this.restart(model);
+      if (!this.isRunning()) throw new Error("server did not come up");
+      this.restartBackoffMs = WATCH_INTERVAL_MS;
+    } catch (error) {
+      this.nextRestartAt = Date.now() + this.restartBackoffMs;
+      this.restartBackoffMs = Math.min(this.restartBackoffMs * 2, MAX_RESTART_BACKOFF_MS);
+      debugLogger.warn(`[${this.name}] Background reload failed`, {
+        model,
+        error: error.message,
+        retryInMs: this.nextRestartAt - Date.now(),
+      });
+    } finally {
+      this.restarting = false;
+    }
+  }
+}
+
+module.exports = WarmServerKeeper;
@@ -10,11 +10,23 @@ const {
   checkDiskSpace,
 } = require("./downloadUtils");
 const WhisperServerManager = require("./whisperServer");
+const { isPcm16kMonoWav, wavToFloat32Samples, float32ToWav } = require("./ffmpegUtils");
+const {
+  MIN_CHUNK_SECONDS,
+  MIN_CHUNKED_SECONDS,
+  THREADS_PER_WORKER,
+  segmentsToSamples,
+  planChunks,
+  transcribeChunks,
+  LocalServerPool,
+} = require("./chunkedTranscription");
+const WarmServerKeeper = require("./warmServerKeeper");
 const { getModelsDirForService } = require("./modelDirUtils");
 
 const modelRegistryData = require("../models/modelRegistryData.json");
 
 const CACHE_TTL_MS = 30000;
+const SAMPLE_RATE = 16000;
 
 function getWhisperModelConfig(modelName) {
   const modelInfo = modelRegistryData.whisperModels[modelName];
@@ -39,6 +51,23 @@ class WhisperManager {
     // Server manager for HTTP-based transcription
     this.serverManager = new WhisperServerManager();
     this.currentServerModel = null;
+    // Reloads the server in the background if it goes away, per the idle policy
+    this.warmKeeper = new WarmServerKeeper({
+      name: "whisper-server",
+      isRunning: () => this.serverManager.ready || !!this.serverManager.startupPromise,
+      restart: async (model) => {
+        await this.serverManager.start(this.getModelPath(model), { warmUp: true });
+        this.currentServerModel = model;
+      },
+      stop: () => this.stopServer(),
+    });
+    // Extra servers for decoding long recordings in parallel chunks
+    this.serverPool = new LocalServerPool({
+      name: "whisper",
+      createServer: () => new WhisperServerManager(),
+      startServer: (server) =>
+        server.start(this.serverPool.modelKey, { threads: THREADS_PER_WORKER }),
+    });
   }
 
   getModelsDir() {
@@ -86,12 +115,15 @@ class WhisperManager {
 
           try {
             const serverStartTime = Date.now();
-            await this.serverManager.start(modelPath);
+            await this.serverManager.start(modelPath, { warmUp: true });
             this.currentServerModel = whisperModel;
+            this.warmKeeper.arm(whisperModel);
 
             debugLogger.info("whisper-server pre-warmed successfully", {
               model: whisperModel,
               startupTimeMs: Date.now() - serverStartTime,
+              loadMs: this.serverManager.loadMs,
+              warmUpMs: this.serverManager.warmUpMs,
               port: this.serverManager.port,
             });
           } catch (err) {
@@ -201,6 +233,7 @@ class WhisperManager {
     try {
       await this.serverManager.start(modelPath);
       this.currentServerModel = modelName;
+      this.warmKeeper.arm(modelName);
       debugLogger.info("whisper-server started", {
         model: modelName,
         port: this.serverManager.port,
@@ -213,7 +246,8 @@ class WhisperManager {
   }
 
   async stopServer() {
-    await this.serverManager.stop();
+    this.warmKeeper.disarm();
+    await Promise.all([this.serverManager.stop(), this.serverPool.stop()]);
     this.currentServerModel = null;
   }
 
@@ -253,6 +287,7 @@ class WhisperManager {
     const model = options.model || "base";
     const language = options.language || null;
     const initialPrompt = options.initialPrompt || null;
+    const segments = options.segments || null;
     const modelPath = this.getModelPath(model);
 
     // Check if model exists
@@ -260,10 +295,10 @@ class WhisperManager {
       throw new Error(`Whisper model "${model}" not downloaded. Please download it from Settings.`);
     }
 
-    return await this.transcribeViaServer(audioBlob, model, language, initialPrompt);
+    return await this.transcribeViaServer(audioBlob, model, language, initialPrompt, segments);
   }
 
-  async transcribeViaServer(audioBlob, model, language, initialPrompt = null) {
+  async transcribeViaServer(audioBlob, model, language, initialPrompt = null, segments = null) {
     debugLogger.info("Transcription mode: SERVER", { model, language: language || "auto" });
     const modelPath = this.getModelPath(model);
 
@@ -273,6 +308,7 @@ class WhisperManager {
       await this.serverManager.start(modelPath);
       this.currentServerModel = model;
     }
+    this.warmKeeper.arm(model);
 
     // Convert audioBlob to Buffer if needed
     let audioBuffer;
@@ -294,6 +330,16 @@ class WhisperManager {
       throw new Error("Audio buffer is empty - no audio data received");
     }
 
+    // Speech segments only come with native recordings, which are already 16 kHz WAV
+    if (segments && isPcm16kMonoWav(audioBuffer)) {
+      const chunked = await this.transcribeChunked(audioBuffer, segments, {
+        modelPath,
+        language,
+        initialPrompt,
+      });
+      if (chunked) return chunked;
+    }
+
     debugLogger.logWhisperPipeline("transcribeViaServer - sending to server", {
       bufferSize: audioBuffer.length,
       model,
@@ -313,6 +359,92 @@ class WhisperManager {
     return this.parseWhisperResult(result);
   }
 
+  /**
+   * Decode a long recording as chunks cut at its speech pauses, spread over
+   * the primary server and the pool's extra servers, and join the texts in
+   * order. A chunk that fails is retried once on the primary server. Returns
+   * null when the recording is too short to be worth it, the machine only has
+   * room for one server, or a chunk still failed; the caller then decodes the
+   * whole recording in one request, so no text goes missing.
+   */
+  async transcribeChunked(audioBuffer, segments, { modelPath, language, initialPrompt }) {
+    const raw = wavToFloat32Samples(audioBuffer);
+    const samples = new Float32Array(raw.buffer, raw.byteOffset, raw.length / 4);
+    const speech = segmentsToSamples(segments, SAMPLE_RATE, samples.length);
+    if (samples.length < MIN_CHUNKED_SECONDS * SAMPLE_RATE || speech.length < 2) return null;
+
+    const workerCount = LocalServerPool.workerCount(fs.statSync(modelPath).size);
+    if (workerCount < 2) return null;
+
+    const chunks = planChunks(speech, samples.length, {
+      targetSamples: Math.max(
+        MIN_CHUNK_SECONDS * SAMPLE_RATE,
+        Math.ceil(samples.length / workerCount)
+      ),
+    });
+    if (chunks.length < 2) return null;
+
+    const { ready, joining } = this.serverPool.acquire(
+      modelPath,
+      Math.min(workerCount, chunks.length) - 1
+    );
+    debugLogger.logWhisperPipeline("transcribeChunked - dispatching", {
+      seconds: samples.length / SAMPLE_RATE,
+      chunks: chunks.length,
+      readyWorkers: ready.length + 1,
+      startingWorkers: joining.length,
+    });
+
+    const startTime = Date.now();
+    const results = await transcribeChunks(
+      chunks,
+      [this.serverManager, ...ready],
+      async (server, { start, end }, index) => {
+        const wav = float32ToWav(samples.subarray(start, end), SAMPLE_RATE);
+        const decode = async (target) =>
+          this.parseWhisperResult(await target.transcribe(wav, { language, initialPrompt }));
+        try {
+          return await decode(server);
+        } catch (error) {
+          debugLogger.warn("transcribeChunked - chunk failed, retrying on the primary server", {
+            chunk: index,
+            error: error.message,
+          });
+        }
+        try {
+          return await decode(this.serverManager);
+        } catch (error) {
+          return { success: false, failed: true, message: error.message };
+        }
+      },
+      joining
+    );
+
+    const failed = results.filter((result) => result.failed);
+    if (failed.length > 0) {
+      debugLogger.warn("transcribeChunked - chunks failed twice, decoding in one request", {
+        failedChunks: failed.length,
+        chunks: chunks.length,
+        error: failed[0].message,
+      });
+      return null;
+    }
+
+    // Chunks the model heard no speech in come back unsuccessful and add nothing
+    const text = this.normalizeWhitespace(
+      results
+        .filter((result) => result.success)
+        .map((result) => result.text)
+        .join(" ")
+    );
+    debugLogger.logWhisperPipeline("transcribeChunked - completed", {
+      elapsed: Date.now() - startTime,
+      chunks: chunks.length,
+      textLength: text.length,
+    });
+    return text ? { success: true, text } : { success: false, message: "No audio detected" };
+  }
+
   // Normalize whitespace: replace newlines with spaces and collapse multiple spaces
   // whisper.cpp returns text with \n between audio segments which causes formatting issues
   normalizeWhitespace(text) {
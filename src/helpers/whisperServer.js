@@ -6,7 +6,8 @@ const http = require("http");
 const debugLogger = require("./debugLogger");
 const { killProcess } = require("../utils/process");
 const { getSafeTempDir } = require("./safeTempDir");
-const { convertToWav } = require("./ffmpegUtils");
+const { convertToWav, isPcm16kMonoWav, float32ToWav } = require("./ffmpegUtils");
+const { hrtimeMicros } = require("./nativeEventStream");
 
 const PORT_RANGE_START = 8178;
 const PORT_RANGE_END = 8199;
@@ -25,6 +26,9 @@ class WhisperServerManager {
     this.cachedServerBinaryPath = null;
     this.cachedFFmpegPath = null;
     this.canConvert = false;
+    // Cost of the last start, also recorded in the dictation trace
+    this.loadMs = null;
+    this.warmUpMs = null;
   }
 
   getFFmpegPath() {
@@ -203,8 +207,11 @@ class WhisperServerManager {
     if (!serverBinary) throw new Error("whisper-server binary not found");
     if (!fs.existsSync(modelPath)) throw new Error(`Model file not found: ${modelPath}`);
 
+    const loadStartUs = hrtimeMicros();
     this.port = await this.findAvailablePort();
     this.modelPath = modelPath;
+    this.loadMs = null;
+    this.warmUpMs = null;
 
     // Check for FFmpeg first - only use --convert flag if FFmpeg is available
     const ffmpegPath = this.getFFmpegPath();
@@ -278,11 +285,38 @@ class WhisperServerManager {
 
     await this.waitForReady(() => ({ stderr: stderrBuffer, exitCode }));
     this.startHealthCheck();
+    const loadEndUs = hrtimeMicros();
+    this.loadMs = Math.round((loadEndUs - loadStartUs) / 1000);
+    debugLogger.traceSpan("model load", loadStartUs, loadEndUs, {
+      track: "local-servers",
+      args: { server: "whisper-server", model: path.basename(modelPath) },
+    });
 
     debugLogger.info("whisper-server started successfully", {
       port: this.port,
       model: path.basename(modelPath),
+      loadMs: this.loadMs,
     });
+
+    if (options.warmUp) await this._warmUp();
+  }
+
+  // One inference on silence, so buffer allocation and GPU pipeline setup
+  // happen before the first dictation rather than during it. Only done for
+  // background starts: for an on-demand start it would delay the dictation.
+  async _warmUp() {
+    const startUs = hrtimeMicros();
+    try {
+      await this.transcribe(float32ToWav(new Float32Array(16000)), {});
+      const endUs = hrtimeMicros();
+      this.warmUpMs = Math.round((endUs - startUs) / 1000);
+      debugLogger.traceSpan("first inference", startUs, endUs, {
+        track: "local-servers",
+        args: { server: "whisper-server", model: path.basename(this.modelPath) },
+      });
+    } catch (err) {
+      debugLogger.warn("whisper-server warm-up failed (non-fatal)", { error: err.message });
+    }
   }
 
   async waitForReady(getProcessInfo) {
@@ -384,12 +418,14 @@ class WhisperServerManager {
 
     const { language, initialPrompt } = options;
 
-    // Always convert to 16kHz mono WAV - whisper.cpp requires this exact format
+    // whisper.cpp requires 16kHz mono WAV; native capture already delivers it
     let finalBuffer = audioBuffer;
-    if (!this.canConvert) {
-      throw new Error("FFmpeg not found - required for audio conversion");
+    if (!isPcm16kMonoWav(audioBuffer)) {
+      if (!this.canConvert) {
+        throw new Error("FFmpeg not found - required for audio conversion");
+      }
+      finalBuffer = await this._convertToWav(audioBuffer);
     }
-    finalBuffer = await this._convertToWav(audioBuffer);
 
     const boundary = `----WhisperBoundary${Date.now()}`;
     const parts = [];
@@ -554,6 +590,8 @@ class WhisperServerManager {
       port: this.port,
       modelPath: this.modelPath,
       modelName: this.modelPath ? path.basename(this.modelPath, ".bin").replace("ggml-", "") : null,
+      loadMs: this.loadMs,
+      warmUpMs: this.warmUpMs,
     };
   }
 }
@@ -26,6 +26,8 @@ class WindowManager {
     this.winPushState = null;
     this._cachedActivationMode = "tap";
     this._floatingIconAutoHide = false;
+    this.pasteTargetDetector = null;
+    this.nativePushListener = null;
 
     app.on("before-quit", () => {
       this.isQuitting = true;
@@ -164,6 +166,12 @@ class WindowManager {
       const activationMode = this.getActivationMode();
       const currentHotkey = this.hotkeyManager.getCurrentHotkey?.();
 
+      // Push mode: defer while a native listener reports this hotkey's key-up itself
+      // (the Linux evdev listener, or a macOS event-tap binding)
+      if (activationMode === "push" && this.nativePushListener?.ownsHotkey(currentHotkey)) {
+        return;
+      }
+
       if (
         process.platform === "darwin" &&
         activationMode === "push" &&
@@ -180,6 +188,7 @@ class WindowManager {
         return;
       }
 
+
       const now = Date.now();
       if (now - lastToggleTime < DEBOUNCE_MS) {
         return;
@@ -539,8 +548,25 @@ class WindowManager {
     await this.loadWindowContent(this.controlPanelWindow, true);
   }
 
+  // Called whenever the dictation panel is shown without taking focus, i.e. while
+  // the user's target window is still active
+  setPasteTargetDetector(detector) {
+    this.pasteTargetDetector = detector;
+  }
+
+  /**
+   * Native key listener that takes over push-to-talk for the hotkeys it
+   * reports via ownsHotkey(). Windows always defers to its listener instead.
+   */
+  setNativePushListener(listener) {
+    this.nativePushListener = listener;
+  }
+
   showDictationPanel(options = {}) {
     const { focus = false } = options;
+    if (!focus) {
+      this.pasteTargetDetector?.();
+    }
     if (this.mainWindow && !this.mainWindow.isDestroyed()) {
       if (this.mainWindow.isMinimized()) {
         this.mainWindow.restore();
@@ -3,13 +3,32 @@
  *
  * Uses a native Windows keyboard hook to detect when specific keys are
  * pressed and released, enabling Push-to-Talk functionality.
+ *
+ * The listener runs with --serve, which also makes it the resident paste
+ * agent: builds that print "FEATURES ..." after READY accept the
+ * windows-fast-paste PASTE / DETECT / TYPE_TEXT commands on stdin (see
+ * sendCommand), and stamp KEY_DOWN/KEY_UP with the same microsecond clock as
+ * their paste replies.
+ *
+ * With OPENWHISPR_BINARY_KEY_EVENTS=true the listener is asked for binary
+ * event records (see nativeEventStream.js). Key events carry
+ * { timestampUs, latencyUs } on process.hrtime's clock either way when the
+ * listener timestamps them.
  */
 
 const { spawn } = require("child_process");
-const path = require("path");
 const EventEmitter = require("events");
-const fs = require("fs");
 const debugLogger = require("./debugLogger");
+const startupManifest = require("./startupManifest");
+const {
+  NativeEventStream,
+  BINARY_EVENTS_ENABLED,
+  BINARY_EVENTS_FLAG,
+  EVENT_TYPES,
+  hrtimeMicros,
+} = require("./nativeEventStream");
+
+const COMMAND_TIMEOUT_MS = 2000;
 
 class WindowsKeyManager extends EventEmitter {
   constructor() {
@@ -19,6 +38,9 @@ class WindowsKeyManager extends EventEmitter {
     this.hasReportedError = false;
     this.currentKey = null;
     this.isReady = false;
+    this.features = new Set();
+    this.lastKeyUpUs = null;
+    this.pending = [];
   }
 
   /**
@@ -55,8 +77,11 @@ class WindowsKeyManager extends EventEmitter {
     });
 
     try {
-      this.process = spawn(listenerPath, [key], {
-        stdio: ["ignore", "pipe", "pipe"],
+      // Older listeners only read argv[1], so --serve is harmless to them
+      const args = [key, "--serve"];
+      if (BINARY_EVENTS_ENABLED) args.push(BINARY_EVENTS_FLAG);
+      this.process = spawn(listenerPath, args, {
+        stdio: ["pipe", "pipe", "pipe"],
         windowsHide: true,
       });
     } catch (error) {
@@ -65,29 +90,14 @@ class WindowsKeyManager extends EventEmitter {
       return;
     }
 
-    this.process.stdout.setEncoding("utf8");
-    this.process.stdout.on("data", (chunk) => {
-      chunk
-        .split(/\r?\n/)
-        .map((line) => line.trim())
-        .filter(Boolean)
-        .forEach((line) => {
-          if (line === "READY") {
-            debugLogger.debug("[WindowsKeyManager] Listener ready", { key });
-            this.isReady = true;
-            this.emit("ready");
-          } else if (line === "KEY_DOWN") {
-            debugLogger.debug("[WindowsKeyManager] KEY_DOWN detected", { key });
-            this.emit("key-down", key);
-          } else if (line === "KEY_UP") {
-            debugLogger.debug("[WindowsKeyManager] KEY_UP detected", { key });
-            this.emit("key-up", key);
-          } else {
-            // Log unknown output at debug level (could be native binary's stderr info)
-            debugLogger.debug("[WindowsKeyManager] Unknown output", { line });
-          }
-        });
+    this.process.stdin.on("error", () => {});
+    // Command replies can be split across chunks; the stream only hands over
+    // whole lines and records
+    const events = new NativeEventStream({
+      onLine: (line) => this._handleLine(line, key),
+      onRecord: (record) => this._handleRecord(record, key),
     });
+    this.process.stdout.on("data", (chunk) => events.push(chunk));
 
     this.process.stderr.setEncoding("utf8");
     this.process.stderr.on("data", (data) => {
@@ -98,14 +108,21 @@ class WindowsKeyManager extends EventEmitter {
       }
     });
 
-    this.process.on("error", (error) => {
+    // After a hotkey change the old listener's events arrive late; they
+    // must not touch the listener that replaced it
+    const proc = this.process;
+    proc.on("error", (error) => {
+      if (this.process !== proc) return;
       this.reportError(error);
       this.process = null;
     });
 
-    this.process.on("exit", (code, signal) => {
+    proc.on("exit", (code, signal) => {
+      if (this.process !== proc) return;
       this.process = null;
       this.isReady = false;
+      this.features = new Set();
+      this._rejectPending(new Error("Windows key listener exited"));
       if (code !== 0) {
         const error = new Error(
           `Windows key listener exited with code ${code ?? "null"} signal ${signal ?? "null"}`
@@ -115,6 +132,124 @@ class WindowsKeyManager extends EventEmitter {
     });
   }
 
+  _handleLine(line, key) {
+    const [event, timestamp] = line.split(" ");
+    if (event === "KEY_DOWN" || event === "KEY_UP") {
+      const timestampUs = timestamp ? Number(timestamp) : null;
+      this._emitKey(event === "KEY_DOWN", key, timestampUs, {
+        timestampUs,
+        latencyUs: timestampUs ? hrtimeMicros() - timestampUs : null,
+      });
+    } else if (line === "READY") {
+      debugLogger.debug("[WindowsKeyManager] Listener ready", { key });
+      this.isReady = true;
+      this.emit("ready");
+    } else if (event === "FEATURES") {
+      this.features = new Set(line.split(/\s+/).slice(1));
+      debugLogger.debug("[WindowsKeyManager] Listener features", { features: [...this.features] });
+      this.emit("features", this.features);
+    } else if (this.pending.length > 0) {
+      this._resolveCommand(line);
+    } else {
+      // Log unknown output at debug level (could be native binary's stderr info)
+      debugLogger.debug("[WindowsKeyManager] Unknown output", { line });
+    }
+  }
+
+  _handleRecord(record, key) {
+    if (record.type !== EVENT_TYPES.KEY_DOWN && record.type !== EVENT_TYPES.KEY_UP) return;
+    // Slot 0 is the positional hotkey, the only one this manager watches
+    if (record.keyId !== 0) return;
+    const { timestampUs, latencyUs, eventTimeMs } = record;
+    this._emitKey(record.type === EVENT_TYPES.KEY_DOWN, key, timestampUs, {
+      timestampUs,
+      latencyUs,
+      eventTimeMs,
+    });
+  }
+
+  _emitKey(isDown, key, timestampUs, timing) {
+    const name = isDown ? "KEY_DOWN" : "KEY_UP";
+    debugLogger.traceEvent(isDown ? "key down" : "key up", {
+      ts: timestampUs ?? undefined,
+      track: "windows-key-listener",
+      args: { key, latencyUs: timing.latencyUs },
+    });
+    if (!isDown) {
+      // Microseconds on the agent's clock, comparable with paste reply start times
+      this.lastKeyUpUs = timestampUs;
+    }
+    debugLogger.debug(`[WindowsKeyManager] ${name} detected`, { key, ...timing });
+    this.emit(isDown ? "key-down" : "key-up", key, timing);
+  }
+
+  /**
+   * Whether the running listener can serve the given agent command group
+   * ("paste", "detect" or "type").
+   */
+  hasFeature(feature) {
+    return !!this.process && this.isReady && this.features.has(feature);
+  }
+
+  /**
+   * Send a paste-agent command and resolve with its reply line. Replies are
+   * matched in FIFO order; "ERROR" and "<COMMAND>_ERROR" replies reject. An
+   * optional payload Buffer follows the command line (TYPE_TEXT). Rejections
+   * for a command that got no reply (timeout, exit) have outcomeUnknown set,
+   * as in NativeHelperDaemon.send.
+   */
+  sendCommand(command, { timeoutMs = COMMAND_TIMEOUT_MS, payload = null } = {}) {
+    const proc = this.process;
+    if (!proc || !this.isReady) {
+      return Promise.reject(new Error("Windows key listener is not running"));
+    }
+
+    return new Promise((resolve, reject) => {
+      const entry = { resolve, reject, timer: null };
+      entry.timer = setTimeout(() => {
+        const index = this.pending.indexOf(entry);
+        if (index !== -1) this.pending.splice(index, 1);
+        // A late reply would be matched to the next command, so stop serving
+        this.features = new Set();
+        const error = new Error(`Windows key listener timed out on "${command}"`);
+        error.outcomeUnknown = true;
+        entry.reject(error);
+      }, timeoutMs);
+
+      this.pending.push(entry);
+      try {
+        const line = `${command}\n`;
+        proc.stdin.write(payload ? Buffer.concat([Buffer.from(line), payload]) : line);
+      } catch (error) {
+        clearTimeout(entry.timer);
+        this.pending.splice(this.pending.indexOf(entry), 1);
+        reject(error);
+      }
+    });
+  }
+
+  _resolveCommand(line) {
+    const entry = this.pending.shift();
+    clearTimeout(entry.timer);
+    const [status] = line.split(" ", 1);
+    if (status === "ERROR" || status.endsWith("_ERROR")) {
+      entry.reject(new Error(`windows-key-listener: ${line}`));
+    } else {
+      entry.resolve(line);
+    }
+  }
+
+  // Pending commands were written but never answered, so they may have run
+  _rejectPending(error) {
+    error.outcomeUnknown = true;
+    const pending = this.pending;
+    this.pending = [];
+    for (const entry of pending) {
+      clearTimeout(entry.timer);
+      entry.reject(error);
+    }
+  }
+
   /**
    * Stop the key listener
    */
@@ -130,6 +265,8 @@ class WindowsKeyManager extends EventEmitter {
     }
     this.isReady = false;
     this.currentKey = null;
+    this.features = new Set();
+    this._rejectPending(new Error("Windows key listener stopped"));
   }
 
   /**
@@ -166,37 +303,7 @@ class WindowsKeyManager extends EventEmitter {
    * Find the listener binary in various possible locations
    */
   resolveListenerBinary() {
-    const binaryName = "windows-key-listener.exe";
-    const candidates = new Set([
-      path.join(__dirname, "..", "..", "resources", "bin", binaryName),
-      path.join(__dirname, "..", "..", "resources", binaryName),
-    ]);
-
-    if (process.resourcesPath) {
-      [
-        path.join(process.resourcesPath, binaryName),
-        path.join(process.resourcesPath, "bin", binaryName),
-        path.join(process.resourcesPath, "resources", binaryName),
-        path.join(process.resourcesPath, "resources", "bin", binaryName),
-        path.join(process.resourcesPath, "app.asar.unpacked", "resources", binaryName),
-        path.join(process.resourcesPath, "app.asar.unpacked", "resources", "bin", binaryName),
-      ].forEach((candidate) => candidates.add(candidate));
-    }
-
-    const candidatePaths = [...candidates];
-
-    for (const candidate of candidatePaths) {
-      try {
-        const stats = fs.statSync(candidate);
-        if (stats.isFile()) {
-          return candidate;
-        }
-      } catch {
-        continue;
-      }
-    }
-
-    return null;
+    return startupManifest.resolveHelper("windows-key-listener.exe");
   }
 }
 
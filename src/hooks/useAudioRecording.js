@@ -2,6 +2,7 @@ import { useState, useEffect, useRef, useCallback } from "react";
 import { useTranslation } from "react-i18next";
 import AudioManager from "../helpers/audioManager";
 import logger from "../utils/logger";
+import dictationTrace from "../utils/dictationTrace";
 import { playStartCue, playStopCue } from "../utils/dictationCues";
 
 export const useAudioRecording = (toast, options = {}) => {
@@ -25,7 +26,9 @@ export const useAudioRecording = (toast, options = {}) => {
       const currentState = audioManagerRef.current.getState();
       if (currentState.isRecording || currentState.isProcessing) return false;
 
-      const didStart = audioManagerRef.current.shouldUseStreaming()
+      const streaming = audioManagerRef.current.shouldUseStreaming();
+      dictationTrace.begin({ streaming });
+      const didStart = streaming
         ? await audioManagerRef.current.startStreamingRecording()
         : await audioManagerRef.current.startRecording();
 
@@ -48,6 +51,7 @@ export const useAudioRecording = (toast, options = {}) => {
       const currentState = audioManagerRef.current.getState();
       if (!currentState.isRecording && !currentState.isStreamingStartInProgress) return false;
 
+      dictationTrace.mark("stop requested");
       if (currentState.isStreaming || currentState.isStreamingStartInProgress) {
         void playStopCue();
         return await audioManagerRef.current.stopStreamingRecording();
@@ -108,6 +112,8 @@ export const useAudioRecording = (toast, options = {}) => {
             result.text,
             isStreaming ? { fromStreaming: true } : {}
           );
+          dictationTrace.span("paste", pasteStart, performance.now(), { source: result.source });
+          dictationTrace.end();
           logger.info(
             "Paste timing",
             {
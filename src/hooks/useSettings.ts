@@ -24,6 +24,7 @@ export interface TranscriptionSettings {
   parakeetModel: string;
   allowOpenAIFallback: boolean;
   allowLocalFallback: boolean;
+  speculativeTranscription: boolean;
   fallbackWhisperModel: string;
   preferredLanguage: string;
   cloudTranscriptionProvider: string;
@@ -115,6 +116,16 @@ function useSettingsInternal() {
     }
   );
 
+  // Decode native recordings in rolling windows while the hotkey is held
+  const [speculativeTranscription, setSpeculativeTranscription] = useLocalStorage(
+    "speculativeTranscription",
+    false,
+    {
+      serialize: String,
+      deserialize: (value) => value === "true",
+    }
+  );
+
   const [allowLocalFallback, setAllowLocalFallback] = useLocalStorage("allowLocalFallback", false, {
     serialize: String,
     deserialize: (value) => value === "true",
@@ -693,6 +704,8 @@ function useSettingsInternal() {
         setAllowOpenAIFallback(settings.allowOpenAIFallback);
       if (settings.allowLocalFallback !== undefined)
         setAllowLocalFallback(settings.allowLocalFallback);
+      if (settings.speculativeTranscription !== undefined)
+        setSpeculativeTranscription(settings.speculativeTranscription);
       if (settings.fallbackWhisperModel !== undefined)
         setFallbackWhisperModel(settings.fallbackWhisperModel);
       if (settings.preferredLanguage !== undefined)
@@ -713,6 +726,7 @@ function useSettingsInternal() {
       setParakeetModel,
       setAllowOpenAIFallback,
       setAllowLocalFallback,
+      setSpeculativeTranscription,
       setFallbackWhisperModel,
       setPreferredLanguage,
       setCloudTranscriptionProvider,
@@ -762,6 +776,7 @@ function useSettingsInternal() {
     parakeetModel,
     allowOpenAIFallback,
     allowLocalFallback,
+    speculativeTranscription,
     fallbackWhisperModel,
     preferredLanguage,
     cloudTranscriptionProvider,
@@ -790,6 +805,7 @@ function useSettingsInternal() {
     setParakeetModel,
     setAllowOpenAIFallback,
     setAllowLocalFallback,
+    setSpeculativeTranscription,
     setFallbackWhisperModel,
     setPreferredLanguage,
     setCloudTranscriptionProvider,
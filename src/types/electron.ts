@@ -173,7 +173,10 @@ declare global {
   interface Window {
     electronAPI: {
       // Basic window operations
-      pasteText: (text: string, options?: { fromStreaming?: boolean }) => Promise<void>;
+      pasteText: (
+        text: string,
+        options?: { fromStreaming?: boolean; typeInjectionMaxChars?: number; keysAfter?: string }
+      ) => Promise<void>;
       hideWindow: () => Promise<void>;
       showDictationPanel: () => Promise<void>;
       onToggleDictation: (callback: () => void) => () => void;
@@ -221,6 +224,34 @@ declare global {
       // Audio
       onNoAudioDetected: (callback: (event: any, data?: any) => void) => () => void;
 
+      // Native microphone capture (16 kHz mono, returned as a WAV)
+      nativeAudioAvailable?: () => Promise<boolean>;
+      nativeAudioStart?: (options?: {
+        deviceName?: string | null;
+        // Transcribe in rolling windows while recording, on this local model
+        speculative?: {
+          provider: string;
+          model: string;
+          language?: string | null;
+          initialPrompt?: string | null;
+        } | null;
+      }) => Promise<{ success: boolean; startUs?: number; error?: string }>;
+      nativeAudioStop?: () => Promise<{
+        success: boolean;
+        audioBuffer?: Uint8Array;
+        durationSeconds?: number;
+        speechSeconds?: number;
+        segments?: Array<{ start: number; end: number }>;
+        // Text decoded during recording, and the audio after it still to decode
+        speculative?: {
+          prefixText: string;
+          committedSeconds: number;
+          tailBuffer: Uint8Array | null;
+          tailSeconds: number;
+        } | null;
+        error?: string;
+      }>;
+
       // Whisper operations (whisper.cpp)
       transcribeLocalWhisper: (audioBlob: Blob | ArrayBuffer, options?: any) => Promise<any>;
       checkWhisperInstallation: () => Promise<WhisperCheckResult>;
@@ -407,6 +438,8 @@ declare global {
         error?: string;
       }>;
       openLogsFolder: () => Promise<{ success: boolean; error?: string }>;
+      traceDictation?: (entry: Record<string, unknown>) => void;
+      exportLatencyTrace?: () => Promise<{ success: boolean; path?: string; error?: string }>;
 
       // FFmpeg availability
       checkFFmpegAvailability: () => Promise<FFmpegAvailabilityResult>;
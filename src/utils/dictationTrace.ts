@@ -0,0 +1,23 @@
+// Renderer side of the dictation latency trace (see debugLogger.traceEntry).
+// Times are performance.now() values; the main process maps them onto the
+// clock the native helpers stamp with and drops them unless debug logging is on.
+
+const send = (entry: Record<string, unknown>) => {
+  if (typeof window === "undefined" || !window.electronAPI?.traceDictation) return;
+  try {
+    window.electronAPI.traceDictation({ ...entry, timeOrigin: performance.timeOrigin });
+  } catch {
+    // Tracing must never affect dictation
+  }
+};
+
+const dictationTrace = {
+  begin: (args?: Record<string, unknown>) => send({ type: "begin", args }),
+  end: () => send({ type: "end" }),
+  span: (name: string, start: number, end = performance.now(), args?: Record<string, unknown>) =>
+    send({ type: "span", name, start, end, args }),
+  mark: (name: string, args?: Record<string, unknown>) =>
+    send({ type: "mark", name, start: performance.now(), args }),
+};
+
+export default dictationTrace;